@@ -79,4 +79,91 @@ pub fn build(b: *std.Build) void {
     const run_step = b.step("run", "Run the example");
     run_step.dependOn(&install_step.step);
     run_step.dependOn(&run_cmd.step);
+
+    // ===== Headless server =====
+    // Native target, does not use the zune module and links no window/graphics libraries
+    const server = addHeadlessExecutable(b, "Zune_rts_server", "src/server.zig", optimize);
+
+    const server_install = b.addInstallArtifact(server, .{});
+    const server_step = b.step("server", "Build the headless server");
+    server_step.dependOn(&server_install.step);
+
+    const server_run = b.addRunArtifact(server);
+    if (b.args) |args| {
+        server_run.addArgs(args);
+    }
+    const server_run_step = b.step("run-server", "Run the headless server");
+    server_run_step.dependOn(&server_install.step);
+    server_run_step.dependOn(&server_run.step);
+
+    // ===== Benchmarks =====
+    const bench_import = addHeadlessExecutable(b, "Zune_rts_bench_import", "src/bench_import.zig", .ReleaseFast);
+    const bench_import_run = b.addRunArtifact(bench_import);
+    if (b.args) |args| {
+        bench_import_run.addArgs(args);
+    }
+    const bench_import_step = b.step("bench-import", "Check the PLY round trip of generated meshes and compare load times with OBJ");
+    bench_import_step.dependOn(&bench_import_run.step);
+
+    const bench_nav = addHeadlessExecutable(b, "Zune_rts_bench_nav", "src/bench_nav.zig", .ReleaseFast);
+    const bench_nav_run = b.addRunArtifact(bench_nav);
+    if (b.args) |args| {
+        bench_nav_run.addArgs(args);
+    }
+    const bench_nav_step = b.step("bench-nav", "Benchmark flow fields and hierarchical paths at several grid sizes");
+    bench_nav_step.dependOn(&bench_nav_run.step);
+
+    const bench_occlusion = addHeadlessExecutable(b, "Zune_rts_bench_occlusion", "src/bench_occlusion.zig", .ReleaseFast);
+    const bench_occlusion_run = b.addRunArtifact(bench_occlusion);
+    if (b.args) |args| {
+        bench_occlusion_run.addArgs(args);
+    }
+    const bench_occlusion_step = b.step("bench-occlusion", "Check software occlusion on a synthetic scene and benchmark it on the first map");
+    bench_occlusion_step.dependOn(&bench_occlusion_run.step);
+
+    const bench_render = addHeadlessExecutable(b, "Zune_rts_bench_render", "src/bench_render.zig", .ReleaseFast);
+    const bench_render_run = b.addRunArtifact(bench_render);
+    if (b.args) |args| {
+        bench_render_run.addArgs(args);
+    }
+    const bench_render_step = b.step("bench-render", "Check the render queue against a mock backend and count draw calls and state changes");
+    bench_render_step.dependOn(&bench_render_run.step);
+
+    const bench_selection = addHeadlessExecutable(b, "Zune_rts_bench_selection", "src/bench_selection.zig", .ReleaseFast);
+    const bench_selection_run = b.addRunArtifact(bench_selection);
+    if (b.args) |args| {
+        bench_selection_run.addArgs(args);
+    }
+    const bench_selection_step = b.step("bench-selection", "Check rectangle and lasso selection of 10k units against a reference and the 100 us budget");
+    bench_selection_step.dependOn(&bench_selection_run.step);
+
+    const bench_simplify = addHeadlessExecutable(b, "Zune_rts_bench_simplify", "src/bench_simplify.zig", .ReleaseFast);
+    const bench_simplify_run = b.addRunArtifact(bench_simplify);
+    if (b.args) |args| {
+        bench_simplify_run.addArgs(args);
+    }
+    const bench_simplify_step = b.step("bench-simplify", "Simplify asset and generated meshes at several thresholds and report time, memory and surface distance");
+    bench_simplify_step.dependOn(&bench_simplify_run.step);
+}
+
+/// Host executable with the eigen wrapper but without zune, for the server and benchmarks
+fn addHeadlessExecutable(b: *std.Build, name: []const u8, root: []const u8, optimize: std.builtin.OptimizeMode) *std.Build.Step.Compile {
+    const exe = b.addExecutable(.{
+        .name = name,
+        .root_source_file = b.path(root),
+        .target = b.graph.host,
+        .optimize = optimize,
+    });
+    exe.linkLibC();
+    exe.linkSystemLibrary("stdc++");
+    exe.addCSourceFile(.{
+        .file = b.path("dependencies/wrappers/eigen.cpp"),
+        .flags = &[_][]const u8{
+            "-std=c++17",
+            "-fno-exceptions",
+        },
+    });
+    exe.addIncludePath(b.path("dependencies/wrappers"));
+    exe.addIncludePath(b.path("zune/dependencies/include/")); // eigen headers
+    return exe;
 }
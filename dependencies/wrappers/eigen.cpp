@@ -1,8 +1,407 @@
 #include <Eigen/Dense>
+#include <algorithm>
+#include <cfloat>
 #include <cstdint>
 #include <iostream>
+#include <thread>
+#include <vector>
+#include <cmath>
 using namespace std;
 
+// ======================================
+// Face kernels
+// ======================================
+
+namespace {
+    // Below this many triangles per thread, spawning costs more than it saves
+    const int minFacesPerThread = 1 << 15;
+
+    // Faces [begin, end) of `eigen_face_attributes`, 8 at a time: gather the corners of 8 triangles into lanes, then the
+    // cross products, lengths and centroids are straight-line lane arithmetic the compiler vectorizes. Hardware
+    // gathers (AVX2) measured no faster than these scalar loads, so the gather stays portable.
+    void faceRange(const float* vertices, const uint32_t* indices, int count, int begin, int end, float* normals, float* areas, float* centroids) {
+        const int lanes = 8;
+        int f = begin;
+        for (; f + lanes <= end; f += lanes) {
+            float p[3][3][lanes]; // [corner][axis][lane]
+            for (int c = 0; c < 3; c++)
+                for (int l = 0; l < lanes; l++) {
+                    const float* v = vertices + 3 * size_t(indices[(f + l) * 3 + c]);
+                    for (int k = 0; k < 3; k++) p[c][k][l] = v[k];
+                }
+            float n[3][lanes];
+            float len[lanes];
+            for (int l = 0; l < lanes; l++) {
+                const float e1x = p[1][0][l] - p[0][0][l], e1y = p[1][1][l] - p[0][1][l], e1z = p[1][2][l] - p[0][2][l];
+                const float e2x = p[2][0][l] - p[0][0][l], e2y = p[2][1][l] - p[0][1][l], e2z = p[2][2][l] - p[0][2][l];
+                n[0][l] = e1y * e2z - e1z * e2y;
+                n[1][l] = e1z * e2x - e1x * e2z;
+                n[2][l] = e1x * e2y - e1y * e2x;
+                len[l] = std::sqrt(n[0][l] * n[0][l] + n[1][l] * n[1][l] + n[2][l] * n[2][l]);
+            }
+            if (normals)
+                for (int k = 0; k < 3; k++)
+                    for (int l = 0; l < lanes; l++) normals[size_t(k) * count + f + l] = len[l] > 0 ? n[k][l] / len[l] : 0.0f;
+            if (areas)
+                for (int l = 0; l < lanes; l++) areas[f + l] = 0.5f * len[l];
+            if (centroids)
+                for (int k = 0; k < 3; k++)
+                    for (int l = 0; l < lanes; l++) centroids[size_t(k) * count + f + l] = (p[0][k][l] + p[1][k][l] + p[2][k][l]) * (1.0f / 3.0f);
+        }
+
+        // Remainder, one face at a time
+        for (; f < end; f++) {
+            Eigen::Map<const Eigen::Vector3f> a(vertices + 3 * size_t(indices[f * 3]));
+            Eigen::Map<const Eigen::Vector3f> b(vertices + 3 * size_t(indices[f * 3 + 1]));
+            Eigen::Map<const Eigen::Vector3f> c(vertices + 3 * size_t(indices[f * 3 + 2]));
+            const Eigen::Vector3f n = (b - a).cross(c - a);
+            const float len = n.norm();
+            for (int k = 0; k < 3; k++) {
+                if (normals) normals[size_t(k) * count + f] = len > 0 ? n(k) / len : 0.0f;
+                if (centroids) centroids[size_t(k) * count + f] = (a(k) + b(k) + c(k)) * (1.0f / 3.0f);
+            }
+            if (areas) areas[f] = 0.5f * len;
+        }
+    }
+}
+
+// ======================================
+// Surface distance
+// ======================================
+
+namespace {
+    // Samples are measured in blocks of this size; each block restarts the warm start and the block sums are added in
+    // block order, so the result does not depend on how blocks are spread over threads
+    const int sampleBlock = 1 << 12;
+    const int bvhLeafSize = 4;
+
+    struct Box {
+        float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+        float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+        void grow(const float* p) {
+            for (int k = 0; k < 3; k++) {
+                lo[k] = std::min(lo[k], p[k]);
+                hi[k] = std::max(hi[k], p[k]);
+            }
+        }
+
+        // Squared distance from p to the box, 0 inside
+        float distance2(const float* p) const {
+            float d2 = 0;
+            for (int k = 0; k < 3; k++) {
+                const float d = std::max(std::max(lo[k] - p[k], p[k] - hi[k]), 0.0f);
+                d2 += d * d;
+            }
+            return d2;
+        }
+    };
+
+    // Interior nodes have `count` 0 and children at `first` and `first + 1`, leaves hold triangles [first, first + count)
+    struct BvhNode {
+        Box box;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    // Bounding volume hierarchy over the triangles of one mesh, split at the centroid median of the longest axis.
+    // Splits partition compact centroid records in place and boxes are merged bottom-up afterwards. The top levels are
+    // split on the calling thread until there is a subtree per thread, which are then built in parallel and spliced
+    // in. Corners are copied in tree order, so a leaf reads 36 consecutive bytes per triangle.
+    struct Bvh {
+        std::vector<BvhNode> nodes;
+        std::vector<float> corners; // [triangle in tree order][corner][axis]
+
+        const float* vertices;
+        const uint32_t* indices;
+        struct Centroid {
+            float c[3];
+            uint32_t triangle;
+        };
+        std::vector<Centroid> centroids; // only during the build
+
+        // Subtree of triangles [begin, end) to be built into node `slot`
+        struct Task { uint32_t slot, begin, end; };
+
+        Bvh(const float* vertices, const uint32_t* indices, int count, int threads) : vertices(vertices), indices(indices) {
+            centroids.resize(count);
+            for (int f = 0; f < count; f++) {
+                centroids[f].triangle = uint32_t(f);
+                for (int k = 0; k < 3; k++) centroids[f].c[k] = (vertices[3 * size_t(indices[f * 3]) + k] + vertices[3 * size_t(indices[f * 3 + 1]) + k] + vertices[3 * size_t(indices[f * 3 + 2]) + k]) * (1.0f / 3.0f);
+            }
+            corners.resize(size_t(count) * 9);
+
+            // ----- top levels here, one subtree per thread -----
+            std::vector<Task> tasks;
+            nodes.push_back({});
+            split(nodes, 0, 0, uint32_t(count), threads > 1 ? threads : 0, tasks);
+
+            std::vector<std::vector<BvhNode>> subtrees(tasks.size());
+            std::vector<std::thread> workers;
+            for (size_t t = 0; t < tasks.size(); t++) {
+                workers.emplace_back([this, &tasks, &subtrees, t] {
+                    std::vector<Task> none;
+                    subtrees[t].push_back({});
+                    split(subtrees[t], 0, tasks[t].begin, tasks[t].end, 0, none);
+                    fitBoxes(subtrees[t], 0);
+                });
+            }
+            for (std::thread& worker : workers) worker.join();
+
+            // ----- subtree roots go into their reserved slot, the rest is appended with shifted child indices -----
+            for (size_t t = 0; t < tasks.size(); t++) {
+                const std::vector<BvhNode>& local = subtrees[t];
+                const uint32_t base = uint32_t(nodes.size()) - 1;
+                auto shifted = [base](BvhNode node) {
+                    if (node.count == 0) node.first += base;
+                    return node;
+                };
+                nodes[tasks[t].slot] = shifted(local[0]);
+                for (size_t i = 1; i < local.size(); i++) nodes.push_back(shifted(local[i]));
+            }
+            fitBoxes(nodes, 0);
+            centroids = std::vector<Centroid>();
+        }
+
+        // Partition triangles [begin, end) (tree order) below `out[slot]` and copy the corners of its leaves. While
+        // `parallel` > 1 the range is split, once it reaches 1 the subtree is handed to `tasks` instead.
+        void split(std::vector<BvhNode>& out, uint32_t slot, uint32_t begin, uint32_t end, int parallel, std::vector<Task>& tasks) {
+            if (end - begin <= uint32_t(bvhLeafSize)) {
+                out[slot].first = begin;
+                out[slot].count = end - begin;
+                for (uint32_t i = begin; i < end; i++) {
+                    const uint32_t f = centroids[i].triangle;
+                    for (int c = 0; c < 3; c++)
+                        for (int k = 0; k < 3; k++) corners[size_t(i) * 9 + c * 3 + k] = vertices[3 * size_t(indices[f * 3 + c]) + k];
+                }
+                return;
+            }
+            if (parallel == 1) {
+                tasks.push_back({slot, begin, end});
+                return;
+            }
+
+            Box centers;
+            for (uint32_t i = begin; i < end; i++) centers.grow(centroids[i].c);
+            int axis = 0;
+            for (int k = 1; k < 3; k++)
+                if (centers.hi[k] - centers.lo[k] > centers.hi[axis] - centers.lo[axis]) axis = k;
+            const uint32_t mid = begin + (end - begin) / 2;
+            std::nth_element(centroids.begin() + begin, centroids.begin() + mid, centroids.begin() + end, [axis](const Centroid& a, const Centroid& b) {
+                return a.c[axis] < b.c[axis];
+            });
+
+            const uint32_t left = uint32_t(out.size());
+            out[slot].first = left;
+            out[slot].count = 0;
+            out.push_back({});
+            out.push_back({});
+            split(out, left, begin, mid, parallel / 2, tasks);
+            split(out, left + 1, mid, end, parallel - parallel / 2, tasks);
+        }
+
+        // Boxes of `out[slot]` and its subtree, skipping subtrees whose box is already set
+        void fitBoxes(std::vector<BvhNode>& out, uint32_t slot) {
+            BvhNode& node = out[slot];
+            if (node.box.lo[0] <= node.box.hi[0]) return;
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++)
+                    for (int c = 0; c < 3; c++) node.box.grow(&corners[size_t(i) * 9 + c * 3]);
+                return;
+            }
+            fitBoxes(out, node.first);
+            fitBoxes(out, node.first + 1);
+            for (uint32_t child = node.first; child <= node.first + 1; child++) {
+                node.box.grow(out[child].box.lo);
+                node.box.grow(out[child].box.hi);
+            }
+        }
+
+        // Closest triangle (tree order) to p with squared distance below `best2`, which is updated. -1 if none is closer.
+        // Triangle `hint` (the previous answer of a nearby query, or -1) is tested first to tighten the bound.
+        int closest(const float* p, float& best2, int hint) const {
+            int bestTriangle = -1;
+            if (hint >= 0) {
+                const float d2 = pointTriangleDistance2(p, &corners[size_t(hint) * 9]);
+                if (d2 < best2) {
+                    best2 = d2;
+                    bestTriangle = hint;
+                }
+            }
+            struct Entry { uint32_t node; float distance2; };
+            Entry stack[64];
+            int top = 0;
+            stack[top++] = {0, nodes[0].box.distance2(p)};
+            while (top > 0) {
+                const Entry entry = stack[--top];
+                if (entry.distance2 >= best2) continue;
+                const BvhNode& node = nodes[entry.node];
+                if (node.count > 0) {
+                    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                        const float d2 = pointTriangleDistance2(p, &corners[size_t(i) * 9]);
+                        if (d2 < best2) {
+                            best2 = d2;
+                            bestTriangle = int(i);
+                        }
+                    }
+                    continue;
+                }
+                // ----- nearer child on top of the stack -----
+                const Entry l = {node.first, nodes[node.first].box.distance2(p)};
+                const Entry r = {node.first + 1, nodes[node.first + 1].box.distance2(p)};
+                if (l.distance2 < r.distance2) {
+                    if (r.distance2 < best2) stack[top++] = r;
+                    stack[top++] = l;
+                } else {
+                    if (l.distance2 < best2) stack[top++] = l;
+                    stack[top++] = r;
+                }
+            }
+            return bestTriangle;
+        }
+
+        // Squared distance from p to the plane of triangle i (tree order), 0 for degenerate triangles
+        float planeDistance2(const float* p, int i) const {
+            const float* t = &corners[size_t(i) * 9];
+            Eigen::Map<const Eigen::Vector3f> a(t), b(t + 3), c(t + 6), q(p);
+            const Eigen::Vector3f n = (b - a).cross(c - a);
+            const float n2 = n.squaredNorm();
+            if (n2 == 0) return 0;
+            const float d = n.dot(q - a);
+            return d * d / n2;
+        }
+
+        // Ericson, Real-Time Collision Detection 5.1.5: closest point by Voronoi region of the triangle
+        static float pointTriangleDistance2(const float* p, const float* t) {
+            Eigen::Map<const Eigen::Vector3f> a(t), b(t + 3), c(t + 6), q(p);
+            const Eigen::Vector3f ab = b - a, ac = c - a, ap = q - a;
+            const float d1 = ab.dot(ap), d2 = ac.dot(ap);
+            if (d1 <= 0 && d2 <= 0) return ap.squaredNorm();
+
+            const Eigen::Vector3f bp = q - b;
+            const float d3 = ab.dot(bp), d4 = ac.dot(bp);
+            if (d3 >= 0 && d4 <= d3) return bp.squaredNorm();
+
+            const float vc = d1 * d4 - d3 * d2;
+            if (vc <= 0 && d1 >= 0 && d3 <= 0) return (ap - ab * (d1 / (d1 - d3))).squaredNorm();
+
+            const Eigen::Vector3f cp = q - c;
+            const float d5 = ab.dot(cp), d6 = ac.dot(cp);
+            if (d6 >= 0 && d5 <= d6) return cp.squaredNorm();
+
+            const float vb = d5 * d2 - d1 * d6;
+            if (vb <= 0 && d2 >= 0 && d6 <= 0) return (ap - ac * (d2 / (d2 - d6))).squaredNorm();
+
+            const float va = d3 * d6 - d5 * d4;
+            if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) return (bp - (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))).squaredNorm();
+
+            const float denom = va + vb + vc;
+            if (denom == 0) return std::min({ap.squaredNorm(), bp.squaredNorm(), cp.squaredNorm()}); // degenerate
+            const float v = vb / denom, w = vc / denom;
+            return (ap - ab * v - ac * w).squaredNorm();
+        }
+    };
+
+    // Hash of (sample, stream, seed) to [0, 1), the same for every thread count
+    float sampleRandom(uint64_t sample, uint64_t stream, uint32_t seed) {
+        uint64_t h = sample * 0x9E3779B97F4A7C15ull ^ (stream + 1) * 0xC2B2AE3D27D4EB4Full ^ seed;
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return float(h >> 40) * (1.0f / 16777216.0f);
+    }
+
+    struct DistanceSums {
+        double max2 = 0, sum2 = 0, plane2 = 0;
+    };
+
+    // Samples [begin, end) of `samples` stratified area weighted points on `from`, measured against `to`
+    void distanceRange(const float* vertices, const uint32_t* indices, const std::vector<double>& cdf, const Bvh& to, int samples, uint32_t seed, int begin, int end, DistanceSums* out) {
+        const double total = cdf.back();
+        float previous[3] = {0, 0, 0};
+        float previousDistance = -1;
+        int previousTriangle = -1;
+        DistanceSums sums;
+        int f = -1;
+        for (int s = begin; s < end; s++) {
+            // ----- stratum s of the area, strata only move forward through the triangles -----
+            const double target = (s + sampleRandom(s, 0, seed)) / samples * total;
+            if (f < 0) f = int(std::upper_bound(cdf.begin(), cdf.end(), target) - cdf.begin());
+            while (f < int(cdf.size()) && cdf[f] <= target) f++;
+            f = std::min(f, int(cdf.size()) - 1);
+
+            // ----- uniform point in the triangle -----
+            float r1 = std::sqrt(sampleRandom(s, 1, seed));
+            float r2 = sampleRandom(s, 2, seed);
+            float p[3];
+            for (int k = 0; k < 3; k++) {
+                const float a = vertices[3 * size_t(indices[f * 3]) + k];
+                const float b = vertices[3 * size_t(indices[f * 3 + 1]) + k];
+                const float c = vertices[3 * size_t(indices[f * 3 + 2]) + k];
+                p[k] = (1 - r1) * a + r1 * (1 - r2) * b + r1 * r2 * c;
+            }
+
+            // ----- the previous sample bounds the distance by the triangle inequality -----
+            float best2 = FLT_MAX;
+            if (previousDistance >= 0) {
+                const float step = std::sqrt((p[0] - previous[0]) * (p[0] - previous[0]) + (p[1] - previous[1]) * (p[1] - previous[1]) + (p[2] - previous[2]) * (p[2] - previous[2]));
+                const float bound = previousDistance + step;
+                best2 = bound * bound * (1 + 1e-5f) + FLT_MIN;
+            }
+            const int triangle = to.closest(p, best2, previousTriangle);
+            const float plane2 = triangle >= 0 ? to.planeDistance2(p, triangle) : 0;
+            if (triangle >= 0) previousTriangle = triangle;
+
+            sums.max2 = std::max(sums.max2, double(best2));
+            sums.sum2 += best2;
+            sums.plane2 += plane2;
+            previousDistance = std::sqrt(best2);
+            for (int k = 0; k < 3; k++) previous[k] = p[k];
+        }
+        *out = sums;
+    }
+
+    // Blocks [first, last), each measured on its own into out[block]
+    void distanceBlocks(const float* vertices, const uint32_t* indices, const std::vector<double>& cdf, const Bvh& to, int samples, uint32_t seed, int first, int last, DistanceSums* out) {
+        for (int b = first; b < last; b++)
+            distanceRange(vertices, indices, cdf, to, samples, seed, b * sampleBlock, std::min(samples, (b + 1) * sampleBlock), &out[b]);
+    }
+
+    // Sample `from` and measure against `to`, blocks split over `threads`
+    DistanceSums sampleDistance(const float* vertices, const uint32_t* indices, int count, const Bvh& to, int samples, uint32_t seed, int threads) {
+        std::vector<double> cdf(count);
+        double area = 0;
+        for (int f = 0; f < count; f++) {
+            Eigen::Map<const Eigen::Vector3f> a(vertices + 3 * size_t(indices[f * 3]));
+            Eigen::Map<const Eigen::Vector3f> b(vertices + 3 * size_t(indices[f * 3 + 1]));
+            Eigen::Map<const Eigen::Vector3f> c(vertices + 3 * size_t(indices[f * 3 + 2]));
+            area += 0.5 * double((b - a).cross(c - a).norm());
+            cdf[f] = area;
+        }
+        if (area <= 0) return {};
+
+        const int blocks = (samples + sampleBlock - 1) / sampleBlock;
+        threads = std::max(1, std::min(threads, blocks));
+        std::vector<DistanceSums> partial(blocks);
+        std::vector<std::thread> workers;
+        const int per = (blocks + threads - 1) / threads;
+        for (int t = 0; t + 1 < threads; t++)
+            workers.emplace_back(distanceBlocks, vertices, indices, std::cref(cdf), std::cref(to), samples, seed, std::min(blocks, t * per), std::min(blocks, (t + 1) * per), partial.data());
+        distanceBlocks(vertices, indices, cdf, to, samples, seed, std::min(blocks, (threads - 1) * per), blocks, partial.data());
+        for (std::thread& worker : workers) worker.join();
+
+        DistanceSums sums;
+        for (const DistanceSums& p : partial) {
+            sums.max2 = std::max(sums.max2, p.max2);
+            sums.sum2 += p.sum2;
+            sums.plane2 += p.plane2;
+        }
+        return sums;
+    }
+}
+
 
 extern "C" {
     // Matrix operations
@@ -29,6 +428,7 @@ extern "C" {
         Eigen::Map<Eigen::Matrix4f> outMat(out);
         outMat = matA * matB;
     }
+
     
     // Vector operations
     void eigen_vec4_multiply(const float* mat, const float* vec, float* out) {
@@ -219,5 +619,72 @@ extern "C" {
         
         return 1;
     }    
+    void eigen_fit_obb(const float* points, int count, float* out) {
+        for (int i = 0; i < 15; i++) out[i] = 0.0f;
+        if (!points || count <= 0) return;
+
+        Eigen::Map<const Eigen::Matrix<float, 3, Eigen::Dynamic>> P(points, 3, count);
+
+        // Covariance of the points around their mean
+        Eigen::Vector3d mean = P.cast<double>().rowwise().mean();
+        Eigen::Matrix3Xd centered = P.cast<double>().colwise() - mean;
+        Eigen::Matrix3d covariance = centered * centered.transpose() / double(count);
+
+        // Eigenvalues come in increasing order, take the axes largest first
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+        Eigen::Matrix3d axes = solver.eigenvectors().rowwise().reverse();
+        if (solver.info() != Eigen::Success) axes = Eigen::Matrix3d::Identity();
+        axes.col(2) = axes.col(0).cross(axes.col(1)); // right-handed, exactly orthonormal
+
+        // Extent of the points along every axis
+        Eigen::Matrix3Xd local = axes.transpose() * centered;
+        Eigen::Vector3d lo = local.rowwise().minCoeff();
+        Eigen::Vector3d hi = local.rowwise().maxCoeff();
+        Eigen::Vector3d center = mean + axes * ((lo + hi) / 2.0);
+        Eigen::Vector3d halfExtents = (hi - lo) / 2.0;
+
+        for (int i = 0; i < 3; i++) {
+            out[i] = float(center(i));
+            out[12 + i] = float(halfExtents(i));
+            for (int j = 0; j < 3; j++) out[3 + 3 * i + j] = float(axes(j, i));
+        }
+    }
+
+    void eigen_face_attributes(const float* vertices, const uint32_t* indices, int count, float* normals, float* areas, float* centroids, int threads) {
+        if (count <= 0) return;
+        if (threads <= 0) threads = int(std::thread::hardware_concurrency());
+        threads = std::max(1, std::min(threads, count / minFacesPerThread));
+
+        // Split on multiples of the lane count, the calling thread takes the last range
+        const int per = (count / threads + 7) & ~7;
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        int begin = 0;
+        for (int t = 0; t + 1 < threads && begin + per < count; t++, begin += per)
+            workers.emplace_back(faceRange, vertices, indices, count, begin, begin + per, normals, areas, centroids);
+        faceRange(vertices, indices, count, begin, count, normals, areas, centroids);
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    void eigen_mesh_distance(const float* verticesA, const uint32_t* indicesA, int countA, const float* verticesB, const uint32_t* indicesB, int countB, int samples, uint32_t seed, int threads, float* out) {
+        for (int i = 0; i < 7; i++) out[i] = 0.0f;
+        if (countA <= 0 || countB <= 0 || samples <= 0) return;
+        if (threads <= 0) threads = int(std::thread::hardware_concurrency());
+        threads = std::max(1, threads);
+
+        const Bvh bvhA(verticesA, indicesA, countA, threads);
+        const Bvh bvhB(verticesB, indicesB, countB, threads);
+        const DistanceSums ab = sampleDistance(verticesA, indicesA, countA, bvhB, samples, seed, threads);
+        const DistanceSums ba = sampleDistance(verticesB, indicesB, countB, bvhA, samples, seed + 1, threads);
+
+        out[0] = float(std::sqrt(ab.max2));
+        out[1] = float(std::sqrt(ba.max2));
+        out[2] = std::max(out[0], out[1]);
+        out[3] = float(std::sqrt(ab.sum2 / samples));
+        out[4] = float(std::sqrt(ba.sum2 / samples));
+        out[5] = float(std::sqrt((ab.sum2 + ba.sum2) / (2.0 * samples)));
+        out[6] = float(ab.plane2 / samples);
+    }
+
     // Add more functions as needed
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef EIGEN_WRAPPER_H
 #define EIGEN_WRAPPER_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -29,6 +31,23 @@ void eigen_vec3_cross(const float* a, const float* b, float* out);
 int eigen_optimal_vertex(const double* Q, const double* v0, double lambda, double* v_out);
 int eigen_optimal_vertex_revised(const double* Q, const double* v0, double lambda, double* v_out);
 
+// Fits an oriented bounding box to `count` points (xyz packed) along the eigenvectors of their covariance.
+// Writes center[3], axes[9] (three orthonormal column vectors, largest variance first) and halfExtents[3] to out[15].
+void eigen_fit_obb(const float* points, int count, float* out);
+
+// Face normals (unit), areas and centroids of `count` triangles over xyz packed `vertices` and `indices`.
+// Outputs are structure of arrays: normals[3 * count] and centroids[3 * count] hold all x, then all y, then all z.
+// Any output may be null. Uses up to `threads` threads, 0 for one per hardware thread.
+void eigen_face_attributes(const float* vertices, const uint32_t* indices, int count, float* normals, float* areas, float* centroids, int threads);
+
+// Distances between triangle surfaces A and B with `countA` and `countB` triangles, measured at `samples` stratified
+// area weighted points on each. Every sample is matched to the closest point of the other surface through a BVH.
+// Writes hausdorffAB, hausdorffBA, hausdorff (symmetric), rmsAB, rmsBA, rms (both) and quadricAB (mean squared
+// distance of samples on A to the plane of their closest triangle of B) to out[7]. Samples are placed by hashing
+// `seed` and measured in fixed-size blocks whose sums are added in block order, so results do not depend on `threads`
+// (0 for one per hardware thread).
+void eigen_mesh_distance(const float* verticesA, const uint32_t* indicesA, int countA, const float* verticesB, const uint32_t* indicesB, int countB, int samples, uint32_t seed, int threads, float* out);
+
 #ifdef __cplusplus
 }
 #endif
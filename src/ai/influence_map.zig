@@ -0,0 +1,298 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const Vec2 = math.vec2;
+const Allocator = std.mem.Allocator;
+
+const InfluenceMapError = error{ InvalidGrid, InvalidPlayer };
+
+const lanes = std.simd.suggestVectorLength(f32) orelse 4;
+const VecN = @Vector(lanes, f32);
+
+/// Kernel radius limit in cells
+pub const maxRadius = 16;
+
+/// What a query reads for `player`
+pub const Layer = enum {
+    influence, // own
+    threat, // sum of all other players
+    control, // own minus threat
+};
+
+pub const Sample = struct {
+    value: f32,
+    x: f32, // world position of the cell center
+    z: f32,
+};
+
+const Phase = enum { idle, horizontal, vertical };
+
+/// Per-player influence on a grid of `subdivision`² cells per map chunk.
+///
+/// Units splat their strength into a source grid, which is spread with a separable linear-falloff kernel: one
+/// vectorized pass along rows, one along columns. The cost of an update only depends on grid size and kernel radius,
+/// not on the number of units, and it can be spread over several ticks with `step`: passes write the back buffer while
+/// queries keep reading the last published (front) buffer.
+pub const InfluenceMap = struct {
+    allocator: Allocator,
+
+    origin: Vec2(f32), // minimum corner of the map, (x, z)
+    cellSize: Vec2(f32),
+    resolution: Vec2(usize), // cell count in x and z
+    playerCount: usize,
+
+    radius: usize, // kernel radius in cells
+    kernel: [2 * maxRadius + 1]f32,
+
+    // ----- per player, one after another -----
+    stride: usize, // row length of front, back and blurred: resolution.x rounded up to whole vectors
+    sourceStride: usize, // row length of source: stride plus `radius` zero cells on both sides
+    source: []f32, // splatted strength, resolution.y rows
+    blurred: []f32, // after the row pass, with `radius` zero rows above and below
+    front: []f32, // published, read by queries
+    back: []f32, // being written by the column pass
+
+    phase: Phase = .idle,
+    nextRow: usize = 0, // of the current pass, over all players
+
+    updates: u64 = 0, // published
+    lastStepNs: u64 = 0,
+    maxStepNs: u64 = 0,
+
+    pub fn init(allocator: Allocator, origin: Vec2(f32), chunking: Vec2(usize), chunkSize: Vec2(f32), subdivision: usize, playerCount: usize, radius: usize) !InfluenceMap {
+        if (chunking.x == 0 or chunking.y == 0 or subdivision == 0 or chunkSize.x <= 0 or chunkSize.y <= 0) return InfluenceMapError.InvalidGrid;
+        if (playerCount == 0 or radius > maxRadius) return InfluenceMapError.InvalidGrid;
+
+        const resolution = Vec2(usize){ .x = chunking.x * subdivision, .y = chunking.y * subdivision };
+        const sub: f32 = @floatFromInt(subdivision);
+        const stride = std.mem.alignForward(usize, resolution.x, lanes);
+        const sourceStride = stride + 2 * radius;
+
+        const source = try allocator.alloc(f32, playerCount * resolution.y * sourceStride);
+        errdefer allocator.free(source);
+        const blurred = try allocator.alloc(f32, playerCount * (resolution.y + 2 * radius) * stride);
+        errdefer allocator.free(blurred);
+        const front = try allocator.alloc(f32, playerCount * resolution.y * stride);
+        errdefer allocator.free(front);
+        const back = try allocator.alloc(f32, playerCount * resolution.y * stride);
+        @memset(source, 0);
+        @memset(blurred, 0); // padding rows stay zero
+        @memset(front, 0);
+        @memset(back, 0);
+
+        // ----- linear falloff, 1 at the center -----
+        var kernel = [_]f32{0} ** (2 * maxRadius + 1);
+        const r: f32 = @floatFromInt(radius);
+        for (kernel[0 .. 2 * radius + 1], 0..) |*w, i| {
+            const d: f32 = @floatFromInt(i);
+            w.* = 1 - @abs(d - r) / (r + 1);
+        }
+
+        return .{
+            .allocator = allocator,
+            .origin = origin,
+            .cellSize = .{ .x = chunkSize.x / sub, .y = chunkSize.y / sub },
+            .resolution = resolution,
+            .playerCount = playerCount,
+            .radius = radius,
+            .kernel = kernel,
+            .stride = stride,
+            .sourceStride = sourceStride,
+            .source = source,
+            .blurred = blurred,
+            .front = front,
+            .back = back,
+        };
+    }
+
+    pub fn deinit(self: *InfluenceMap) void {
+        self.allocator.free(self.source);
+        self.allocator.free(self.blurred);
+        self.allocator.free(self.front);
+        self.allocator.free(self.back);
+    }
+
+    fn grid(self: InfluenceMap, buffer: []f32, player: usize) []f32 {
+        const size = self.resolution.y * self.stride;
+        return buffer[player * size ..][0..size];
+    }
+
+    // ======================================
+    // Update
+    // ======================================
+
+    /// No update in progress, a new one can be started with `begin`
+    pub fn isIdle(self: InfluenceMap) bool {
+        return self.phase == .idle;
+    }
+
+    /// Start a new update: clears the sources, `splat` all units next, then `step` until it publishes
+    pub fn begin(self: *InfluenceMap) void {
+        std.debug.assert(self.phase == .idle);
+        @memset(self.source, 0);
+        self.phase = .horizontal;
+        self.nextRow = 0;
+    }
+
+    /// Add `strength` of `player` at world position (`x`, `z`) to the update started by the last `begin`
+    pub fn splat(self: *InfluenceMap, player: usize, x: f32, z: f32, strength: f32) !void {
+        if (player >= self.playerCount) return InfluenceMapError.InvalidPlayer;
+        std.debug.assert(self.phase == .horizontal and self.nextRow == 0);
+        const cx = cellCoord(x, self.origin.x, self.cellSize.x, self.resolution.x);
+        const cz = cellCoord(z, self.origin.y, self.cellSize.y, self.resolution.y);
+        const rows = self.resolution.y * self.sourceStride;
+        self.source[player * rows + cz * self.sourceStride + cx + self.radius] += strength;
+    }
+
+    /// Run at most `rowBudget` kernel rows (over all players and both passes) of the current update.
+    /// Returns true if this step finished the update and published it to the queries.
+    pub fn step(self: *InfluenceMap, rowBudget: usize) !bool {
+        if (self.phase == .idle) return false;
+        var timer = try std.time.Timer.start();
+        defer {
+            self.lastStepNs = timer.read();
+            self.maxStepNs = @max(self.maxStepNs, self.lastStepNs);
+        }
+
+        const passRows = self.playerCount * self.resolution.y;
+        var budget = rowBudget;
+        while (budget > 0) : (budget -= 1) {
+            const player = self.nextRow / self.resolution.y;
+            const z = self.nextRow % self.resolution.y;
+            switch (self.phase) {
+                .horizontal => self.blurRow(player, z),
+                .vertical => self.blurColumn(player, z),
+                .idle => unreachable,
+            }
+
+            self.nextRow += 1;
+            if (self.nextRow < passRows) continue;
+            self.nextRow = 0;
+            if (self.phase == .horizontal) {
+                self.phase = .vertical;
+                continue;
+            }
+
+            // ----- publish -----
+            std.mem.swap([]f32, &self.front, &self.back);
+            self.phase = .idle;
+            self.updates += 1;
+            return true;
+        }
+        return false;
+    }
+
+    /// Spread row `z` of the sources of `player` along x
+    fn blurRow(self: InfluenceMap, player: usize, z: usize) void {
+        const taps = 2 * self.radius + 1;
+        const sourceRows = self.resolution.y * self.sourceStride;
+        const src = self.source[player * sourceRows + z * self.sourceStride ..][0..self.sourceStride];
+        const blurredRows = (self.resolution.y + 2 * self.radius) * self.stride;
+        const dst = self.blurred[player * blurredRows + (z + self.radius) * self.stride ..][0..self.stride];
+
+        var x: usize = 0;
+        while (x < self.stride) : (x += lanes) {
+            var acc: VecN = @splat(0);
+            for (self.kernel[0..taps], 0..) |w, d| acc += @as(VecN, @splat(w)) * @as(VecN, src[x + d ..][0..lanes].*);
+            dst[x..][0..lanes].* = acc;
+        }
+    }
+
+    /// Spread the row-blurred grid of `player` along z into row `z` of the back buffer
+    fn blurColumn(self: InfluenceMap, player: usize, z: usize) void {
+        const taps = 2 * self.radius + 1;
+        const blurredRows = (self.resolution.y + 2 * self.radius) * self.stride;
+        const src = self.blurred[player * blurredRows ..][0..blurredRows];
+        const dst = self.grid(self.back, player)[z * self.stride ..][0..self.stride];
+
+        var x: usize = 0;
+        while (x < self.stride) : (x += lanes) {
+            var acc: VecN = @splat(0);
+            for (self.kernel[0..taps], 0..) |w, d| acc += @as(VecN, @splat(w)) * @as(VecN, src[(z + d) * self.stride + x ..][0..lanes].*);
+            dst[x..][0..lanes].* = acc;
+        }
+    }
+
+    // ======================================
+    // Queries
+    // ======================================
+
+    /// `layer` of `player` at cell (`cx`, `cz`) of the published map
+    fn cellValue(self: InfluenceMap, layer: Layer, player: usize, cx: usize, cz: usize) f32 {
+        const i = cz * self.stride + cx;
+        const own = self.grid(self.front, player)[i];
+        if (layer == .influence) return own;
+
+        var threat: f32 = 0;
+        for (0..self.playerCount) |p| {
+            if (p != player) threat += self.grid(self.front, p)[i];
+        }
+        return if (layer == .threat) threat else own - threat;
+    }
+
+    pub fn value(self: InfluenceMap, layer: Layer, player: usize, x: f32, z: f32) f32 {
+        const cx = cellCoord(x, self.origin.x, self.cellSize.x, self.resolution.x);
+        const cz = cellCoord(z, self.origin.y, self.cellSize.y, self.resolution.y);
+        return self.cellValue(layer, player, cx, cz);
+    }
+
+    /// Highest value of `layer` in the cells overlapping the world rectangle `min`..`max` (x, z)
+    pub fn regionMax(self: InfluenceMap, layer: Layer, player: usize, min: Vec2(f32), max: Vec2(f32)) Sample {
+        return self.regionExtremum(layer, player, min, max, true);
+    }
+
+    /// Lowest value of `layer` in the cells overlapping the world rectangle `min`..`max` (x, z)
+    pub fn regionMin(self: InfluenceMap, layer: Layer, player: usize, min: Vec2(f32), max: Vec2(f32)) Sample {
+        return self.regionExtremum(layer, player, min, max, false);
+    }
+
+    fn regionExtremum(self: InfluenceMap, layer: Layer, player: usize, min: Vec2(f32), max: Vec2(f32), highest: bool) Sample {
+        const cx0 = cellCoord(min.x, self.origin.x, self.cellSize.x, self.resolution.x);
+        const cx1 = cellCoord(max.x, self.origin.x, self.cellSize.x, self.resolution.x);
+        const cz0 = cellCoord(min.y, self.origin.y, self.cellSize.y, self.resolution.y);
+        const cz1 = cellCoord(max.y, self.origin.y, self.cellSize.y, self.resolution.y);
+
+        var best = self.cellValue(layer, player, cx0, cz0);
+        var bestX = cx0;
+        var bestZ = cz0;
+        for (cz0..cz1 + 1) |cz| {
+            for (cx0..cx1 + 1) |cx| {
+                const v = self.cellValue(layer, player, cx, cz);
+                if (if (highest) v > best else v < best) {
+                    best = v;
+                    bestX = cx;
+                    bestZ = cz;
+                }
+            }
+        }
+        return .{
+            .value = best,
+            .x = self.origin.x + (@as(f32, @floatFromInt(bestX)) + 0.5) * self.cellSize.x,
+            .z = self.origin.y + (@as(f32, @floatFromInt(bestZ)) + 0.5) * self.cellSize.y,
+        };
+    }
+
+    /// Central-difference gradient of `layer` at world position (`x`, `z`), per world unit. Points uphill.
+    pub fn gradient(self: InfluenceMap, layer: Layer, player: usize, x: f32, z: f32) Vec2(f32) {
+        const cx = cellCoord(x, self.origin.x, self.cellSize.x, self.resolution.x);
+        const cz = cellCoord(z, self.origin.y, self.cellSize.y, self.resolution.y);
+        const x0 = if (cx > 0) cx - 1 else cx;
+        const x1 = @min(cx + 1, self.resolution.x - 1);
+        const z0 = if (cz > 0) cz - 1 else cz;
+        const z1 = @min(cz + 1, self.resolution.y - 1);
+
+        const dx = self.cellValue(layer, player, x1, cz) - self.cellValue(layer, player, x0, cz);
+        const dz = self.cellValue(layer, player, cx, z1) - self.cellValue(layer, player, cx, z0);
+        return .{
+            .x = if (x1 > x0) dx / (@as(f32, @floatFromInt(x1 - x0)) * self.cellSize.x) else 0,
+            .y = if (z1 > z0) dz / (@as(f32, @floatFromInt(z1 - z0)) * self.cellSize.y) else 0,
+        };
+    }
+};
+
+/// Grid coordinate of `v` along one axis, clamped to [0, resolution)
+fn cellCoord(v: f32, origin: f32, cellSize: f32, resolution: usize) usize {
+    const f = @floor((v - origin) / cellSize);
+    if (!(f > 0)) return 0; // also catches NaN
+    return @min(@as(usize, @intFromFloat(@min(f, 1e9))), resolution - 1);
+}
@@ -0,0 +1,117 @@
+const std = @import("std");
+const scratch_arena = @import("utils/scratch.zig");
+const mesh_import = @import("mesh/import_files.zig");
+const generate = @import("mesh/generate.zig");
+
+const PHMesh = @import("mesh/processing.zig").PlaceHolderMesh;
+
+// Round trip of generated meshes through the binary PLY loader. Every mesh is written with `writePly` and `writeObj`,
+// loaded back through `importPHMeshAlloc` and the PLY result must match the original bit for bit: counts, positions,
+// normals, texcoords and indices. Load times of both formats are reported, OBJ as the text baseline.
+//
+// usage: Zune_rts_bench_import [directory for the temporary files]
+
+const BenchError = error{RoundTripMismatch};
+
+const Source = struct { shape: generate.Shape, triangles: usize };
+const sources = [_]Source{
+    .{ .shape = .terrain, .triangles = 1 << 14 },
+    .{ .shape = .sphere, .triangles = 1 << 16 },
+    .{ .shape = .torus, .triangles = 1 << 16 },
+    .{ .shape = .terrain, .triangles = 1 << 20 },
+};
+const seed = 0x1A7;
+const loads = 5; // best of
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+    defer scratch_arena.deinitThreadScratch();
+
+    const args = try std.process.argsAlloc(allocator);
+    defer std.process.argsFree(allocator, args);
+    const directory = if (args.len > 1) args[1] else ".";
+
+    const plyPath = try std.fs.path.join(allocator, &.{ directory, "bench_import.ply" });
+    defer allocator.free(plyPath);
+    const objPath = try std.fs.path.join(allocator, &.{ directory, "bench_import.obj" });
+    defer allocator.free(objPath);
+    defer std.fs.cwd().deleteFile(plyPath) catch {};
+    defer std.fs.cwd().deleteFile(objPath) catch {};
+
+    var lines: [sources.len][160]u8 = undefined;
+    var lineLens: [sources.len]usize = undefined;
+    for (sources, 0..) |source, s| {
+        var original = try generate.generate(allocator, source.shape, source.triangles, seed);
+        defer original.deinit();
+        try generate.writePly(original, plyPath);
+        try generate.writeObj(original, objPath);
+        const plyBytes = (try std.fs.cwd().statFile(plyPath)).size;
+
+        // ----- binary round trip, checked on every load -----
+        var plyNs: u64 = std.math.maxInt(u64);
+        for (0..loads) |_| {
+            var timer = try std.time.Timer.start();
+            var loaded = try mesh_import.importPHMeshAlloc(allocator, plyPath);
+            plyNs = @min(plyNs, timer.read());
+            defer loaded.deinit();
+            try compare(original, loaded, source);
+        }
+
+        // ----- text baseline -----
+        var objNs: u64 = std.math.maxInt(u64);
+        for (0..loads) |_| {
+            var timer = try std.time.Timer.start();
+            var loaded = try mesh_import.importPHMeshAlloc(allocator, objPath);
+            objNs = @min(objNs, timer.read());
+            loaded.deinit();
+        }
+
+        // ----- the importers log while loading, the table comes after -----
+        const line = try std.fmt.bufPrint(&lines[s], "{s:>8} {:>10} {:>10} {d:>10.1} {d:>10.2} {d:>10.2} {d:>8.1}", .{
+            @tagName(source.shape),
+            original.vertexCount,
+            original.triangleCount,
+            @as(f64, @floatFromInt(plyBytes)) / (1 << 20),
+            ms(plyNs),
+            ms(objNs),
+            ms(objNs) / @max(ms(plyNs), 1e-6),
+        });
+        lineLens[s] = line.len;
+    }
+
+    std.debug.print("\n===== Import: PLY round trip, best of {} loads =====\n", .{loads});
+    std.debug.print("{s:>8} {s:>10} {s:>10} {s:>10} {s:>10} {s:>10} {s:>8}\n", .{ "mesh", "vertices", "triangles", "ply MiB", "ply ms", "obj ms", "speedup" });
+    for (lines, lineLens) |line, len| std.debug.print("{s}\n", .{line[0..len]});
+}
+
+/// Loaded PLY must reproduce every attribute of `original` exactly
+fn compare(original: PHMesh, loaded: PHMesh, source: Source) !void {
+    const same = original.vertexCount == loaded.vertexCount and
+        original.triangleCount == loaded.triangleCount and
+        std.mem.eql(u32, original.indices, loaded.indices) and
+        bitEqual(original.vertices, loaded.vertices) and
+        bitEqual(original.normals, loaded.normals) and
+        bitEqual(original.texcoords, loaded.texcoords);
+    if (same) return;
+
+    std.debug.print("{s}-{}: PLY round trip differs, {}/{} vertices and {}/{} triangles (original/loaded)\n", .{
+        @tagName(source.shape),
+        source.triangles,
+        original.vertexCount,
+        loaded.vertexCount,
+        original.triangleCount,
+        loaded.triangleCount,
+    });
+    return BenchError.RoundTripMismatch;
+}
+
+/// Equal bit patterns, such that NaN payloads and signed zeros count too
+fn bitEqual(a: []const f32, b: []const f32) bool {
+    return std.mem.eql(u8, std.mem.sliceAsBytes(a), std.mem.sliceAsBytes(b));
+}
+
+fn ms(ns: u64) f64 {
+    return @as(f64, @floatFromInt(ns)) / std.time.ns_per_ms;
+}
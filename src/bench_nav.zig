@@ -0,0 +1,181 @@
+const std = @import("std");
+const scratch_arena = @import("utils/scratch.zig");
+const mesh_import = @import("mesh/import_files.zig");
+
+const MN = @import("globals.zig");
+
+const cost_grid = @import("nav/cost_grid.zig");
+const CostGrid = cost_grid.CostGrid;
+const flow_field = @import("nav/flow_field.zig");
+const FlowField = flow_field.FlowField;
+const FlowFieldCache = flow_field.FlowFieldCache;
+const Hpa = @import("nav/hpa.zig").Hpa;
+const navmesh = @import("nav/navmesh.zig");
+const NavMesh = navmesh.NavMesh;
+const Vec3 = @import("math.zig").vec3;
+
+// Navigation throughput on the first map at several nav grid resolutions. Flow fields: full builds, repairs after a
+// single cost change and the cost of steering a group of units by one field. HPA*: cluster build time and long
+// path queries between random cells. Navmesh: polygon count and funnel path queries on the raw and the simplified map,
+// failing if a straightened path leaves its polygon corridor.
+//
+// usage: Zune_rts_bench_nav [fields per resolution]
+
+const BenchError = error{PathLeftCorridor};
+
+const units = 500;
+const pathQueries = 256;
+const corridorSamples = 16; // points checked per path segment
+const corridorTolerance = 1e-3; // allowed distance outside the corridor, fraction of the simplification error
+const cellsPerChunk = [_]usize{ 4, 8, 16, 32 };
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+    defer scratch_arena.deinitThreadScratch();
+
+    const args = try std.process.argsAlloc(allocator);
+    defer std.process.argsFree(allocator, args);
+    const fieldCount = if (args.len > 1) try std.fmt.parseInt(usize, args[1], 10) else 32;
+
+    var mesh = try mesh_import.importPHMeshAlloc(allocator, MN.MAP_MESHES[0]);
+    defer mesh.deinit();
+
+    std.debug.print("\n===== Navigation: {s} =====\n", .{MN.MAP_NAMES[0]});
+    std.debug.print("{s:>10} {s:>10} {s:>12} {s:>12} {s:>14} {s:>12} {s:>12}\n", .{ "grid", "cells", "builds/s", "repairs/s", "steer us/unit", "hpa build ms", "hpa path us" });
+
+    var rng = std.Random.DefaultPrng.init(0xF10);
+    const random = rng.random();
+
+    for (cellsPerChunk) |cells| {
+        var grid = try CostGrid.fromMesh(allocator, mesh, MN.MAP_CHUNKING[0], cells, MN.MAX_WALKABLE_SLOPE);
+        defer grid.deinit();
+
+        const goals = try allocator.alloc(u32, fieldCount);
+        defer allocator.free(goals);
+        for (goals) |*goal| goal.* = randomOpenCell(&grid, random);
+
+        // ----- full builds -----
+        var field = try FlowField.init(allocator, &grid);
+        defer field.deinit();
+        var timer = try std.time.Timer.start();
+        for (goals) |goal| try field.build(&grid, goal);
+        const buildNs = timer.lap();
+
+        // ----- single-cell changes, repaired through the cache -----
+        var cache = try FlowFieldCache.init(allocator, &grid, MN.FLOW_FIELD_CACHE_SIZE);
+        defer cache.deinit();
+        _ = try cache.get(goals[0]);
+        _ = timer.lap();
+        for (0..fieldCount) |_| {
+            const cell = randomOpenCell(&grid, random);
+            // ----- always a different cost, setCost returns early on unchanged cells -----
+            try grid.setCost(cell, if (grid.cost(cell) == MN.FLOW_BENCH_OBSTACLE_COST) 1 else MN.FLOW_BENCH_OBSTACLE_COST);
+            _ = try cache.get(goals[0]);
+        }
+        const repairNs = timer.lap();
+
+        // ----- one field steering a group -----
+        const steered = try cache.get(goals[0]);
+        var sum: f32 = 0;
+        _ = timer.lap();
+        for (0..units) |_| {
+            const p = grid.cellCenter(randomOpenCell(&grid, random));
+            const dir = steered.flowAt(&grid, p.x, p.z);
+            sum += dir.x + dir.y;
+        }
+        const steerNs = timer.lap();
+        std.mem.doNotOptimizeAway(sum);
+
+        // ----- hierarchical paths, clusters are the map chunks -----
+        var hpa = try Hpa.init(allocator, &grid);
+        defer hpa.deinit();
+        const hpaBuildNs = timer.lap();
+
+        var path = std.ArrayList(u32).init(allocator);
+        defer path.deinit();
+        for (0..pathQueries) |_| {
+            path.clearRetainingCapacity();
+            _ = try hpa.findPath(randomOpenCell(&grid, random), randomOpenCell(&grid, random), &path);
+        }
+        const pathNs = timer.lap();
+
+        var label: [32]u8 = undefined;
+        std.debug.print("{s:>10} {:>10} {d:>12.1} {d:>12.1} {d:>14.3} {d:>12.2} {d:>12.2}\n", .{
+            try std.fmt.bufPrint(&label, "{}x{}", .{ grid.resolution.x, grid.resolution.y }),
+            grid.cellCount(),
+            perSecond(fieldCount, buildNs),
+            perSecond(fieldCount, repairNs),
+            @as(f64, @floatFromInt(steerNs)) / units / std.time.ns_per_us,
+            @as(f64, @floatFromInt(hpaBuildNs)) / std.time.ns_per_ms,
+            @as(f64, @floatFromInt(pathNs)) / pathQueries / std.time.ns_per_us,
+        });
+    }
+
+    // ===== Navmesh, raw and QEM-simplified =====
+    std.debug.print("\n{s:>10} {s:>10} {s:>10} {s:>12} {s:>12} {s:>14}\n", .{ "navmesh", "triangles", "polygons", "build ms", "path us", "left corridor" });
+    const bb = mesh.getBoundingBox();
+    const extent = bb.max.subtract(bb.min);
+    const simplifyError = @max(extent.x, extent.y, extent.z) / 100;
+
+    for ([_]bool{ false, true }) |simplified| {
+        var navMeshSource = try mesh_import.importPHMeshAlloc(allocator, MN.MAP_MESHES[0]);
+        defer navMeshSource.deinit();
+
+        var timer = try std.time.Timer.start();
+        var nav = if (simplified)
+            try NavMesh.fromSimplified(allocator, &navMeshSource, simplifyError, MN.MAX_WALKABLE_SLOPE)
+        else
+            try NavMesh.build(allocator, &navMeshSource, MN.MAX_WALKABLE_SLOPE);
+        defer nav.deinit();
+        const buildNs = timer.lap();
+
+        var search = try navmesh.PathSearch.init(allocator, &nav);
+        defer search.deinit();
+        var points = std.ArrayList(Vec3(f32)).init(allocator);
+        defer points.deinit();
+        _ = timer.lap();
+        for (0..pathQueries) |_| {
+            points.clearRetainingCapacity();
+            _ = try nav.findPath(&search, randomPolygonCenter(&nav, random), randomPolygonCenter(&nav, random), &points);
+        }
+        const pathNs = timer.lap();
+
+        // ----- untimed: straightened paths must not leave their polygon corridor -----
+        var leftCorridor: usize = 0;
+        for (0..pathQueries) |_| {
+            points.clearRetainingCapacity();
+            if (!try nav.findPath(&search, randomPolygonCenter(&nav, random), randomPolygonCenter(&nav, random), &points)) continue;
+            if (!nav.pathInCorridor(&search, points.items, corridorSamples, corridorTolerance * simplifyError)) leftCorridor += 1;
+        }
+
+        std.debug.print("{s:>10} {:>10} {:>10} {d:>12.2} {d:>12.2} {:>14}\n", .{
+            if (simplified) "simplified" else "raw",
+            navMeshSource.triangleCount,
+            nav.polygons.len,
+            @as(f64, @floatFromInt(buildNs)) / std.time.ns_per_ms,
+            @as(f64, @floatFromInt(pathNs)) / pathQueries / std.time.ns_per_us,
+            leftCorridor,
+        });
+        if (leftCorridor > 0) return BenchError.PathLeftCorridor;
+    }
+}
+
+fn perSecond(count: usize, ns: u64) f64 {
+    return @as(f64, @floatFromInt(count)) * std.time.ns_per_s / @as(f64, @floatFromInt(@max(ns, 1)));
+}
+
+/// Random walkable cell, any cell if there are few of them
+fn randomOpenCell(grid: *const CostGrid, random: std.Random) u32 {
+    var cell: u32 = 0;
+    for (0..64) |_| {
+        cell = random.uintLessThan(u32, @intCast(grid.cellCount()));
+        if (grid.cost(cell) != cost_grid.blocked) break;
+    }
+    return cell;
+}
+
+fn randomPolygonCenter(nav: *const NavMesh, random: std.Random) Vec3(f32) {
+    return nav.polygons[random.uintLessThan(usize, nav.polygons.len)].center;
+}
@@ -0,0 +1,275 @@
+const std = @import("std");
+const math = @import("math.zig");
+const scratch_arena = @import("utils/scratch.zig");
+
+const MN = @import("globals.zig");
+
+const sim_map = @import("world/sim_map.zig");
+const SimMap = sim_map.SimMap;
+const occlusion = @import("render/occlusion.zig");
+const HiZBuffer = occlusion.HiZBuffer;
+const TerrainOccluders = occlusion.TerrainOccluders;
+const BoundingBox = @import("mesh/processing.zig").BoundingBox;
+const bounding_volumes = @import("mesh/bounding_volumes.zig");
+const BoundingVolume = bounding_volumes.BoundingVolume;
+const Frustum = bounding_volumes.Frustum;
+
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+
+// Software occlusion culling without a window. A synthetic ridge scene checks that chunks behind the ridge are culled
+// and chunks in front of it never are. The first map is then viewed from low cameras around its center, reporting
+// culled chunks and units and the cost of a pass. Last, frustum culling of the map chunks with axis aligned boxes is
+// compared with the fitted volumes, counting chunks reported visible although none of their points is. A volume
+// culling a chunk with a visible point fails the run.
+//
+// usage: Zune_rts_bench_occlusion [units]
+
+const BenchError = error{OcclusionCheckFailed};
+
+const cameraPoses = 8;
+const unitSize = 0.5;
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+    defer scratch_arena.deinitThreadScratch();
+
+    const args = try std.process.argsAlloc(allocator);
+    defer std.process.argsFree(allocator, args);
+    const unitCount = if (args.len > 1) try std.fmt.parseInt(usize, args[1], 10) else 2000;
+
+    var buffer = try HiZBuffer.init(allocator, MN.OCCLUSION_WIDTH, MN.OCCLUSION_HEIGHT);
+    defer buffer.deinit();
+    const projection = math.mat4Perspective(MN.CAMERA_FOV, @as(f32, @floatFromInt(MN.OCCLUSION_WIDTH)) / @as(f32, @floatFromInt(MN.OCCLUSION_HEIGHT)), MN.CAMERA_NEAR, MN.CAMERA_FAR);
+
+    try ridgeScene(allocator, &buffer, projection);
+
+    // ===== First map, cameras circling the center =====
+    var map = try SimMap.init(allocator, MN.MAP_MESHES[0], MN.MAP_CHUNKING[0], MN.NAV_CELLS_PER_CHUNK);
+    defer map.deinit();
+    var occluders = try TerrainOccluders.fromSimMap(allocator, &map, MN.OCCLUDER_QUADS_PER_CHUNK);
+    defer occluders.deinit();
+
+    // ----- chunk bounds first, then units standing on the terrain -----
+    const boxes = try allocator.alloc(BoundingBox, map.chunkBounds.len + unitCount);
+    defer allocator.free(boxes);
+    const visibility = try allocator.alloc(occlusion.Visibility, boxes.len);
+    defer allocator.free(visibility);
+    for (map.chunkBounds, 0..) |bounds, i| boxes[i] = bounds.toBoundingBox();
+    var rng = std.Random.DefaultPrng.init(0x0CC);
+    const random = rng.random();
+    for (boxes[map.chunkBounds.len..]) |*box| {
+        const x = map.origin.x + random.float(f32) * map.extent.x;
+        const z = map.origin.z + random.float(f32) * map.extent.z;
+        const y = map.heightAt(x, z);
+        box.* = .{ .min = .{ .x = x - unitSize, .y = y, .z = z - unitSize }, .max = .{ .x = x + unitSize, .y = y + 2 * unitSize, .z = z + unitSize } };
+    }
+
+    std.debug.print("\n===== Occlusion: {s}, {} chunks, {} units, {}x{} depth =====\n", .{ MN.MAP_NAMES[0], map.chunkBounds.len, unitCount, buffer.width, buffer.height });
+    std.debug.print("{s:>6} {s:>10} {s:>10} {s:>10} {s:>10} {s:>10} {s:>10}\n", .{ "pose", "triangles", "culled %", "raster us", "pyramid us", "test us", "pass us" });
+
+    for (0..cameraPoses) |pose| {
+        const eye = cameraEye(&map, pose);
+        try buffer.begin(math.mat4Multiply(projection, cameraView(&map, eye)));
+        occluders.draw(&buffer, eye, MN.OCCLUDER_CHUNKS);
+        buffer.buildPyramid();
+        buffer.testBoxes(boxes, visibility);
+
+        const stats = buffer.stats;
+        std.debug.print("{:>6} {:>10} {d:>10.1} {d:>10.1} {d:>10.1} {d:>10.1} {d:>10.1}\n", .{
+            pose,
+            stats.occluderTriangles,
+            stats.culledPercent(),
+            @as(f64, @floatFromInt(stats.rasterNs)) / std.time.ns_per_us,
+            @as(f64, @floatFromInt(stats.pyramidNs)) / std.time.ns_per_us,
+            @as(f64, @floatFromInt(stats.testNs)) / std.time.ns_per_us,
+            @as(f64, @floatFromInt(stats.passNs())) / std.time.ns_per_us,
+        });
+    }
+
+    try frustumScene(allocator, &map, projection);
+}
+
+fn cameraEye(map: *const SimMap, pose: usize) Vec3(f32) {
+    const center = map.origin.add(map.extent.scale(0.5));
+    const radius = @max(map.extent.x, map.extent.z) * 0.45;
+    const angle = @as(f32, @floatFromInt(pose)) / cameraPoses * std.math.tau;
+    const eyeX = center.x + @cos(angle) * radius;
+    const eyeZ = center.z + @sin(angle) * radius;
+    return .{ .x = eyeX, .y = map.heightAt(eyeX, eyeZ) + map.extent.y * 0.1, .z = eyeZ };
+}
+
+/// Look from `eye` at the terrain under the map center
+fn cameraView(map: *const SimMap, eye: Vec3(f32)) [16]f32 {
+    const center = map.origin.add(map.extent.scale(0.5));
+    const target = Vec3(f32){ .x = center.x, .y = map.heightAt(center.x, center.z), .z = center.z };
+    return math.mat4LookAt(eye, target, .{ .y = 1 });
+}
+
+/// Frustum culling of the map chunks, axis aligned boxes against the fitted volumes. Every chunk is sampled at its
+/// cell centers; a chunk counts as truly visible when one of its samples lies inside the frustum.
+fn frustumScene(allocator: Allocator, map: *const SimMap, projection: [16]f32) !void {
+    const chunkCount = map.chunking.x * map.chunking.y;
+    const cellsX = map.resolution.x / map.chunking.x;
+    const cellsZ = map.resolution.y / map.chunking.y;
+
+    const points = try allocator.alloc(f32, chunkCount * cellsX * cellsZ * 3);
+    defer allocator.free(points);
+    const volumes = try allocator.alloc(BoundingVolume, chunkCount);
+    defer allocator.free(volumes);
+
+    // ----- cell centers of every chunk, chunk after chunk -----
+    var kinds = [_]usize{0} ** @typeInfo(bounding_volumes.VolumeKind).@"enum".fields.len;
+    for (0..map.chunking.y) |cz| {
+        for (0..map.chunking.x) |cx| {
+            const chunk = cz * map.chunking.x + cx;
+            const chunkPoints = points[chunk * cellsX * cellsZ * 3 ..][0 .. cellsX * cellsZ * 3];
+            var k: usize = 0;
+            for (cz * cellsZ..(cz + 1) * cellsZ) |z| {
+                for (cx * cellsX..(cx + 1) * cellsX) |x| {
+                    chunkPoints[k..][0..3].* = .{
+                        map.origin.x + (@as(f32, @floatFromInt(x)) + 0.5) * map.cellSize.x,
+                        map.heights[z * map.resolution.x + x],
+                        map.origin.z + (@as(f32, @floatFromInt(z)) + 0.5) * map.cellSize.y,
+                    };
+                    k += 3;
+                }
+            }
+            volumes[chunk] = BoundingVolume.fromPoints(chunkPoints);
+            kinds[@intFromEnum(volumes[chunk].kind)] += 1;
+        }
+    }
+
+    std.debug.print("\n===== Frustum culling: {} chunks, {} spheres, {} boxes, {} oriented boxes =====\n", .{ chunkCount, kinds[0], kinds[1], kinds[2] });
+    std.debug.print("{s:>6} {s:>10} {s:>10} {s:>10} {s:>10} {s:>10}\n", .{ "pose", "visible", "box", "box fp %", "fitted", "fitted fp %" });
+
+    var boxFalseTotal: usize = 0;
+    var fittedFalseTotal: usize = 0;
+    var hiddenTotal: usize = 0;
+    var missedTotal: usize = 0; // truly visible chunks a volume culled
+    for (0..cameraPoses) |pose| {
+        const frustum = Frustum.fromViewProjection(math.mat4Multiply(projection, cameraView(map, cameraEye(map, pose))));
+
+        var visible: usize = 0;
+        var boxVisible: usize = 0;
+        var fittedVisible: usize = 0;
+        var boxFalse: usize = 0;
+        var fittedFalse: usize = 0;
+        for (volumes, 0..) |volume, chunk| {
+            const chunkPoints = points[chunk * cellsX * cellsZ * 3 ..][0 .. cellsX * cellsZ * 3];
+            var truth = false;
+            var k: usize = 0;
+            while (!truth and k < chunkPoints.len) : (k += 3) truth = frustum.containsPoint(chunkPoints[k..][0..3].*);
+
+            const inBox = frustum.intersectsBox(volume.box);
+            const inFitted = frustum.intersects(volume);
+            if (truth) visible += 1;
+            if (inBox) boxVisible += 1;
+            if (inFitted) fittedVisible += 1;
+
+            // ----- false positives counted per chunk, culling a visible chunk is a bug -----
+            if (!truth and inBox) boxFalse += 1;
+            if (!truth and inFitted) fittedFalse += 1;
+            if (truth and (!inBox or !inFitted)) {
+                std.debug.print("pose {}: chunk {} is visible but culled (box {}, fitted {} as {s})\n", .{ pose, chunk, inBox, inFitted, @tagName(volume.kind) });
+                missedTotal += 1;
+            }
+        }
+        const hidden = chunkCount - visible;
+        hiddenTotal += hidden;
+        boxFalseTotal += boxFalse;
+        fittedFalseTotal += fittedFalse;
+        std.debug.print("{:>6} {:>10} {:>10} {d:>10.1} {:>10} {d:>10.1}\n", .{
+            pose,
+            visible,
+            boxVisible,
+            falsePercent(boxFalse, hidden),
+            fittedVisible,
+            falsePercent(fittedFalse, hidden),
+        });
+    }
+    std.debug.print("false positive rate: box {d:.1}%, fitted {d:.1}%\n", .{ falsePercent(boxFalseTotal, hiddenTotal), falsePercent(fittedFalseTotal, hiddenTotal) });
+    if (missedTotal > 0) return BenchError.OcclusionCheckFailed;
+}
+
+/// Share of the chunks outside the frustum which were reported visible
+fn falsePercent(falseVisible: usize, hidden: usize) f64 {
+    if (hidden == 0) return 0;
+    return @as(f64, @floatFromInt(falseVisible)) / @as(f64, @floatFromInt(hidden)) * 100;
+}
+
+/// Flat ground with a ridge across the middle, camera low in front of it looking across. Every chunk entirely behind
+/// the ridge must be occluded, no chunk entirely in front of it may be.
+fn ridgeScene(allocator: Allocator, buffer: *HiZBuffer, projection: [16]f32) !void {
+    const chunks = 8;
+    const cellsPerChunk = 16;
+    const size: f32 = 128;
+    const ridgeZ: f32 = 64;
+    const res = chunks * cellsPerChunk;
+
+    const heights = try allocator.alloc(f32, res * res);
+    const walkable = try allocator.alloc(bool, res * res);
+    const chunkBounds = try allocator.alloc(sim_map.ChunkBounds, chunks * chunks);
+    var map = SimMap{
+        .backing = .{ .owned = allocator },
+        .origin = .{},
+        .extent = .{ .x = size, .y = 20, .z = size },
+        .chunking = .{ .x = chunks, .y = chunks },
+        .chunkSize = .{ .x = size / chunks, .y = size / chunks },
+        .resolution = .{ .x = res, .y = res },
+        .cellSize = .{ .x = size / res, .y = size / res },
+        .heights = heights,
+        .walkable = walkable,
+        .chunkBounds = chunkBounds,
+    };
+    defer map.deinit();
+
+    @memset(walkable, true);
+    for (0..res) |z| {
+        const d = ((@as(f32, @floatFromInt(z)) + 0.5) * map.cellSize.y - ridgeZ) / 6;
+        @memset(heights[z * res ..][0..res], 20 * @exp(-d * d));
+    }
+    for (0..chunks) |cz| {
+        for (0..chunks) |cx| {
+            var maxY: f32 = 0;
+            for (cz * cellsPerChunk..(cz + 1) * cellsPerChunk) |z| maxY = @max(maxY, heights[z * res]);
+            const fx: f32 = @floatFromInt(cx);
+            const fz: f32 = @floatFromInt(cz);
+            chunkBounds[cz * chunks + cx] = .{
+                .min = .{ fx * map.chunkSize.x, 0, fz * map.chunkSize.y },
+                .max = .{ (fx + 1) * map.chunkSize.x, maxY, (fz + 1) * map.chunkSize.y },
+            };
+        }
+    }
+
+    var occluders = try TerrainOccluders.fromSimMap(allocator, &map, MN.OCCLUDER_QUADS_PER_CHUNK);
+    defer occluders.deinit();
+
+    const eye = Vec3(f32){ .x = size / 2, .y = 3, .z = 8 };
+    try buffer.begin(math.mat4Multiply(projection, math.mat4LookAt(eye, .{ .x = size / 2, .y = 3, .z = size }, .{ .y = 1 })));
+    occluders.draw(buffer, eye, chunks * chunks);
+    buffer.buildPyramid();
+
+    // ----- only chunks the camera looks at: in front of the eye and within the horizontal field of view -----
+    var hidden: usize = 0;
+    var hiddenCulled: usize = 0;
+    var front: usize = 0;
+    var frontCulled: usize = 0;
+    for (chunkBounds) |bounds| {
+        const box = bounds.toBoundingBox();
+        const visibility = buffer.testBox(box.min, box.max);
+        if (visibility == .outside) continue;
+        if (box.min.z >= ridgeZ + 16) {
+            hidden += 1;
+            if (visibility == .occluded) hiddenCulled += 1;
+        } else if (box.max.z <= ridgeZ - 16 and box.min.z > eye.z) {
+            front += 1;
+            if (visibility == .occluded) frontCulled += 1;
+        }
+    }
+    std.debug.print("\n===== Occlusion: synthetic ridge =====\n", .{});
+    std.debug.print("chunks behind ridge culled: {}/{}, chunks in front culled: {}/{}\n", .{ hiddenCulled, hidden, frontCulled, front });
+    if (frontCulled != 0 or hiddenCulled != hidden) return BenchError.OcclusionCheckFailed;
+}
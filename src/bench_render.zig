@@ -0,0 +1,132 @@
+const std = @import("std");
+const MN = @import("globals.zig");
+const FrameArena = @import("utils/frame_arena.zig").FrameArena;
+
+const render_queue = @import("render/render_queue.zig");
+const MockBackend = render_queue.MockBackend;
+const RenderQueue = render_queue.RenderQueue(MockBackend);
+const Pass = render_queue.Pass;
+
+// Render queue against a mock backend, without a window. Draws of a synthetic scene are recorded in random order, as
+// ECS queries would visit them, then sorted and batched. The submitted calls are checked for order and completeness,
+// and draw calls and state changes are compared with drawing every entity in record order.
+//
+// usage: Zune_rts_bench_render [draws]
+
+const BenchError = error{RenderQueueCheckFailed};
+
+const materialCount = 12;
+const meshCount = 40;
+const frames = 16;
+
+const Draw = struct {
+    pass: Pass,
+    material: u32,
+    mesh: u32,
+    depth: f32,
+};
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    const args = try std.process.argsAlloc(allocator);
+    defer std.process.argsFree(allocator, args);
+    const drawCount = if (args.len > 1) try std.fmt.parseInt(usize, args[1], 10) else 20000;
+
+    // ----- meshes belong to one material, a few draws are transparent -----
+    const draws = try allocator.alloc(Draw, drawCount);
+    defer allocator.free(draws);
+    var rng = std.Random.DefaultPrng.init(0x5047);
+    const random = rng.random();
+    for (draws) |*draw| {
+        const mesh = random.uintLessThan(u32, meshCount);
+        draw.* = .{
+            .pass = if (random.uintLessThan(u32, 16) == 0) .transparent else .opaqueGeometry,
+            .material = mesh % materialCount,
+            .mesh = mesh,
+            .depth = MN.CAMERA_NEAR + random.float(f32) * 1000,
+        };
+    }
+
+    var queue = try RenderQueue.init(allocator);
+    defer queue.deinit();
+    var frameArena = FrameArena.init(allocator);
+    defer frameArena.deinit();
+    var backend = MockBackend.init(allocator);
+    defer backend.deinit();
+
+    var sortNs: u64 = 0;
+    var submitNs: u64 = 0;
+    for (0..frames) |_| {
+        backend.reset();
+        frameArena.reset(); // after the last frame the commands stay valid for `check`
+        try queue.begin(frameArena.allocator(), MN.CAMERA_NEAR, MN.CAMERA_FAR);
+        for (draws, 0..) |draw, i| try queue.record(draw.pass, draw.material, draw.mesh, tagged(i), draw.depth);
+        try queue.submit(&backend);
+        sortNs += queue.stats.sortNs;
+        submitNs += queue.stats.submitNs;
+    }
+    try check(draws, &queue, &backend);
+
+    // ----- record order: every draw is a call, every resource change a bind -----
+    var unsortedChanges: usize = 0;
+    for (draws, 0..) |draw, i| {
+        if (i == 0 or draw.material != draws[i - 1].material) unsortedChanges += 1;
+        if (i == 0 or draw.mesh != draws[i - 1].mesh) unsortedChanges += 1;
+    }
+
+    const stats = queue.stats;
+    std.debug.print("\n===== Render queue: {} draws, {} materials, {} meshes =====\n", .{ drawCount, materialCount, meshCount });
+    std.debug.print("{s:>12} {s:>12} {s:>14}\n", .{ "", "draw calls", "state changes" });
+    std.debug.print("{s:>12} {:>12} {:>14}\n", .{ "record order", drawCount, unsortedChanges });
+    std.debug.print("{s:>12} {:>12} {:>14}\n", .{ "sorted", stats.drawCalls, stats.stateChanges() });
+    std.debug.print("sort {d:.1} us, submit {d:.1} us per frame\n", .{
+        @as(f64, @floatFromInt(sortNs)) / frames / std.time.ns_per_us,
+        @as(f64, @floatFromInt(submitNs)) / frames / std.time.ns_per_us,
+    });
+}
+
+/// Transform carrying the draw index in its translation, to find the draw again behind the mock backend
+fn tagged(index: usize) [16]f32 {
+    var m = [_]f32{0} ** 16;
+    m[0] = 1;
+    m[5] = 1;
+    m[10] = 1;
+    m[15] = 1;
+    m[12] = @floatFromInt(index);
+    return m;
+}
+
+/// Every draw submitted once, with its own material and mesh, passes in order, depth sorted within a batch key and
+/// transparent draws back to front across materials
+fn check(draws: []const Draw, queue: *const RenderQueue, backend: *const MockBackend) !void {
+    var instances: usize = 0;
+    var previousKey: u64 = 0;
+    for (backend.calls.items) |call| {
+        const draw = draws[@as(usize, @intFromFloat(call.firstTransform[12]))];
+        if (draw.material != call.material or draw.mesh != call.mesh) return BenchError.RenderQueueCheckFailed;
+        if (call.instances == 0 or call.instances > MN.RENDER_MAX_INSTANCES) return BenchError.RenderQueueCheckFailed;
+        instances += call.instances;
+    }
+    if (instances != draws.len or backend.calls.items.len != queue.stats.drawCalls) return BenchError.RenderQueueCheckFailed;
+
+    var transparentCount: usize = 0;
+    var previousDepth = std.math.inf(f32);
+    for (queue.commands.items) |command| {
+        if (command.key < previousKey) return BenchError.RenderQueueCheckFailed;
+        previousKey = command.key;
+
+        const draw = draws[@as(usize, @intFromFloat(queue.transforms.items[command.instance][12]))];
+        if (draw.pass != render_queue.keyPass(command.key)) return BenchError.RenderQueueCheckFailed;
+        if (draw.pass != .transparent) continue;
+        transparentCount += 1;
+        if (draw.depth > previousDepth + (MN.CAMERA_FAR - MN.CAMERA_NEAR) / (1 << 24)) return BenchError.RenderQueueCheckFailed; // within quantization
+        previousDepth = draw.depth;
+    }
+
+    // ----- opaque state changes are bounded by the distinct resources, transparent ones by the draws -----
+    if (queue.stats.materialChanges > materialCount + transparentCount or queue.stats.meshChanges > meshCount + transparentCount) return BenchError.RenderQueueCheckFailed;
+    std.debug.print("\n===== Render queue: mock backend check passed, {} calls =====\n", .{backend.calls.items.len});
+}
@@ -0,0 +1,159 @@
+const std = @import("std");
+const math = @import("math.zig");
+
+const MN = @import("globals.zig");
+
+const selection = @import("ui/selection.zig");
+const Selection = selection.Selection;
+
+const Vec2 = math.vec2;
+const Vec3 = math.vec3;
+
+// Drag selection of units spread in front of and behind a camera. Every iteration projects all units and selects
+// once with a rectangle and once with a convex lasso, timed through `lastProjectNs` and `lastSelectNs`. Selections
+// are compared with a scalar reference, the median of project + select has to stay within the frame budget.
+//
+// usage: Zune_rts_bench_selection [units]
+
+const BenchError = error{ SelectionMismatch, OverBudget };
+
+const iterations = 1000;
+const budgetNs = 100 * std.time.ns_per_us; // project + select
+const lassoCorners = 12;
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    const allocator = gpa.allocator();
+
+    const args = try std.process.argsAlloc(allocator);
+    defer std.process.argsFree(allocator, args);
+    const unitCount = if (args.len > 1) try std.fmt.parseInt(usize, args[1], 10) else 10_000;
+
+    // ----- units around a camera on the ground, about a tenth of them behind it -----
+    var rng = std.Random.DefaultPrng.init(0x5E1);
+    const random = rng.random();
+    const positions = try allocator.alloc(Vec3(f32), unitCount);
+    defer allocator.free(positions);
+    for (positions) |*p| p.* = .{
+        .x = (random.float(f32) - 0.5) * 200,
+        .y = random.float(f32) * 2,
+        .z = 20 - random.float(f32) * 220,
+    };
+    const w: f32 = MN.WINDOW_WIDTH;
+    const h: f32 = MN.WINDOW_HEIGHT;
+    const eye = Vec3(f32){ .x = 0, .y = 40, .z = 0 };
+    const view = math.mat4LookAt(eye, .{ .x = 0, .y = 0, .z = -60 }, .{ .y = 1 });
+    const viewProjection = math.mat4Multiply(math.mat4Perspective(MN.CAMERA_FOV, w / h, MN.CAMERA_NEAR, MN.CAMERA_FAR), view);
+
+    // ----- drag from pixels, like the game -----
+    const rectA = Selection.ndcFromPixels(w * 0.2, h * 0.3, w, h);
+    const rectB = Selection.ndcFromPixels(w * 0.7, h * 0.8, w, h);
+    var lasso: [lassoCorners]Vec2(f32) = undefined;
+    for (&lasso, 0..) |*corner, k| {
+        const angle = @as(f32, @floatFromInt(k)) * 2 * std.math.pi / lassoCorners;
+        corner.* = .{ .x = 0.1 + 0.4 * @cos(angle), .y = -0.1 + 0.5 * @sin(angle) };
+    }
+
+    var sel = Selection.init(allocator);
+    defer sel.deinit();
+    try sel.reserve(unitCount);
+    var out = try std.ArrayList(u32).initCapacity(allocator, unitCount);
+    defer out.deinit();
+
+    // ----- reference selections -----
+    const expectedRect = try reference(allocator, viewProjection, positions, .{ .rect = .{ rectA, rectB } });
+    defer allocator.free(expectedRect);
+    const expectedLasso = try reference(allocator, viewProjection, positions, .{ .lasso = &lasso });
+    defer allocator.free(expectedLasso);
+
+    const rectNs = try allocator.alloc(u64, iterations);
+    defer allocator.free(rectNs);
+    const lassoNs = try allocator.alloc(u64, iterations);
+    defer allocator.free(lassoNs);
+
+    for (rectNs, lassoNs) |*rectTime, *lassoTime| {
+        out.clearRetainingCapacity();
+        try sel.project(viewProjection, positions);
+        try sel.selectRect(rectA, rectB, &out);
+        rectTime.* = sel.lastProjectNs + sel.lastSelectNs;
+        if (!std.mem.eql(u32, out.items, expectedRect)) return fail("rect", out.items.len, expectedRect.len);
+
+        out.clearRetainingCapacity();
+        try sel.project(viewProjection, positions);
+        try sel.selectLasso(&lasso, &out);
+        lassoTime.* = sel.lastProjectNs + sel.lastSelectNs;
+        if (!std.mem.eql(u32, out.items, expectedLasso)) return fail("lasso", out.items.len, expectedLasso.len);
+    }
+
+    std.debug.print("\n===== Selection: {} units, {} iterations, budget {} us =====\n", .{ unitCount, iterations, budgetNs / std.time.ns_per_us });
+    std.debug.print("{s:>6} {s:>10} {s:>10} {s:>10} {s:>10}\n", .{ "shape", "selected", "median us", "p99 us", "max us" });
+    const rectMedian = report("rect", expectedRect.len, rectNs);
+    const lassoMedian = report("lasso", expectedLasso.len, lassoNs);
+    if (rectMedian > budgetNs or lassoMedian > budgetNs) {
+        std.debug.print("Median above the budget\n", .{});
+        return BenchError.OverBudget;
+    }
+}
+
+const Shape = union(enum) {
+    rect: [2]Vec2(f32),
+    lasso: []const Vec2(f32),
+};
+
+/// Indices of the units inside `shape`, one unit at a time with the same arithmetic as `Selection`
+fn reference(allocator: std.mem.Allocator, viewProjection: [16]f32, positions: []const Vec3(f32), shape: Shape) ![]u32 {
+    var result = std.ArrayList(u32).init(allocator);
+    errdefer result.deinit();
+    const M = viewProjection;
+    for (positions, 0..) |p, i| {
+        const cw = M[3] * p.x + M[7] * p.y + M[11] * p.z + M[15];
+        if (!(cw > 0)) continue;
+        const x = (M[0] * p.x + M[4] * p.y + M[8] * p.z + M[12]) / cw;
+        const y = (M[1] * p.x + M[5] * p.y + M[9] * p.z + M[13]) / cw;
+
+        const inside = switch (shape) {
+            .rect => |r| x >= @min(r[0].x, r[1].x) and x <= @max(r[0].x, r[1].x) and y >= @min(r[0].y, r[1].y) and y <= @max(r[0].y, r[1].y),
+            .lasso => |l| inLasso(l, x, y),
+        };
+        if (inside) try result.append(@intCast(i));
+    }
+    return result.toOwnedSlice();
+}
+
+fn inLasso(lasso: []const Vec2(f32), x: f32, y: f32) bool {
+    var area2: f32 = 0;
+    for (lasso, 0..) |p, k| {
+        const q = lasso[(k + 1) % lasso.len];
+        area2 += p.x * q.y - q.x * p.y;
+    }
+    const sign: f32 = if (area2 > 0) 1 else -1;
+    for (lasso, 0..) |p, k| {
+        const q = lasso[(k + 1) % lasso.len];
+        const nx = -(q.y - p.y) * sign;
+        const ny = (q.x - p.x) * sign;
+        const c = -(nx * p.x + ny * p.y);
+        if (!(nx * x + ny * y + c >= 0)) return false;
+    }
+    return true;
+}
+
+fn fail(shape: []const u8, selected: usize, expected: usize) BenchError {
+    std.debug.print("{s} selection differs from the reference: {} units selected, {} expected\n", .{ shape, selected, expected });
+    return BenchError.SelectionMismatch;
+}
+
+/// Print a line of the table, returns the median
+fn report(shape: []const u8, selected: usize, times: []u64) u64 {
+    std.mem.sort(u64, times, {}, std.sort.asc(u64));
+    const median = times[times.len / 2];
+    const us = @as(f64, std.time.ns_per_us);
+    std.debug.print("{s:>6} {:>10} {d:>10.2} {d:>10.2} {d:>10.2}\n", .{
+        shape,
+        selected,
+        @as(f64, @floatFromInt(median)) / us,
+        @as(f64, @floatFromInt(times[times.len * 99 / 100])) / us,
+        @as(f64, @floatFromInt(times[times.len - 1])) / us,
+    });
+    return median;
+}
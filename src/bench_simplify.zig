@@ -0,0 +1,286 @@
+const std = @import("std");
+const scratch_arena = @import("utils/scratch.zig");
+const tracking = @import("utils/tracking_allocator.zig");
+const mesh_import = @import("mesh/import_files.zig");
+const generate = @import("mesh/generate.zig");
+const mesh_simplification = @import("mesh/cuthulus_box.zig");
+
+const MN = @import("globals.zig");
+
+const PHMesh = @import("mesh/processing.zig").PlaceHolderMesh;
+const HalfEdges = mesh_simplification.HalfEdges;
+const SurfaceDistance = @import("mesh/surface_distance.zig").SurfaceDistance;
+
+// Simplifier curves over a matrix of meshes and error thresholds, so every change to `collapseMesh` is judged on the
+// same runs. Each run simplifies a fresh copy of the mesh and reports wall time per phase (half-edge construction,
+// quadric setup, collapsing), peak memory, triangles in and out, collapses per second and the surface distance to the
+// original, with the time the distance measurement took on `MN.DISTANCE_KERNEL_THREADS` threads. Thresholds are
+// fractions of the largest bounding box extent, like in bench-nav.
+//
+// Runs can be written as CSV and JSON. The JSON of an earlier run is read back with --baseline and compared per run.
+//
+// usage: Zune_rts_bench_simplify [--csv path] [--json path] [--baseline path] [--samples n]
+
+const BenchError = error{ UnknownArgument, MissingArgumentValue };
+
+const Source = union(enum) {
+    asset: usize, // index into MN.MAP_MESHES
+    generated: struct { shape: generate.Shape, triangles: usize },
+};
+
+const sources = [_]Source{
+    .{ .asset = 0 },
+    .{ .generated = .{ .shape = .terrain, .triangles = 1 << 14 } },
+    .{ .generated = .{ .shape = .terrain, .triangles = 1 << 18 } },
+    .{ .generated = .{ .shape = .terrain, .triangles = 1 << 21 } }, // surface distance target: under 1 s on all cores
+    .{ .generated = .{ .shape = .sphere, .triangles = 1 << 16 } },
+    .{ .generated = .{ .shape = .torus, .triangles = 1 << 16 } },
+    .{ .generated = .{ .shape = .degenerate, .triangles = 1 << 16 } },
+};
+const relativeThresholds = [_]f32{ 1e-4, 1e-3, 1e-2 };
+const seed = 0x5117;
+
+/// One simplification: a line of the CSV, an element of the JSON array
+const Run = struct {
+    mesh: []const u8,
+    threshold: f32, // fraction of the largest extent
+    status: []const u8, // "ok" or the error which ended the run
+    trianglesIn: u32 = 0,
+    trianglesOut: u32 = 0,
+    collapses: u32 = 0,
+    halfEdgeMs: f64 = 0,
+    quadricMs: f64 = 0,
+    collapseMs: f64 = 0, // including the write back to the mesh
+    totalMs: f64 = 0,
+    collapsesPerSecond: f64 = 0,
+    peakBytes: usize = 0, // above the two meshes, scratch included
+    hausdorff: f32 = 0,
+    rms: f32 = 0,
+    quadric: f32 = 0,
+    distanceMs: f64 = 0, // surface distance measurement, all kernel threads
+};
+
+const Options = struct {
+    csv: ?[]const u8 = null,
+    json: ?[]const u8 = null,
+    baseline: ?[]const u8 = null,
+    samples: usize = MN.DISTANCE_SAMPLES,
+
+    fn parse(args: []const [:0]u8) !Options {
+        var options = Options{};
+        var i: usize = 1;
+        while (i < args.len) : (i += 2) {
+            if (i + 1 >= args.len) return BenchError.MissingArgumentValue;
+            const value = args[i + 1];
+            if (std.mem.eql(u8, args[i], "--csv")) {
+                options.csv = value;
+            } else if (std.mem.eql(u8, args[i], "--json")) {
+                options.json = value;
+            } else if (std.mem.eql(u8, args[i], "--baseline")) {
+                options.baseline = value;
+            } else if (std.mem.eql(u8, args[i], "--samples")) {
+                options.samples = try std.fmt.parseInt(usize, value, 10);
+            } else return BenchError.UnknownArgument;
+        }
+        return options;
+    }
+};
+
+pub fn main() !void {
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+    var tracker = try tracking.TrackingAllocator.init(gpa.allocator(), .{});
+    defer tracker.deinit();
+    const allocator = tracker.allocator();
+    defer scratch_arena.deinitThreadScratch();
+
+    var arena = std.heap.ArenaAllocator.init(gpa.allocator()); // labels, runs and baseline
+    defer arena.deinit();
+    const results = arena.allocator();
+
+    const args = try std.process.argsAlloc(results);
+    const options = try Options.parse(args);
+
+    var runs = std.ArrayList(Run).init(results);
+    for (sources) |source| {
+        const label = try sourceLabel(results, source);
+        for (relativeThresholds) |threshold| {
+            const run = simplify(allocator, &tracker, source, label, threshold, options.samples) catch |err| Run{
+                .mesh = label,
+                .threshold = threshold,
+                .status = @errorName(err),
+            };
+            try runs.append(run);
+        }
+    }
+
+    // ----- collapseMesh logs while running, the table comes after -----
+    std.debug.print("\n===== Simplification: {} meshes, {} thresholds, {} cpus =====\n", .{ sources.len, relativeThresholds.len, std.Thread.getCpuCount() catch 1 });
+    std.debug.print("{s:>16} {s:>9} {s:>10} {s:>10} {s:>11} {s:>11} {s:>11} {s:>12} {s:>9} {s:>10} {s:>10} {s:>11} {s:>8}\n", .{ "mesh", "threshold", "tris in", "tris out", "halfedge ms", "quadric ms", "collapse ms", "collapses/s", "peak MiB", "hausdorff", "rms", "distance ms", "status" });
+    for (runs.items) |run| {
+        std.debug.print("{s:>16} {d:>9} {:>10} {:>10} {d:>11.2} {d:>11.2} {d:>11.2} {d:>12.0} {d:>9.1} {d:>10.5} {d:>10.5} {d:>11.1} {s:>8}\n", .{
+            run.mesh,
+            run.threshold,
+            run.trianglesIn,
+            run.trianglesOut,
+            run.halfEdgeMs,
+            run.quadricMs,
+            run.collapseMs,
+            run.collapsesPerSecond,
+            @as(f64, @floatFromInt(run.peakBytes)) / (1 << 20),
+            run.hausdorff,
+            run.rms,
+            run.distanceMs,
+            run.status,
+        });
+    }
+
+    if (options.csv) |path| try writeCsv(runs.items, path);
+    if (options.json) |path| try writeJson(runs.items, path);
+    if (options.baseline) |path| compare(runs.items, try readBaseline(results, path));
+}
+
+fn sourceLabel(allocator: std.mem.Allocator, source: Source) ![]const u8 {
+    return switch (source) {
+        .asset => |map| MN.MAP_NAMES[map],
+        .generated => |g| try std.fmt.allocPrint(allocator, "{s}-{}", .{ @tagName(g.shape), g.triangles }),
+    };
+}
+
+fn load(allocator: std.mem.Allocator, source: Source) !PHMesh {
+    return switch (source) {
+        .asset => |map| try mesh_import.importPHMeshAlloc(allocator, MN.MAP_MESHES[map]),
+        .generated => |g| try generate.generate(allocator, g.shape, g.triangles, seed),
+    };
+}
+
+/// Simplify a fresh copy of `source` at `threshold` times its largest extent and measure it against another copy
+fn simplify(allocator: std.mem.Allocator, tracker: *tracking.TrackingAllocator, source: Source, label: []const u8, threshold: f32, samples: usize) !Run {
+    var original = try load(allocator, source);
+    defer original.deinit();
+    var mesh = try load(allocator, source);
+    defer mesh.deinit();
+
+    const bb = original.getBoundingBox();
+    const extent = bb.max.subtract(bb.min);
+    const errThreshold = threshold * @max(extent.x, extent.y, extent.z);
+
+    // ----- scratch starts empty, such that its growth counts towards the peak -----
+    scratch_arena.deinitThreadScratch();
+    tracker.resetPeaks();
+    const liveBefore = tracker.liveTotal;
+
+    const prevSubsystem = tracking.enter(.simplification);
+    errdefer tracking.leave(prevSubsystem);
+    var timer = try std.time.Timer.start();
+    var halfEdges = try HalfEdges.fromPHMesh(&mesh);
+    defer halfEdges.deinit();
+    scratch_arena.threadScratch(allocator).reset();
+    const halfEdgeNs = timer.lap();
+
+    try halfEdges.addErrorMatrices(mesh_simplification.defaultBoundaryPenalty);
+    try halfEdges.addEdgeErrorsList();
+    const quadricNs = timer.lap();
+
+    try halfEdges.collapseMesh(errThreshold);
+    const collapseNs = timer.lap();
+    scratch_arena.threadScratch(allocator).reset();
+    tracking.leave(prevSubsystem);
+    const peakBytes = tracker.peakTotal - liveBefore;
+
+    _ = timer.lap();
+    const distance = SurfaceDistance.measureSamples(mesh, original, samples, 0);
+    const distanceNs = timer.lap();
+    return .{
+        .mesh = label,
+        .threshold = threshold,
+        .status = "ok",
+        .trianglesIn = original.triangleCount,
+        .trianglesOut = mesh.triangleCount,
+        .collapses = halfEdges.collapses,
+        .halfEdgeMs = ms(halfEdgeNs),
+        .quadricMs = ms(quadricNs),
+        .collapseMs = ms(collapseNs),
+        .totalMs = ms(halfEdgeNs + quadricNs + collapseNs),
+        .collapsesPerSecond = @as(f64, @floatFromInt(halfEdges.collapses)) * std.time.ns_per_s / @as(f64, @floatFromInt(@max(collapseNs, 1))),
+        .peakBytes = peakBytes,
+        .hausdorff = distance.hausdorff,
+        .rms = distance.rms,
+        .quadric = distance.quadric,
+        .distanceMs = ms(distanceNs),
+    };
+}
+
+fn ms(ns: u64) f64 {
+    return @as(f64, @floatFromInt(ns)) / std.time.ns_per_ms;
+}
+
+// ======================================
+// Output
+// ======================================
+
+/// Header of `Run` field names, one line per run
+fn writeCsv(runs: []const Run, path: []const u8) !void {
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+    var buffered = std.io.bufferedWriter(file.writer());
+    const writer = buffered.writer();
+
+    inline for (std.meta.fields(Run), 0..) |field, i| {
+        if (i > 0) try writer.writeByte(',');
+        try writer.writeAll(field.name);
+    }
+    try writer.writeByte('\n');
+    for (runs) |run| {
+        inline for (std.meta.fields(Run), 0..) |field, i| {
+            if (i > 0) try writer.writeByte(',');
+            if (field.type == []const u8) {
+                try writer.writeAll(@field(run, field.name));
+            } else {
+                try writer.print("{d}", .{@field(run, field.name)});
+            }
+        }
+        try writer.writeByte('\n');
+    }
+    try buffered.flush();
+}
+
+fn writeJson(runs: []const Run, path: []const u8) !void {
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+    var buffered = std.io.bufferedWriter(file.writer());
+    try std.json.stringify(runs, .{ .whitespace = .indent_2 }, buffered.writer());
+    try buffered.flush();
+}
+
+fn readBaseline(arena: std.mem.Allocator, path: []const u8) ![]const Run {
+    const text = try std.fs.cwd().readFileAlloc(arena, path, 1 << 26);
+    return try std.json.parseFromSliceLeaky([]const Run, arena, text, .{ .ignore_unknown_fields = true });
+}
+
+/// Ratios now / baseline of the runs present in both, matched on mesh and threshold
+fn compare(runs: []const Run, baseline: []const Run) void {
+    std.debug.print("\n===== Against baseline: now / baseline =====\n", .{});
+    std.debug.print("{s:>16} {s:>9} {s:>10} {s:>12} {s:>10} {s:>10} {s:>10}\n", .{ "mesh", "threshold", "total", "collapses/s", "tris out", "hausdorff", "peak" });
+    for (runs) |run| {
+        const base = for (baseline) |candidate| {
+            if (std.mem.eql(u8, candidate.mesh, run.mesh) and std.math.approxEqRel(f32, candidate.threshold, run.threshold, 1e-5)) break candidate;
+        } else {
+            std.debug.print("{s:>16} {d:>9} not in baseline\n", .{ run.mesh, run.threshold });
+            continue;
+        };
+        std.debug.print("{s:>16} {d:>9} {d:>10.3} {d:>12.3} {d:>10.3} {d:>10.3} {d:>10.3}\n", .{
+            run.mesh,
+            run.threshold,
+            ratio(run.totalMs, base.totalMs),
+            ratio(run.collapsesPerSecond, base.collapsesPerSecond),
+            ratio(@floatFromInt(run.trianglesOut), @floatFromInt(base.trianglesOut)),
+            ratio(run.hausdorff, base.hausdorff),
+            ratio(@floatFromInt(run.peakBytes), @floatFromInt(base.peakBytes)),
+        });
+    }
+}
+
+fn ratio(now: f64, base: f64) f64 {
+    return if (base == 0) std.math.nan(f64) else now / base;
+}
@@ -2,6 +2,10 @@ const std = @import("std");
 const zune = @import("zune");
 
 const MN = @import("globals.zig");
+const FrameArena = @import("utils/frame_arena.zig").FrameArena;
+const TransformGraph = @import("world/transform_graph.zig").TransformGraph;
+const RenderQueue = @import("render/render_queue.zig").RenderQueue;
+const ZuneBackend = @import("render/zune_backend.zig").ZuneBackend;
 
 // Types
 const Allocator = std.mem.Allocator;
@@ -13,9 +17,13 @@ pub const GameSetup = struct {
     input: *zune.core.Input,
     camera: zune.graphics.Camera,
     ecs: *zune.ecs.Registry,
+    frameArena: FrameArena, // per-frame temporaries, reset after `swapBuffers`
+    transforms: TransformGraph, // world matrices of all entities with a `TransformNode`
+    renderQueue: RenderQueue(ZuneBackend), // draws of a frame, sorted and batched before submission
     // memoryLeakprt: *GameSetup,
 
-    pub fn init(allocator: Allocator) !GameSetup {
+    /// `frameBacking` backs the per-frame arena, pass an allocator which is not guarded against frame-scope allocations
+    pub fn init(allocator: Allocator, frameBacking: Allocator) !GameSetup {
 
         // ----- Initialize window -----
         var window = try zune.core.Window.create(allocator, .{
@@ -52,10 +60,16 @@ pub const GameSetup = struct {
             .camera = camera,
             .ecs = ecs,
             .input = input,
+            .frameArena = FrameArena.init(frameBacking),
+            .transforms = TransformGraph.init(allocator),
+            .renderQueue = try RenderQueue(ZuneBackend).init(allocator),
         };
     }
 
     pub fn deinit(self: *GameSetup) void {
+        self.renderQueue.deinit();
+        self.transforms.deinit();
+        self.frameArena.deinit();
         self.ecs.release();
         self.window.release();
         self.renderer.release();
@@ -10,12 +10,36 @@ pub const WINDOW_WIDTH = 1280;
 pub const WINDOW_HEIGHT = 720;
 pub const WINDOW_TITLE = "Zune RTS";
 
+// Memory diagnostics
+pub const TRACK_MEMORY = true; // attribute allocations to subsystems, print summary on exit
+pub const TRACK_MEMORY_TIMELINE = false; // also record every allocation event
+pub const MEMORY_TIMELINE_FILE = "memory_timeline.csv";
+pub const GUARD_FRAME_HEAP = @import("builtin").mode == .Debug; // report heap allocations made inside the frame loop
+pub const TRAP_FRAME_HEAP = false; // panic on the first one instead of reporting
+
 // Camera config
 pub const CAMERA_FOV: f32 = std.math.degreesToRadians(90.0);
 pub const CAMERA_ASPECT: f32 = WINDOW_WIDTH / WINDOW_HEIGHT;
 pub const CAMERA_NEAR: f32 = 0.1;
 pub const CAMERA_FAR: f32 = 5000;
 
+// Occlusion culling
+pub const OCCLUSION_WIDTH: usize = 256; // software depth buffer, pixels
+pub const OCCLUSION_HEIGHT: usize = 144;
+pub const OCCLUDER_QUADS_PER_CHUNK: usize = 4; // occluder mesh quads along a chunk side
+pub const OCCLUDER_CHUNKS: usize = 24; // nearest chunks drawn as occluders
+pub const BOUNDS_LOOSENESS: f32 = 1.25; // cull with the cheapest volume at most this much larger than the tightest
+pub const SPHERE_REFINE_PASSES: usize = 8; // shrink and regrow passes of the bounding sphere fit
+
+// Mesh processing
+pub const FACE_KERNEL_THREADS: c_int = 0; // threads of the face normal/area kernel, 0 -> one per hardware thread
+pub const DISTANCE_KERNEL_THREADS: c_int = 0; // threads of the surface distance kernel, 0 -> one per hardware thread
+pub const DISTANCE_SAMPLES: usize = 1 << 20; // samples per surface when measuring simplification error
+
+// Render queue
+pub const RENDER_MAX_INSTANCES: usize = 256; // draws merged into one instanced call at most
+pub const RENDER_RESOURCE_CAPACITY: usize = 1024; // materials and meshes interned without growing inside a frame
+
 // Maps
 pub const MAP_NAMES = [_][]const u8{
     "Dunes"
@@ -30,6 +54,27 @@ pub const MAP_TEXT = [_][]const u8{
 pub const MAP_CHUNKING = [_]Vec2(usize){
     .{.x = 11, .y = 11},
 };
+pub const MAP_PACKS = [_][]const u8{ // simulation data, built from MAP_MESHES on first server start
+    "assets/packs/Dunes.zmap"
+};
 pub const MAP_SIZE = [_]Vec3(f32){
     .{.x = 100.0, .y = 25.0, .z = 100.0}
-};
\ No newline at end of file
+};
+
+// Simulation / headless server
+pub const SIM_TICK_RATE: u64 = 30; // client simulation thread ticks per second
+pub const SIM_STEER_SPEED: f32 = 5.0; // arrow keys steer the test body, units per second
+pub const SERVER_TICK_RATE: u64 = 30; // simulation ticks per second
+pub const NAV_CELLS_PER_CHUNK: usize = 16; // heightfield cells along a chunk side
+pub const MAX_WALKABLE_SLOPE: f32 = 1.0; // rise over run -> 45 degrees
+pub const UNIT_SPEED: f32 = 2.0;
+pub const SPATIAL_CELLS_PER_CHUNK: usize = 4; // spatial hash cells along a chunk side
+pub const UNIT_SEPARATION: f32 = 1.0; // units closer than this steer apart
+pub const UNIT_SIGHT_CELLS: u8 = 10; // fog of war sight radius in nav cells
+pub const UNIT_EYE_HEIGHT: f32 = 1.0; // above terrain, for line of sight
+pub const TEAMS_PER_MATCH: u8 = 2;
+pub const INFLUENCE_CELLS_PER_CHUNK: usize = 8; // influence map cells along a chunk side
+pub const INFLUENCE_RADIUS_CELLS: usize = 4; // unit influence falls off to zero beyond this
+pub const INFLUENCE_ROWS_PER_TICK: usize = 64; // kernel rows per tick, bounds the AI cost of a tick
+pub const FLOW_FIELD_CACHE_SIZE: usize = 16; // flow fields kept per cost grid
+pub const FLOW_BENCH_OBSTACLE_COST: u8 = 200; // cost written by the flow field benchmark
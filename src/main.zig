@@ -6,6 +6,15 @@ const mesh_processing = @import("mesh/processing.zig");
 const mesh_simplification = @import("mesh/cuthulus_box.zig");
 const math = @import("math.zig");
 const util_print = @import("utils/prints.zig");
+const tracking = @import("utils/tracking_allocator.zig");
+const scratch_arena = @import("utils/scratch.zig");
+const frame_arena = @import("utils/frame_arena.zig");
+const sim_world = @import("sim/sim_world.zig");
+const sim_thread = @import("sim/sim_thread.zig");
+const transform_graph = @import("world/transform_graph.zig");
+const render_queue = @import("render/render_queue.zig");
+const ZuneBackend = @import("render/zune_backend.zig").ZuneBackend;
+const Selection = @import("ui/selection.zig").Selection;
 
 const MN = @import("globals.zig");
 
@@ -18,22 +27,41 @@ const ECS = zune.ecs.Registry;
 const Model = zune.ecs.components.ModelComponent;
 const Transform = zune.ecs.components.TransformComponent;
 const Mesh = zune.graphics.Mesh;
+const SimBody = sim_world.SimBody;
+const SimThread = sim_thread.SimThread;
+const Snapshot = sim_thread.Snapshot;
+const Velocity = sim_world.Velocity;
+const TransformGraph = transform_graph.TransformGraph;
+const TransformNode = transform_graph.TransformNode;
+const RenderQueue = render_queue.RenderQueue(ZuneBackend);
 
 pub fn main() !void {
     std.debug.print("Started program...\n", .{});
     // ===== Initialize Everything ===== //
     // ----- Initialize allocator ----- //
     var gpa = std.heap.GeneralPurposeAllocator(.{}){};
-    const allocator = gpa.allocator();
     defer _ = gpa.deinit();
 
+    // ----- Wrap allocator for per-subsystem statistics ----- //
+    var tracker = try tracking.TrackingAllocator.init(gpa.allocator(), .{ .timeline = MN.TRACK_MEMORY_TIMELINE });
+    defer tracker.deinit();
+    defer if (MN.TRACK_MEMORY) reportMemory(&tracker);
+    const baseAllocator = if (MN.TRACK_MEMORY) tracker.allocator() else gpa.allocator();
+
+    // ----- Guard against heap allocations inside the frame loop ----- //
+    var heapGuard = frame_arena.HeapGuard.init(baseAllocator, .{ .trap = MN.TRAP_FRAME_HEAP });
+    defer if (MN.GUARD_FRAME_HEAP) heapGuard.printSummary();
+    const allocator = if (MN.GUARD_FRAME_HEAP) heapGuard.allocator() else baseAllocator;
+    defer scratch_arena.deinitThreadScratch(); // mesh pipeline temporaries, released before the tracker reports
+
     // ----- Initialize resource manager ----- //
     var resource_manager = try zune.graphics.ResourceManager.create(allocator, .{ .enabled = false });
     defer _ = resource_manager.releaseAll() catch std.debug.print("all your errors are belong to us\n", .{});
 
     // ----- Initialize game ----- //
-    var gameSetup = try GameSetup.init(allocator);
+    var gameSetup = try GameSetup.init(allocator, baseAllocator); // frame arena grows unguarded
     defer gameSetup.deinit();
+    defer gameSetup.transforms.printSummary();
 
     // ===== Set Variables ===== //
     const initial_mouse_pos = gameSetup.input.getMousePosition();
@@ -44,7 +72,7 @@ pub fn main() !void {
     try ecsMap(gameSetup.ecs);
 
     // ===== Setup game =====
-    try setActiveMap(gameSetup.ecs, 0, resource_manager, &gameSetup.camera);
+    try setActiveMap(gameSetup.ecs, &gameSetup.transforms, 0, resource_manager, &gameSetup.camera);
 
     // =====================
     // ===== TEST CODE =====
@@ -71,45 +99,105 @@ pub fn main() !void {
     try model.addMeshMaterial(tmesh, material);
     const ent = try gameSetup.ecs.createEntity();
     try gameSetup.ecs.addComponent(ent, Model{ .model = model, .visible = true });
-    try gameSetup.ecs.addComponent(ent, Transform.identity());
+    try addTransform(gameSetup.ecs, &gameSetup.transforms, ent, transform_graph.noParent, math.mat4Identity);
+
+    // ----- Simulation, ticks on its own thread ----- //
+    var simWorld = sim_world.SimWorld.init(allocator);
+    defer simWorld.deinit();
+    const testBody = try simWorld.spawn(.{}, .{});
+    try gameSetup.ecs.addComponent(ent, testBody);
+
+    var simThread = try SimThread.init(allocator, &simWorld, MN.SIM_TICK_RATE);
+    defer simThread.deinit();
+    defer simThread.printPacing();
+    try simThread.start();
+
+    // ----- Drag selection of the sim bodies, reserved for all of them ----- //
+    var selection = Selection.init(allocator);
+    defer selection.deinit();
+    try selection.reserve(simWorld.bodyCount());
+    var selected = try std.ArrayList(u32).initCapacity(allocator, simWorld.bodyCount());
+    defer selected.deinit();
+    var dragStart: ?math.vec2(f32) = null;
 
     // =====================
     // === END TEST CODE ===
     // =====================
 
     // ===== Main Loop ===== //
+    var inputSeq: u64 = 0;
+    var lastFrame = simThread.now();
     while (!gameSetup.window.shouldClose()) {
+        heapGuard.beginFrame();
+        defer heapGuard.endFrame(); // also when leaving the loop, teardown is not frame scope
+        const frameAllocator = gameSetup.frameArena.allocator();
+        const frameStart = simThread.now();
+        const frameNs = frameStart - lastFrame;
+        lastFrame = frameStart;
+        const frameDt: f32 = @as(f32, @floatFromInt(frameNs)) / std.time.ns_per_s;
+
         // ==== Process Input ==== \\
         const mouse_pos = gameSetup.input.getMousePosition();
-        camera_controller.handleMouseMovement(@as(f32, @floatCast(mouse_pos.x)), @as(f32, @floatCast(mouse_pos.y)), 1.0 / 60.0);
+        camera_controller.handleMouseMovement(@as(f32, @floatCast(mouse_pos.x)), @as(f32, @floatCast(mouse_pos.y)), frameDt);
+        inputSeq += 1;
+        simThread.sendInput(.{
+            .seq = inputSeq,
+            .steer = .{ .body = testBody.index, .velocity = steerControl(gameSetup.input) },
+        });
 
         cameraControl(gameSetup.input, &gameSetup.camera);
 
         if (gameSetup.input.isKeyReleased(.KEY_ESCAPE)) break;
 
         // ==== Experimental ====
-        try testController(gameSetup.input, tmesh, &testMesh, &collapse_err);
+        try testController(gameSetup.input, &heapGuard, tmesh, &testMesh, &collapse_err);
+
+        // ==== Apply simulation ====
+        const snapshot = simThread.latest(frameNs);
+        try applySimTransforms(gameSetup.ecs, &gameSetup.transforms, &simThread, snapshot);
+
+        // ==== Drag selection ====
+        try selectControl(gameSetup.input, &gameSetup.camera, &selection, &dragStart, snapshot.current, &selected);
+
+        // ==== Propagate changed transforms ====
+        gameSetup.transforms.update();
+        try syncTransforms(gameSetup.ecs, &gameSetup.transforms);
+
+        // ==== Stream map chunks around the view ====
+        try updateMaps(gameSetup.ecs, frameAllocator);
 
         // ==== Render game ====
         gameSetup.renderer.clear();
-        try renderSystem(gameSetup.ecs, &gameSetup.camera);
+        try renderSystem(gameSetup.ecs, &gameSetup.camera, &gameSetup.renderQueue, frameAllocator);
 
         // ==== Frame logistics ====
         try gameSetup.window.pollEvents();
         gameSetup.window.swapBuffers();
+        gameSetup.frameArena.reset();
     }
 }
 
-const Velocity = struct {
-    x: f32,
-    y: f32,
-    z: f32,
-};
+/// Print per-subsystem memory summary and write the allocation timeline if it was recorded
+fn reportMemory(tracker: *tracking.TrackingAllocator) void {
+    tracker.printSummary();
+    if (!MN.TRACK_MEMORY_TIMELINE) return;
+
+    const file = std.fs.cwd().createFile(MN.MEMORY_TIMELINE_FILE, .{}) catch |err| {
+        std.debug.print("Could not write memory timeline: {}\n", .{err});
+        return;
+    };
+    defer file.close();
+    var buffered = std.io.bufferedWriter(file.writer());
+    tracker.dumpTimeline(buffered.writer()) catch |err| std.debug.print("Could not write memory timeline: {}\n", .{err});
+    buffered.flush() catch {};
+}
 
 const ECSError = error{MapError};
 pub fn ecsGeneralComponents(ecs: *ECS) !void {
     try ecs.registerComponent(Model);
     try ecs.registerComponent(Transform);
+    try ecs.registerComponent(SimBody);
+    try ecs.registerComponent(TransformNode);
 }
 
 pub fn ecsMap(ecs: *ECS) !void {
@@ -127,7 +215,7 @@ pub fn ecsMap(ecs: *ECS) !void {
     try ecs.registerDeferedComponent(Map, "deinit");
 }
 
-pub fn setActiveMap(ecs: *ECS, mapId: usize, resourceManager: *zune.graphics.ResourceManager, camera: *zune.graphics.Camera) !void {
+pub fn setActiveMap(ecs: *ECS, transforms: *TransformGraph, mapId: usize, resourceManager: *zune.graphics.ResourceManager, camera: *zune.graphics.Camera) !void {
     if (mapId >= MN.MAP_MESHES.len) {
         std.debug.print("MapId exceeds map count\n", .{});
         return ECSError.MapError;
@@ -146,11 +234,18 @@ pub fn setActiveMap(ecs: *ECS, mapId: usize, resourceManager: *zune.graphics.Res
     const entity = try ecs.createEntity();
 
     try ecs.addComponent(entity, try Map.init(resourceManager, mapMeshLoc, camera, mapMaterial, mapSize, mapChunking, mapName));
-    const id = zmath.Mat4f{.data = math.mat4Identity};
+    try addTransform(ecs, transforms, entity, transform_graph.noParent, math.mat4Identity);
+}
+
+/// Add a `Transform` with its `TransformNode` to `entity`. Only `syncTransforms` writes world matrices, so every
+/// rendered transform is added here; a transform without a node would keep its matrix from spawn forever.
+pub fn addTransform(ecs: *ECS, transforms: *TransformGraph, entity: anytype, parent: u32, local: [16]f32) !void {
+    const matrix = zmath.Mat4f{ .data = local };
     try ecs.addComponent(entity, Transform{
-        .local_matrix = id,
-        .world_matrix = id,
+        .local_matrix = matrix,
+        .world_matrix = matrix,
     });
+    try ecs.addComponent(entity, TransformNode{ .index = try transforms.add(parent, local) });
 }
 
 pub fn cameraControl(input: *zune.core.Input, camera: *zune.graphics.Camera) void {
@@ -187,7 +282,40 @@ pub fn cameraControl(input: *zune.core.Input, camera: *zune.graphics.Camera) voi
     }
 }
 
-pub fn testController(input: *zune.core.Input, m: *Mesh, phMesh: *PlaceHolderMesh, err: *f32) !void {
+/// Arrow keys -> velocity of the test body, sent to the simulation every frame
+fn steerControl(input: *zune.core.Input) Velocity {
+    var velocity = Velocity{};
+    if (input.isKeyHeld(.KEY_UP)) velocity.z -= MN.SIM_STEER_SPEED;
+    if (input.isKeyHeld(.KEY_DOWN)) velocity.z += MN.SIM_STEER_SPEED;
+    if (input.isKeyHeld(.KEY_LEFT)) velocity.x -= MN.SIM_STEER_SPEED;
+    if (input.isKeyHeld(.KEY_RIGHT)) velocity.x += MN.SIM_STEER_SPEED;
+    return velocity;
+}
+
+/// Box selection of sim bodies: hold Q and move the mouse to span the box, releasing Q selects the bodies inside.
+/// Buffers are reserved for all bodies, selecting does not allocate inside the frame.
+fn selectControl(input: *zune.core.Input, camera: *zune.graphics.Camera, selection: *Selection, dragStart: *?math.vec2(f32), positions: []const math.vec3(f32), selected: *std.ArrayList(u32)) !void {
+    const mouse = input.getMousePosition();
+    const cursor = Selection.ndcFromPixels(@floatCast(mouse.x), @floatCast(mouse.y), MN.WINDOW_WIDTH, MN.WINDOW_HEIGHT);
+
+    if (input.isKeyReleased(.KEY_Q)) {
+        const start = dragStart.* orelse return;
+        dragStart.* = null;
+        selected.clearRetainingCapacity();
+        try selection.project(camera.getViewProjectionMatrix().data, positions);
+        try selection.selectRect(start, cursor, selected);
+        std.debug.print("Selected {} bodies (project {d:.1} us, select {d:.1} us)\n", .{
+            selected.items.len,
+            @as(f64, @floatFromInt(selection.lastProjectNs)) / std.time.ns_per_us,
+            @as(f64, @floatFromInt(selection.lastSelectNs)) / std.time.ns_per_us,
+        });
+    } else if (input.isKeyHeld(.KEY_Q) and dragStart.* == null) {
+        dragStart.* = cursor;
+    }
+}
+
+/// Editor keys for the test mesh. Collapsing is an explicit edit and may use the heap inside the frame.
+pub fn testController(input: *zune.core.Input, heapGuard: *frame_arena.HeapGuard, m: *Mesh, phMesh: *PlaceHolderMesh, err: *f32) !void {
     var changed = false;
     if(input.isKeyReleased(.KEY_EQUAL)){
         err.* *= 1.2;
@@ -196,6 +324,8 @@ pub fn testController(input: *zune.core.Input, m: *Mesh, phMesh: *PlaceHolderMes
     }
 
     if(changed){
+        heapGuard.exempt();
+        defer heapGuard.unexempt();
         try mesh_simplification.collapseMesh(phMesh, err.*);
         try m.updateMesh(phMesh.vertices, phMesh.indices, 3);
     }
@@ -209,13 +339,78 @@ pub fn testController(input: *zune.core.Input, m: *Mesh, phMesh: *PlaceHolderMes
     }
 }
 
-pub fn renderSystem(ecs: *ECS, camera: *zune.graphics.Camera) !void {
-    try renderEntities(ecs, camera);
-    try renderMaps(ecs, camera);
+/// Move entities with a `SimBody` to their position interpolated between the last two simulation ticks
+fn applySimTransforms(ecs: *ECS, transforms: *TransformGraph, simThread: *SimThread, snapshot: *const Snapshot) !void {
+    const now = simThread.now();
+
+    var query = try ecs.query(struct {
+        node: *TransformNode,
+        body: *SimBody,
+    });
+
+    while (try query.next()) |components| {
+        const body = components.body;
+
+        // ----- bodies at rest are only written once, with their final position -----
+        if (!snapshot.moved[body.index]) {
+            if (body.settled) continue;
+            body.settled = true;
+        } else body.settled = false;
+
+        const p = simThread.interpolate(snapshot, body.index, if (body.settled) std.math.maxInt(u64) else now);
+        transforms.setTranslation(components.node.index, p);
+    }
+}
+
+/// Copy world matrices recomputed by the last `TransformGraph.update` into the entities' transforms
+fn syncTransforms(ecs: *ECS, transforms: *const TransformGraph) !void {
+    if (transforms.matricesRecomputed == 0) return;
+
+    var query = try ecs.query(struct {
+        transform: *Transform,
+        node: *TransformNode,
+    });
+
+    while (try query.next()) |components| {
+        const node = components.node;
+        const version = transforms.worldVersion(node.index);
+        if (version == node.seenVersion) continue;
+        node.seenVersion = version;
+        components.transform.world_matrix = .{ .data = transforms.world(node.index).* };
+    }
+}
+
+/// Update which chunks of every map are in view, loaded and monitored. Temporaries come from `frameAllocator`.
+fn updateMaps(ecs: *ECS, frameAllocator: Allocator) !void {
+    var query = try ecs.query(struct {
+        map: *Map,
+    });
+
+    while (try query.next()) |components| {
+        try components.map.refreshView(frameAllocator);
+    }
 }
 
-/// render all `model` components with a `transform` component
-fn renderEntities(ecs: *ECS, camera: *zune.graphics.Camera) !void {
+/// Record all visible draws into `queue`, then submit them sorted by pass and batch, transparent draws back to front.
+/// Commands of the frame are recorded into `frameAllocator`.
+pub fn renderSystem(ecs: *ECS, camera: *zune.graphics.Camera, queue: *RenderQueue, frameAllocator: Allocator) !void {
+    try queue.begin(frameAllocator, MN.CAMERA_NEAR, MN.CAMERA_FAR);
+    try renderEntities(ecs, camera, queue);
+    try renderMaps(ecs, camera, queue);
+
+    var backend = ZuneBackend{ .camera = camera };
+    try queue.submit(&backend);
+}
+
+/// Distance from the camera to the translation of `world`
+fn viewDepth(camera: *zune.graphics.Camera, world: [16]f32) f32 {
+    const p = camera.position;
+    const d = math.vec3(f32){ .x = world[12] - p.x, .y = world[13] - p.y, .z = world[14] - p.z };
+    return @sqrt(d.dot(d));
+}
+
+/// record all `model` components with a `transform` component. World matrices are kept current by `syncTransforms`.
+fn renderEntities(ecs: *ECS, camera: *zune.graphics.Camera, queue: *RenderQueue) !void {
     // Query for entities with all required components
     var query = try ecs.query(struct {
         transform: *Transform,
@@ -226,29 +421,22 @@ fn renderEntities(ecs: *ECS, camera: *zune.graphics.Camera) !void {
         // Skip if not visible
         if (!components.model.visible) continue;
 
-        // Update transform matrices
-        components.transform.updateMatrices();
-
-        // Draw the model using current transform
-        try camera.drawModel(
-            components.model.model,
-            &components.transform.world_matrix,
-        );
+        const model = components.model.model;
+        const world = components.transform.world_matrix.data;
+        try queue.record(.opaqueGeometry, model, model, world, viewDepth(camera, world));
     }
 }
 
-/// render all `map` components with a `transform` component
-fn renderMaps(ecs: *ECS, camera: *zune.graphics.Camera) !void {
+/// record all `map` components with a `transform` component
+fn renderMaps(ecs: *ECS, camera: *zune.graphics.Camera, queue: *RenderQueue) !void {
     var query = try ecs.query(struct {
         transform: *Transform,
         map: *Map,
     });
 
     while (try query.next()) |map| {
-        try camera.drawModel(
-            map.map.model,
-            &map.transform.world_matrix,
-        );
+        const world = map.transform.world_matrix.data;
+        try queue.record(.terrain, map.map.model, map.map.model, world, viewDepth(camera, world));
     }
 }
 
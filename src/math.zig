@@ -153,6 +153,46 @@ pub fn Mat4Vec4(m: Mat4, v: Vec4(f32)) Vec4(f32) {
     };
 }
 
+/// a * b for column-major matrices. Every result column is a linear combination of the columns of `a`, computed 4 lanes at a time.
+pub inline fn mat4Multiply(a: [16]f32, b: [16]f32) [16]f32 {
+    const V = @Vector(4, f32);
+    const c0: V = a[0..4].*;
+    const c1: V = a[4..8].*;
+    const c2: V = a[8..12].*;
+    const c3: V = a[12..16].*;
+
+    var out: [16]f32 = undefined;
+    inline for (0..4) |j| {
+        const col = c0 * @as(V, @splat(b[j*4])) +
+                    c1 * @as(V, @splat(b[j*4 + 1])) +
+                    c2 * @as(V, @splat(b[j*4 + 2])) +
+                    c3 * @as(V, @splat(b[j*4 + 3]));
+        out[j*4..][0..4].* = col;
+    }
+    return out;
+}
+
+/// Column-major right-handed perspective projection (OpenGL clip space), `fovY` in radians. Clip w is the view depth.
+pub fn mat4Perspective(fovY: f32, aspect: f32, near: f32, far: f32) [16]f32 {
+    const f = 1 / @tan(fovY / 2);
+    return .{   f / aspect, 0, 0, 0,
+                0, f, 0, 0,
+                0, 0, (far + near) / (near - far), -1,
+                0, 0, 2 * far * near / (near - far), 0};
+}
+
+/// Column-major view matrix of a camera at `eye` looking at `target`
+pub fn mat4LookAt(eye: vec3(f32), target: vec3(f32), up: vec3(f32)) [16]f32 {
+    const f = vec3returnNormalize(.{target.x - eye.x, target.y - eye.y, target.z - eye.z});
+    const s = vec3returnNormalize(vec3Cross(f, .{up.x, up.y, up.z}));
+    const u: @Vector(3, f32) = vec3Cross(s, f);
+    const e: @Vector(3, f32) = .{eye.x, eye.y, eye.z};
+    return .{   s[0], u[0], -f[0], 0,
+                s[1], u[1], -f[1], 0,
+                s[2], u[2], -f[2], 0,
+                -@reduce(.Add, s * e), -@reduce(.Add, u * e), @reduce(.Add, f * e), 1};
+}
+
 // /// Solve for x in Ax = b. Assumes m is symetric and negative/positive-semidefinite. m is column major and only stores lower triangle
 // pub inline fn solveLDLT(m: *[16]f32, b_: [4]f32) [4]f32 {
 //     var b = b_;
@@ -0,0 +1,245 @@
+const std = @import("std");
+const math = @import("../math.zig");
+const MN = @import("../globals.zig");
+
+const BoundingBox = @import("processing.zig").BoundingBox;
+const Vec3 = math.vec3;
+
+pub const Sphere = struct {
+    center: [3]f32,
+    radius: f32,
+};
+
+/// Box along three orthonormal `axes`, `halfExtents` along each of them
+pub const OrientedBox = struct {
+    center: [3]f32,
+    axes: [3][3]f32,
+    halfExtents: [3]f32,
+};
+
+/// Volume used by culling, in order of test cost
+pub const VolumeKind = enum { sphere, box, orientedBox };
+
+/// Axis aligned box, bounding sphere and oriented box of one point set, plus the one culling should test.
+///
+/// The sphere is the cheapest test (one dot product per plane), then the axis aligned box, then the oriented box
+/// (three). `kind` picks the cheapest volume which is not much looser than the tightest one.
+pub const BoundingVolume = struct {
+    box: BoundingBox,
+    sphere: Sphere,
+    orientedBox: OrientedBox,
+    kind: VolumeKind,
+
+    /// Fit all volumes to `points` (xyz packed, at least one point)
+    pub fn fromPoints(points: []const f32) BoundingVolume {
+        std.debug.assert(points.len >= 3 and points.len % 3 == 0);
+
+        var box = BoundingBox{ .min = toVec3(points[0..3].*), .max = toVec3(points[0..3].*) };
+        var i: usize = 3;
+        while (i < points.len) : (i += 3) {
+            const p = toVec3(points[i..][0..3].*);
+            box.min = math.vec3Min(box.min, p);
+            box.max = math.vec3Max(box.max, p);
+        }
+
+        var result = BoundingVolume{
+            .box = box,
+            .sphere = boundingSphere(points),
+            .orientedBox = fitOrientedBox(points),
+            .kind = .box,
+        };
+        result.kind = result.cheapestTight();
+        return result;
+    }
+
+    fn cheapestTight(self: BoundingVolume) VolumeKind {
+        const size = self.box.max.subtract(self.box.min);
+        const boxVolume = size.x * size.y * size.z;
+        const r = self.sphere.radius;
+        const sphereVolume = 4.0 / 3.0 * std.math.pi * r * r * r;
+        const h = self.orientedBox.halfExtents;
+        const orientedVolume = 8 * h[0] * h[1] * h[2];
+
+        const tightest = @min(boxVolume, sphereVolume, orientedVolume);
+        if (sphereVolume <= tightest * MN.BOUNDS_LOOSENESS) return .sphere;
+        if (boxVolume <= tightest * MN.BOUNDS_LOOSENESS) return .box;
+        return .orientedBox;
+    }
+};
+
+fn toVec3(p: [3]f32) Vec3(f32) {
+    return .{ .x = p[0], .y = p[1], .z = p[2] };
+}
+
+// ======================================
+// Fitting
+// ======================================
+
+/// Oriented box along the principal axes of `points`, see `eigen_fit_obb`
+pub fn fitOrientedBox(points: []const f32) OrientedBox {
+    var out: [15]f32 = undefined;
+    math.eigen_fit_obb(points.ptr, @intCast(points.len / 3), &out);
+
+    var result = OrientedBox{
+        .center = out[0..3].*,
+        .axes = .{ out[3..6].*, out[6..9].*, out[9..12].* },
+        .halfExtents = out[12..15].*,
+    };
+    // ----- fitted in double, stored in float: keep every point inside -----
+    for (&result.halfExtents) |*h| h.* = h.* * (1 + 1e-5) + 1e-6;
+    return result;
+}
+
+/// Near-minimal bounding sphere: Ritter's sphere, then repeatedly shrunk and regrown over all points, keeping the
+/// smallest one which still contains every point (Ericson, Real-Time Collision Detection 4.3.5)
+pub fn boundingSphere(points: []const f32) Sphere {
+    const count = points.len / 3;
+    var best = ritterSphere(points);
+
+    var s = best;
+    for (0..MN.SPHERE_REFINE_PASSES) |pass| {
+        s.radius *= 0.95;
+        // ----- visit points in a different order every pass, stride coprime with the count -----
+        const stride = coprimeStride(count, pass);
+        var k: usize = 0;
+        for (0..count) |_| {
+            growSphere(&s, points[k * 3 ..][0..3].*);
+            k = (k + stride) % count;
+        }
+        if (s.radius < best.radius) best = s;
+    }
+    return best;
+}
+
+/// Sphere around the most separated pair of axis-extreme points, grown to contain all points
+fn ritterSphere(points: []const f32) Sphere {
+    const count = points.len / 3;
+    var minIndex = [3]usize{ 0, 0, 0 };
+    var maxIndex = [3]usize{ 0, 0, 0 };
+    for (0..count) |i| {
+        for (0..3) |axis| {
+            if (points[i * 3 + axis] < points[minIndex[axis] * 3 + axis]) minIndex[axis] = i;
+            if (points[i * 3 + axis] > points[maxIndex[axis] * 3 + axis]) maxIndex[axis] = i;
+        }
+    }
+
+    var widest: usize = 0;
+    var widestDistance: f32 = -1;
+    for (0..3) |axis| {
+        const d = distanceSquared(points[minIndex[axis] * 3 ..][0..3].*, points[maxIndex[axis] * 3 ..][0..3].*);
+        if (d > widestDistance) {
+            widest = axis;
+            widestDistance = d;
+        }
+    }
+
+    const a: @Vector(3, f32) = points[minIndex[widest] * 3 ..][0..3].*;
+    const b: @Vector(3, f32) = points[maxIndex[widest] * 3 ..][0..3].*;
+    var s = Sphere{ .center = (a + b) * @as(@Vector(3, f32), @splat(0.5)), .radius = @sqrt(widestDistance) / 2 };
+    for (0..count) |i| growSphere(&s, points[i * 3 ..][0..3].*);
+    return s;
+}
+
+/// Move and grow `s` just enough to contain `p`
+fn growSphere(s: *Sphere, p: [3]f32) void {
+    const d2 = distanceSquared(s.center, p);
+    if (d2 <= s.radius * s.radius) return;
+    const d = @sqrt(d2);
+    const radius = (s.radius + d) / 2;
+    const t = (radius - s.radius) / d;
+    const c: @Vector(3, f32) = s.center;
+    const q: @Vector(3, f32) = p;
+    s.center = c + (q - c) * @as(@Vector(3, f32), @splat(t));
+    s.radius = radius;
+}
+
+fn distanceSquared(a: [3]f32, b: [3]f32) f32 {
+    const d = @as(@Vector(3, f32), a) - @as(@Vector(3, f32), b);
+    return @reduce(.Add, d * d);
+}
+
+fn coprimeStride(count: usize, pass: usize) usize {
+    if (count <= 1) return 1;
+    var stride = (count / 2 + 7 * pass + 1) % count;
+    while (std.math.gcd(@max(stride, 1), count) != 1) stride = (stride + 1) % count;
+    return @max(stride, 1);
+}
+
+// ======================================
+// Frustum
+// ======================================
+
+/// Six planes (nx, ny, nz, d) of a view-projection, inside where n . p + d >= 0
+pub const Frustum = struct {
+    planes: [6][4]f32,
+
+    /// Planes of the column-major OpenGL `viewProjection` (Gribb-Hartmann), normalized
+    pub fn fromViewProjection(m: [16]f32) Frustum {
+        const row = [4][4]f32{
+            .{ m[0], m[4], m[8], m[12] },
+            .{ m[1], m[5], m[9], m[13] },
+            .{ m[2], m[6], m[10], m[14] },
+            .{ m[3], m[7], m[11], m[15] },
+        };
+        var result: Frustum = undefined;
+        for (0..3) |axis| {
+            for (0..2) |side| {
+                const sign: f32 = if (side == 0) 1 else -1;
+                var plane: @Vector(4, f32) = @as(@Vector(4, f32), row[3]) + @as(@Vector(4, f32), row[axis]) * @as(@Vector(4, f32), @splat(sign));
+                const length = @sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+                if (length > 0) plane /= @as(@Vector(4, f32), @splat(length));
+                result.planes[axis * 2 + side] = plane;
+            }
+        }
+        return result;
+    }
+
+    inline fn distance(plane: [4]f32, p: [3]f32) f32 {
+        return plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2] + plane[3];
+    }
+
+    pub fn containsPoint(self: Frustum, p: [3]f32) bool {
+        for (self.planes) |plane| {
+            if (distance(plane, p) < 0) return false;
+        }
+        return true;
+    }
+
+    pub fn intersectsSphere(self: Frustum, s: Sphere) bool {
+        for (self.planes) |plane| {
+            if (distance(plane, s.center) < -s.radius) return false;
+        }
+        return true;
+    }
+
+    pub fn intersectsBox(self: Frustum, box: BoundingBox) bool {
+        for (self.planes) |plane| {
+            // ----- corner farthest along the plane normal -----
+            const p = [3]f32{
+                if (plane[0] >= 0) box.max.x else box.min.x,
+                if (plane[1] >= 0) box.max.y else box.min.y,
+                if (plane[2] >= 0) box.max.z else box.min.z,
+            };
+            if (distance(plane, p) < 0) return false;
+        }
+        return true;
+    }
+
+    pub fn intersectsOrientedBox(self: Frustum, box: OrientedBox) bool {
+        for (self.planes) |plane| {
+            var reach: f32 = 0; // half extent of the box projected onto the normal
+            for (box.axes, box.halfExtents) |axis, h| reach += @abs(plane[0] * axis[0] + plane[1] * axis[1] + plane[2] * axis[2]) * h;
+            if (distance(plane, box.center) < -reach) return false;
+        }
+        return true;
+    }
+
+    /// Test the volume selected by `volume.kind`
+    pub fn intersects(self: Frustum, volume: BoundingVolume) bool {
+        return switch (volume.kind) {
+            .sphere => self.intersectsSphere(volume.sphere),
+            .box => self.intersectsBox(volume.box),
+            .orientedBox => self.intersectsOrientedBox(volume.orientedBox),
+        };
+    }
+};
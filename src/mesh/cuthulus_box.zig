@@ -1,6 +1,8 @@
 const std = @import("std");
 const math = @import("../math.zig");
 const util_print = @import("../utils/prints.zig");
+const tracking = @import("../utils/tracking_allocator.zig");
+const scratch_arena = @import("../utils/scratch.zig");
 
 const Allocator: type = std.mem.Allocator;
 
@@ -9,6 +11,7 @@ const ErrorMatrix = [HalfMatLen]f64; // row major generally (last 2 indices unus
 const avec3 = @Vector(3, f32);
 
 const PlaceHolderMesh = @import("processing.zig").PlaceHolderMesh;
+const FaceAttributes = @import("face_attributes.zig").FaceAttributes;
 
 const indexOfPtr = @import("processing.zig").indexOfPtr;
 
@@ -17,11 +20,18 @@ const indexOfPtr = @import("processing.zig").indexOfPtr;
 // =====================================
 
 pub fn collapseMesh(mesh: *PlaceHolderMesh, err_threshold: f32) !void {
+    const prevSubsystem = tracking.enter(.simplification);
+    defer tracking.leave(prevSubsystem);
+
+    const scratch = scratch_arena.threadScratch(mesh.allocator);
+    const mark = scratch.mark();
+    defer scratch.restore(mark);
 
     // ===== Create halfEdge mesh =====
     std.debug.print("create halfEdges\n", .{});
     var halfEdges = try HalfEdges.fromPHMesh(mesh);
     defer halfEdges.deinit();
+    scratch.restore(mark);
     std.debug.print("Created halfedges\n", .{});
     try halfEdges.collapseMesh(err_threshold);
 }
@@ -84,6 +94,9 @@ fn indices_manifoldCheck(allocator: Allocator, indices: []u32) !void {
 //               STRUCTS
 // =====================================
 
+/// Weight of the perpendicular planes which keep boundary edges in place during `collapseMesh`
+pub const defaultBoundaryPenalty: f32 = 1000;
+
 const HalfEdgeError = error{ TooManyNeighbours, NotEnoughNeighbours, NoQuadricErrors, NoEdgeErrors, FaceFlip, DetachedVertex, SingularFace };
 
 /// Struct to store raw mesh data in halfEdge structure
@@ -100,20 +113,29 @@ pub const HalfEdges = struct {
     indexBuffer1: std.ArrayList(u32),
     indexBuffer2: std.ArrayList(u32),
     faceNormals: []f32, // owned
+    faceAreas: []f32, // owned, area of each face, weights the vertex normals
     normalBuffer1: std.ArrayList(FaceNormalInfo),
     normalBuffer2: std.ArrayList(FaceNormalInfo),
 
+    vertexNormals: []f32, // owned, area weighted sum of adjacent face normals
+    vertexDirty: []bool, // owned, vertex normal differs from `mesh.normals`
+    dirtyVertices: std.ArrayList(u32),
+
     vertices: []f32, // shared with mesh
     quadricError: ?[]ErrorMatrix = null,
     edgeErrors: ?[]EdgeErrInfo = null,
     alteredErrorsBuffer: std.ArrayList(AlteredEdgeErrorInfo),
 
     edge: u32 = 0,
+    collapses: u32 = 0, // successful edge collapses over all `collapseMesh` calls
 
-    /// Removes duplicates from `mesh`. This will invalidate texCoords and normals.
+    /// Removes duplicates from `mesh`, texcoords of the first of duplicate vertices are kept.
+    ///
+    /// Construction temporaries are taken from the thread scratch arena and left to the caller's mark.
     pub fn fromPHMesh(mesh: *PlaceHolderMesh) !HalfEdges {
         // ===== Retrieve required info =====
         const allocator = mesh.allocator;
+        const scratch = scratch_arena.threadScratch(allocator).allocator();
         const triangleCount = mesh.triangleCount;
         const indices = mesh.indices;
         const vertices = mesh.vertices;
@@ -122,20 +144,35 @@ pub const HalfEdges = struct {
         // try indices_manifoldCheck(allocator, indices);
 
         // ===== De-duplicate mesh vertices =====
-        try mesh.removeDuplicateVertices();
+        try mesh.removeDuplicateVertices(scratch);
 
         // ===== Find face normals =====
-        const faceNormals = try getFaceNormals(allocator, vertices, indices);
+        const faces = try FaceAttributes.compute(scratch, vertices, indices);
+        defer faces.deinit();
+        const faceNormals = try allocator.alloc(f32, triangleCount * 3);
+        for (0..triangleCount) |f| faceNormals[f * 3 ..][0..3].* = faces.normal(f);
+        const faceAreas = try allocator.dupe(f32, faces.areas);
+
+        // ===== Sum area weighted vertex normals =====
+        const vertexNormals = try allocator.alloc(f32, mesh.vertexCount * 3);
+        @memset(vertexNormals, 0);
+        for (0..triangleCount) |f| {
+            for (indices[f * 3 ..][0..3]) |v| {
+                for (0..3) |k| vertexNormals[v * 3 + k] += faceNormals[f * 3 + k] * faceAreas[f];
+            }
+        }
+        const vertexDirty = try allocator.alloc(bool, mesh.vertexCount);
+        @memset(vertexDirty, false);
 
         // std.debug.print("vertexCount: {}\n", .{@divExact(vertices.len, 3)});
 
         // ===== Create storage =====
         var halfEdges = try allocator.alloc(HalfEdge, 3 * triangleCount); // Needs more capacity for boundary twins //try std.ArrayList(HalfEdge).initCapacity(allocator, 3*triangleCount);
-        var twinless = try allocator.alloc(bool, 3 * triangleCount);
-        defer allocator.free(twinless);
+        var twinless = try scratch.alloc(bool, 3 * triangleCount);
+        defer scratch.free(twinless);
         var twinnedCount: u32 = 0;
         for (0..twinless.len) |i| twinless[i] = true;
-        var links = std.AutoHashMap([2]u32, u32).init(allocator);
+        var links = std.AutoHashMap([2]u32, u32).init(scratch);
         defer links.deinit();
         try links.ensureTotalCapacity(4 * @as(u32, @intCast(triangleCount))); // add 3*triangles actual capacity -> ensure more empty space
 
@@ -349,8 +386,12 @@ pub const HalfEdges = struct {
             .indexBuffer1 = try std.ArrayList(u32).initCapacity(allocator, 30),
             .indexBuffer2 = try std.ArrayList(u32).initCapacity(allocator, 30),
             .faceNormals = faceNormals,
+            .faceAreas = faceAreas,
             .normalBuffer1 = try std.ArrayList(FaceNormalInfo).initCapacity(allocator, 30),
             .normalBuffer2 = try std.ArrayList(FaceNormalInfo).initCapacity(allocator, 30),
+            .vertexNormals = vertexNormals,
+            .vertexDirty = vertexDirty,
+            .dirtyVertices = try std.ArrayList(u32).initCapacity(allocator, 32),
             .indices = indices,
 
             .alteredErrorsBuffer = try std.ArrayList(AlteredEdgeErrorInfo).initCapacity(allocator, 32),
@@ -362,6 +403,9 @@ pub const HalfEdges = struct {
 
         allocator.free(self.HE);
         allocator.free(self.faceNormals);
+        allocator.free(self.faceAreas);
+        allocator.free(self.vertexNormals);
+        allocator.free(self.vertexDirty);
 
         if (self.quadricError) |err| allocator.free(err);
         if (self.edgeErrors) |err| allocator.free(err);
@@ -374,6 +418,7 @@ pub const HalfEdges = struct {
 
         self.normalBuffer1.deinit();
         self.normalBuffer2.deinit();
+        self.dirtyVertices.deinit();
 
         self.alteredErrorsBuffer.deinit();
     }
@@ -418,9 +463,13 @@ pub const HalfEdges = struct {
     /// Collapse mesh until errThreshold. Alters `self.edge` and `self.mesh`.
     pub fn collapseMesh(self: *HalfEdges, errThreshold: f32) !void {
         const allocator = self.allocator;
+        const scratchArena = scratch_arena.threadScratch(allocator);
+        const mark = scratchArena.mark();
+        defer scratchArena.restore(mark);
+        const scratch = scratchArena.allocator();
 
         // ===== Create edge errors =====
-        if (self.quadricError == null) try self.addErrorMatrices(1000);
+        if (self.quadricError == null) try self.addErrorMatrices(defaultBoundaryPenalty);
 
         if (self.edgeErrors == null) try self.addEdgeErrorsList();
         const edgeErrors = self.edgeErrors.?;
@@ -469,58 +518,17 @@ pub const HalfEdges = struct {
 
         // ===== Create linkedErrors list =====
         std.debug.print("Start collapse with error threshold: {d}\n", .{errThreshold});
-        var LE = try LinkedErrors.fromEdgeErrors(allocator, edgeErrors, errThreshold);
+        var LE = try LinkedErrors.fromEdgeErrors(allocator, scratch, edgeErrors, errThreshold);
         defer LE.deinit();
 
-        var debug: u32 = 0;
         var onlyErrors: bool = false;
         while (!onlyErrors) : (LE.resetStart()) {
             onlyErrors = true;
             var chainExists = true;
 
-            // ===== DEBUG PRINT =====
-            std.debug.print("looping\n", .{});
-            // ===== DEBUG PRINT =====
-
             while (LE.getEdgeIndexWithLowestError()) |edge| {
                 self.edge = edge;
                 var EndOfChain = false;
-                // ===== DEBUG PRINT ======
-                std.debug.print("\nprocessed edge: {}\n", .{edge});
-
-                if (edge == 4314) {
-                    self.printEdgeChain(19050, LE);
-                    std.debug.print("\n", .{});
-                }
-
-                if (self.HE[19050].prev == self.HE[19050].next) {
-                    std.debug.print("degenerate mesh\n", .{});
-                    self.printEdgeChain(19050, LE);
-                    std.debug.print("\n", .{});
-                    return error.Unexpected;
-                }
-
-                if (self.edge == 1176) {
-                    printEdgeHeader();
-                    self.printEdge(19050);
-                    self.printEdge(19086);
-                }
-
-                if (self.edge == 1776) {
-                    printEdgeHeader();
-                    self.printEdge(19050);
-                    self.printEdge(19086);
-                }
-
-                if (self.edge == 2523) {
-                    std.debug.print("error of edge[{}] ({}): {}/{}\n", .{ edge, LE.inChain(edge), LE.edgeErrors[edge].err, errThreshold });
-                    // printEdgeHeader();
-                    // for([_]u32{16, 15, 17, 58})|e|self.printEdge(e);
-                    // std.debug.print("\n", .{});
-                    // std.debug.print("\nedge[16]:", .{});
-                    // for([_]u32{64, 51, 49, 16, 60, 33, 16}) | e | std.debug.print("edge[{}] inChain: {}\n", .{e, LE.inChain(e)});
-                }
-                // ===== DEBUG PRINT ======
                 // std.debug.print("\nprocessed edge: {}\n", .{edge});
                 // std.debug.print("error of edge[{}] ({}): {}/{}\n", .{ edge, LE.inChain(edge), LE.edgeErrors[edge].err, errThreshold });
                 // if(self.edgeErrors.?[edge].err >= errThreshold) return error.Unexpected;
@@ -530,7 +538,7 @@ pub const HalfEdges = struct {
                 // try LE.chainCheck(self.HE); // Check chain integrity
 
                 // std.debug.print("\n---------------------------------------------\n", .{});
-                // std.debug.print("collapsing edge({}): {}\n", .{ debug, self.edge });
+                // std.debug.print("collapsing edge({}): {}\n", .{ self.collapses, self.edge });
 
                 self.collapseEdge() catch |err| switch (err) {
                     HalfEdgeError.FaceFlip, HalfEdgeError.DetachedVertex, HalfEdgeError.NotEnoughNeighbours, HalfEdgeError.TooManyNeighbours, HalfEdgeError.SingularFace => {
@@ -549,26 +557,7 @@ pub const HalfEdges = struct {
 
                 // ===== Propegate edge collapse in linkedErrors =====
                 // ----- re-order halfEdges -----
-                if (self.edge == 2523) {
-                    std.debug.print("flag0\n", .{});
-                    printEdgeHeader();
-                    self.printEdgeWithOrigin(self.getHalfEdge().origin);
-                    std.debug.print("halfedge count: {}\n", .{self.HE.len});
-                    for (self.alteredErrorsBuffer.items) |alt| {
-                        std.debug.print("altered edge: {}\n", .{alt.index});
-                    }
-                }
-
-                if (edge == 4314) {
-                    std.debug.print("altered edges:\n", .{});
-                    printEdgeHeader();
-                    for (self.alteredErrorsBuffer.items) |alt| {
-                        self.printEdge(alt.index);
-                    }
-                }
-
                 try LE.reevaluateEntries(self.alteredErrorsBuffer.items); // remove try -> remove try from LLspot
-                if (self.edge == 2523) std.debug.print("flag1\n", .{});
 
                 // ----- remove deleted edges ------
                 const removeEdge1 = self.edge;
@@ -588,7 +577,6 @@ pub const HalfEdges = struct {
                     },
                     else => return err, // Unexpected error
                 };
-                if (self.edge == 2523) std.debug.print("flag2\n", .{});
                 LE.removeFaceOfEdge(removeEdge2, self.HE) catch |err| switch (err) {
                     LinkedErrorsErrors.EndOfChain => { // LE.linkStart has reached end of chain -> Try to reset
                         EndOfChain = true;
@@ -604,9 +592,8 @@ pub const HalfEdges = struct {
                     },
                     else => return err, // Unexpected error
                 };
-                if (self.edge == 2523) std.debug.print("flag3\n", .{});
 
-                debug += 1;
+                self.collapses += 1;
 
                 // // ===== DEBUG =====
                 // chainExists = false;
@@ -652,7 +639,8 @@ pub const HalfEdges = struct {
         //     util_print.print_CM_4Matd(t2);
         // }
         // ===== DEBUG PRINT =====
-        try LE.updateToPHMesh(self.HE, self.mesh);
+        self.updateVertexNormals();
+        try LE.updateToPHMesh(scratch, self.HE, self.mesh);
     }
 
     /// Modify self to collapse edge, stores alteredEdgeErrInfo in `self.alteredErrorsBuffer`
@@ -855,6 +843,9 @@ pub const HalfEdges = struct {
         qe1[8] += qe2[8];
         qe1[9] += qe2[9];
 
+        // ===== Carry normals and texcoords over the collapse =====
+        try self.commitAttributes(collapsingFaces, mergedOrigin, removedOrigin, V_mergedOrigin_old);
+
         // ===== Update new edge-collapse errors =====
         // std.debug.print("Construct new error values\n", .{});
         self.alteredErrorsBuffer.clearRetainingCapacity();
@@ -1133,6 +1124,7 @@ pub const HalfEdges = struct {
 
             for (self.normalBuffer1.items) |normalInfo| {
                 @memcpy(normals[normalInfo.i_face..][0..3], &normalInfo.normal);
+                self.faceAreas[normalInfo.i_face / 3] = normalInfo.area;
             }
             for (self.indexBuffer1.items) |ind| {
                 indices[ind] = removedOrigin.?;
@@ -1147,6 +1139,7 @@ pub const HalfEdges = struct {
 
             for (self.normalBuffer2.items) |normalInfo| {
                 @memcpy(normals[normalInfo.i_face..][0..3], &normalInfo.normal);
+                self.faceAreas[normalInfo.i_face / 3] = normalInfo.area;
             }
             for (self.indexBuffer2.items) |ind| {
                 indices[ind] = removedOrigin.?;
@@ -1157,7 +1150,7 @@ pub const HalfEdges = struct {
     /// For all faces adjointing vertex at base of `self.edge`, replace `removedVertex` from `self.indices` to `mergedVertex`.
     /// Replaces normals in `self.faceNormals` with new orientation.
     ///
-    /// Stores old normals in `normalBuffer`, and the indices inside which `self.indices` which were changed in `indexBuffer`
+    /// Stores old normals, areas and indices in `normalBuffer`, and the indices inside which `self.indices` which were changed in `indexBuffer`
     ///
     /// If face flips, return an error
     fn modifyIndices(self: *HalfEdges, normalBuffer: *std.ArrayList(FaceNormalInfo), replacedIndicesBuffer: *std.ArrayList(u32), mergedVertex: u32, removedVertex: u32) !void {
@@ -1188,6 +1181,7 @@ pub const HalfEdges = struct {
             const norm_old = faceNormals[i_currFace..][0..3];
 
             const currIndices = indices[i_currFace..][0..3];
+            const oldIndices = currIndices.*;
             if (std.mem.indexOfScalar(u32, currIndices, removedVertex)) |pos| {
                 // std.debug.print("face: {} != {}/{}\n", .{i_currFace, leftFace, rightFace});
                 // std.debug.print("RemovedVertex: {}\n", .{removedVertex});
@@ -1225,16 +1219,87 @@ pub const HalfEdges = struct {
                 return HalfEdgeError.FaceFlip;
             } else {
                 const normalInfo = FaceNormalInfo{
-                    .normal = norm_new,
+                    .normal = norm_old.*,
+                    .area = self.faceAreas[i_currFace / 3],
+                    .indices = oldIndices,
                     .i_face = i_currFace,
                 };
-                try normalBuffer.append(normalInfo); // Store slice
+                try normalBuffer.append(normalInfo); // Store old state for `restoreCollapse` and `commitAttributes`
+
+                // ----- norm_new is the unnormalized cross product -----
+                const area = 0.5 * @sqrt(@reduce(.Add, @as(avec3, norm_new) * @as(avec3, norm_new)));
+                @memcpy(norm_old, &@as([3]f32, math.vec3returnNormalize(norm_new)));
+                self.faceAreas[i_currFace / 3] = area;
             }
         }
 
         self.edge = currEdge;
     }
 
+    /// Carry attributes over a successful collapse of the edge between `mergedVertex` and `removedVertex`.
+    ///
+    /// Moves the contributions of every face changed by `modifyIndices` in the vertex normal sums, drops those of the
+    /// `collapsingFaces` and marks the vertices involved for `updateVertexNormals`. Texcoords of `mergedVertex` are
+    /// interpolated along the collapsed edge. Work is proportional to the faces around the edge.
+    fn commitAttributes(self: *HalfEdges, collapsingFaces: [2]u32, mergedVertex: u32, removedVertex: u32, mergedVertexOld: [3]f32) !void {
+        const faceNormals = self.faceNormals;
+
+        // ===== Remove collapsed faces =====
+        for (collapsingFaces) |i_face| {
+            if (i_face == std.math.maxInt(u32)) continue;
+            for (self.indices[i_face..][0..3]) |v| {
+                self.addFaceNormal(v, faceNormals[i_face..][0..3].*, -self.faceAreas[i_face / 3]);
+                try self.markDirty(v);
+            }
+            self.faceAreas[i_face / 3] = 0;
+        }
+
+        // ===== Move contributions of altered faces =====
+        for ([2][]FaceNormalInfo{ self.normalBuffer1.items, self.normalBuffer2.items }) |normalInfos| {
+            for (normalInfos) |info| {
+                for (info.indices) |v| self.addFaceNormal(v, info.normal, -info.area);
+                for (self.indices[info.i_face..][0..3]) |v| {
+                    self.addFaceNormal(v, faceNormals[info.i_face..][0..3].*, self.faceAreas[info.i_face / 3]);
+                    try self.markDirty(v);
+                }
+            }
+        }
+        @memset(self.vertexNormals[removedVertex * 3 ..][0..3], 0);
+
+        // ===== Interpolate texcoords along the collapsed edge =====
+        const texcoords = self.mesh.texcoords;
+        const a: avec3 = mergedVertexOld;
+        const b: avec3 = self.vertices[removedVertex * 3 ..][0..3].*;
+        const p: avec3 = self.vertices[mergedVertex * 3 ..][0..3].*;
+        const edgeLen2 = @reduce(.Add, (b - a) * (b - a));
+        const t = if (edgeLen2 == 0) 0 else std.math.clamp(@reduce(.Add, (p - a) * (b - a)) / edgeLen2, 0, 1);
+        for (0..2) |k| {
+            const uv = &texcoords[mergedVertex * 2 + k];
+            uv.* += (texcoords[removedVertex * 2 + k] - uv.*) * t;
+        }
+    }
+
+    inline fn addFaceNormal(self: *HalfEdges, vertex: u32, normal: [3]f32, weight: f32) void {
+        for (0..3) |k| self.vertexNormals[vertex * 3 + k] += normal[k] * weight;
+    }
+
+    fn markDirty(self: *HalfEdges, vertex: u32) !void {
+        if (self.vertexDirty[vertex]) return;
+        self.vertexDirty[vertex] = true;
+        try self.dirtyVertices.append(vertex);
+    }
+
+    /// Write normals of vertices touched since the last call to `mesh.normals`
+    pub fn updateVertexNormals(self: *HalfEdges) void {
+        const normals = self.mesh.normals;
+        for (self.dirtyVertices.items) |v| {
+            const sum: avec3 = self.vertexNormals[v * 3 ..][0..3].*;
+            @memcpy(normals[v * 3 ..][0..3], &@as([3]f32, math.vec3returnNormalize(sum)));
+            self.vertexDirty[v] = false;
+        }
+        self.dirtyVertices.clearRetainingCapacity();
+    }
+
     /// Get `halfEdge`s from shared neighbouring vertices towards start and end vertices of `self.edge`.
     /// First entree in edge-pairs ([2]*Halfedges) points to base of `self.edge`, second entree points to vertex at end of `self.edge`
     ///
@@ -1467,7 +1532,7 @@ pub const HalfEdges = struct {
     }
 
     /// Returns error matrices based on indices, vertices, and normals. Sorting mirrors `self.vertices`
-    fn addErrorMatrices(self: *HalfEdges, boundaryPenalty: f32) !void {
+    pub fn addErrorMatrices(self: *HalfEdges, boundaryPenalty: f32) !void {
         // ===== Retreive mesh constituent =====
         const allocator = self.allocator;
         const vertices = self.vertices;
@@ -1511,41 +1576,6 @@ pub const HalfEdges = struct {
         if (boundaryPenalty != 0) try self.addBoundaryErrors(boundaryPenalty);
     }
 
-    fn getFaceNormals(allocator: Allocator, vertices: []f32, indices: []u32) ![]f32 {
-        const triangleCount = @divExact(indices.len, 3);
-        const faceNormals = try allocator.alloc(f32, triangleCount * 3);
-
-        var i: usize = 0;
-        while (i < triangleCount) : (i += 1) {
-            const i_a: u32 = indices[i * 3];
-            const i_b: u32 = indices[i * 3 + 1];
-            const i_c: u32 = indices[i * 3 + 2];
-
-            // const debugCond = i_a == 0 or i_b == 0 or i_c == 0;
-
-            // if(debugCond) std.debug.print("V1: ({d}, {d}, {d})\n", .{vertices[i_a * 3], vertices[i_a * 3+1], vertices[i_a * 3+2]});
-            // if(debugCond) std.debug.print("V2: ({d}, {d}, {d})\n", .{vertices[i_b * 3], vertices[i_b * 3+1], vertices[i_b * 3+2]});
-            // if(debugCond) std.debug.print("V3: ({d}, {d}, {d})\n", .{vertices[i_c * 3], vertices[i_c * 3+1], vertices[i_c * 3+2]});
-
-            const V1: avec3 = vertices[i_a * 3 ..][0..3].*;
-            const V2: avec3 = vertices[i_b * 3 ..][0..3].*;
-            const V3: avec3 = vertices[i_c * 3 ..][0..3].*;
-
-            const edge1 = V2 - V1;
-            const edge2 = V3 - V1;
-            const tmp_0 = @shuffle(f32, edge1, edge1, avec3{ 1, 2, 0 });
-            const tmp_1 = @shuffle(f32, edge2, edge2, avec3{ 2, 0, 1 });
-            const tmp_2 = tmp_0 * edge2;
-            const tmp_3 = @shuffle(f32, tmp_2, tmp_2, avec3{ 1, 2, 0 });
-            const tmp_4 = tmp_0 * tmp_1;
-            const cross = tmp_4 - tmp_3; // Edge 1 x edge 2
-
-            @memcpy(faceNormals[i * 3 ..][0..3], @as([3]f32, math.vec3returnNormalize(cross))[0..]);
-            // if(debugCond) std.debug.print("normal: ({d}, {d}, {d})\n", .{faceNormals[i*3], faceNormals[i*3+1], faceNormals[i*3+2]});
-        }
-        return faceNormals;
-    }
-
     pub fn printEdgeHeader() void {
         std.debug.print("Edge       | Origin     | Twin       | Next       | Prev       | i_face     |\n", .{});
     }
@@ -1633,7 +1663,9 @@ pub const LinkedErrors = struct {
     /// Returns linked list of errors which may be used to perform certain operations like insertions, alterations, and re-evaluating entries.
     ///
     /// Linked-items have an index corresponding to edgeErrors. Linked-items will link-up to be ordered according to ascending collapse-errors
-    pub fn fromEdgeErrors(allocator: Allocator, edgeErrors: []EdgeErrInfo, errorCutOff: f32) !LinkedErrors {
+    ///
+    /// Sorting temporaries are allocated with `scratch`.
+    pub fn fromEdgeErrors(allocator: Allocator, scratch: Allocator, edgeErrors: []EdgeErrInfo, errorCutOff: f32) !LinkedErrors {
         // ===== Create HalfEdges with indices for linkedList =====
         const itemCount: u32 = @intCast(edgeErrors.len);
 
@@ -1647,8 +1679,8 @@ pub const LinkedErrors = struct {
         }
 
         // connect 'linkedList' to be sorted & retreive sorted indices of edgeErrors 'surrogateLinks'
-        const surrogateLinks = try linkUpToAscendingValues(allocator, linkedList);
-        defer allocator.free(surrogateLinks);
+        const surrogateLinks = try linkUpToAscendingValues(scratch, linkedList);
+        defer scratch.free(surrogateLinks);
         const linkStart = surrogateLinks[0].originalIndex;
         const linkEnd = surrogateLinks[itemCount - 1].originalIndex; // Last item in linked list
 
@@ -2357,8 +2389,9 @@ pub const LinkedErrors = struct {
     ///
     /// Mesh should be the parent of the halfEdges to avoid innapropriate memory allocation.
     ///
-    /// Only alters geometry (`mesh.vertices` and `mesh.indices`).
-    pub fn updateToPHMesh(self: LinkedErrors, halfEdges: []HalfEdge, mesh: *PlaceHolderMesh) !void {
+    /// Alters `mesh.vertices` and `mesh.indices`, moving `mesh.normals` and `mesh.texcoords` along with the vertices.
+    /// Bookkeeping buffers are allocated with `scratch`.
+    pub fn updateToPHMesh(self: LinkedErrors, scratch: Allocator, halfEdges: []HalfEdge, mesh: *PlaceHolderMesh) !void {
         // ===== Store constants =====
         const allocator = self.allocator;
 
@@ -2367,7 +2400,7 @@ pub const LinkedErrors = struct {
         const LL_length: u32 = @intCast(LL.len);
 
         // ===== Store face-adjacent halfEdges =====
-        const longEdges: []HalfEdge = try allocator.alloc(HalfEdge, LL.len);
+        const longEdges: []HalfEdge = try scratch.alloc(HalfEdge, LL.len);
 
         var i: u32 = self.valueFlags.items[0].index;
         var j: u32 = 0; // Count of face-adjacent edges
@@ -2405,8 +2438,8 @@ pub const LinkedErrors = struct {
 
         const faceCount = @divExact(j, 3);
 
-        const edges: []HalfEdge = try allocator.realloc(longEdges, j); // trim longedges to valid edges
-        defer allocator.free(edges);
+        const edges: []HalfEdge = longEdges[0..j]; // trim longedges to valid edges
+        defer scratch.free(longEdges);
 
         // // ===== DEBUG PRINT =====
         // var bordering_edges: u32 = 0;
@@ -2455,10 +2488,10 @@ pub const LinkedErrors = struct {
         // // ===== DEBUG PRINT =====
 
         // ===== Find used indices/vertices =====
-        const intactVertex: []bool = try allocator.alloc(bool, mesh.vertexCount);
-        const intactFace: []bool = try allocator.alloc(bool, mesh.triangleCount);
-        defer allocator.free(intactVertex);
-        defer allocator.free(intactFace);
+        const intactVertex: []bool = try scratch.alloc(bool, mesh.vertexCount);
+        const intactFace: []bool = try scratch.alloc(bool, mesh.triangleCount);
+        defer scratch.free(intactVertex);
+        defer scratch.free(intactFace);
 
         // ----- initialize to false -----
         const minIntactLen = @min(intactFace.len, intactVertex.len);
@@ -2492,9 +2525,11 @@ pub const LinkedErrors = struct {
         // ===== Realocate indices =====
         const indices = mesh.indices;
         const vertices = mesh.vertices;
+        const normals = mesh.normals;
+        const texcoords = mesh.texcoords;
 
-        const vertexMoved: []?u32 = try allocator.alloc(?u32, intactVertex.len);
-        defer allocator.free(vertexMoved);
+        const vertexMoved: []?u32 = try scratch.alloc(?u32, intactVertex.len);
+        defer scratch.free(vertexMoved);
         for (0..vertexMoved.len) |q| vertexMoved[q] = null; // initialize to null
         var i_validFace: usize = std.mem.indexOfScalar(bool, intactFace, true) orelse intactFace.len; // Stores index of used-face
         var i_vertexSpot: usize = std.mem.indexOfScalar(bool, intactVertex, false) orelse intactVertex.len; // Stores unused spot in vertices which may be used to store a used-vertex
@@ -2592,6 +2627,8 @@ pub const LinkedErrors = struct {
                         intactVertex[i_vertexSpot] = true;
 
                         @memcpy(vertices[i_vertexSpot * 3 ..][0..3], vertices[i_vertex * 3 ..][0..3]); // move vertex to free spot
+                        @memcpy(normals[i_vertexSpot * 3 ..][0..3], normals[i_vertex * 3 ..][0..3]);
+                        @memcpy(texcoords[i_vertexSpot * 2 ..][0..2], texcoords[i_vertex * 2 ..][0..2]);
                         i_vertexSpot = std.mem.indexOfScalarPos(bool, intactVertex, i_vertexSpot + 1, false) orelse intactVertex.len; // look for next free spot
                     }
                 }
@@ -2615,6 +2652,8 @@ pub const LinkedErrors = struct {
         mesh.vertexCount = @intCast(i_vertexSpot); // Index of first unused memory spot
         mesh.triangleCount = @intCast(faceCount);
         mesh.vertices = try allocator.realloc(mesh.vertices, mesh.vertexCount * 3);
+        mesh.normals = try allocator.realloc(mesh.normals, mesh.vertexCount * 3);
+        mesh.texcoords = try allocator.realloc(mesh.texcoords, mesh.vertexCount * 2);
         mesh.indices = try allocator.realloc(mesh.indices, mesh.triangleCount * 3);
 
         if (mesh.vertexCount - 1 < std.mem.max(u32, mesh.indices)) std.debug.print("Indices refer to non-existing vertex\n", .{});
@@ -2852,4 +2891,6 @@ pub const CollapsingFaceTwins = struct {
 const FaceNormalInfo = struct {
     i_face: u32,
     normal: [3]f32,
+    area: f32,
+    indices: [3]u32,
 };
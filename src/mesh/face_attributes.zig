@@ -0,0 +1,81 @@
+const std = @import("std");
+const math = @import("../math.zig");
+const MN = @import("../globals.zig");
+const tracking = @import("../utils/tracking_allocator.zig");
+
+const Allocator = std.mem.Allocator;
+
+/// Unit normal, area and centroid of every face of an indexed triangle mesh, as structure of arrays.
+///
+/// Computed in one pass by the `eigen_face_attributes` wrapper kernel (gathered 8 faces at a time, split over threads), so
+/// quadric setup, slope filtering and rasterization read the same arrays instead of repeating cross products.
+pub const FaceAttributes = struct {
+    allocator: Allocator,
+    count: usize,
+    normalX: []f32,
+    normalY: []f32,
+    normalZ: []f32,
+    areas: []f32,
+    centroidX: []f32,
+    centroidY: []f32,
+    centroidZ: []f32,
+    backing: []f32, // all of the above
+
+    pub fn compute(allocator: Allocator, vertices: []const f32, indices: []const u32) !FaceAttributes {
+        const prevSubsystem = tracking.enter(.wrapper);
+        defer tracking.leave(prevSubsystem);
+
+        const count = indices.len / 3;
+        const backing = try allocator.alloc(f32, count * 7);
+        math.eigen_face_attributes(vertices.ptr, indices.ptr, @intCast(count), backing.ptr, backing[count * 3 ..].ptr, backing[count * 4 ..].ptr, MN.FACE_KERNEL_THREADS);
+
+        return .{
+            .allocator = allocator,
+            .count = count,
+            .normalX = backing[0..count],
+            .normalY = backing[count..][0..count],
+            .normalZ = backing[count * 2 ..][0..count],
+            .areas = backing[count * 3 ..][0..count],
+            .centroidX = backing[count * 4 ..][0..count],
+            .centroidY = backing[count * 5 ..][0..count],
+            .centroidZ = backing[count * 6 ..][0..count],
+            .backing = backing,
+        };
+    }
+
+    pub fn deinit(self: FaceAttributes) void {
+        self.allocator.free(self.backing);
+    }
+
+    pub inline fn normal(self: FaceAttributes, face: usize) [3]f32 {
+        return .{ self.normalX[face], self.normalY[face], self.normalZ[face] };
+    }
+
+    pub inline fn centroid(self: FaceAttributes, face: usize) [3]f32 {
+        return .{ self.centroidX[face], self.centroidY[face], self.centroidZ[face] };
+    }
+
+    /// Rise over run of the face plane, infinite for vertical faces
+    pub inline fn slope(self: FaceAttributes, face: usize) f32 {
+        const x = self.normalX[face];
+        const z = self.normalZ[face];
+        return @sqrt(x * x + z * z) / @abs(self.normalY[face]);
+    }
+};
+
+/// Area weighted vertex normals of an indexed triangle mesh, written to zeroed `normals`
+pub fn vertexNormals(scratch: Allocator, vertices: []const f32, indices: []const u32, normals: []f32) !void {
+    const faces = try FaceAttributes.compute(scratch, vertices, indices);
+    defer faces.deinit();
+
+    for (0..faces.count) |f| {
+        const n = faces.normal(f);
+        const area = faces.areas[f];
+        for (indices[f * 3 ..][0..3]) |v| {
+            normals[v * 3] += n[0] * area;
+            normals[v * 3 + 1] += n[1] * area;
+            normals[v * 3 + 2] += n[2] * area;
+        }
+    }
+    for (0..normals.len / 3) |v| math.vec3normalize(normals[v * 3 ..][0..3]);
+}
@@ -0,0 +1,361 @@
+const std = @import("std");
+const math = @import("../math.zig");
+const MN = @import("../globals.zig");
+
+const PHMesh = @import("processing.zig").PlaceHolderMesh;
+
+const Allocator = std.mem.Allocator;
+const Vec3 = math.vec3;
+
+// Deterministic synthetic meshes for scaling studies: import, chunking, simplification and culling can be swept from a
+// few thousand to tens of millions of triangles without assets. Every shape takes a target triangle count and lands
+// within a few percent of it. Equal arguments give equal meshes: terrain noise is integer hashed and defects are
+// placed by a generator seeded from the arguments.
+
+const GenerateError = error{TooManyTriangles};
+
+pub const Shape = enum { terrain, sphere, torus, degenerate };
+
+pub const TerrainOptions = struct {
+    size: Vec3(f32) = MN.MAP_SIZE[0], // extent, heights span [0, size.y]
+    frequency: f32 = 4, // noise periods across the map
+    octaves: u32 = 6,
+};
+
+pub const DegenerateOptions = struct {
+    terrain: TerrainOptions = .{},
+    fraction: f32 = 1.0 / 64.0, // share of the triangles in every defect category
+};
+
+/// Mesh of `shape` with about `triangleCount` triangles, default options
+pub fn generate(allocator: Allocator, shape: Shape, triangleCount: usize, seed: u64) !PHMesh {
+    return switch (shape) {
+        .terrain => try terrain(allocator, triangleCount, seed, .{}),
+        .sphere => try sphere(allocator, triangleCount, 1),
+        .torus => try torus(allocator, triangleCount, 3, 1),
+        .degenerate => try degenerate(allocator, triangleCount, seed, .{}),
+    };
+}
+
+// ======================================
+// Shapes
+// ======================================
+
+/// Heightfield of fractal value noise on a square grid, y up, starting at the origin
+pub fn terrain(allocator: Allocator, triangleCount: usize, seed: u64, options: TerrainOptions) !PHMesh {
+    const quads = gridQuads(triangleCount);
+    const mesh = try allocMesh(allocator, (quads + 1) * (quads + 1), 2 * quads * quads);
+    fillTerrain(mesh, quads, seed, options);
+    return mesh;
+}
+
+/// Closed latitude-longitude sphere around the origin, poles on the y axis
+pub fn sphere(allocator: Allocator, triangleCount: usize, radius: f32) !PHMesh {
+    // ----- 2 * segments * (rings - 1) triangles with segments = 2 * rings -----
+    const rings: usize = @max(2, @as(usize, @intFromFloat(@round((1 + @sqrt(1 + @as(f64, @floatFromInt(triangleCount)))) / 2))));
+    const segments = 2 * rings;
+    const mesh = try allocMesh(allocator, (rings - 1) * segments + 2, 2 * segments * (rings - 1));
+
+    // ----- vertices: north pole, rings from north to south, south pole -----
+    const south = mesh.vertexCount - 1;
+    setVertex(mesh, 0, .{ 0, radius, 0 }, .{ 0, 1, 0 }, .{ 0.5, 0 });
+    setVertex(mesh, south, .{ 0, -radius, 0 }, .{ 0, -1, 0 }, .{ 0.5, 1 });
+    for (1..rings) |r| {
+        const v = @as(f32, @floatFromInt(r)) / @as(f32, @floatFromInt(rings));
+        const theta = std.math.pi * v;
+        for (0..segments) |j| {
+            const u = @as(f32, @floatFromInt(j)) / @as(f32, @floatFromInt(segments));
+            const phi = 2 * std.math.pi * u;
+            const n = [3]f32{ @sin(theta) * @cos(phi), @cos(theta), -@sin(theta) * @sin(phi) };
+            setVertex(mesh, 1 + (r - 1) * segments + j, .{ n[0] * radius, n[1] * radius, n[2] * radius }, n, .{ u, v });
+        }
+    }
+
+    // ----- pole fans, then quads between rings -----
+    const lastRing: u32 = @intCast(1 + (rings - 2) * segments);
+    for (0..segments) |j| {
+        const next: u32 = @intCast((j + 1) % segments);
+        const k: u32 = @intCast(j);
+        mesh.indices[j * 3 ..][0..3].* = .{ 0, 1 + k, 1 + next };
+        mesh.indices[(segments + j) * 3 ..][0..3].* = .{ lastRing + k, south, lastRing + next };
+    }
+    writeGrid(mesh.indices[segments * 6 ..], segments, rings - 2, segments, rings - 1, 1);
+    return mesh;
+}
+
+/// Torus around the y axis with `majorRadius` to the tube center and `minorRadius` of the tube
+pub fn torus(allocator: Allocator, triangleCount: usize, majorRadius: f32, minorRadius: f32) !PHMesh {
+    // ----- quads roughly square: segments around the axis scale with the radii -----
+    const ratio = majorRadius / minorRadius;
+    const tube: usize = @max(3, @as(usize, @intFromFloat(@round(@sqrt(@as(f32, @floatFromInt(triangleCount)) / (2 * ratio))))));
+    const around: usize = @max(3, @divFloor(triangleCount, 2 * tube));
+    const mesh = try allocMesh(allocator, around * tube, 2 * around * tube);
+
+    for (0..tube) |t| {
+        const v = @as(f32, @floatFromInt(t)) / @as(f32, @floatFromInt(tube));
+        const beta = 2 * std.math.pi * v;
+        for (0..around) |a| {
+            const u = @as(f32, @floatFromInt(a)) / @as(f32, @floatFromInt(around));
+            const alpha = 2 * std.math.pi * u;
+            const n = [3]f32{ @cos(beta) * @cos(alpha), @sin(beta), @cos(beta) * @sin(alpha) };
+            const ring = majorRadius + minorRadius * @cos(beta);
+            setVertex(mesh, t * around + a, .{ ring * @cos(alpha), minorRadius * n[1], ring * @sin(alpha) }, n, .{ u, v });
+        }
+    }
+    writeGrid(mesh.indices, around, tube, around, tube, 0);
+    return mesh;
+}
+
+/// Terrain with defects simplification and import have to survive, `options.fraction` of the triangles each:
+///  - zero area triangles (a repeated corner)
+///  - unwelded corners (a coincident copy of a vertex)
+///  - flipped winding
+///  - non-manifold edges (a fin standing on an interior edge)
+///  - duplicated faces
+pub fn degenerate(allocator: Allocator, triangleCount: usize, seed: u64, options: DegenerateOptions) !PHMesh {
+    const defects: usize = @intFromFloat(@as(f64, @floatFromInt(triangleCount)) * options.fraction);
+    const quads = gridQuads(triangleCount -| 2 * defects);
+    const gridVertices = (quads + 1) * (quads + 1);
+    const gridTriangles = 2 * quads * quads;
+
+    // ----- grid first, split vertices and fin apexes appended -----
+    const mesh = try allocMesh(allocator, gridVertices + 2 * defects, gridTriangles + 2 * defects);
+    fillTerrain(mesh, quads, seed, options.terrain);
+
+    var rng = std.Random.DefaultPrng.init(seed ^ 0xDE9E);
+    const random = rng.random();
+    var vertex: u32 = @intCast(gridVertices);
+    var triangle: usize = gridTriangles;
+    for (0..defects) |_| {
+        // ----- zero area -----
+        const collapsed = mesh.indices[random.uintLessThan(usize, gridTriangles) * 3 ..][0..3];
+        collapsed[1] = collapsed[0];
+
+        // ----- unwelded corner -----
+        const corner = &mesh.indices[random.uintLessThan(usize, gridTriangles) * 3 + random.uintLessThan(usize, 3)];
+        copyVertex(mesh, vertex, corner.*);
+        corner.* = vertex;
+        vertex += 1;
+
+        // ----- flipped -----
+        const flipped = mesh.indices[random.uintLessThan(usize, gridTriangles) * 3 ..][0..3];
+        std.mem.swap(u32, &flipped[1], &flipped[2]);
+
+        // ----- fin on the b-c edge of a grid triangle (shared with its neighbour) -----
+        const base = mesh.indices[random.uintLessThan(usize, gridTriangles) * 3 ..][0..3].*;
+        const b = mesh.vertices[base[1] * 3 ..][0..3];
+        const c = mesh.vertices[base[2] * 3 ..][0..3];
+        const apex = [3]f32{ (b[0] + c[0]) / 2, (b[1] + c[1]) / 2 + options.terrain.size.y / @as(f32, @floatFromInt(quads)), (b[2] + c[2]) / 2 };
+        setVertex(mesh, vertex, apex, .{ 1, 0, 0 }, .{ 0, 0 });
+        mesh.indices[triangle * 3 ..][0..3].* = .{ base[1], base[2], vertex };
+        vertex += 1;
+        triangle += 1;
+
+        // ----- duplicate face -----
+        const original = random.uintLessThan(usize, gridTriangles);
+        @memcpy(mesh.indices[triangle * 3 ..][0..3], mesh.indices[original * 3 ..][0..3]);
+        triangle += 1;
+    }
+    return mesh;
+}
+
+// ======================================
+// Writers
+// ======================================
+
+/// Write `mesh` as .obj with positions, texcoords and normals, readable by `importPHMeshObj`
+pub fn writeObj(mesh: PHMesh, path: []const u8) !void {
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+    var buffered = std.io.bufferedWriter(file.writer());
+    const writer = buffered.writer();
+
+    try writer.print("# generated, {} vertices, {} triangles\n", .{ mesh.vertexCount, mesh.triangleCount });
+    for (0..mesh.vertexCount) |v| try writer.print("v {d} {d} {d}\n", .{ mesh.vertices[v * 3], mesh.vertices[v * 3 + 1], mesh.vertices[v * 3 + 2] });
+    for (0..mesh.vertexCount) |v| try writer.print("vt {d} {d}\n", .{ mesh.texcoords[v * 2], mesh.texcoords[v * 2 + 1] });
+    for (0..mesh.vertexCount) |v| try writer.print("vn {d} {d} {d}\n", .{ mesh.normals[v * 3], mesh.normals[v * 3 + 1], mesh.normals[v * 3 + 2] });
+    for (0..mesh.triangleCount) |f| {
+        const t = mesh.indices[f * 3 ..][0..3];
+        try writer.print("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n", .{ t[0] + 1, t[1] + 1, t[2] + 1 });
+    }
+    try buffered.flush();
+}
+
+/// Write `mesh` as binary little endian .ply with interleaved position, normal and texcoord, readable by `importPly`
+pub fn writePly(mesh: PHMesh, path: []const u8) !void {
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+    var buffered = std.io.bufferedWriter(file.writer());
+    const writer = buffered.writer();
+
+    try writer.print(
+        \\ply
+        \\format binary_little_endian 1.0
+        \\comment generated
+        \\element vertex {}
+        \\property float x
+        \\property float y
+        \\property float z
+        \\property float nx
+        \\property float ny
+        \\property float nz
+        \\property float u
+        \\property float v
+        \\element face {}
+        \\property list uchar uint vertex_indices
+        \\end_header
+        \\
+    , .{ mesh.vertexCount, mesh.triangleCount });
+
+    for (0..mesh.vertexCount) |v| {
+        for (mesh.vertices[v * 3 ..][0..3]) |x| try writer.writeInt(u32, @bitCast(x), .little);
+        for (mesh.normals[v * 3 ..][0..3]) |x| try writer.writeInt(u32, @bitCast(x), .little);
+        for (mesh.texcoords[v * 2 ..][0..2]) |x| try writer.writeInt(u32, @bitCast(x), .little);
+    }
+    for (0..mesh.triangleCount) |f| {
+        try writer.writeByte(3);
+        for (mesh.indices[f * 3 ..][0..3]) |i| try writer.writeInt(u32, i, .little);
+    }
+    try buffered.flush();
+}
+
+// ======================================
+// Helpers
+// ======================================
+
+/// Mesh with undefined contents, every array allocated at its final size
+fn allocMesh(allocator: Allocator, vertexCount: usize, triangleCount: usize) !PHMesh {
+    if (vertexCount > std.math.maxInt(u32) or triangleCount > std.math.maxInt(u32)) return GenerateError.TooManyTriangles;
+
+    const indices = try allocator.alloc(u32, triangleCount * 3);
+    errdefer allocator.free(indices);
+    const vertices = try allocator.alloc(f32, vertexCount * 3);
+    errdefer allocator.free(vertices);
+    const normals = try allocator.alloc(f32, vertexCount * 3);
+    errdefer allocator.free(normals);
+    const texcoords = try allocator.alloc(f32, vertexCount * 2);
+
+    return .{
+        .allocator = allocator,
+        .indices = indices,
+        .vertices = vertices,
+        .normals = normals,
+        .texcoords = texcoords,
+        .triangleCount = @intCast(triangleCount),
+        .vertexCount = @intCast(vertexCount),
+    };
+}
+
+/// Quads along each side of a square grid with about `triangleCount` triangles
+fn gridQuads(triangleCount: usize) usize {
+    return @max(1, @as(usize, @intFromFloat(@round(@sqrt(@as(f64, @floatFromInt(triangleCount)) / 2)))));
+}
+
+inline fn setVertex(mesh: PHMesh, v: usize, position: [3]f32, normal: [3]f32, uv: [2]f32) void {
+    mesh.vertices[v * 3 ..][0..3].* = position;
+    mesh.normals[v * 3 ..][0..3].* = normal;
+    mesh.texcoords[v * 2 ..][0..2].* = uv;
+}
+
+inline fn copyVertex(mesh: PHMesh, dst: usize, src: usize) void {
+    @memcpy(mesh.vertices[dst * 3 ..][0..3], mesh.vertices[src * 3 ..][0..3]);
+    @memcpy(mesh.normals[dst * 3 ..][0..3], mesh.normals[src * 3 ..][0..3]);
+    @memcpy(mesh.texcoords[dst * 2 ..][0..2], mesh.texcoords[src * 2 ..][0..2]);
+}
+
+/// Two triangles per quad of a `quadsX` by `quadsY` grid over vertices `base + y * columns + x`, wrapping around in
+/// x when `columns == quadsX` and in y when `rows == quadsY`. Faces point along dP/dy cross dP/dx.
+fn writeGrid(indices: []u32, quadsX: usize, quadsY: usize, columns: usize, rows: usize, base: u32) void {
+    var i: usize = 0;
+    for (0..quadsY) |y| {
+        const y1 = (y + 1) % rows;
+        for (0..quadsX) |x| {
+            const x1 = (x + 1) % columns;
+            const a: u32 = @intCast(base + y * columns + x);
+            const b: u32 = @intCast(base + y1 * columns + x);
+            const c: u32 = @intCast(base + y * columns + x1);
+            const d: u32 = @intCast(base + y1 * columns + x1);
+            indices[i..][0..6].* = .{ a, b, c, c, b, d };
+            i += 6;
+        }
+    }
+}
+
+/// Fill the first vertices and triangles of `mesh` with a (quads + 1)^2 vertex heightfield
+fn fillTerrain(mesh: PHMesh, quads: usize, seed: u64, options: TerrainOptions) void {
+    const columns = quads + 1;
+    const size = options.size;
+    const q: f32 = @floatFromInt(quads);
+
+    for (0..columns) |z| {
+        for (0..columns) |x| {
+            const u = @as(f32, @floatFromInt(x)) / q;
+            const w = @as(f32, @floatFromInt(z)) / q;
+            const height = size.y * fractalNoise(u * options.frequency, w * options.frequency, options.octaves, seed);
+            setVertex(mesh, z * columns + x, .{ u * size.x, height, w * size.z }, undefined, .{ u, w });
+        }
+    }
+
+    // ----- normals from central height differences -----
+    const dx = 2 * size.x / q;
+    const dz = 2 * size.z / q;
+    for (0..columns) |z| {
+        for (0..columns) |x| {
+            const left = mesh.vertices[(z * columns + (x -| 1)) * 3 + 1];
+            const right = mesh.vertices[(z * columns + @min(x + 1, quads)) * 3 + 1];
+            const back = mesh.vertices[((z -| 1) * columns + x) * 3 + 1];
+            const front = mesh.vertices[(@min(z + 1, quads) * columns + x) * 3 + 1];
+            const n = mesh.normals[(z * columns + x) * 3 ..][0..3];
+            n.* = .{ -(right - left) / dx, 1, -(front - back) / dz };
+            math.vec3normalize(n);
+        }
+    }
+
+    writeGrid(mesh.indices[0 .. 6 * quads * quads], quads, quads, columns, columns, 0);
+}
+
+/// Sum of `octaves` value noise layers, doubling frequency and halving amplitude, normalized to [0, 1]
+fn fractalNoise(x: f32, z: f32, octaves: u32, seed: u64) f32 {
+    var sum: f32 = 0;
+    var amplitude: f32 = 1;
+    var total: f32 = 0;
+    var frequency: f32 = 1;
+    for (0..octaves) |o| {
+        sum += amplitude * valueNoise(x * frequency, z * frequency, seed +% o);
+        total += amplitude;
+        amplitude *= 0.5;
+        frequency *= 2;
+    }
+    return if (total > 0) sum / total else 0;
+}
+
+/// Smoothly interpolated lattice noise in [0, 1]
+fn valueNoise(x: f32, z: f32, seed: u64) f32 {
+    const x0 = @floor(x);
+    const z0 = @floor(z);
+    const ix: i32 = @intFromFloat(x0);
+    const iz: i32 = @intFromFloat(z0);
+    const tx = smoothstep(x - x0);
+    const tz = smoothstep(z - z0);
+
+    const a = std.math.lerp(latticeValue(ix, iz, seed), latticeValue(ix + 1, iz, seed), tx);
+    const b = std.math.lerp(latticeValue(ix, iz + 1, seed), latticeValue(ix + 1, iz + 1, seed), tx);
+    return std.math.lerp(a, b, tz);
+}
+
+inline fn smoothstep(t: f32) f32 {
+    return t * t * (3 - 2 * t);
+}
+
+/// Hash of a lattice point to [0, 1)
+fn latticeValue(x: i32, z: i32, seed: u64) f32 {
+    var h: u64 = seed;
+    h ^= @as(u64, @as(u32, @bitCast(x))) *% 0x9E3779B97F4A7C15;
+    h ^= @as(u64, @as(u32, @bitCast(z))) *% 0xC2B2AE3D27D4EB4F;
+    h ^= h >> 33;
+    h *%= 0xFF51AFD7ED558CCD;
+    h ^= h >> 33;
+    h *%= 0xC4CEB9FE1A85EC53;
+    h ^= h >> 33;
+    return @as(f32, @floatFromInt(h >> 40)) / (1 << 24);
+}
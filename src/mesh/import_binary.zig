@@ -0,0 +1,599 @@
+const std = @import("std");
+const builtin = @import("builtin");
+
+const PHMesh = @import("processing.zig").PlaceHolderMesh;
+const vertexNormals = @import("face_attributes.zig").vertexNormals;
+const tracking = @import("../utils/tracking_allocator.zig");
+const scratch_arena = @import("../utils/scratch.zig");
+
+const Allocator = std.mem.Allocator;
+
+// Binary mesh formats: PLY (binary little or big endian) and glTF 2.0 binary (GLB).
+//
+// The file is mapped read-only (read in one go on Windows) and attributes are read through strided views into the
+// mapping. Attributes stored as tightly packed native floats / u32 indices are copied into the mesh with a single
+// memcpy, anything else (doubles, normalized integers, interleaved layouts, other endianness) is converted element by
+// element. Nothing is parsed from text except the headers.
+
+const BinaryError = error{
+    EmptyFile,
+    InvalidPly,
+    UnsupportedPly,
+    InvalidGlb,
+    UnsupportedGlb,
+    IndexOutOfRange,
+};
+
+const nativeEndian = builtin.cpu.arch.endian();
+
+/// Import binary .ply file to PHMesh. Reads `vertex` (x y z, optional nx ny nz and u v / s t) and `face`
+/// (vertex_indices), polygons are split into triangle fans.
+pub fn importPly(allocator: Allocator, path: []const u8) !PHMesh {
+    const prevSubsystem = tracking.enter(.import);
+    defer tracking.leave(prevSubsystem);
+
+    const scratch = scratch_arena.threadScratch(allocator);
+    const mark = scratch.mark();
+    defer scratch.restore(mark);
+
+    const file = try MappedFile.open(allocator, path);
+    defer file.deinit();
+    return try readPly(allocator, scratch.allocator(), file.bytes);
+}
+
+/// Import .glb file to PHMesh. All triangle primitives of all meshes are concatenated, node transforms are not applied.
+pub fn importGlb(allocator: Allocator, path: []const u8) !PHMesh {
+    const prevSubsystem = tracking.enter(.import);
+    defer tracking.leave(prevSubsystem);
+
+    const scratch = scratch_arena.threadScratch(allocator);
+    const mark = scratch.mark();
+    defer scratch.restore(mark);
+
+    const file = try MappedFile.open(allocator, path);
+    defer file.deinit();
+    return try readGlb(allocator, scratch.allocator(), file.bytes);
+}
+
+// ======================================
+// Mapped files and attribute views
+// ======================================
+
+/// File mapped read-only, unmapped by `deinit`. Windows has no `mmap`, there the file is read with `allocator` instead.
+const MappedFile = struct {
+    bytes: []const u8,
+    backing: union(enum) {
+        mapped: []align(std.heap.page_size_min) const u8,
+        owned: Allocator,
+    },
+
+    fn open(allocator: Allocator, path: []const u8) !MappedFile {
+        const file = try std.fs.cwd().openFile(path, .{});
+        defer file.close(); // mapping stays valid after closing
+
+        const size = (try file.stat()).size;
+        if (size == 0) return BinaryError.EmptyFile;
+
+        if (builtin.os.tag == .windows) {
+            const bytes = try allocator.alloc(u8, size);
+            errdefer allocator.free(bytes);
+            if (try file.readAll(bytes) != size) return error.EndOfStream;
+            return .{ .bytes = bytes, .backing = .{ .owned = allocator } };
+        }
+
+        const mapping = try std.posix.mmap(null, size, std.posix.PROT.READ, .{ .TYPE = .PRIVATE }, file.handle, 0);
+        std.posix.madvise(mapping.ptr, mapping.len, std.posix.MADV.SEQUENTIAL) catch {}; // only a read-ahead hint
+        return .{ .bytes = mapping, .backing = .{ .mapped = mapping } };
+    }
+
+    fn deinit(self: MappedFile) void {
+        switch (self.backing) {
+            .mapped => |mapping| std.posix.munmap(mapping),
+            .owned => |allocator| allocator.free(self.bytes),
+        }
+    }
+};
+
+/// Scalar types of both formats, named as in PLY headers
+const Scalar = enum {
+    int8,
+    uint8,
+    int16,
+    uint16,
+    int32,
+    uint32,
+    float32,
+    float64,
+
+    fn size(self: Scalar) usize {
+        return switch (self) {
+            .int8, .uint8 => 1,
+            .int16, .uint16 => 2,
+            .int32, .uint32, .float32 => 4,
+            .float64 => 8,
+        };
+    }
+
+    /// Largest value, used to map normalized integers to [-1, 1]
+    fn maxValue(self: Scalar) f32 {
+        return switch (self) {
+            .int8 => 127,
+            .uint8 => 255,
+            .int16 => 32767,
+            .uint16 => 65535,
+            .int32 => 2147483647,
+            .uint32 => 4294967295,
+            .float32, .float64 => 1,
+        };
+    }
+
+    inline fn readFloat(self: Scalar, bytes: [*]const u8, endian: std.builtin.Endian) f32 {
+        return switch (self) {
+            .int8 => @floatFromInt(@as(i8, @bitCast(bytes[0]))),
+            .uint8 => @floatFromInt(bytes[0]),
+            .int16 => @floatFromInt(std.mem.readInt(i16, bytes[0..2], endian)),
+            .uint16 => @floatFromInt(std.mem.readInt(u16, bytes[0..2], endian)),
+            .int32 => @floatFromInt(std.mem.readInt(i32, bytes[0..4], endian)),
+            .uint32 => @floatFromInt(std.mem.readInt(u32, bytes[0..4], endian)),
+            .float32 => @bitCast(std.mem.readInt(u32, bytes[0..4], endian)),
+            .float64 => @floatCast(@as(f64, @bitCast(std.mem.readInt(u64, bytes[0..8], endian)))),
+        };
+    }
+
+    /// Non-negative integer at `bytes`, null for negative values and floats
+    inline fn readIndex(self: Scalar, bytes: [*]const u8, endian: std.builtin.Endian) ?u32 {
+        return switch (self) {
+            .int8 => std.math.cast(u32, @as(i8, @bitCast(bytes[0]))),
+            .uint8 => bytes[0],
+            .int16 => std.math.cast(u32, std.mem.readInt(i16, bytes[0..2], endian)),
+            .uint16 => std.mem.readInt(u16, bytes[0..2], endian),
+            .int32 => std.math.cast(u32, std.mem.readInt(i32, bytes[0..4], endian)),
+            .uint32 => std.mem.readInt(u32, bytes[0..4], endian),
+            .float32, .float64 => null,
+        };
+    }
+};
+
+/// `count` elements of `components` consecutive scalars, `stride` bytes apart, viewed in the mapped file
+const View = struct {
+    bytes: []const u8, // starts at the first element, bounds are checked by `init`
+    count: usize,
+    stride: usize,
+    components: usize,
+    scalar: Scalar,
+    endian: std.builtin.Endian = .little,
+    normalized: bool = false,
+
+    fn init(file: []const u8, offset: usize, count: usize, stride: usize, components: usize, scalar: Scalar) ?View {
+        const elementSize = components * scalar.size();
+        if (offset > file.len or stride < elementSize) return null;
+        if (count > 0) {
+            const available = file.len - offset;
+            if (available < elementSize or (available - elementSize) / stride < count - 1) return null;
+        }
+        return .{ .bytes = file[offset..], .count = count, .stride = stride, .components = components, .scalar = scalar };
+    }
+
+    /// Stored exactly as the destination array -> a single memcpy
+    fn isPacked(self: View, scalar: Scalar) bool {
+        return self.scalar == scalar and self.endian == nativeEndian and self.stride == self.components * scalar.size();
+    }
+};
+
+/// Copy the elements of `view` to `dst` as f32
+fn readFloats(dst: []f32, view: View) void {
+    std.debug.assert(dst.len == view.count * view.components);
+    if (view.isPacked(.float32)) {
+        @memcpy(std.mem.sliceAsBytes(dst), view.bytes[0 .. dst.len * 4]);
+        return;
+    }
+
+    const scale: f32 = if (view.normalized) 1 / view.scalar.maxValue() else 1;
+    const scalarSize = view.scalar.size();
+    for (0..view.count) |e| {
+        const element = view.bytes.ptr + e * view.stride;
+        for (0..view.components) |c| {
+            const value = view.scalar.readFloat(element + c * scalarSize, view.endian) * scale;
+            dst[e * view.components + c] = if (view.normalized) @max(value, -1) else value;
+        }
+    }
+}
+
+/// Copy the indices of `view` to `dst`, adding `base`. Every index must be below `vertexCount`.
+fn readIndices(dst: []u32, view: View, base: u32, vertexCount: u32) !void {
+    std.debug.assert(dst.len == view.count and view.components == 1);
+    if (view.isPacked(.uint32) and base == 0) {
+        @memcpy(std.mem.sliceAsBytes(dst), view.bytes[0 .. dst.len * 4]);
+        if (dst.len > 0 and std.mem.max(u32, dst) >= vertexCount) return BinaryError.IndexOutOfRange;
+        return;
+    }
+
+    for (dst, 0..) |*index, e| {
+        const value = view.scalar.readIndex(view.bytes.ptr + e * view.stride, view.endian) orelse return BinaryError.IndexOutOfRange;
+        if (value >= vertexCount - base) return BinaryError.IndexOutOfRange;
+        index.* = base + value;
+    }
+}
+
+// ======================================
+// PLY
+// ======================================
+
+const maxPlyHeader = 1 << 16;
+
+const PlyProperty = struct {
+    name: []const u8,
+    scalar: Scalar, // item type for lists
+    listCount: ?Scalar = null, // count type of list properties
+    offset: usize = 0, // bytes from the start of the record, only for elements without lists
+};
+
+const PlyElement = struct {
+    name: []const u8,
+    count: usize,
+    properties: std.ArrayListUnmanaged(PlyProperty) = .{},
+
+    /// Bytes per record, null if the element has list properties
+    fn recordSize(self: PlyElement) ?usize {
+        var size: usize = 0;
+        for (self.properties.items) |property| {
+            if (property.listCount != null) return null;
+            size += property.scalar.size();
+        }
+        return size;
+    }
+
+    fn property(self: PlyElement, names: []const []const u8) ?PlyProperty {
+        for (self.properties.items) |p| {
+            for (names) |name| if (std.mem.eql(u8, p.name, name)) return p;
+        }
+        return null;
+    }
+};
+
+fn plyScalar(name: []const u8) !Scalar {
+    const names = [_]struct { []const u8, []const u8, Scalar }{
+        .{ "char", "int8", .int8 },       .{ "uchar", "uint8", .uint8 },
+        .{ "short", "int16", .int16 },    .{ "ushort", "uint16", .uint16 },
+        .{ "int", "int32", .int32 },      .{ "uint", "uint32", .uint32 },
+        .{ "float", "float32", .float32 }, .{ "double", "float64", .float64 },
+    };
+    for (names) |entry| {
+        if (std.mem.eql(u8, name, entry[0]) or std.mem.eql(u8, name, entry[1])) return entry[2];
+    }
+    return BinaryError.InvalidPly;
+}
+
+/// Build PHMesh from the bytes of a binary .ply file, output is allocated with `allocator`, the parsed header with `scratch`
+fn readPly(allocator: Allocator, scratch: Allocator, bytes: []const u8) !PHMesh {
+    // ===== Parse header =====
+    if (!std.mem.startsWith(u8, bytes, "ply")) return BinaryError.InvalidPly;
+    const headerLen = std.mem.indexOf(u8, bytes[0..@min(bytes.len, maxPlyHeader)], "end_header") orelse return BinaryError.InvalidPly;
+    const dataStart = (std.mem.indexOfScalarPos(u8, bytes, headerLen, '\n') orelse return BinaryError.InvalidPly) + 1;
+
+    var endian: ?std.builtin.Endian = null;
+    var elements: std.ArrayListUnmanaged(PlyElement) = .{};
+    var lines = std.mem.tokenizeAny(u8, bytes[0..headerLen], "\r\n");
+    _ = lines.next(); // "ply"
+    while (lines.next()) |line| {
+        var words = std.mem.tokenizeAny(u8, line, " \t");
+        const keyword = words.next() orelse continue;
+
+        if (std.mem.eql(u8, keyword, "format")) {
+            const format = words.next() orelse return BinaryError.InvalidPly;
+            endian = if (std.mem.eql(u8, format, "binary_little_endian")) .little
+                else if (std.mem.eql(u8, format, "binary_big_endian")) .big
+                else return BinaryError.UnsupportedPly; // ascii files go through the text importers
+        } else if (std.mem.eql(u8, keyword, "element")) {
+            const name = words.next() orelse return BinaryError.InvalidPly;
+            const count = std.fmt.parseInt(usize, words.next() orelse return BinaryError.InvalidPly, 10) catch return BinaryError.InvalidPly;
+            try elements.append(scratch, .{ .name = name, .count = count });
+        } else if (std.mem.eql(u8, keyword, "property")) {
+            if (elements.items.len == 0) return BinaryError.InvalidPly;
+            const element = &elements.items[elements.items.len - 1];
+            const typeName = words.next() orelse return BinaryError.InvalidPly;
+
+            var property: PlyProperty = undefined;
+            if (std.mem.eql(u8, typeName, "list")) {
+                const countType = try plyScalar(words.next() orelse return BinaryError.InvalidPly);
+                const itemType = try plyScalar(words.next() orelse return BinaryError.InvalidPly);
+                property = .{ .name = words.next() orelse return BinaryError.InvalidPly, .scalar = itemType, .listCount = countType };
+            } else {
+                const scalar = try plyScalar(typeName);
+                property = .{ .name = words.next() orelse return BinaryError.InvalidPly, .scalar = scalar };
+                if (element.recordSize()) |size| property.offset = size;
+            }
+            try element.properties.append(scratch, property);
+        } // comment, obj_info: ignored
+    }
+    const fileEndian = endian orelse return BinaryError.InvalidPly;
+
+    // ===== Locate vertex and face data =====
+    var vertexElement: ?PlyElement = null;
+    var vertexStart: usize = 0;
+    var faceElement: ?PlyElement = null;
+    var faceStart: usize = 0;
+    var offset = dataStart;
+    for (elements.items) |element| {
+        if (std.mem.eql(u8, element.name, "vertex")) {
+            vertexElement = element;
+            vertexStart = offset;
+        } else if (std.mem.eql(u8, element.name, "face")) {
+            faceElement = element;
+            faceStart = offset;
+        }
+        if (vertexElement != null and faceElement != null) break;
+
+        offset = if (element.recordSize()) |size| offset + size * element.count else (try walkPlyRecords(bytes, offset, element, fileEndian, null, null, 0)).end;
+        if (offset > bytes.len) return BinaryError.InvalidPly;
+    }
+    const vertexEl = vertexElement orelse return BinaryError.InvalidPly;
+    const faceEl = faceElement orelse return BinaryError.InvalidPly;
+    const stride = vertexEl.recordSize() orelse return BinaryError.UnsupportedPly; // lists in vertices
+    const vertexCount = std.math.cast(u32, vertexEl.count) orelse return BinaryError.UnsupportedPly;
+
+    // ===== Vertex attributes =====
+    const positions = (try plyAttribute(bytes, vertexStart, vertexEl, stride, fileEndian, &.{ &.{"x"}, &.{"y"}, &.{"z"} })) orelse return BinaryError.InvalidPly;
+    const normalsView = try plyAttribute(bytes, vertexStart, vertexEl, stride, fileEndian, &.{ &.{"nx"}, &.{"ny"}, &.{"nz"} });
+    const uvView = try plyAttribute(bytes, vertexStart, vertexEl, stride, fileEndian, &.{ &.{ "u", "s", "texture_u" }, &.{ "v", "t", "texture_v" } });
+
+    const vertices = try allocator.alloc(f32, @as(usize, vertexCount) * 3);
+    errdefer allocator.free(vertices);
+    const normals = try allocator.alloc(f32, @as(usize, vertexCount) * 3);
+    errdefer allocator.free(normals);
+    const texcoords = try allocator.alloc(f32, @as(usize, vertexCount) * 2);
+    errdefer allocator.free(texcoords);
+
+    readFloats(vertices, positions);
+    if (uvView) |view| readFloats(texcoords, view) else @memset(texcoords, 0);
+
+    // ===== Faces =====
+    const indexProperty = faceEl.property(&.{ "vertex_indices", "vertex_index" }) orelse return BinaryError.InvalidPly;
+    if (indexProperty.listCount == null) return BinaryError.InvalidPly;
+
+    const faces = try walkPlyRecords(bytes, faceStart, faceEl, fileEndian, indexProperty.name, null, vertexCount);
+    const triangleCount = std.math.cast(u32, faces.triangles) orelse return BinaryError.UnsupportedPly;
+    const indices = try allocator.alloc(u32, @as(usize, triangleCount) * 3);
+    errdefer allocator.free(indices);
+    _ = try walkPlyRecords(bytes, faceStart, faceEl, fileEndian, indexProperty.name, indices, vertexCount);
+
+    // ===== Normals =====
+    if (normalsView) |view| readFloats(normals, view) else {
+        @memset(normals, 0);
+        try vertexNormals(scratch, vertices, indices, normals);
+    }
+    std.debug.print("Imported ply: {} vertices, {} triangles...\n", .{ vertexCount, triangleCount });
+
+    return PHMesh{
+        .allocator = allocator,
+        .indices = indices,
+        .vertices = vertices,
+        .texcoords = texcoords,
+        .normals = normals,
+        .triangleCount = triangleCount,
+        .vertexCount = vertexCount,
+    };
+}
+
+/// View of consecutive properties with one of the names in each of `components`, null if the first is missing
+fn plyAttribute(bytes: []const u8, start: usize, element: PlyElement, stride: usize, endian: std.builtin.Endian, comptime components: []const []const []const u8) !?View {
+    const first = element.property(components[0]) orelse return null;
+    for (components[1..], 1..) |names, c| {
+        const p = element.property(names) orelse return BinaryError.InvalidPly;
+        if (p.scalar != first.scalar or p.offset != first.offset + c * first.scalar.size()) return BinaryError.UnsupportedPly; // not interleaved as one attribute
+    }
+
+    var view = View.init(bytes, start + first.offset, element.count, stride, components.len, first.scalar) orelse return BinaryError.InvalidPly;
+    view.endian = endian;
+    return view;
+}
+
+/// Walk the variable size records of `element` starting at `start`, returning the offset after the last one and the
+/// triangle count of the polygons in list `indexName` split into fans. The triangles are written to `out` if given.
+fn walkPlyRecords(bytes: []const u8, start: usize, element: PlyElement, endian: std.builtin.Endian, indexName: ?[]const u8, out: ?[]u32, vertexCount: u32) !struct { end: usize, triangles: usize } {
+    var pos = start;
+    var triangles: usize = 0;
+    for (0..element.count) |_| {
+        for (element.properties.items) |property| {
+            const countType = property.listCount orelse {
+                pos += property.scalar.size();
+                continue;
+            };
+            if (pos > bytes.len or bytes.len - pos < countType.size()) return BinaryError.InvalidPly;
+            const count = countType.readIndex(bytes.ptr + pos, endian) orelse return BinaryError.InvalidPly;
+            pos += countType.size();
+
+            const itemSize = property.scalar.size();
+            if (count > (bytes.len - pos) / itemSize) return BinaryError.InvalidPly;
+            const items = bytes.ptr + pos;
+            pos += count * itemSize;
+
+            const name = indexName orelse continue;
+            if (count < 3 or !std.mem.eql(u8, property.name, name)) continue;
+
+            // ----- fan around the first corner -----
+            const indices = out orelse {
+                triangles += count - 2;
+                continue;
+            };
+            var corners: [3]u32 = undefined;
+            for (0..count) |k| {
+                const index = property.scalar.readIndex(items + k * itemSize, endian) orelse return BinaryError.IndexOutOfRange;
+                if (index >= vertexCount) return BinaryError.IndexOutOfRange;
+                if (k == 0) corners[0] = index else if (k == 1) corners[2] = index else {
+                    corners[1] = corners[2];
+                    corners[2] = index;
+                    @memcpy(indices[triangles * 3 ..][0..3], &corners);
+                    triangles += 1;
+                }
+            }
+        }
+    }
+    if (pos > bytes.len) return BinaryError.InvalidPly;
+    return .{ .end = pos, .triangles = triangles };
+}
+
+// ======================================
+// glTF binary
+// ======================================
+
+const glbMagic = 0x46546C67; // "glTF"
+const chunkJson = 0x4E4F534A; // "JSON"
+const chunkBin = 0x004E4942; // "BIN\0"
+
+/// Subset of the glTF 2.0 JSON needed for mesh geometry
+const Gltf = struct {
+    buffers: []const struct { byteLength: u64, uri: ?[]const u8 = null } = &.{},
+    bufferViews: []const struct { buffer: u32, byteOffset: u64 = 0, byteLength: u64, byteStride: ?u64 = null } = &.{},
+    accessors: []const Accessor = &.{},
+    meshes: []const struct { primitives: []const Primitive } = &.{},
+
+    const Accessor = struct {
+        bufferView: ?u32 = null, // sparse / zero filled accessors are not supported
+        byteOffset: u64 = 0,
+        componentType: u32,
+        normalized: bool = false,
+        count: u64,
+        @"type": []const u8,
+    };
+
+    const Primitive = struct {
+        attributes: struct { POSITION: ?u32 = null, NORMAL: ?u32 = null, TEXCOORD_0: ?u32 = null },
+        indices: ?u32 = null,
+        mode: u32 = 4, // triangles
+    };
+
+    /// View of accessor `index` in the binary chunk, checking it holds `components` scalars per element
+    fn view(self: Gltf, bin: []const u8, index: u32, components: usize) !View {
+        if (index >= self.accessors.len) return BinaryError.InvalidGlb;
+        const accessor = self.accessors[index];
+        const scalar: Scalar = switch (accessor.componentType) {
+            5120 => .int8,
+            5121 => .uint8,
+            5122 => .int16,
+            5123 => .uint16,
+            5125 => .uint32,
+            5126 => .float32,
+            else => return BinaryError.InvalidGlb,
+        };
+        const typeComponents: usize = if (std.mem.eql(u8, accessor.@"type", "SCALAR")) 1
+            else if (std.mem.eql(u8, accessor.@"type", "VEC2")) 2
+            else if (std.mem.eql(u8, accessor.@"type", "VEC3")) 3
+            else if (std.mem.eql(u8, accessor.@"type", "VEC4")) 4
+            else return BinaryError.UnsupportedGlb;
+        if (typeComponents != components) return BinaryError.InvalidGlb;
+
+        const viewIndex = accessor.bufferView orelse return BinaryError.UnsupportedGlb;
+        if (viewIndex >= self.bufferViews.len) return BinaryError.InvalidGlb;
+        const bufferView = self.bufferViews[viewIndex];
+        if (bufferView.buffer != 0 or self.buffers.len == 0 or self.buffers[0].uri != null) return BinaryError.UnsupportedGlb; // external buffers
+        if (bufferView.byteOffset > bin.len or bin.len - bufferView.byteOffset < bufferView.byteLength) return BinaryError.InvalidGlb;
+
+        const viewBytes = bin[@intCast(bufferView.byteOffset)..][0..@intCast(bufferView.byteLength)];
+        const stride: usize = @intCast(bufferView.byteStride orelse components * scalar.size());
+        var result = View.init(viewBytes, @intCast(accessor.byteOffset), @intCast(accessor.count), stride, components, scalar) orelse return BinaryError.InvalidGlb;
+        result.normalized = accessor.normalized;
+        return result;
+    }
+};
+
+/// Build PHMesh from the bytes of a .glb file, output is allocated with `allocator`, the parsed JSON with `scratch`
+fn readGlb(allocator: Allocator, scratch: Allocator, bytes: []const u8) !PHMesh {
+    // ===== Header and chunks =====
+    if (bytes.len < 20) return BinaryError.InvalidGlb;
+    if (std.mem.readInt(u32, bytes[0..4], .little) != glbMagic) return BinaryError.InvalidGlb;
+    if (std.mem.readInt(u32, bytes[4..8], .little) != 2) return BinaryError.UnsupportedGlb;
+    const length = @min(bytes.len, std.mem.readInt(u32, bytes[8..12], .little));
+
+    var json: ?[]const u8 = null;
+    var bin: []const u8 = &.{};
+    var pos: usize = 12;
+    while (pos + 8 <= length) {
+        const chunkLength = std.mem.readInt(u32, bytes[pos..][0..4], .little);
+        const chunkType = std.mem.readInt(u32, bytes[pos + 4 ..][0..4], .little);
+        pos += 8;
+        if (chunkLength > length - pos) return BinaryError.InvalidGlb;
+        const chunk = bytes[pos..][0..chunkLength];
+        if (chunkType == chunkJson and json == null) json = chunk else if (chunkType == chunkBin and bin.len == 0) bin = chunk;
+        pos += std.mem.alignForward(usize, chunkLength, 4);
+    }
+
+    const gltf = std.json.parseFromSliceLeaky(Gltf, scratch, json orelse return BinaryError.InvalidGlb, .{ .ignore_unknown_fields = true }) catch return BinaryError.InvalidGlb;
+
+    // ===== Size of all triangle primitives =====
+    var vertexTotal: usize = 0;
+    var indexTotal: usize = 0;
+    var hasNormals = true;
+    for (gltf.meshes) |mesh| {
+        for (mesh.primitives) |primitive| {
+            if (primitive.mode != 4) continue; // points, lines, strips and fans
+            const positions = try gltf.view(bin, primitive.attributes.POSITION orelse return BinaryError.InvalidGlb, 3);
+            vertexTotal += positions.count;
+            indexTotal += if (primitive.indices) |i| (try gltf.view(bin, i, 1)).count else positions.count;
+            hasNormals = hasNormals and primitive.attributes.NORMAL != null;
+        }
+    }
+    const vertexCount = std.math.cast(u32, vertexTotal) orelse return BinaryError.UnsupportedGlb;
+    if (indexTotal % 3 != 0) return BinaryError.InvalidGlb;
+    const triangleCount = std.math.cast(u32, indexTotal / 3) orelse return BinaryError.UnsupportedGlb;
+
+    const vertices = try allocator.alloc(f32, vertexTotal * 3);
+    errdefer allocator.free(vertices);
+    const normals = try allocator.alloc(f32, vertexTotal * 3);
+    errdefer allocator.free(normals);
+    const texcoords = try allocator.alloc(f32, vertexTotal * 2);
+    errdefer allocator.free(texcoords);
+    const indices = try allocator.alloc(u32, indexTotal);
+    errdefer allocator.free(indices);
+    if (!hasNormals) @memset(normals, 0);
+
+    // ===== Copy primitives one after another =====
+    var v: usize = 0;
+    var i: usize = 0;
+    for (gltf.meshes) |mesh| {
+        for (mesh.primitives) |primitive| {
+            if (primitive.mode != 4) continue;
+            const attributes = primitive.attributes;
+            const positions = try gltf.view(bin, attributes.POSITION.?, 3);
+            const n = positions.count;
+            readFloats(vertices[v * 3 ..][0 .. n * 3], positions);
+
+            if (hasNormals) {
+                const view = try gltf.view(bin, attributes.NORMAL.?, 3);
+                if (view.count != n) return BinaryError.InvalidGlb;
+                readFloats(normals[v * 3 ..][0 .. n * 3], view);
+            }
+
+            const uv = texcoords[v * 2 ..][0 .. n * 2];
+            if (attributes.TEXCOORD_0) |accessor| {
+                const view = try gltf.view(bin, accessor, 2);
+                if (view.count != n) return BinaryError.InvalidGlb;
+                readFloats(uv, view);
+                for (0..n) |k| uv[k * 2 + 1] = 1 - uv[k * 2 + 1]; // glTF uv origin is top left
+            } else @memset(uv, 0);
+
+            if (primitive.indices) |accessor| {
+                const view = try gltf.view(bin, accessor, 1);
+                try readIndices(indices[i..][0..view.count], view, @intCast(v), @intCast(v + n));
+                i += view.count;
+            } else {
+                for (indices[i..][0..n], 0..) |*index, k| index.* = @intCast(v + k);
+                i += n;
+            }
+            v += n;
+        }
+    }
+
+    if (!hasNormals) try vertexNormals(scratch, vertices, indices, normals);
+    std.debug.print("Imported glb: {} vertices, {} triangles...\n", .{ vertexCount, triangleCount });
+
+    return PHMesh{
+        .allocator = allocator,
+        .indices = indices,
+        .vertices = vertices,
+        .texcoords = texcoords,
+        .normals = normals,
+        .triangleCount = triangleCount,
+        .vertexCount = vertexCount,
+    };
+}
@@ -1,9 +1,14 @@
 const std = @import("std");
+const builtin = @import("builtin");
 const zune = @import("zune");
 const zmath = zune.math;
 const math = @import("../math.zig");
 
 const PHMesh = @import("processing.zig").PlaceHolderMesh;
+const import_binary = @import("import_binary.zig");
+const vertexNormals = @import("face_attributes.zig").vertexNormals;
+const tracking = @import("../utils/tracking_allocator.zig");
+const scratch_arena = @import("../utils/scratch.zig");
 
 const Allocator = std.mem.Allocator;
 const Vec3 = math.vec3;
@@ -17,6 +22,7 @@ const fileError = error{
     InvalidDataType,
     InvalidContext,
     PrecederOnBoundary,
+    UnsupportedFormat,
 };
 
 const ParseFun = union(enum) { intParse: @TypeOf(std.fmt.parseInt), floatParse: @TypeOf(std.fmt.parseFloat) };
@@ -24,6 +30,36 @@ const ParseFun = union(enum) { intParse: @TypeOf(std.fmt.parseInt), floatParse:
 const OfMesh = union(enum) { zMesh: *zune.graphics.Mesh, phMesh: PHMesh };
 pub const OfMeshName = union(enum) { meshName: []const u8, meshPrefix: []const u8 };
 
+// ===== Format by extension =====
+
+const MeshFormat = enum { obj, ply, glb };
+
+fn meshFormat(path: []const u8) !MeshFormat {
+    const extension = std.fs.path.extension(path);
+    inline for (@typeInfo(MeshFormat).@"enum".fields) |field| {
+        if (extension.len > 1 and std.ascii.eqlIgnoreCase(extension[1..], field.name)) return @enumFromInt(field.value);
+    }
+    return fileError.UnsupportedFormat;
+}
+
+/// Import .obj, binary .ply or .glb file to PHMesh, the format is chosen by the extension of `path`
+pub fn importPHMesh(resourceManager: *zune.graphics.ResourceManager, path: []const u8) !PHMesh {
+    return switch (try meshFormat(path)) {
+        .obj => try importPHMeshObj(resourceManager, path),
+        .ply => try import_binary.importPly(resourceManager.allocator, path),
+        .glb => try import_binary.importGlb(resourceManager.allocator, path),
+    };
+}
+
+/// `importPHMesh` without a resource manager (headless server, tools)
+pub fn importPHMeshAlloc(allocator: Allocator, path: []const u8) !PHMesh {
+    return switch (try meshFormat(path)) {
+        .obj => try importPHMeshObjAlloc(allocator, path),
+        .ply => try import_binary.importPly(allocator, path),
+        .glb => try import_binary.importGlb(allocator, path),
+    };
+}
+
 // ===== Thin wrappers for importObj function =====
 
 pub fn importZMeshObj(resourceManager: *zune.graphics.ResourceManager, obj_file: []const u8, meshName: []const u8) !*zune.graphics.Mesh {
@@ -40,24 +76,77 @@ pub fn importPHMeshObj(resourceManager: *zune.graphics.ResourceManager, obj_file
 fn importObj(resourceManager: *zune.graphics.ResourceManager, obj_file: []const u8, meshName: []const u8, toMesh: bool) !OfMesh {
     // ===== Initialize variables =====
     const allocator = resourceManager.allocator;
+    const prevSubsystem = tracking.enter(.import);
+    defer tracking.leave(prevSubsystem);
+
+    // ----- file contents, line buffers and intermediate indices only live during import -----
+    const scratch = scratch_arena.threadScratch(allocator);
+    const mark = scratch.mark();
+    defer scratch.restore(mark);
+    const scratchAllocator = scratch.allocator();
+
+    const contents = try readObj(scratchAllocator, obj_file);
+
+    // ===== Create meshes =====
+    switch (toMesh) {
+        false => {
+            const result = try assemblePHMesh(allocator, scratchAllocator, contents.indiceContext, contents.vertexContext, contents.uvInfo, contents.vertexNormalsInfo, contents.normalsExist);
+            return .{ .phMesh = result };
+        },
+        true => {
+            // ----- upload buffers live in the scratch too, released with the import's mark -----
+            const zMeshComponents = try assembleZMesh(scratchAllocator, scratchAllocator, contents.indiceContext, contents.vertexContext, contents.uvInfo, contents.vertexNormalsInfo, contents.normalsExist);
+
+            const result = try resourceManager.createMesh(meshName, zMeshComponents.data, zMeshComponents.indices, 3 + @as(u4, if (contents.vertexNormalsInfo) |_| 3 else 0) + @as(u4, if (contents.uvInfo) |_| 2 else 0));
+            std.debug.print("Uploaded mesh...\n", .{});
+
+            return .{ .zMesh = result };
+        },
+    }
+}
+
+/// Import .obj file to PHMesh without a resource manager (headless server, tools). Does not reference any graphics types.
+pub fn importPHMeshObjAlloc(allocator: Allocator, obj_file: []const u8) !PHMesh {
+    const prevSubsystem = tracking.enter(.import);
+    defer tracking.leave(prevSubsystem);
+
+    const scratch = scratch_arena.threadScratch(allocator);
+    const mark = scratch.mark();
+    defer scratch.restore(mark);
+    const scratchAllocator = scratch.allocator();
+
+    const contents = try readObj(scratchAllocator, obj_file);
+    return try assemblePHMesh(allocator, scratchAllocator, contents.indiceContext, contents.vertexContext, contents.uvInfo, contents.vertexNormalsInfo, contents.normalsExist);
+}
+
+/// Parsed and triangulated .obj contents, indices start at 0. All slices are allocated with the scratch allocator passed to `readObj`.
+const ObjContents = struct {
+    indiceContext: IndiceContext,
+    vertexContext: VertexContext,
+    uvInfo: ?readInfo(f32),
+    vertexNormalsInfo: ?readInfo(f32),
+    normalsExist: bool,
+};
+
+/// Read and triangulate .obj file, everything is allocated with `scratchAllocator`
+fn readObj(scratchAllocator: Allocator, obj_file: []const u8) !ObjContents {
     const linePreceders = [_][]const u8{ "v ", "vt ", "vn ", "f " };
     var i_lp: usize = 0;
     std.debug.print("Started import...\n", .{});
     // ----- find file -----
     const file = try std.fs.cwd().openFile(obj_file, .{});
+    defer file.close();
     std.debug.print("Opened file...\n", .{});
     // Create buffered reader -> Stores sections of file in buffer to minimize calls to system
     var buffered = std.io.bufferedReader(file.reader());
 
     // Create buffer to store lines
-    var lineBuf = std.ArrayList(u8).init(allocator);
-    // errdefer lineBuf.deinit();
+    var lineBuf = try std.ArrayList(u8).initCapacity(scratchAllocator, 256);
     defer lineBuf.deinit();
 
     // ===== Read vertices =====
     const verticeInfo: readInfo(f32) =
-        try storeLineInfo(allocator, f32, &buffered, "v ", .{ .lineBuf = &lineBuf });
-    defer allocator.free(verticeInfo.values);
+        try storeLineInfo(scratchAllocator, f32, &buffered, "v ", .{ .lineBuf = &lineBuf });
 
     const vertexCount = @divExact(verticeInfo.values.len, verticeInfo.lineValueCount);
 
@@ -68,10 +157,9 @@ fn importObj(resourceManager: *zune.graphics.ResourceManager, obj_file: []const
     var i_del = try sneakToEither(&buffered, linePreceders[i_lp..]);
 
     const uvInfo: ?readInfo(f32) = switch (i_del == 0) { // delimiter of uv was found
-        true => try storeLineInfo(allocator, f32, &buffered, "vt ", .{ .lineBuf = &lineBuf, .readCapacity = vertexCount }),
+        true => try storeLineInfo(scratchAllocator, f32, &buffered, "vt ", .{ .lineBuf = &lineBuf, .readCapacity = vertexCount * 2 }),
         false => null,
     };
-    defer if (uvInfo) |info| allocator.free(info.values);
     // ----- Sanity check -----
 
     if (uvInfo) |info| {
@@ -85,10 +173,9 @@ fn importObj(resourceManager: *zune.graphics.ResourceManager, obj_file: []const
     const normalsExist = i_del == 0;
 
     const vertexNormalsInfo: ?readInfo(f32) = switch (normalsExist) { // delimiter of uv was found
-        true => try storeLineInfo(allocator, f32, &buffered, "vn ", .{ .lineBuf = &lineBuf, .readCapacity = vertexCount }),
+        true => try storeLineInfo(scratchAllocator, f32, &buffered, "vn ", .{ .lineBuf = &lineBuf, .readCapacity = vertexCount * 3 }),
         false => null,
     };
-    defer if (vertexNormalsInfo) |info| allocator.free(info.values);
 
     // ----- Sanity check -----
     if (vertexNormalsInfo) |info| {
@@ -98,14 +185,13 @@ fn importObj(resourceManager: *zune.graphics.ResourceManager, obj_file: []const
 
     // ===== Read indices =====
     const indiceInfo: readInfo(u32) =
-        try storeLineInfo(allocator, u32, &buffered, "f ", .{
+        try storeLineInfo(scratchAllocator, u32, &buffered, "f ", .{
             .lineBuf = &lineBuf,
-            .readCapacity = vertexCount*3,
+            .readCapacity = vertexCount * 18, // ~2 faces per vertex with 9 values each
             .subdivider = '/',
             .lineValueCount = 12,
         });
     std.debug.print("Created indiceInfo\n", .{});
-    defer allocator.free(indiceInfo.values);
 
     const faceCount = @divExact(indiceInfo.values.len, indiceInfo.lineValueCount); // Count of lines
     const faceVertexCount: usize = switch (indiceInfo.lineValueCount) {
@@ -132,9 +218,7 @@ fn importObj(resourceManager: *zune.graphics.ResourceManager, obj_file: []const
     const indiceCount: usize = triangleCount * 3;
 
     // ----- Ensure faces are triangular -----
-    const triIndices = try allocator.alloc(u32, indiceCount * indiceLen);
-    errdefer allocator.free(triIndices);
-    defer allocator.free(triIndices);
+    const triIndices = try scratchAllocator.alloc(u32, indiceCount * indiceLen);
     if (faceVertexCount == 4) {
         var i: usize = 0;
         const triStepSize = 6 * indiceLen; // 2 triangles with 3 vertices
@@ -154,39 +238,21 @@ fn importObj(resourceManager: *zune.graphics.ResourceManager, obj_file: []const
     }
     for (0..triIndices.len) |i| triIndices[i] -= 1; // Make indices start from 0
 
-    // ===== Create meshes =====
-    switch (toMesh) {
-        false => {
-            const result = try assemblePHMesh(allocator, .{
-                .triangleCount = triangleCount,
-                .indiceCount = indiceCount,
-                .indiceLen = indiceLen,
-                .triIndices = triIndices,
-            }, .{
-                .vertexCount = vertexCount,
-                .verticeInfo = verticeInfo,
-            }, uvInfo, vertexNormalsInfo, normalsExist);
-            return .{ .phMesh = result };
+    return .{
+        .indiceContext = .{
+            .triangleCount = triangleCount,
+            .indiceCount = indiceCount,
+            .indiceLen = indiceLen,
+            .triIndices = triIndices,
         },
-        true => {
-            const zMeshComponents = try assembleZMesh(allocator, .{
-                .triangleCount = triangleCount,
-                .indiceCount = indiceCount,
-                .indiceLen = indiceLen,
-                .triIndices = triIndices,
-            }, .{
-                .vertexCount = vertexCount,
-                .verticeInfo = verticeInfo,
-            }, uvInfo, vertexNormalsInfo, normalsExist);
-
-            const result = try resourceManager.createMesh(meshName, zMeshComponents.data, zMeshComponents.indices, 3 + @as(u4, if (vertexNormalsInfo) |_| 3 else 0) + @as(u4, if (uvInfo) |_| 2 else 0));
-            std.debug.print("Uploaded mesh...\n", .{});
-            allocator.free(zMeshComponents.data);
-            allocator.free(zMeshComponents.indices);
-
-            return .{ .zMesh = result };
+        .vertexContext = .{
+            .vertexCount = vertexCount,
+            .verticeInfo = verticeInfo,
         },
-    }
+        .uvInfo = uvInfo,
+        .vertexNormalsInfo = vertexNormalsInfo,
+        .normalsExist = normalsExist,
+    };
 }
 
 const IndiceContext = struct {
@@ -201,256 +267,263 @@ const VertexContext = struct {
     verticeInfo: readInfo(f32),
 };
 
-fn assemblePHMesh(allocator: Allocator, indiceContext: IndiceContext, vertexContext: VertexContext, uvInfo: ?readInfo(f32), vertexNormalsInfo: ?readInfo(f32), hasNormals: bool) !PHMesh {
+/// Output slices are allocated with `allocator` at their final size, all intermediate buffers come from `scratch`.
+fn assemblePHMesh(allocator: Allocator, scratch: Allocator, indiceContext: IndiceContext, vertexContext: VertexContext, uvInfo: ?readInfo(f32), vertexNormalsInfo: ?readInfo(f32), hasNormals: bool) !PHMesh {
     // ===== unpack contexts =====
     const indiceLen = indiceContext.indiceLen;
-    const indiceCount = indiceContext.indiceCount;
     const triIndices = indiceContext.triIndices;
     const triangleCount = indiceContext.triangleCount;
 
-    const vertexCount = vertexContext.vertexCount;
     const verticeInfo: readInfo(f32) = vertexContext.verticeInfo;
 
-    // ===== Create phMesh data structure and store read values =====
-    const maxVertexCount = triangleCount * 3; // a vertex for each index
-    var vertices = try allocator.alloc(f32, maxVertexCount * 3); // Max length -> vertices may be duplicated if uv is different for face
-    var uv: []f32 = if (uvInfo != null) try allocator.alloc(f32, maxVertexCount * 2) else undefined;
-    var normals: []f32 = try allocator.alloc(f32, maxVertexCount * 3);
-
-    const indices = try allocator.alloc(u32, indiceCount); // Final vertex indices in form 1 2 3 | 2 3 4 etc.
-
-    // ----- Create auxilirary variables -----
-    const uniqueIndice = try allocator.alloc(u32, vertexCount * indiceLen); // Scales with original vertex count -> stores only initial vertex' indice-set e.g. '1/2/3' (2/3/4 4/5/6)
-    const uniqueIndex = try allocator.alloc(u32, vertexCount);
-    const uniqueFound = try allocator.alloc(bool, vertexCount);
-    defer allocator.free(uniqueIndice);
-    defer allocator.free(uniqueIndex);
-    defer allocator.free(uniqueFound);
-
-    // ----- Start storing read-values -----
-    var n: u32 = 0; // count of stored vertices
-    var i: usize = 0; // count of reformated indices
-    while (i < triangleCount * 3) : (i += 1) {
-        const indice = triIndices[i * indiceLen ..][0..indiceLen];
-        const vertexInd = indice[0];
-        // var vertexUnique = vertexUniques[vertexInd];
-
-        if (!uniqueFound[vertexInd]) { // if vertex index has not been found yet -> store vertex + metaData
-            // ----- Make unique vertex entry -----
-            uniqueFound[vertexInd] = true;
-            uniqueIndex[vertexInd] = n;
-            @memcpy(uniqueIndice[vertexInd * indiceLen ..][0..indiceLen], indice);
-
-            // ----- Copy values to new containers -----
-            @memcpy(vertices[n * 3 ..][0..3], verticeInfo.values[vertexInd * verticeInfo.lineValueCount ..][0..3]); // vertex
-            if (uvInfo) |uvInf| @memcpy(uv[n * 2 ..][0..2], uvInf.values[indice[1] * uvInf.lineValueCount ..][0..2]); // uv
-            if (vertexNormalsInfo) |normalsInfo| @memcpy(normals[n * 3 ..][0..3], normalsInfo.values[indice[2] * normalsInfo.lineValueCount ..][0..3]); // normals
-
-            // ----- Store indicex -----
-            indices[i] = n;
-
-            n += 1;
-        } else if (std.mem.eql(u32, uniqueIndice[vertexInd * indiceLen ..][0..indiceLen], indice)) { // vertex has already been found, with the same properties
-            indices[i] = uniqueIndex[vertexInd];
-        } else { // Vertex has been found, but with different properties
-            // ----- Copy values to new containers -----
-            @memcpy(vertices[n * 3 ..][0..3], verticeInfo.values[vertexInd * verticeInfo.lineValueCount ..][0..3]); // vertex
-            if (uvInfo) |uvInf| @memcpy(uv[n * 2 ..][0..2], uvInf.values[indice[1] * uvInf.lineValueCount ..][0..2]); // uv
-            if (vertexNormalsInfo) |normalsInfo| @memcpy(normals[n * 3 ..][0..3], normalsInfo.values[indice[2] * normalsInfo.lineValueCount ..][0..3]); // normals
-
-            // ----- Store indicex -----
-            indices[i] = n;
-
-            n += 1;
-        }
+    // ===== One vertex per distinct v/vt/vn =====
+    const wedges = try dedupWedges(allocator, scratch, indiceContext, vertexContext.vertexCount);
+    defer allocator.free(wedges.corners);
+    const indices = wedges.indices;
+    errdefer allocator.free(indices);
+    const n: u32 = @intCast(wedges.corners.len);
+
+    const vertices = try allocator.alloc(f32, n * 3);
+    errdefer allocator.free(vertices);
+    const uv = try allocator.alloc(f32, n * 2);
+    errdefer allocator.free(uv);
+    const normals = try allocator.alloc(f32, n * 3);
+    errdefer allocator.free(normals);
+    if (uvInfo == null) @memset(uv, 0);
+    if (!hasNormals) @memset(normals, 0);
+
+    // ----- Copy values of the first corner of every wedge -----
+    for (wedges.corners, 0..) |corner, w| {
+        const indice = triIndices[corner * indiceLen ..][0..indiceLen];
+        @memcpy(vertices[w * 3 ..][0..3], verticeInfo.values[indice[0] * verticeInfo.lineValueCount ..][0..3]); // vertex
+        if (uvInfo) |uvInf| @memcpy(uv[w * 2 ..][0..2], uvInf.values[indice[1] * uvInf.lineValueCount ..][0..2]); // uv
+        if (vertexNormalsInfo) |normalsInfo| @memcpy(normals[w * 3 ..][0..3], normalsInfo.values[indice[2] * normalsInfo.lineValueCount ..][0..3]); // normals
     }
-    std.debug.print("Made Data struct for phMesh...\n", .{});
+    std.debug.print("Made Data struct for phMesh, {} vertices...\n", .{n});
 
     // ===== Create Normals if not present =====
-    if (hasNormals) {
-        // ----- Create constants -----
-        const faceNormals = try allocator.alloc(f32, triangleCount*3);
-        defer allocator.free(faceNormals);
-
-        // ----- Find face normals -----
-        i = 0;
-        while (i < triangleCount) : (i += 1) {
-
-            const i_a: u32 = indices[i * 3];
-            const i_b: u32 = indices[i * 3 + 1];
-            const i_c: u32 = indices[i * 3 + 2];
-
-            const v1: @Vector(3, f32) = vertices[i_a * 3..][0..3].*;
-            const v2: @Vector(3, f32) = vertices[i_b * 3..][0..3].*;
-            const v3: @Vector(3, f32) = vertices[i_c * 3..][0..3].*;
-
-            // const v1: Vec3(f32) = Vec3(f32){ .x = vertices[i_a * 3], .y = vertices[i_a * 3 + 1], .z = vertices[i_a * 3 + 2] };
-            // const v2: Vec3(f32) = Vec3(f32){ .x = vertices[i_b * 3], .y = vertices[i_b * 3 + 1], .z = vertices[i_b * 3 + 2] };
-            // const v3: Vec3(f32) = Vec3(f32){ .x = vertices[i_c * 3], .y = vertices[i_c * 3 + 1], .z = vertices[i_c * 3 + 2] };
-
-            
-            @memcpy(faceNormals[i*3..][0..3], &math.getVec3Normal(v1, v2, v3)); // v2.subtract(v1).cross(v3.subtract(v1));
-        }
-
-        // ----- Find vertice normals -----
-        i = 0;
-        while (i < triangleCount) : (i += 1) {
-            const faceNormal = faceNormals[i*3..][0..3]; // Find normal of face
-
-            for (indices[i * 3 ..][0..3]) |Iv| {
-                // Add normal to vertex-normals
-                normals[Iv * 3] += faceNormal[0];
-                normals[Iv * 3 + 1] += faceNormal[1];
-                normals[Iv * 3 + 2] += faceNormal[2];
-            }
-        }
-
-        // ----- Normalize vertex normals -----
-        i = 0;
-        while (i < vertexCount) : (i += 1) {
-            math.vec3normalize(normals[i * 3 ..][0..3]);
-        }
+    if (!hasNormals) {
+        try vertexNormals(scratch, vertices, indices, normals);
         std.debug.print("Created normals...\n", .{});
     }
 
-    // ===== Shorten allocated memory =====
     return PHMesh{
         .allocator = allocator,
         .indices = indices,
-        .vertices = try allocator.realloc(vertices, n * 3),
-        .texcoords = try allocator.realloc(uv, n * 2),
-        .normals = try allocator.realloc(normals, n * 3),
+        .vertices = vertices,
+        .texcoords = uv,
+        .normals = normals,
         .triangleCount = @intCast(triangleCount),
         .vertexCount = n,
     };
 }
 
-fn assembleZMesh(allocator: Allocator, indiceContext: IndiceContext, vertexContext: VertexContext, uvInfo: ?readInfo(f32), vertexNormalsInfo: ?readInfo(f32), hasNormals: bool) !struct { data: []f32, indices: []u32 } {
+/// Returned buffers are allocated with `allocator` and only need to live until the mesh is uploaded, all intermediate
+/// buffers come from `scratch`.
+fn assembleZMesh(allocator: Allocator, scratch: Allocator, indiceContext: IndiceContext, vertexContext: VertexContext, uvInfo: ?readInfo(f32), vertexNormalsInfo: ?readInfo(f32), hasNormals: bool) !struct { data: []f32, indices: []u32 } {
     // ===== unpack contexts =====
     const indiceLen = indiceContext.indiceLen;
-    const indiceCount = indiceContext.indiceCount;
     const triIndices = indiceContext.triIndices;
-    const triangleCount = indiceContext.triangleCount;
 
-    const vertexCount = vertexContext.vertexCount;
     const verticeInfo: readInfo(f32) = vertexContext.verticeInfo;
 
+    // ===== One vertex per distinct v/vt/vn =====
+    const wedges = try dedupWedges(allocator, scratch, indiceContext, vertexContext.vertexCount);
+    defer allocator.free(wedges.corners);
+    const indices = wedges.indices;
+    errdefer allocator.free(indices);
+    const n: u32 = @intCast(wedges.corners.len);
+
     // ===== Create zMesh data structure and store read values =====
     const b: usize = if (uvInfo != null) 8 else 6; // Amount of data points in single data-entree
-    const Data = try allocator.alloc(f32, indiceCount * b);
-    const indices = try allocator.alloc(u32, indiceCount); // Final vertex indices in form 1 2 3 | 2 3 4 etc.
-
-    // ----- Create auxilirary variables -----
-    const uniqueIndice = try allocator.alloc(u32, indiceLen * vertexCount);
-    const uniqueIndex = try allocator.alloc(u32, vertexCount);
-    const uniqueFound = try allocator.alloc(bool, vertexCount);
-    defer allocator.free(uniqueIndice);
-    defer allocator.free(uniqueIndex);
-    defer allocator.free(uniqueFound);
-
-    // ----- Start storing read-values -----
-    var n: u32 = 0; // count of stored vertices
-    var i: usize = 0; // count of reformated indices
-    while (i < triangleCount * 3) : (i += 1) {
-        const indice = triIndices[i * indiceLen ..][0..indiceLen];
-        const vertexInd = indice[0];
-        // var vertexUnique = vertexUniques[vertexInd];
-
-        if (!uniqueFound[vertexInd]) { // if vertex index has not been found yet -> store vertex + metaData
-            // ----- Make unique vertex entry -----
-            uniqueFound[vertexInd] = true;
-            uniqueIndex[vertexInd] = n;
-            @memcpy(uniqueIndice[vertexInd * indiceLen ..][0..indiceLen], indice);
-
-            // ----- Copy values to new containers -----
-            @memcpy(Data[n * b ..][0..3], verticeInfo.values[vertexInd * verticeInfo.lineValueCount ..][0..3]); // vertex
-            if (uvInfo) |uvInf| {
-                @memcpy(Data[n * b ..][3..5], uvInf.values[indice[1] * uvInf.lineValueCount ..][0..2]); // uv
-                if (vertexNormalsInfo) |normalsInfo| @memcpy(Data[n * b ..][5..8], normalsInfo.values[indice[2] * 3 ..][0..3]); // normals
-            } else {
-                if (vertexNormalsInfo) |normalsInfo| @memcpy(Data[n * b ..][3..6], normalsInfo.values[indice[2] * 3 ..][0..3]); // normals
-            }
-
-            // ----- Store indicex -----
-            indices[i] = n;
-
-            n += 1;
-        } else if (std.mem.eql(u32, uniqueIndice[vertexInd * indiceLen ..][0..indiceLen], indice)) { // vertex has already been found, but has the same properties
-            indices[i] = uniqueIndex[vertexInd];
-        } else { // Vertex has been found, but with different properties
-            // ----- Copy values to new containers -----
-            @memcpy(Data[n * b ..][0..3], verticeInfo.values[vertexInd * verticeInfo.lineValueCount ..][0..3]); // vertex
-            if (uvInfo) |uvInf| {
-                @memcpy(Data[n * b ..][3..5], uvInf.values[indice[1] * uvInf.lineValueCount ..][0..2]); // uv
-                if (vertexNormalsInfo) |normalsInfo| @memcpy(Data[n * b ..][5..8], normalsInfo.values[indice[2] * 3 ..][0..3]); // normals
-            } else {
-                if (vertexNormalsInfo) |normalsInfo| @memcpy(Data[n * b ..][3..6], normalsInfo.values[indice[2] * 3 ..][0..3]); // normals
-            }
-
-            // ----- Store indicex -----
-            indices[i] = n;
-
-            n += 1;
+    const Data = try allocator.alloc(f32, n * b);
+    errdefer allocator.free(Data);
+    const c: u8 = if (uvInfo != null) 5 else 3; // offset of normals in a data-entree
+
+    for (wedges.corners, 0..) |corner, w| {
+        const indice = triIndices[corner * indiceLen ..][0..indiceLen];
+        @memcpy(Data[w * b ..][0..3], verticeInfo.values[indice[0] * verticeInfo.lineValueCount ..][0..3]); // vertex
+        if (uvInfo) |uvInf| {
+            @memcpy(Data[w * b ..][3..5], uvInf.values[indice[1] * uvInf.lineValueCount ..][0..2]); // uv
+            if (vertexNormalsInfo) |normalsInfo| @memcpy(Data[w * b ..][5..8], normalsInfo.values[indice[2] * 3 ..][0..3]); // normals
+        } else {
+            if (vertexNormalsInfo) |normalsInfo| @memcpy(Data[w * b ..][3..6], normalsInfo.values[indice[2] * 3 ..][0..3]); // normals
         }
     }
     std.debug.print("Made Data struct for zMeshg...\n", .{});
 
     // ===== Create Normals if not present =====
     if (!hasNormals) {
-        // ----- Find face normals -----
-        const faceNormals = try allocator.alloc(f32, triangleCount*3);
-        defer allocator.free(faceNormals);
-
-        i = 0;
-        while (i < triangleCount) : (i += 1) {
-            const i_a: u32 = indices[i * 3];
-            const i_b: u32 = indices[i * 3 + 1];
-            const i_c: u32 = indices[i * 3 + 2];
-
-            
-            const v1: @Vector(3, f32) = Data[i_a * b..][0..3].*;
-            const v2: @Vector(3, f32) = Data[i_b * b..][0..3].*;
-            const v3: @Vector(3, f32) = Data[i_c * b..][0..3].*;
-
-            // const v1: Vec3(f32) = Vec3(f32){ .x = vertices[i_a * 3], .y = vertices[i_a * 3 + 1], .z = vertices[i_a * 3 + 2] };
-            // const v2: Vec3(f32) = Vec3(f32){ .x = vertices[i_b * 3], .y = vertices[i_b * 3 + 1], .z = vertices[i_b * 3 + 2] };
-            // const v3: Vec3(f32) = Vec3(f32){ .x = vertices[i_c * 3], .y = vertices[i_c * 3 + 1], .z = vertices[i_c * 3 + 2] };
-
-            
-            @memcpy(faceNormals[i*3..][0..3], &math.getVec3Normal(v1, v2, v3)); // v2.subtract(v1).cross(v3.subtract(v1));
-        }
-
-        // ----- Find vertex normals -----
-        i = 0;
-        const c: u8 = if (uvInfo != null) 5 else 3;
-        while (i < triangleCount) : (i += 1) {
-            const faceNormal = faceNormals[i*3..][0..3]; // Find normal of face
-
-            for (indices[i * 3 .. i * 3 + 2]) |Iv| {
-                // Add normal to vertex-normals
-                Data[Iv * b + c] += faceNormal[0];
-                Data[Iv * b + c + 1] += faceNormal[1];
-                Data[Iv * b + c + 2] += faceNormal[2];
-            }
-        }
-
-        // ----- Normalize vertex normals -----
-        i = 0;
-        while (i < vertexCount) : (i += 1) {
-            math.vec3normalize(Data[i * b + c ..][0..3][0..]);
-        }
+        // ----- the kernel reads packed positions, gather them out of the interleaved data -----
+        const vertices = try scratch.alloc(f32, n * 3);
+        const normals = try scratch.alloc(f32, n * 3);
+        @memset(normals, 0);
+        for (0..n) |w| @memcpy(vertices[w * 3 ..][0..3], Data[w * b ..][0..3]);
+
+        try vertexNormals(scratch, vertices, indices, normals);
+        for (0..n) |w| @memcpy(Data[w * b + c ..][0..3], normals[w * 3 ..][0..3]);
         std.debug.print("Created normals...\n", .{});
     } else {
         std.debug.print("normals already existed...\n", .{});
     }
 
-    // ===== Shorten allocated memory =====
-    const new_vertexCount = n;
-    std.debug.print("new_vertexCount: {}\n", .{new_vertexCount});
-    const data: []f32 = try allocator.realloc(Data, new_vertexCount * b);
-    return .{ .data = data, .indices = indices };
+    std.debug.print("new_vertexCount: {}\n", .{n});
+    return .{ .data = Data, .indices = indices };
+}
+
+// ======================================
+// Wedge de-duplication
+// ======================================
+
+/// Vertices of an assembled mesh, one per distinct index tuple (`v`, `v/vt`, `v/vt/vn`, ...)
+const Wedges = struct {
+    indices: []u32, // [corner] -> wedge
+    corners: []u32, // [wedge] -> first corner with its tuple
+};
+
+/// Vertex ranges smaller than this are not worth a thread
+const minVerticesPerJob = 1 << 14;
+const maxWedgeJobs = 64;
+
+/// Exact de-duplication of the index tuples of all corners in `indiceContext`, both outputs allocated with `allocator`.
+///
+/// Corners are bucketed by position index with a counting sort, so equal tuples always share a bucket. Buckets hold
+/// only the few corners around one position and are de-duplicated by comparing full tuples. Vertex ranges are
+/// processed in parallel twice: first counting the wedges of every range, then numbering them from the prefix sums,
+/// so the outputs are allocated at their exact size. Wedges are ordered by position index, corners by first use.
+fn dedupWedges(allocator: Allocator, scratch: Allocator, indiceContext: IndiceContext, vertexCount: usize) !Wedges {
+    const indiceLen = indiceContext.indiceLen;
+    const triIndices = indiceContext.triIndices;
+    const cornerCount = indiceContext.indiceCount;
+
+    // ===== Bucket corners by position =====
+    const bucketStart = try scratch.alloc(u32, vertexCount + 1);
+    @memset(bucketStart, 0);
+    for (0..cornerCount) |c| {
+        const v = triIndices[c * indiceLen];
+        if (v >= vertexCount) return fileError.IndiceError;
+        bucketStart[v + 1] += 1;
+    }
+    for (1..bucketStart.len) |v| bucketStart[v] += bucketStart[v - 1];
+
+    const byVertex = try scratch.alloc(u32, cornerCount);
+    const fill = try scratch.dupe(u32, bucketStart[0..vertexCount]);
+    for (0..cornerCount) |c| {
+        const v = triIndices[c * indiceLen];
+        byVertex[fill[v]] = @intCast(c);
+        fill[v] += 1;
+    }
+
+    // ===== Count wedges per vertex range =====
+    const cpuCount = if (builtin.single_threaded) 1 else std.Thread.getCpuCount() catch 1;
+    const jobCount = std.math.clamp(@min(cpuCount, vertexCount / minVerticesPerJob), 1, maxWedgeJobs);
+    var job = WedgeJob{
+        .triIndices = triIndices,
+        .indiceLen = indiceLen,
+        .vertexCount = vertexCount,
+        .jobCount = jobCount,
+        .bucketStart = bucketStart,
+        .byVertex = byVertex,
+        .localWedge = try scratch.alloc(u32, cornerCount),
+        .indices = try allocator.alloc(u32, cornerCount),
+    };
+    errdefer allocator.free(job.indices);
+    try job.run(allocator, WedgeJob.count);
+
+    // ----- wedge offset of every range -----
+    var total: u32 = 0;
+    for (job.wedgeOffset[0..jobCount]) |*offset| {
+        const c = offset.*;
+        offset.* = total;
+        total += c;
+    }
+
+    // ===== Number wedges =====
+    job.corners = try allocator.alloc(u32, total);
+    errdefer allocator.free(job.corners);
+    try job.run(allocator, WedgeJob.assign);
+
+    return .{ .indices = job.indices, .corners = job.corners };
 }
 
+/// Shared state of the `dedupWedges` passes. Job `i` only writes corners of positions in its vertex range.
+const WedgeJob = struct {
+    triIndices: []const u32,
+    indiceLen: usize,
+    vertexCount: usize,
+    jobCount: usize,
+    bucketStart: []const u32, // [position] -> first entry in `byVertex`, one extra entry at the end
+    byVertex: []const u32, // corners sorted by position
+    localWedge: []u32, // [entry of byVertex] -> wedge number within its job
+    wedgeOffset: [maxWedgeJobs]u32 = undefined, // wedge count, then first wedge, of every job
+    indices: []u32,
+    corners: []u32 = &.{},
+
+    /// Run `pass` for every job, on a thread pool when there is more than one
+    fn run(self: *WedgeJob, allocator: Allocator, comptime pass: fn (*WedgeJob, usize) void) !void {
+        if (self.jobCount == 1) return pass(self, 0);
+
+        var pool: std.Thread.Pool = undefined;
+        try pool.init(.{ .allocator = allocator, .n_jobs = self.jobCount });
+        defer pool.deinit();
+        var wg: std.Thread.WaitGroup = .{};
+        for (0..self.jobCount) |i| pool.spawnWg(&wg, pass, .{ self, i });
+        pool.waitAndWork(&wg);
+    }
+
+    fn entries(self: *const WedgeJob, i: usize) [2]u32 {
+        const v0 = self.vertexCount * i / self.jobCount;
+        const v1 = self.vertexCount * (i + 1) / self.jobCount;
+        return .{ self.bucketStart[v0], self.bucketStart[v1] };
+    }
+
+    inline fn tuple(self: *const WedgeJob, corner: u32) []const u32 {
+        return self.triIndices[corner * self.indiceLen ..][0..self.indiceLen];
+    }
+
+    /// Give every entry the wedge number of the first equal tuple in its bucket, count new wedges
+    fn count(self: *WedgeJob, i: usize) void {
+        const range = self.entries(i);
+        var wedges: u32 = 0;
+        var bucketEnd: u32 = range[0];
+        var bucket: u32 = range[0];
+        var p: u32 = range[0];
+        while (p < range[1]) : (p += 1) {
+            // ----- entries of one position are contiguous -----
+            if (p == bucketEnd) {
+                bucket = p;
+                const v = self.triIndices[self.byVertex[p] * self.indiceLen];
+                bucketEnd = self.bucketStart[v + 1];
+            }
+            const key = self.tuple(self.byVertex[p]);
+            self.localWedge[p] = wedges;
+            for (bucket..p) |q| {
+                if (std.mem.eql(u32, self.tuple(self.byVertex[q]), key)) {
+                    self.localWedge[p] = self.localWedge[q];
+                    break;
+                }
+            } else wedges += 1;
+        }
+        self.wedgeOffset[i] = wedges;
+    }
+
+    /// Write global wedge numbers of all corners and the first corner of every wedge
+    fn assign(self: *WedgeJob, i: usize) void {
+        const range = self.entries(i);
+        const offset = self.wedgeOffset[i];
+        var next: u32 = 0; // wedges are numbered in entry order, a new one is the first with this number
+        for (range[0]..range[1]) |p| {
+            const corner = self.byVertex[p];
+            const local = self.localWedge[p];
+            self.indices[corner] = offset + local;
+            if (local == next) {
+                self.corners[offset + local] = corner;
+                next += 1;
+            }
+        }
+    }
+};
+
 /// Context for `storeLineInfo`.
 pub const StoreLineContext = struct {
     lineBuf: *std.ArrayList(u8), // stores line characters when file is being read
@@ -473,6 +546,9 @@ fn readInfo(T: type) type {
 /// `bufferedReader` should be reading the file.
 /// `lineBuf` in `context` is used to store lines.
 /// `lineValueCount` in `context` should be the maximum expected amount of values in a line.
+///
+/// Intended to be called with a scratch allocator: the value buffer and preceder are allocated before the
+/// value array, so the array stays the last allocation and can grow in place.
 pub fn storeLineInfo(allocator: Allocator, comptime T: type, bufferedReader: anytype, linePreceder: []const u8, context: StoreLineContext) !readInfo(T) {
 
     // ===== Initialize auxilirary variables =====
@@ -482,8 +558,6 @@ pub fn storeLineInfo(allocator: Allocator, comptime T: type, bufferedReader: any
     var lineBuf: *std.ArrayList(u8) = context.lineBuf;
     const subdivider = context.subdivider;
 
-    var array = try std.ArrayList(T).initCapacity(allocator, context.readCapacity);
-
     const parseFun = switch (@typeInfo(T)) {
         .int => parseInt(T, 10),
         .comptime_int => parseInt(T, 10),
@@ -506,6 +580,9 @@ pub fn storeLineInfo(allocator: Allocator, comptime T: type, bufferedReader: any
     };
     defer allocator.free(preceder);
 
+    var array = try std.ArrayList(T).initCapacity(allocator, context.readCapacity);
+    errdefer array.deinit();
+
     // ===== Load in data =====
 
     var lineLen = try readUntilDelimiter(bufferedReader, lineBuf.writer(), '\n', false);
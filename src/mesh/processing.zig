@@ -9,6 +9,9 @@ const Vec3 = math.vec3;
 
 const Allocator: type = std.mem.Allocator;
 const OfMeshName = @import("import_files.zig").OfMeshName;
+const tracking = @import("../utils/tracking_allocator.zig");
+const scratch_arena = @import("../utils/scratch.zig");
+const ScratchArena = scratch_arena.ScratchArena;
 
 // ======================================
 // Error definition and type declations
@@ -59,6 +62,9 @@ pub fn zeroMesh(mesh: PlaceHolderMesh) void {
 /// Deinits provided `mesh`.
 pub fn chunkMesh(resourceManager: *zune.graphics.ResourceManager, mesh: *PlaceHolderMesh, chunkName: []const u8, XChunks: usize, ZChunks: usize, keepPH: bool) !struct { meshes: []*zune.graphics.Mesh, phMeshes: []PlaceHolderMesh } {
     const allocator = resourceManager.allocator;
+    const prevSubsystem = tracking.enter(.chunking);
+    defer tracking.leave(prevSubsystem);
+    const scratch = scratch_arena.threadScratch(allocator);
 
     // ===== Ensure valid boundingBox in mesh =====
     mesh.boundingBox = mesh.getBoundingBox();
@@ -71,12 +77,12 @@ pub fn chunkMesh(resourceManager: *zune.graphics.ResourceManager, mesh: *PlaceHo
     meshes[0] = mesh.*; // Store value inside array
 
     // ===== Create x-axis strips =====
-    const stripMeshes = try chopChopMesh(allocator, meshes[0], ZChunks, .{ .z = 1 });
+    const stripMeshes = try chopChopMesh(allocator, scratch, meshes[0], ZChunks, .{ .z = 1 });
     defer allocator.free(stripMeshes);
 
     // ===== Split strips into chunks and store =====
     for (stripMeshes, 0..) |strip, i| {
-        const chunks = try chopChopMesh(allocator, strip, XChunks, .{ .x = 1 });
+        const chunks = try chopChopMesh(allocator, scratch, strip, XChunks, .{ .x = 1 });
         @memcpy(meshes[i * XChunks ..][0..XChunks], chunks);
         allocator.free(chunks);
     }
@@ -118,7 +124,8 @@ pub fn chunkMesh2Model(resourceManager: *zune.graphics.ResourceManager, mesh: *P
 // ======================================
 
 /// Split mesh in N strips along cardinal 'dir' axis: This implies the axis orthogonal to `dir` axis remains intact
-fn chopChopMesh(allocator: Allocator, mesh: PlaceHolderMesh, N: usize, dir: Vec3(f32)) ![]PlaceHolderMesh {
+/// `scratch` is restored after every split.
+fn chopChopMesh(allocator: Allocator, scratch: *ScratchArena, mesh: PlaceHolderMesh, N: usize, dir: Vec3(f32)) ![]PlaceHolderMesh {
     // ===== Initialize variables =====
     const axis: Vec3(f32) = if (dir.x > dir.z) .{ .x = 1 } else .{ .z = 1 };
     const meshes = try allocator.alloc(PlaceHolderMesh, N);
@@ -141,7 +148,7 @@ fn chopChopMesh(allocator: Allocator, mesh: PlaceHolderMesh, N: usize, dir: Vec3
         const ratio = @as(f32, @floatFromInt(splitWorth)) / @as(f32, @floatFromInt(maxWorth));
 
         // ----- Split mesh & store -----
-        const splitMeshes = try ratioSplitMesh(allocator, meshes[i], ratio, axis);
+        const splitMeshes = try ratioSplitMesh(allocator, scratch, meshes[i], ratio, axis);
 
         meshes[i] = splitMeshes[0];
         meshes[i + splitWorth] = splitMeshes[1];
@@ -158,48 +165,45 @@ fn chopChopMesh(allocator: Allocator, mesh: PlaceHolderMesh, N: usize, dir: Vec3
 
 /// Thin wrapper around `splitMesh` to split based on a ratio along `dir`. Cuts orthogonal to direction.
 /// Assumes `mesh.boundingBox` exists, and dir is axis-bound: either y=1 or z=1
-fn ratioSplitMesh(allocator: Allocator, mesh: PlaceHolderMesh, ratio: f32, dir: Vec3(f32)) ![2]PlaceHolderMesh {
+fn ratioSplitMesh(allocator: Allocator, scratch: *ScratchArena, mesh: PlaceHolderMesh, ratio: f32, dir: Vec3(f32)) ![2]PlaceHolderMesh {
     if (ratio < 0 or 1 <= ratio) return MeshError.InvalidDimensions;
 
     const meshSize = mesh.boundingBox.max.subtract(mesh.boundingBox.min);
 
     return switch (dir.x == 1) {
-        true => try splitMesh(allocator, mesh, .{ .x = ratio * meshSize.x + mesh.boundingBox.min.x }, .{ .z = -1.0 }),
-        false => try splitMesh(allocator, mesh, .{ .z = ratio * meshSize.z + mesh.boundingBox.min.z }, .{ .x = 1.0 }),
+        true => try splitMesh(allocator, scratch, mesh, .{ .x = ratio * meshSize.x + mesh.boundingBox.min.x }, .{ .z = -1.0 }),
+        false => try splitMesh(allocator, scratch, mesh, .{ .z = ratio * meshSize.z + mesh.boundingBox.min.z }, .{ .x = 1.0 }),
     };
 }
 
 /// Split phMesh into 2 seperate placeholder meshes, cutting from `point` along `dir`
 /// left of `dir` is first mesh, right of `dir` is other.
 /// Deinitializes provided mesh
-pub fn splitMesh(allocator: Allocator, mesh: PlaceHolderMesh, point: Vec3(f32), dir: Vec3(f32)) ![2]PlaceHolderMesh {
+///
+/// Working buffers are taken from `scratch`, which is restored to its entry mark before returning. Only the final, exactly sized slices are allocated with `allocator`.
+pub fn splitMesh(allocator: Allocator, scratch: *ScratchArena, mesh: PlaceHolderMesh, point: Vec3(f32), dir: Vec3(f32)) ![2]PlaceHolderMesh {
     const TotVertexCount: u32 = mesh.vertexCount;
     const TotTriangleCount: u32 = mesh.triangleCount;
+    const mark = scratch.mark();
+    defer scratch.restore(mark);
+    const scratchAllocator = scratch.allocator();
 
     const orth_dir = (Vec3(f32){ .y = 1 }).cross(dir);
 
     // Continue initializing vertices
-    const vertice1 = try allocator.alloc(f32, TotVertexCount * 3);
-    errdefer allocator.free(vertice1);
+    const vertice1 = try scratchAllocator.alloc(f32, TotVertexCount * 3);
     var p1: u32 = 0;
-    const vertice2 = try allocator.alloc(f32, TotVertexCount * 3);
-    errdefer allocator.free(vertice2);
+    const vertice2 = try scratchAllocator.alloc(f32, TotVertexCount * 3);
     var p2: u32 = 0;
 
-    const UV1 = try allocator.alloc(f32, TotVertexCount * 2);
-    errdefer allocator.free(UV1);
-    const UV2 = try allocator.alloc(f32, TotVertexCount * 2);
-    errdefer allocator.free(UV2);
+    const UV1 = try scratchAllocator.alloc(f32, TotVertexCount * 2);
+    const UV2 = try scratchAllocator.alloc(f32, TotVertexCount * 2);
 
-    const normal1 = try allocator.alloc(f32, TotVertexCount * 3);
-    errdefer allocator.free(normal1);
-    const normal2 = try allocator.alloc(f32, TotVertexCount * 3);
-    errdefer allocator.free(normal2);
+    const normal1 = try scratchAllocator.alloc(f32, TotVertexCount * 3);
+    const normal2 = try scratchAllocator.alloc(f32, TotVertexCount * 3);
 
-    const ids1: []u32 = try allocator.alloc(u32, TotVertexCount);
-    errdefer allocator.free(ids1);
-    const ids2: []u32 = try allocator.alloc(u32, TotVertexCount);
-    errdefer allocator.free(ids2);
+    const ids1: []u32 = try scratchAllocator.alloc(u32, TotVertexCount);
+    const ids2: []u32 = try scratchAllocator.alloc(u32, TotVertexCount);
 
     // Bounding box variable to keep track of
     var BBmin1: Vec3(f32) = .{ .x = 999999.9, .y = 999999.9, .z = 999999.9 };
@@ -254,15 +258,13 @@ pub fn splitMesh(allocator: Allocator, mesh: PlaceHolderMesh, point: Vec3(f32),
     const chunk2Vertices = p2;
 
     // Refactor indices such that all vertices with an index below n belong to chunk 1 and all vertices above n fall within chunk 2
-    const connection_mask1: []bool = try allocator.alloc(bool, TotTriangleCount); // Used to keep track of which faces belong to chunk 1
-    errdefer allocator.free(connection_mask1);
-    const connection_mask2: []bool = try allocator.alloc(bool, TotTriangleCount); // Used to keep track of which faces belong to chunk 2
-    errdefer allocator.free(connection_mask2);
-    const other_vertex_offset: []u2 = try allocator.alloc(u2, TotTriangleCount); // Used to keep track which singular vertice falls in the other chunk | vertex 0 -> vertex 1 and 2 fall inside other chunk etc.
-    errdefer allocator.free(other_vertex_offset);
+    const connection_mask1: []bool = try scratchAllocator.alloc(bool, TotTriangleCount); // Used to keep track of which faces belong to chunk 1
+    const connection_mask2: []bool = try scratchAllocator.alloc(bool, TotTriangleCount); // Used to keep track of which faces belong to chunk 2
+    const other_vertex_offset: []u2 = try scratchAllocator.alloc(u2, TotTriangleCount); // Used to keep track which singular vertice falls in the other chunk | vertex 0 -> vertex 1 and 2 fall inside other chunk etc.
+    @memset(connection_mask1, false);
+    @memset(connection_mask2, false);
 
-    const editable_indices = try allocator.alloc(u32, TotTriangleCount * 3);
-    errdefer allocator.free(editable_indices);
+    const editable_indices = try scratchAllocator.alloc(u32, TotTriangleCount * 3);
 
     @memcpy(editable_indices, mesh.indices[0 .. TotTriangleCount * 3]);
 
@@ -320,11 +322,9 @@ pub fn splitMesh(allocator: Allocator, mesh: PlaceHolderMesh, point: Vec3(f32),
     }
 
     // store faces into respective indices and divide up ambiguous faces between the 2 chunks
-    const indice1 = try allocator.alloc(u32, (TotTriangleCount - p2) * 3); // p1 = amount of faces in chunk 1 -> total-p2 = amount of possible faces in chunk 1 (including edge-faces)
-    errdefer allocator.free(indice1);
+    const indice1 = try scratchAllocator.alloc(u32, (TotTriangleCount - p2) * 3); // p1 = amount of faces in chunk 1 -> total-p2 = amount of possible faces in chunk 1 (including edge-faces)
     // std.debug.print("TotTriangleCount - p1 = {} - {} = {}\n", .{TotTriangleCount, p1, TotTriangleCount - p1});
-    const indice2 = try allocator.alloc(u32, (TotTriangleCount - p1) * 3); // Same for p2 and chunk 2
-    errdefer allocator.free(indice2);
+    const indice2 = try scratchAllocator.alloc(u32, (TotTriangleCount - p1) * 3); // Same for p2 and chunk 2
 
     var added_vertices1: u32 = 0; // Keep track of added vertices
     var added_vertices2: u32 = 0;
@@ -414,18 +414,25 @@ pub fn splitMesh(allocator: Allocator, mesh: PlaceHolderMesh, point: Vec3(f32),
         // IF CUT SHOULD BE WITHIN MESH BOUNDS -> TRY ROTATING CUTTING DIRECTION
     }
 
-    // Trimming memory to correct size
-    const vertices1 = try allocator.realloc(vertice1, chunk1_Vertices * 3);
-    const vertices2 = try allocator.realloc(vertice2, chunk2_Vertices * 3);
+    // Copy used portion out of scratch memory
+    const vertices1 = try allocator.dupe(f32, vertice1[0 .. chunk1_Vertices * 3]);
+    errdefer allocator.free(vertices1);
+    const vertices2 = try allocator.dupe(f32, vertice2[0 .. chunk2_Vertices * 3]);
+    errdefer allocator.free(vertices2);
 
-    const indices1 = try allocator.realloc(indice1, p1 * 3);
-    const indices2 = try allocator.realloc(indice2, p2 * 3);
+    const indices1 = try allocator.dupe(u32, indice1[0 .. p1 * 3]);
+    errdefer allocator.free(indices1);
+    const indices2 = try allocator.dupe(u32, indice2[0 .. p2 * 3]);
+    errdefer allocator.free(indices2);
 
-    const normals1 = try allocator.realloc(normal1, chunk1_Vertices * 3);
-    const normals2 = try allocator.realloc(normal2, chunk2_Vertices * 3);
+    const normals1 = try allocator.dupe(f32, normal1[0 .. chunk1_Vertices * 3]);
+    errdefer allocator.free(normals1);
+    const normals2 = try allocator.dupe(f32, normal2[0 .. chunk2_Vertices * 3]);
+    errdefer allocator.free(normals2);
 
-    const UVs1 = try allocator.realloc(UV1, chunk1_Vertices * 2);
-    const UVs2 = try allocator.realloc(UV2, chunk2_Vertices * 2);
+    const UVs1 = try allocator.dupe(f32, UV1[0 .. chunk1_Vertices * 2]);
+    errdefer allocator.free(UVs1);
+    const UVs2 = try allocator.dupe(f32, UV2[0 .. chunk2_Vertices * 2]);
 
     // Construct meshes
     const meshes: [2]PlaceHolderMesh = .{
@@ -451,13 +458,7 @@ pub fn splitMesh(allocator: Allocator, mesh: PlaceHolderMesh, point: Vec3(f32),
         },
     };
 
-    // Free up memory
-    allocator.free(connection_mask1);
-    allocator.free(connection_mask2);
-    allocator.free(other_vertex_offset);
-    allocator.free(editable_indices);
-    allocator.free(ids1);
-    allocator.free(ids2);
+    // Free up memory (working buffers are released with the scratch reset)
     mesh.deinit();
 
     return meshes;
@@ -548,23 +549,26 @@ pub const PlaceHolderMesh = struct {
         return data;
     }
 
-    /// Simplifies mesh by de-duplicating meshses. Assumes texcoords are not present, if they are, they will be invalidated.
+    /// Simplifies mesh by de-duplicating meshses. Duplicates keep the texcoords of their first occurrence.
     /// The new normal of a de-duped vertex is simply taken as the average of the duplicate vertices.
-    pub fn removeDuplicateVertices(self: *PlaceHolderMesh) !void {
+    ///
+    /// The lookup table and remap buffer are allocated with `scratch`.
+    pub fn removeDuplicateVertices(self: *PlaceHolderMesh, scratch: Allocator) !void {
         const allocator = self.allocator;
         const vertexCount = self.vertexCount;
         const vertices = self.vertices;
         const indices = self.indices;
         const normals = self.normals;
+        const texcoords = self.texcoords;
 
-        var hm = std.AutoHashMap([3]u32, u32).init(allocator);
+        var hm = std.AutoHashMap([3]u32, u32).init(scratch);
         defer hm.deinit();
         const reservedCapacity: u32 = @intFromFloat(@round(@as(f32,@floatFromInt(vertexCount))*1.2));
         try hm.ensureTotalCapacity(reservedCapacity);
 
         // const new_vertices = try self.allocator.alloc(f32, vertexCount*3);
-        const replace_loc: []u32 = try allocator.alloc(u32, vertexCount);
-        defer allocator.free(replace_loc);
+        const replace_loc: []u32 = try scratch.alloc(u32, vertexCount);
+        defer scratch.free(replace_loc);
 
         var i:u32 = 0;
         var j:u32 = 0;
@@ -586,6 +590,8 @@ pub const PlaceHolderMesh = struct {
             if(!hm_result.found_existing) { // if unique vertex
                 @memcpy(vertices[j*3..][0..3], &vertex); // copy back if not the same location (j <= i always true)
                 @memcpy(normals[j*3..][0..3], &normal);
+                const uv = texcoords[i*2..][0..2].*;
+                @memcpy(texcoords[j*2..][0..2], &uv);
 
                 hm_result.value_ptr.* = j;
                 replace_loc[i] = hm_result.value_ptr.*; // Store new vertex position
@@ -621,9 +627,11 @@ pub const PlaceHolderMesh = struct {
 
         const vertices_trimmed: []f32 = try allocator.realloc(vertices, self.vertexCount*3);
         const normals_trimmed: []f32 = try allocator.realloc(normals, self.vertexCount*3);
+        const texcoords_trimmed: []f32 = try allocator.realloc(texcoords, self.vertexCount*2);
         
         self.vertices = vertices_trimmed;
         self.normals = normals_trimmed;
+        self.texcoords = texcoords_trimmed;
 
     }
 
@@ -0,0 +1,51 @@
+const std = @import("std");
+const math = @import("../math.zig");
+const MN = @import("../globals.zig");
+
+const PHMesh = @import("processing.zig").PlaceHolderMesh;
+
+/// How far a simplified mesh strays from its original, for tuning `collapseMesh` and comparing schedulers.
+///
+/// Measured by the `eigen_mesh_distance` wrapper kernel at stratified, area weighted samples on both surfaces, each
+/// matched to the closest point of the other surface through a BVH. The sample count bounds the cost, not the
+/// triangle counts.
+pub const SurfaceDistance = struct {
+    hausdorffSimplified: f32, // max distance from the simplified surface to the original
+    hausdorffOriginal: f32, // max distance from the original surface to the simplified one
+    hausdorff: f32, // symmetric
+    rmsSimplified: f32,
+    rmsOriginal: f32,
+    rms: f32, // over the samples of both surfaces
+    quadric: f32, // mean squared distance of simplified samples to the plane of their closest original face
+
+    /// Distances between `simplified` and `original` over `MN.DISTANCE_SAMPLES` samples per surface
+    pub fn measure(simplified: PHMesh, original: PHMesh) SurfaceDistance {
+        return measureSamples(simplified, original, MN.DISTANCE_SAMPLES, 0);
+    }
+
+    /// Distances over `samples` samples per surface, placed from `seed`. Equal arguments give equal results.
+    pub fn measureSamples(simplified: PHMesh, original: PHMesh, samples: usize, seed: u32) SurfaceDistance {
+        var out: [7]f32 = undefined;
+        math.eigen_mesh_distance(
+            simplified.vertices.ptr,
+            simplified.indices.ptr,
+            @intCast(simplified.triangleCount),
+            original.vertices.ptr,
+            original.indices.ptr,
+            @intCast(original.triangleCount),
+            @intCast(@min(samples, std.math.maxInt(c_int))),
+            seed,
+            MN.DISTANCE_KERNEL_THREADS,
+            &out,
+        );
+        return .{
+            .hausdorffSimplified = out[0],
+            .hausdorffOriginal = out[1],
+            .hausdorff = out[2],
+            .rmsSimplified = out[3],
+            .rmsOriginal = out[4],
+            .rms = out[5],
+            .quadric = out[6],
+        };
+    }
+};
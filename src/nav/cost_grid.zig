@@ -0,0 +1,246 @@
+const std = @import("std");
+const math = @import("../math.zig");
+const mProc = @import("../mesh/processing.zig");
+const FaceAttributes = @import("../mesh/face_attributes.zig").FaceAttributes;
+
+const Vec2 = math.vec2;
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+
+const CostGridError = error{ InvalidResolution, EmptyMap };
+
+pub const blocked: u8 = 255;
+pub const maxCost: u8 = 254;
+
+// ----- 8-neighbourhood: orthogonal first, then diagonal -----
+pub const neighbourX = [8]i32{ 1, -1, 0, 0, 1, -1, 1, -1 };
+pub const neighbourZ = [8]i32{ 0, 0, 1, -1, 1, 1, -1, -1 };
+pub const neighbourWeight = [8]f32{ 1, 1, 1, 1, std.math.sqrt2, std.math.sqrt2, std.math.sqrt2, std.math.sqrt2 };
+
+/// Padded index offsets of the neighbourhood for a grid of `width`
+pub fn neighbourOffsets(width: usize) [8]i64 {
+    var offsets: [8]i64 = undefined;
+    for (&offsets, neighbourX, neighbourZ) |*o, dx, dz| o.* = @as(i64, dz) * @as(i64, @intCast(width)) + dx;
+    return offsets;
+}
+
+/// Diagonal step `k` from padded cell `p` does not cut a blocked corner
+pub inline fn diagonalOpen(costs: []const u8, p: usize, k: usize, width: usize) bool {
+    const sx: usize = @intCast(@as(i64, @intCast(p)) + neighbourX[k]);
+    const sz: usize = @intCast(@as(i64, @intCast(p)) + @as(i64, neighbourZ[k]) * @as(i64, @intCast(width)));
+    return costs[sx] != blocked and costs[sz] != blocked;
+}
+
+/// A single cost change, see `CostGrid.changesSince`
+pub const CostChange = struct {
+    cell: u32, // unpadded cell index
+    version: u64,
+    increased: bool, // cost went up (or cell got blocked), paths through it may have become invalid
+};
+
+/// Traversal cost of every nav cell, 1 on flat ground up to `maxCost` on the steepest walkable slope, `blocked` if the
+/// cell is too steep or not covered by the map.
+///
+/// The grid is stored with a one cell border of blocked cells (`width` x `height`), so neighbour lookups of field
+/// passes never need bounds checks. Every cost change bumps `version` and is logged for incremental field repair.
+pub const CostGrid = struct {
+    allocator: Allocator,
+
+    origin: Vec3(f32), // minimum corner of the map
+    chunking: Vec2(usize), // map chunks, every chunk is `cellsPerChunk` x `cellsPerChunk` cells
+    cellsPerChunk: usize,
+    resolution: Vec2(usize), // cell count in x and z, without border
+    cellSize: Vec2(f32),
+    width: usize, // resolution.x + 2
+    height: usize, // resolution.y + 2
+    costs: []u8, // [(z + 1) * width + x + 1]
+
+    version: u64 = 0,
+    changes: std.ArrayList(CostChange),
+    logStart: u64 = 0, // changes of versions <= logStart were dropped
+
+    const maxLoggedChanges = 4096;
+
+    /// Rasterize the slope of every face of `mesh` onto a grid of `cellsPerChunk` cells per chunk side. The grid matches
+    /// `SimMap` for the same mesh, chunking and resolution. Cells take the steepest face covering their center.
+    pub fn fromMesh(allocator: Allocator, mesh: mProc.PlaceHolderMesh, chunking: Vec2(usize), cellsPerChunk: usize, maxSlope: f32) !CostGrid {
+        if (chunking.x == 0 or chunking.y == 0 or cellsPerChunk == 0) return CostGridError.InvalidResolution;
+        if (mesh.triangleCount == 0) return CostGridError.EmptyMap;
+
+        const bb = mesh.getBoundingBox();
+        const extent = bb.max.subtract(bb.min);
+        const resolution = Vec2(usize){ .x = chunking.x * cellsPerChunk, .y = chunking.y * cellsPerChunk };
+
+        var result = try CostGrid.initBlocked(allocator, bb.min, chunking, cellsPerChunk, .{
+            .x = extent.x / @as(f32, @floatFromInt(resolution.x)),
+            .y = extent.z / @as(f32, @floatFromInt(resolution.y)),
+        });
+        errdefer result.deinit();
+
+        // ----- steepest face slope per cell, NaN where uncovered -----
+        const slopes = try allocator.alloc(f32, resolution.x * resolution.y);
+        defer allocator.free(slopes);
+        const faces = try FaceAttributes.compute(allocator, mesh.vertices[0 .. mesh.vertexCount * 3], mesh.indices[0 .. mesh.triangleCount * 3]);
+        defer faces.deinit();
+        result.rasterizeSlopes(slopes, mesh, faces);
+
+        for (0..resolution.y) |z| {
+            for (0..resolution.x) |x| {
+                const slope = slopes[z * resolution.x + x];
+                result.costs[result.padded(x, z)] = slopeCost(slope, maxSlope);
+            }
+        }
+        return result;
+    }
+
+    /// Grid with every cell blocked, e.g. to be filled with `setCost`
+    pub fn initBlocked(allocator: Allocator, origin: Vec3(f32), chunking: Vec2(usize), cellsPerChunk: usize, cellSize: Vec2(f32)) !CostGrid {
+        if (chunking.x == 0 or chunking.y == 0 or cellsPerChunk == 0) return CostGridError.InvalidResolution;
+        const resolution = Vec2(usize){ .x = chunking.x * cellsPerChunk, .y = chunking.y * cellsPerChunk };
+        const width = resolution.x + 2;
+        const height = resolution.y + 2;
+        const costs = try allocator.alloc(u8, width * height);
+        @memset(costs, blocked);
+
+        return .{
+            .allocator = allocator,
+            .origin = origin,
+            .chunking = chunking,
+            .cellsPerChunk = cellsPerChunk,
+            .resolution = resolution,
+            .cellSize = cellSize,
+            .width = width,
+            .height = height,
+            .costs = costs,
+            .changes = std.ArrayList(CostChange).init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *CostGrid) void {
+        self.allocator.free(self.costs);
+        self.changes.deinit();
+    }
+
+    pub fn cellCount(self: CostGrid) usize {
+        return self.resolution.x * self.resolution.y;
+    }
+
+    /// Padded index of cell (`x`, `z`)
+    pub inline fn padded(self: CostGrid, x: usize, z: usize) usize {
+        return (z + 1) * self.width + x + 1;
+    }
+
+    /// Unpadded cell index -> padded index
+    pub inline fn paddedIndex(self: CostGrid, cell: usize) usize {
+        return self.padded(cell % self.resolution.x, cell / self.resolution.x);
+    }
+
+    /// Cell containing world position (`x`, `z`), null if outside the map
+    pub fn cellIndex(self: CostGrid, x: f32, z: f32) ?usize {
+        const fx = (x - self.origin.x) / self.cellSize.x;
+        const fz = (z - self.origin.z) / self.cellSize.y;
+        if (!(fx >= 0) or !(fz >= 0)) return null;
+        const cx: usize = @intFromFloat(@min(fx, 1e9));
+        const cz: usize = @intFromFloat(@min(fz, 1e9));
+        if (cx >= self.resolution.x or cz >= self.resolution.y) return null;
+        return cz * self.resolution.x + cx;
+    }
+
+    /// World position of the center of `cell`
+    pub fn cellCenter(self: CostGrid, cell: usize) Vec3(f32) {
+        const x: f32 = @floatFromInt(cell % self.resolution.x);
+        const z: f32 = @floatFromInt(cell / self.resolution.x);
+        return .{ .x = self.origin.x + (x + 0.5) * self.cellSize.x, .y = self.origin.y, .z = self.origin.z + (z + 0.5) * self.cellSize.y };
+    }
+
+    pub fn cost(self: CostGrid, cell: usize) u8 {
+        return self.costs[self.paddedIndex(cell)];
+    }
+
+    // ======================================
+    // Changes
+    // ======================================
+
+    /// Change cost of `cell` (1..`maxCost` or `blocked`), cached flow fields repair themselves on their next use
+    pub fn setCost(self: *CostGrid, cell: usize, newCost: u8) !void {
+        const c = &self.costs[self.paddedIndex(cell)];
+        const clamped = @max(newCost, 1);
+        if (c.* == clamped) return;
+        const increased = clamped > c.*;
+        c.* = clamped;
+        self.version += 1;
+
+        if (self.changes.items.len >= maxLoggedChanges) {
+            self.logStart = self.version - 1; // older fields rebuild from scratch
+            self.changes.clearRetainingCapacity();
+        }
+        try self.changes.append(.{ .cell = @intCast(cell), .version = self.version, .increased = increased });
+    }
+
+    /// Changes after `version`, null if part of them is no longer logged
+    pub fn changesSince(self: CostGrid, version: u64) ?[]const CostChange {
+        if (version < self.logStart) return null;
+        const changes = self.changes.items;
+        var i = changes.len;
+        while (i > 0 and changes[i - 1].version > version) i -= 1;
+        return changes[i..];
+    }
+
+    // ======================================
+    // Construction
+    // ======================================
+
+    fn slopeCost(slope: f32, maxSlope: f32) u8 {
+        if (std.math.isNan(slope) or slope > maxSlope) return blocked;
+        const t = slope / maxSlope; // 0 flat .. 1 steepest walkable
+        return @intFromFloat(1 + @round(t * t * @as(f32, maxCost - 1)));
+    }
+
+    /// Store the steepest face slope (rise over run, from the face normal) at every cell center. NaN if uncovered.
+    fn rasterizeSlopes(self: CostGrid, slopes: []f32, mesh: mProc.PlaceHolderMesh, faces: FaceAttributes) void {
+        @memset(slopes, std.math.nan(f32));
+        const row = self.resolution.x;
+        const v = mesh.vertices;
+
+        var f: usize = 0;
+        while (f < mesh.triangleCount) : (f += 1) {
+            const tri = mesh.indices[f * 3 ..][0..3];
+            const a: @Vector(3, f32) = v[tri[0] * 3 ..][0..3].*;
+            const b: @Vector(3, f32) = v[tri[1] * 3 ..][0..3].*;
+            const c: @Vector(3, f32) = v[tri[2] * 3 ..][0..3].*;
+
+            // ----- slope from face normal -----
+            if (faces.normalY[f] == 0) continue; // vertical face, does not cover any cell center
+            const slope = faces.slope(f);
+
+            // ----- barycentric denominator in xz -----
+            const det = (b[2] - c[2]) * (a[0] - c[0]) + (c[0] - b[0]) * (a[2] - c[2]);
+            if (@abs(det) < 1e-12) continue;
+
+            const cx0 = self.cellFloor(@min(a[0], b[0], c[0]) - self.origin.x, self.cellSize.x, self.resolution.x);
+            const cx1 = self.cellFloor(@max(a[0], b[0], c[0]) - self.origin.x, self.cellSize.x, self.resolution.x);
+            const cz0 = self.cellFloor(@min(a[2], b[2], c[2]) - self.origin.z, self.cellSize.y, self.resolution.y);
+            const cz1 = self.cellFloor(@max(a[2], b[2], c[2]) - self.origin.z, self.cellSize.y, self.resolution.y);
+
+            for (cz0..cz1 + 1) |cz| {
+                const pz = (@as(f32, @floatFromInt(cz)) + 0.5) * self.cellSize.y + self.origin.z;
+                for (cx0..cx1 + 1) |cx| {
+                    const px = (@as(f32, @floatFromInt(cx)) + 0.5) * self.cellSize.x + self.origin.x;
+
+                    const w0 = ((b[2] - c[2]) * (px - c[0]) + (c[0] - b[0]) * (pz - c[2])) / det;
+                    const w1 = ((c[2] - a[2]) * (px - c[0]) + (a[0] - c[0]) * (pz - c[2])) / det;
+                    if (w0 < 0 or w1 < 0 or 1 - w0 - w1 < 0) continue; // cell center outside triangle
+
+                    const cell = &slopes[cz * row + cx];
+                    if (std.math.isNan(cell.*) or slope > cell.*) cell.* = slope;
+                }
+            }
+        }
+    }
+
+    fn cellFloor(_: CostGrid, local: f32, cellSize: f32, count: usize) usize {
+        const c = @floor(local / cellSize);
+        if (c <= 0) return 0;
+        return @min(@as(usize, @intFromFloat(c)), count - 1);
+    }
+};
@@ -0,0 +1,349 @@
+const std = @import("std");
+const math = @import("../math.zig");
+const cost_grid = @import("cost_grid.zig");
+
+const CostGrid = cost_grid.CostGrid;
+const Vec2 = math.vec2;
+const Allocator = std.mem.Allocator;
+
+const lanes = std.simd.suggestVectorLength(f32) orelse 4;
+const VecN = @Vector(lanes, f32);
+const VecU8 = @Vector(lanes, u8);
+
+pub const noDirection: u8 = 255;
+const inf = std.math.inf(f32);
+
+const neighbourX = cost_grid.neighbourX;
+const neighbourZ = cost_grid.neighbourZ;
+const neighbourWeight = cost_grid.neighbourWeight;
+const neighbourOffsets = cost_grid.neighbourOffsets;
+const diagonalOpen = cost_grid.diagonalOpen;
+
+const QueueEntry = struct {
+    distance: f32,
+    cell: u32, // padded
+};
+
+fn queueOrder(_: void, a: QueueEntry, b: QueueEntry) std.math.Order {
+    return std.math.order(a.distance, b.distance);
+}
+const Queue = std.PriorityQueue(QueueEntry, void, queueOrder);
+
+/// Path to a single goal for every cell of a `CostGrid`. The integration field holds the cheapest cost to the goal,
+/// the direction field points every cell at the neighbour it is reached through. Any number of units can steer by
+/// sampling `flowAt`.
+///
+/// Fields use the padded layout of the grid. Diagonal moves are only allowed when both orthogonal neighbours are open.
+pub const FlowField = struct {
+    allocator: Allocator,
+    goal: u32, // unpadded cell index, `noGoal` until the first successful build
+    costVersion: u64 = 0, // grid version the field is valid for
+
+    integration: []f32,
+    directions: []u8, // index into the neighbourhood, `noDirection` at the goal and unreachable cells
+
+    // ----- reused by builds and repairs -----
+    queue: Queue,
+    marks: []u8, // repair: 0 unknown, 1 affected, 2 valid
+    chain: std.ArrayList(u32),
+
+    pub const noGoal = std.math.maxInt(u32);
+
+    pub fn init(allocator: Allocator, grid: *const CostGrid) !FlowField {
+        const n = grid.width * grid.height;
+        const integration = try allocator.alloc(f32, n);
+        errdefer allocator.free(integration);
+        const directions = try allocator.alloc(u8, n);
+        errdefer allocator.free(directions);
+        const marks = try allocator.alloc(u8, n);
+
+        return .{
+            .allocator = allocator,
+            .goal = noGoal,
+            .integration = integration,
+            .directions = directions,
+            .queue = Queue.init(allocator, {}),
+            .marks = marks,
+            .chain = std.ArrayList(u32).init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *FlowField) void {
+        self.allocator.free(self.integration);
+        self.allocator.free(self.directions);
+        self.allocator.free(self.marks);
+        self.queue.deinit();
+        self.chain.deinit();
+    }
+
+    // ======================================
+    // Queries
+    // ======================================
+
+    /// Normalized xz-direction towards the goal at world position (`x`, `z`), zero at the goal or if unreachable
+    pub fn flowAt(self: FlowField, grid: *const CostGrid, x: f32, z: f32) Vec2(f32) {
+        const cell = grid.cellIndex(x, z) orelse return .{};
+        return directionVector(self.directions[grid.paddedIndex(cell)]);
+    }
+
+    pub fn reachable(self: FlowField, grid: *const CostGrid, cell: usize) bool {
+        return self.integration[grid.paddedIndex(cell)] != inf;
+    }
+
+    fn directionVector(direction: u8) Vec2(f32) {
+        if (direction == noDirection) return .{};
+        const x: f32 = @floatFromInt(neighbourX[direction]);
+        const z: f32 = @floatFromInt(neighbourZ[direction]);
+        const r = 1 / neighbourWeight[direction];
+        return .{ .x = x * r, .y = z * r };
+    }
+
+    // ======================================
+    // Build
+    // ======================================
+
+    /// Integrate from `goal` over the whole grid and derive the direction field
+    pub fn build(self: *FlowField, grid: *const CostGrid, goal: u32) !void {
+        self.goal = goal;
+        @memset(self.integration, inf);
+        self.queue.items.len = 0; // entries left by a failed build or repair
+
+        const start: u32 = @intCast(grid.paddedIndex(goal));
+        if (grid.costs[start] != cost_grid.blocked) {
+            self.integration[start] = 0;
+            try self.queue.add(.{ .distance = 0, .cell = start });
+            try self.integrate(grid);
+        }
+        self.updateDirections(grid);
+        self.costVersion = grid.version;
+    }
+
+    /// Dijkstra from everything in the queue. Entries must hold the current integration value of their cell.
+    fn integrate(self: *FlowField, grid: *const CostGrid) !void {
+        const costs = grid.costs;
+        const integration = self.integration;
+        const offsets = neighbourOffsets(grid.width);
+
+        while (self.queue.removeOrNull()) |entry| {
+            const p = entry.cell;
+            if (entry.distance > integration[p]) continue; // stale entry
+
+            inline for (0..8) |k| {
+                const n: u32 = @intCast(@as(i64, p) + offsets[k]);
+                if (costs[n] != cost_grid.blocked and (k < 4 or diagonalOpen(costs, p, k, grid.width))) {
+                    const d = entry.distance + neighbourWeight[k] * @as(f32, @floatFromInt(costs[n]));
+                    if (d < integration[n]) {
+                        integration[n] = d;
+                        try self.queue.add(.{ .distance = d, .cell = n });
+                    }
+                }
+            }
+        }
+    }
+
+    /// Point every reachable cell at the neighbour minimizing neighbour integration + step cost. Rows are processed
+    /// `lanes` cells at a time.
+    fn updateDirections(self: *FlowField, grid: *const CostGrid) void {
+        const costs = grid.costs;
+        const integration = self.integration;
+        const width = grid.width;
+        const offsets = neighbourOffsets(width);
+        const blockedV: VecU8 = @splat(cost_grid.blocked);
+        const infV: VecN = @splat(inf);
+
+        @memset(self.directions, noDirection);
+        for (1..grid.height - 1) |z| {
+            const rowEnd = z * width + width - 1;
+            var p = z * width + 1;
+            while (p + lanes <= rowEnd) : (p += lanes) {
+                const own: VecN = integration[p..][0..lanes].*;
+                const cost: VecN = @floatFromInt(@as(VecU8, costs[p..][0..lanes].*));
+
+                var best = infV;
+                var dir: VecU8 = @splat(noDirection);
+                inline for (0..8) |k| {
+                    const n: usize = @intCast(@as(i64, @intCast(p)) + offsets[k]);
+                    var cand = @as(VecN, integration[n..][0..lanes].*) + cost * @as(VecN, @splat(neighbourWeight[k]));
+                    if (k >= 4) {
+                        const sx: usize = @intCast(@as(i64, @intCast(p)) + neighbourX[k]);
+                        const sz: usize = @intCast(@as(i64, @intCast(p)) + neighbourZ[k] * @as(i64, @intCast(width)));
+                        const openX = @as(VecU8, costs[sx..][0..lanes].*) != blockedV;
+                        const openZ = @as(VecU8, costs[sz..][0..lanes].*) != blockedV;
+                        cand = @select(f32, openX, @select(f32, openZ, cand, infV), infV);
+                    }
+                    const better = cand < best;
+                    best = @select(f32, better, cand, best);
+                    dir = @select(u8, better, @as(VecU8, @splat(k)), dir);
+                }
+
+                // ----- goal, blocked and unreachable cells keep no direction -----
+                const none: VecU8 = @splat(noDirection);
+                const finite = @select(u8, own < infV, dir, none);
+                self.directions[p..][0..lanes].* = @select(u8, own > @as(VecN, @splat(0)), finite, none);
+            }
+            while (p < rowEnd) : (p += 1) self.directions[p] = self.directionAt(grid, p);
+        }
+    }
+
+    fn directionAt(self: FlowField, grid: *const CostGrid, p: usize) u8 {
+        const own = self.integration[p];
+        if (!(own > 0) or own == inf) return noDirection;
+
+        const offsets = neighbourOffsets(grid.width);
+        const cost: f32 = @floatFromInt(grid.costs[p]);
+        var best = inf;
+        var dir = noDirection;
+        inline for (0..8) |k| {
+            const n: usize = @intCast(@as(i64, @intCast(p)) + offsets[k]);
+            if (k < 4 or diagonalOpen(grid.costs, p, k, grid.width)) {
+                const cand = self.integration[n] + cost * neighbourWeight[k];
+                if (cand < best) {
+                    best = cand;
+                    dir = k;
+                }
+            }
+        }
+        return dir;
+    }
+
+    // ======================================
+    // Incremental repair
+    // ======================================
+
+    /// Bring the field up to the current grid version. Cells whose path runs through a cell which got more expensive
+    /// are reset and re-integrated from their valid neighbours, cheaper cells are re-relaxed from their neighbours.
+    /// Falls back to a full `build` when the change log no longer covers the field or the goal itself changed.
+    pub fn repair(self: *FlowField, grid: *const CostGrid) !void {
+        if (self.costVersion == grid.version) return;
+        const changes = grid.changesSince(self.costVersion) orelse return self.build(grid, self.goal);
+        for (changes) |change| {
+            if (change.cell == self.goal) return self.build(grid, self.goal);
+        }
+
+        const width = grid.width;
+        const offsets = neighbourOffsets(width);
+        const integration = self.integration;
+        const marks = self.marks;
+
+        // ----- cells routed through a more expensive cell are affected -----
+        @memset(marks, 0);
+        var anyIncrease = false;
+        for (changes) |change| {
+            if (!change.increased) continue;
+            marks[grid.paddedIndex(change.cell)] = 1;
+            anyIncrease = true;
+        }
+
+        if (anyIncrease) {
+            for (1..grid.height - 1) |z| {
+                for (z * width + 1..z * width + width - 1) |p| {
+                    if (marks[p] != 0 or integration[p] == inf) continue;
+
+                    // ----- follow directions until a decided cell, then decide the whole chain -----
+                    self.chain.clearRetainingCapacity();
+                    var q = p;
+                    const state: u8 = blk: while (true) {
+                        if (marks[q] != 0) break :blk marks[q];
+                        const dir = self.directions[q];
+                        if (dir == noDirection) break :blk 2;
+                        try self.chain.append(@intCast(q));
+                        q = @intCast(@as(i64, @intCast(q)) + offsets[dir]);
+                    };
+                    for (self.chain.items) |c| marks[c] = state;
+                }
+            }
+
+            for (marks, integration) |m, *value| {
+                if (m == 1) value.* = inf;
+            }
+        }
+
+        // ----- seed from valid neighbours of affected and changed cells -----
+        for (1..grid.height - 1) |z| {
+            for (z * width + 1..z * width + width - 1) |p| {
+                if (marks[p] != 1) continue;
+                try self.seedNeighbours(grid, p);
+            }
+        }
+        for (changes) |change| {
+            if (!change.increased) try self.seedNeighbours(grid, grid.paddedIndex(change.cell));
+        }
+
+        try self.integrate(grid);
+        self.updateDirections(grid);
+        self.costVersion = grid.version;
+    }
+
+    fn seedNeighbours(self: *FlowField, grid: *const CostGrid, p: usize) !void {
+        const offsets = neighbourOffsets(grid.width);
+        inline for (0..8) |k| {
+            const n: u32 = @intCast(@as(i64, @intCast(p)) + offsets[k]);
+            const d = self.integration[n];
+            if (d != inf and self.marks[n] != 1) try self.queue.add(.{ .distance = d, .cell = n });
+        }
+    }
+};
+
+// ======================================
+// Cache
+// ======================================
+
+/// Fields for the most recently used goals of a single grid. Fields are repaired lazily when the grid changed.
+pub const FlowFieldCache = struct {
+    allocator: Allocator,
+    grid: *const CostGrid,
+    fields: std.ArrayList(FlowField), // never grows past `capacity`, returned pointers stay valid until evicted
+    lastUsed: std.ArrayList(u64),
+    clock: u64 = 0,
+
+    // ----- counters -----
+    hits: usize = 0,
+    builds: usize = 0,
+    repairs: usize = 0,
+
+    pub fn init(allocator: Allocator, grid: *const CostGrid, capacity: usize) !FlowFieldCache {
+        var fields = try std.ArrayList(FlowField).initCapacity(allocator, @max(capacity, 1));
+        errdefer fields.deinit();
+        return .{
+            .allocator = allocator,
+            .grid = grid,
+            .fields = fields,
+            .lastUsed = try std.ArrayList(u64).initCapacity(allocator, @max(capacity, 1)),
+        };
+    }
+
+    pub fn deinit(self: *FlowFieldCache) void {
+        for (self.fields.items) |*field| field.deinit();
+        self.fields.deinit();
+        self.lastUsed.deinit();
+    }
+
+    /// Field towards `goal` (unpadded cell index), built or repaired if needed
+    pub fn get(self: *FlowFieldCache, goal: u32) !*const FlowField {
+        self.clock += 1;
+        for (self.fields.items, self.lastUsed.items) |*field, *used| {
+            if (field.goal != goal) continue;
+            used.* = self.clock;
+            if (field.costVersion != self.grid.version) {
+                errdefer field.goal = FlowField.noGoal;
+                try field.repair(self.grid);
+                self.repairs += 1;
+            } else self.hits += 1;
+            return field;
+        }
+
+        // ----- miss: take a free slot or evict the least recently used field -----
+        const slot = if (self.fields.items.len < self.fields.capacity) blk: {
+            self.fields.appendAssumeCapacity(try FlowField.init(self.allocator, self.grid));
+            self.lastUsed.appendAssumeCapacity(0);
+            break :blk self.fields.items.len - 1;
+        } else std.mem.indexOfMin(u64, self.lastUsed.items);
+
+        const field = &self.fields.items[slot];
+        self.lastUsed.items[slot] = self.clock;
+        errdefer field.goal = FlowField.noGoal; // half built, must not be found by the next lookup
+        try field.build(self.grid, goal);
+        self.builds += 1;
+        return field;
+    }
+};
@@ -0,0 +1,514 @@
+const std = @import("std");
+const builtin = @import("builtin");
+const cost_grid = @import("cost_grid.zig");
+
+const CostGrid = cost_grid.CostGrid;
+const Allocator = std.mem.Allocator;
+
+const neighbourX = cost_grid.neighbourX;
+const neighbourZ = cost_grid.neighbourZ;
+const neighbourWeight = cost_grid.neighbourWeight;
+
+const inf = std.math.inf(f32);
+const noParent = std.math.maxInt(u32);
+const goalNode = std.math.maxInt(u32); // virtual node of the abstract search
+
+/// Crossing between two adjacent chunks, seen from one side
+const Entrance = struct {
+    cell: u32, // on this chunk's side
+    partnerChunk: u32,
+    partnerCell: u32, // on the other side of the border
+    partner: u16 = 0, // index of the matching entrance in `partnerChunk`
+    crossCost: f32, // stepping onto `partnerCell`
+};
+
+/// Level-1 cluster: a single map chunk with its entrances and the cheapest path cost between every pair of them
+const Cluster = struct {
+    entrances: std.ArrayListUnmanaged(Entrance) = .{},
+    costs: std.ArrayListUnmanaged(f32) = .{}, // [from * entrances.len + to], inf if not connected inside the chunk
+
+    fn deinit(self: *Cluster, allocator: Allocator) void {
+        self.entrances.deinit(allocator);
+        self.costs.deinit(allocator);
+    }
+
+    fn cost(self: Cluster, from: usize, to: usize) f32 {
+        return self.costs.items[from * self.entrances.items.len + to];
+    }
+};
+
+/// Hierarchical A* on a `CostGrid`, using the map chunks as clusters.
+///
+/// Every border run of open cell pairs between two chunks gets one entrance per side. Paths between entrances of the
+/// same chunk are precomputed with a search bounded to that chunk, one chunk per thread-pool job. Queries search the
+/// small graph of entrances and only refine the chosen chunks on the grid.
+///
+/// Terrain changes are picked up from the grid's change log: only changed chunks and their direct neighbours are rebuilt.
+pub const Hpa = struct {
+    allocator: Allocator, // must be thread-safe, used by the build jobs
+    grid: *const CostGrid,
+    clusters: []Cluster,
+    builtVersion: u64 = 0,
+
+    // ----- query state, reused -----
+    startSearch: LocalSearch,
+    goalSearch: LocalSearch,
+    refineSearch: LocalSearch,
+    open: std.PriorityQueue(QueueEntry, void, queueOrder),
+    gScore: std.AutoHashMapUnmanaged(u32, f32) = .{},
+    cameFrom: std.AutoHashMapUnmanaged(u32, u32) = .{},
+    abstractPath: std.ArrayListUnmanaged(u32) = .{},
+
+    // ----- counters -----
+    clustersBuilt: usize = 0,
+
+    pub fn init(allocator: Allocator, grid: *const CostGrid) !Hpa {
+        const clusters = try allocator.alloc(Cluster, grid.chunking.x * grid.chunking.y);
+        @memset(clusters, .{});
+
+        var result = Hpa{
+            .allocator = allocator,
+            .grid = grid,
+            .clusters = clusters,
+            .startSearch = try LocalSearch.init(allocator, grid.cellsPerChunk),
+            .goalSearch = try LocalSearch.init(allocator, grid.cellsPerChunk),
+            .refineSearch = try LocalSearch.init(allocator, grid.cellsPerChunk),
+            .open = std.PriorityQueue(QueueEntry, void, queueOrder).init(allocator, {}),
+        };
+        errdefer result.deinit();
+
+        const all = try allocator.alloc(u32, clusters.len);
+        defer allocator.free(all);
+        for (all, 0..) |*c, i| c.* = @intCast(i);
+        try result.rebuild(all);
+        result.builtVersion = grid.version;
+        return result;
+    }
+
+    pub fn deinit(self: *Hpa) void {
+        for (self.clusters) |*cluster| cluster.deinit(self.allocator);
+        self.allocator.free(self.clusters);
+        self.startSearch.deinit();
+        self.goalSearch.deinit();
+        self.refineSearch.deinit();
+        self.open.deinit();
+        self.gScore.deinit(self.allocator);
+        self.cameFrom.deinit(self.allocator);
+        self.abstractPath.deinit(self.allocator);
+    }
+
+    pub fn entranceCount(self: Hpa) usize {
+        var count: usize = 0;
+        for (self.clusters) |cluster| count += cluster.entrances.items.len;
+        return count;
+    }
+
+    // ======================================
+    // Build
+    // ======================================
+
+    /// Rebuild clusters of chunks touched by cost changes since the last build, and their direct neighbours
+    pub fn refresh(self: *Hpa) !void {
+        const grid = self.grid;
+        if (self.builtVersion == grid.version) return;
+
+        const dirty = try self.allocator.alloc(bool, self.clusters.len);
+        defer self.allocator.free(dirty);
+        @memset(dirty, false);
+
+        if (grid.changesSince(self.builtVersion)) |changes| {
+            for (changes) |change| {
+                const chunk = self.chunkOf(change.cell);
+                dirty[chunk] = true;
+                for (self.directNeighbours(chunk)) |n| {
+                    if (n) |i| dirty[i] = true;
+                }
+            }
+        } else @memset(dirty, true);
+
+        var list = std.ArrayList(u32).init(self.allocator);
+        defer list.deinit();
+        for (dirty, 0..) |d, i| {
+            if (d) try list.append(@intCast(i));
+        }
+        try self.rebuild(list.items);
+        self.builtVersion = grid.version;
+    }
+
+    /// Rebuild entrances and intra-chunk costs of `chunks`, then re-link entrances to their partners
+    fn rebuild(self: *Hpa, chunks: []const u32) !void {
+        if (builtin.single_threaded or chunks.len < 4) {
+            for (chunks) |c| try self.buildCluster(c);
+        } else {
+            var pool: std.Thread.Pool = undefined;
+            try pool.init(.{ .allocator = self.allocator });
+            defer pool.deinit();
+
+            var failed = std.atomic.Value(bool).init(false);
+            var wg: std.Thread.WaitGroup = .{};
+            for (chunks) |c| pool.spawnWg(&wg, buildClusterJob, .{ self, c, &failed });
+            pool.waitAndWork(&wg);
+            if (failed.load(.acquire)) return error.OutOfMemory;
+        }
+        self.clustersBuilt += chunks.len;
+
+        // ----- partners, chunks next to rebuilt ones refer into them -----
+        for (self.clusters) |*cluster| {
+            for (cluster.entrances.items) |*e| {
+                const partner = self.clusters[e.partnerChunk].entrances.items;
+                for (partner, 0..) |p, i| {
+                    if (p.cell != e.partnerCell) continue;
+                    e.partner = @intCast(i);
+                    break;
+                }
+            }
+        }
+    }
+
+    fn buildClusterJob(self: *Hpa, chunk: u32, failed: *std.atomic.Value(bool)) void {
+        self.buildCluster(chunk) catch failed.store(true, .release);
+    }
+
+    /// Only writes `clusters[chunk]`, safe to run for different chunks in parallel
+    fn buildCluster(self: *Hpa, chunk: u32) !void {
+        const grid = self.grid;
+        const cluster = &self.clusters[chunk];
+        cluster.entrances.clearRetainingCapacity();
+
+        // ----- entrances on all four borders -----
+        for (self.directNeighbours(chunk), 0..) |neighbour, side| {
+            if (neighbour) |n| try self.scanBorder(cluster, chunk, @intCast(n), side);
+        }
+
+        // ----- cheapest paths between entrances, bounded to the chunk -----
+        const k = cluster.entrances.items.len;
+        try cluster.costs.resize(self.allocator, k * k);
+        if (k == 0) return;
+
+        var search = try LocalSearch.init(self.allocator, grid.cellsPerChunk);
+        defer search.deinit();
+        for (cluster.entrances.items, 0..) |from, i| {
+            try search.run(grid, chunk, from.cell, null);
+            for (cluster.entrances.items, 0..) |to, j| cluster.costs.items[i * k + j] = search.distance(grid, to.cell);
+        }
+    }
+
+    /// One entrance per maximal run of open cell pairs along `side` (0 north, 1 east, 2 south, 3 west). The border is
+    /// scanned the same way from both chunks, so both sides agree on the entrances.
+    fn scanBorder(self: *Hpa, cluster: *Cluster, chunk: u32, neighbour: u32, side: usize) !void {
+        const grid = self.grid;
+        const n = grid.cellsPerChunk;
+        const x0 = (chunk % grid.chunking.x) * n;
+        const z0 = (chunk / grid.chunking.x) * n;
+
+        var runStart: ?usize = null;
+        for (0..n + 1) |i| {
+            const pair = if (i < n) borderPair(grid, x0, z0, side, i) else null;
+            const open = if (pair) |p| grid.cost(p[0]) != cost_grid.blocked and grid.cost(p[1]) != cost_grid.blocked else false;
+
+            if (open and runStart == null) runStart = i;
+            if (open or runStart == null) continue;
+
+            // ----- run ended, entrance in its middle -----
+            const mid = runStart.? + (i - runStart.?) / 2;
+            const p = borderPair(grid, x0, z0, side, mid);
+            try cluster.entrances.append(self.allocator, .{
+                .cell = p[0],
+                .partnerChunk = neighbour,
+                .partnerCell = p[1],
+                .crossCost = @floatFromInt(grid.cost(p[1])),
+            });
+            runStart = null;
+        }
+    }
+
+    /// Cell `i` along `side` of the chunk at (`x0`, `z0`) and the cell across the border
+    fn borderPair(grid: *const CostGrid, x0: usize, z0: usize, side: usize, i: usize) [2]u32 {
+        const n = grid.cellsPerChunk;
+        const row = grid.resolution.x;
+        const c: [4]usize = switch (side) { // ax, az, bx, bz
+            0 => .{ x0 + i, z0, x0 + i, z0 - 1 },
+            1 => .{ x0 + n - 1, z0 + i, x0 + n, z0 + i },
+            2 => .{ x0 + i, z0 + n - 1, x0 + i, z0 + n },
+            else => .{ x0, z0 + i, x0 - 1, z0 + i },
+        };
+        return .{ @intCast(c[1] * row + c[0]), @intCast(c[3] * row + c[2]) };
+    }
+
+    /// North, east, south, west
+    fn directNeighbours(self: Hpa, chunk: usize) [4]?usize {
+        const row = self.grid.chunking.x;
+        const col = self.grid.chunking.y;
+        const x = chunk % row;
+        const z = chunk / row;
+        return .{
+            if (z == 0) null else chunk - row,
+            if (x == row - 1) null else chunk + 1,
+            if (z == col - 1) null else chunk + row,
+            if (x == 0) null else chunk - 1,
+        };
+    }
+
+    fn chunkOf(self: Hpa, cell: usize) u32 {
+        const n = self.grid.cellsPerChunk;
+        const x = (cell % self.grid.resolution.x) / n;
+        const z = (cell / self.grid.resolution.x) / n;
+        return @intCast(z * self.grid.chunking.x + x);
+    }
+
+    // ======================================
+    // Query
+    // ======================================
+
+    /// Cells from `start` to `goal` (unpadded indices, both included) appended to `out`. Returns false if there is no path.
+    pub fn findPath(self: *Hpa, start: u32, goal: u32, out: *std.ArrayList(u32)) !bool {
+        try self.refresh();
+        const grid = self.grid;
+        if (grid.cost(start) == cost_grid.blocked or grid.cost(goal) == cost_grid.blocked) return false;
+
+        const startChunk = self.chunkOf(start);
+        const goalChunk = self.chunkOf(goal);
+
+        // ----- same chunk: plain bounded search first -----
+        if (startChunk == goalChunk) {
+            try self.refineSearch.run(grid, startChunk, start, goal);
+            if (self.refineSearch.distance(grid, goal) != inf) {
+                try self.refineSearch.appendPath(grid, goal, out, false);
+                return true;
+            }
+        }
+
+        // ----- costs from start to its chunk's entrances and from the goal chunk's entrances to the goal -----
+        try self.startSearch.run(grid, startChunk, start, null);
+        try self.goalSearch.run(grid, goalChunk, goal, null);
+
+        if (!try self.searchAbstract(startChunk, goalChunk)) return false;
+
+        // ----- refine: start -> first entrance -> ... -> last entrance -> goal -----
+        const path = self.abstractPath.items;
+        const first = self.entrance(path[0]);
+        try self.startSearch.appendPath(grid, first.cell, out, false);
+
+        for (path[0 .. path.len - 1], path[1..]) |a, b| {
+            if (nodeChunk(a) != nodeChunk(b)) {
+                try out.append(self.entrance(b).cell); // border crossing
+                continue;
+            }
+            try self.refineSearch.run(grid, nodeChunk(a), self.entrance(a).cell, self.entrance(b).cell);
+            try self.refineSearch.appendPath(grid, self.entrance(b).cell, out, true);
+        }
+
+        // goal search ran from the goal, its parents lead from the last entrance to the goal
+        try self.goalSearch.appendPathReversed(grid, self.entrance(path[path.len - 1]).cell, out);
+        return true;
+    }
+
+    fn entrance(self: Hpa, node: u32) Entrance {
+        return self.clusters[nodeChunk(node)].entrances.items[nodeLocal(node)];
+    }
+
+    /// A* over entrances. On success `abstractPath` holds the entrances from the start chunk to the goal chunk.
+    fn searchAbstract(self: *Hpa, startChunk: u32, goalChunk: u32) !bool {
+        const grid = self.grid;
+        self.open.items.len = 0;
+        self.gScore.clearRetainingCapacity();
+        self.cameFrom.clearRetainingCapacity();
+        self.abstractPath.clearRetainingCapacity();
+
+        const goalCell = self.goalSearch.origin;
+        for (self.clusters[startChunk].entrances.items, 0..) |e, l| {
+            const g = self.startSearch.distance(grid, e.cell);
+            if (g == inf) continue;
+            const node = makeNode(startChunk, l);
+            try self.gScore.put(self.allocator, node, g);
+            try self.cameFrom.put(self.allocator, node, noParent);
+            try self.open.add(.{ .distance = g + octile(grid, e.cell, goalCell), .node = node });
+        }
+
+        while (self.open.removeOrNull()) |entry| {
+            const node = entry.node;
+            if (node == goalNode) return try self.collectPath();
+            const g = self.gScore.get(node).?;
+            if (entry.distance > g + self.heuristic(node, goalCell) + 1e-3) continue; // stale
+
+            const chunk = nodeChunk(node);
+            const local = nodeLocal(node);
+            const cluster = self.clusters[chunk];
+            const e = cluster.entrances.items[local];
+
+            // ----- into the goal -----
+            if (chunk == goalChunk) {
+                const toGoal = self.goalSearch.distance(grid, e.cell);
+                if (toGoal != inf) try self.relax(node, goalNode, g + toGoal, 0);
+            }
+
+            // ----- across the border -----
+            try self.relax(node, makeNode(e.partnerChunk, e.partner), g + e.crossCost, octile(grid, e.partnerCell, goalCell));
+
+            // ----- through the chunk -----
+            for (cluster.entrances.items, 0..) |other, j| {
+                if (j == local) continue;
+                const c = cluster.cost(local, j);
+                if (c == inf) continue;
+                try self.relax(node, makeNode(chunk, j), g + c, octile(grid, other.cell, goalCell));
+            }
+        }
+        return false;
+    }
+
+    fn relax(self: *Hpa, from: u32, to: u32, g: f32, h: f32) !void {
+        const entry = try self.gScore.getOrPut(self.allocator, to);
+        if (entry.found_existing and entry.value_ptr.* <= g) return;
+        entry.value_ptr.* = g;
+        try self.cameFrom.put(self.allocator, to, from);
+        try self.open.add(.{ .distance = g + h, .node = to });
+    }
+
+    fn heuristic(self: Hpa, node: u32, goalCell: u32) f32 {
+        if (node == goalNode) return 0;
+        return octile(self.grid, self.entrance(node).cell, goalCell);
+    }
+
+    fn collectPath(self: *Hpa) !bool {
+        var node = self.cameFrom.get(goalNode).?;
+        while (node != noParent) : (node = self.cameFrom.get(node).?) try self.abstractPath.append(self.allocator, node);
+        std.mem.reverse(u32, self.abstractPath.items);
+        return true;
+    }
+};
+
+// ----- abstract nodes: chunk << 16 | entrance -----
+fn makeNode(chunk: usize, local: usize) u32 {
+    return @intCast(chunk << 16 | local);
+}
+fn nodeChunk(node: u32) u32 {
+    return node >> 16;
+}
+fn nodeLocal(node: u32) u16 {
+    return @truncate(node);
+}
+
+/// Octile distance between two cells, a lower bound of the path cost as every cell costs at least 1
+fn octile(grid: *const CostGrid, a: u32, b: u32) f32 {
+    const row = grid.resolution.x;
+    const dx: f32 = @floatFromInt(@max(a % row, b % row) - @min(a % row, b % row));
+    const dz: f32 = @floatFromInt(@max(a / row, b / row) - @min(a / row, b / row));
+    return @max(dx, dz) + (std.math.sqrt2 - 1) * @min(dx, dz);
+}
+
+const QueueEntry = struct {
+    distance: f32,
+    node: u32,
+};
+
+fn queueOrder(_: void, a: QueueEntry, b: QueueEntry) std.math.Order {
+    return std.math.order(a.distance, b.distance);
+}
+
+// ======================================
+// Search bounded to a single chunk
+// ======================================
+
+const LocalSearch = struct {
+    allocator: Allocator,
+    size: usize, // cells along a chunk side
+    x0: usize = 0,
+    z0: usize = 0,
+    origin: u32 = 0, // cell the last search started from
+    dist: []f32, // [local]
+    parent: []u32, // [local] towards `origin`
+    queue: std.PriorityQueue(QueueEntry, void, queueOrder),
+
+    fn init(allocator: Allocator, size: usize) !LocalSearch {
+        const dist = try allocator.alloc(f32, size * size);
+        errdefer allocator.free(dist);
+        return .{
+            .allocator = allocator,
+            .size = size,
+            .dist = dist,
+            .parent = try allocator.alloc(u32, size * size),
+            .queue = std.PriorityQueue(QueueEntry, void, queueOrder).init(allocator, {}),
+        };
+    }
+
+    fn deinit(self: *LocalSearch) void {
+        self.allocator.free(self.dist);
+        self.allocator.free(self.parent);
+        self.queue.deinit();
+    }
+
+    fn localOf(self: LocalSearch, grid: *const CostGrid, cell: u32) ?usize {
+        const x = cell % grid.resolution.x;
+        const z = cell / grid.resolution.x;
+        if (x < self.x0 or z < self.z0 or x >= self.x0 + self.size or z >= self.z0 + self.size) return null;
+        return (z - self.z0) * self.size + (x - self.x0);
+    }
+
+    fn cellOf(self: LocalSearch, grid: *const CostGrid, local: usize) u32 {
+        return @intCast((self.z0 + local / self.size) * grid.resolution.x + self.x0 + local % self.size);
+    }
+
+    /// Dijkstra from `start` inside `chunk`, stops once `target` is settled if given
+    fn run(self: *LocalSearch, grid: *const CostGrid, chunk: u32, start: u32, target: ?u32) !void {
+        self.x0 = (chunk % grid.chunking.x) * self.size;
+        self.z0 = (chunk / grid.chunking.x) * self.size;
+        self.origin = start;
+        @memset(self.dist, inf);
+        @memset(self.parent, noParent);
+        self.queue.items.len = 0;
+
+        const s = self.localOf(grid, start) orelse return;
+        self.dist[s] = 0;
+        try self.queue.add(.{ .distance = 0, .node = @intCast(s) });
+
+        const costs = grid.costs;
+        const offsets = cost_grid.neighbourOffsets(grid.width);
+        while (self.queue.removeOrNull()) |entry| {
+            const l = entry.node;
+            if (entry.distance > self.dist[l]) continue;
+            const cell = self.cellOf(grid, l);
+            if (target != null and cell == target.?) return;
+
+            const size: i64 = @intCast(self.size);
+            const lx: i64 = @intCast(l % self.size);
+            const lz: i64 = @intCast(l / self.size);
+            const p = grid.paddedIndex(cell);
+            inline for (0..8) |k| {
+                const nx = lx + neighbourX[k];
+                const nz = lz + neighbourZ[k];
+                if (nx >= 0 and nz >= 0 and nx < size and nz < size) {
+                    const np: usize = @intCast(@as(i64, @intCast(p)) + offsets[k]);
+                    if (costs[np] != cost_grid.blocked and (k < 4 or cost_grid.diagonalOpen(costs, p, k, grid.width))) {
+                        const n: usize = @intCast(nz * size + nx);
+                        const d = entry.distance + neighbourWeight[k] * @as(f32, @floatFromInt(costs[np]));
+                        if (d < self.dist[n]) {
+                            self.dist[n] = d;
+                            self.parent[n] = l;
+                            try self.queue.add(.{ .distance = d, .node = @intCast(n) });
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    fn distance(self: LocalSearch, grid: *const CostGrid, cell: u32) f32 {
+        const l = self.localOf(grid, cell) orelse return inf;
+        return self.dist[l];
+    }
+
+    /// Append the path origin -> `cell` to `out`, without the origin if `skipOrigin`
+    fn appendPath(self: LocalSearch, grid: *const CostGrid, cell: u32, out: *std.ArrayList(u32), skipOrigin: bool) !void {
+        const begin = out.items.len;
+        var l: u32 = @intCast(self.localOf(grid, cell).?);
+        while (l != noParent) : (l = self.parent[l]) try out.append(self.cellOf(grid, l));
+        std.mem.reverse(u32, out.items[begin..]);
+        if (skipOrigin) _ = out.orderedRemove(begin);
+    }
+
+    /// Append the path `cell` -> origin to `out`, without `cell`
+    fn appendPathReversed(self: LocalSearch, grid: *const CostGrid, cell: u32, out: *std.ArrayList(u32)) !void {
+        var l = self.parent[self.localOf(grid, cell).?];
+        while (l != noParent) : (l = self.parent[l]) try out.append(self.cellOf(grid, l));
+    }
+};
@@ -0,0 +1,636 @@
+const std = @import("std");
+const math = @import("../math.zig");
+const mesh_simplification = @import("../mesh/cuthulus_box.zig");
+const scratch_arena = @import("../utils/scratch.zig");
+const tracking = @import("../utils/tracking_allocator.zig");
+
+const HalfEdges = mesh_simplification.HalfEdges;
+const PlaceHolderMesh = @import("../mesh/processing.zig").PlaceHolderMesh;
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+
+const NavMeshError = error{NoWalkableFaces};
+
+/// Polygons are merged up to this many vertices
+pub const maxPolyVertices = 12;
+pub const noPolygon = std.math.maxInt(u32);
+
+const inf = std.math.inf(f32);
+
+pub const Polygon = struct {
+    firstVertex: u32, // into `NavMesh.polyVertices`
+    vertexCount: u32,
+    firstLink: u32, // into `NavMesh.links`
+    linkCount: u32,
+    center: Vec3(f32),
+    minX: f32,
+    minZ: f32,
+    maxX: f32,
+    maxZ: f32,
+};
+
+/// Shared edge between two polygons, `a` -> `b` in the winding of the polygon owning the link
+pub const Link = struct {
+    neighbour: u32,
+    a: u32,
+    b: u32,
+};
+
+/// Walkable convex polygons of a terrain mesh with portal adjacency.
+///
+/// Built from the half-edge representation: faces are filtered by the slope of their face normal, neighbouring faces
+/// are merged into convex polygons across their shared edges (longest edges first) and twin links of edges between
+/// different polygons become portals. Paths are found with A* over polygons and straightened with a funnel pass.
+pub const NavMesh = struct {
+    allocator: Allocator,
+    vertices: [][3]f32,
+    polygons: []Polygon,
+    polyVertices: []u32, // vertex loops of all polygons
+    links: []Link,
+
+    // ----- point location grid over polygon bounds -----
+    gridMinX: f32,
+    gridMinZ: f32,
+    gridCellSize: f32,
+    gridResolution: [2]usize,
+    gridStart: []u32, // [cell] -> first entry in `gridPolygons`, one extra entry at the end
+    gridPolygons: []u32,
+
+    /// Simplify `mesh` with the QEM collapse first, then `build`. Keeps the polygon graph small for large terrains.
+    pub fn fromSimplified(allocator: Allocator, mesh: *PlaceHolderMesh, errThreshold: f32, maxSlope: f32) !NavMesh {
+        try mesh_simplification.collapseMesh(mesh, errThreshold);
+        return build(allocator, mesh, maxSlope);
+    }
+
+    /// Build navmesh of all faces of `mesh` with slope (rise over run) up to `maxSlope`.
+    /// Removes duplicate vertices from `mesh`, like every half-edge conversion.
+    pub fn build(allocator: Allocator, mesh: *PlaceHolderMesh, maxSlope: f32) !NavMesh {
+        const prevSubsystem = tracking.enter(.map);
+        defer tracking.leave(prevSubsystem);
+
+        // ----- half-edge construction temporaries are released with the build's own -----
+        const scratchArena = scratch_arena.threadScratch(mesh.allocator);
+        const mark = scratchArena.mark();
+        defer scratchArena.restore(mark);
+        const scratch = scratchArena.allocator();
+
+        var halfEdges = try HalfEdges.fromPHMesh(mesh);
+        defer halfEdges.deinit();
+
+        const faceCount = mesh.triangleCount;
+        const HE = halfEdges.HE;
+        const positions = mesh.vertices;
+
+        // ===== Walkable faces, from face normals =====
+        const walkable = try scratch.alloc(bool, faceCount);
+        for (walkable, 0..) |*w, f| {
+            const n = halfEdges.faceNormals[f * 3 ..][0..3];
+            w.* = n[1] > 0 and @sqrt(n[0] * n[0] + n[2] * n[2]) <= maxSlope * n[1];
+        }
+
+        // ===== Merge faces into convex polygons =====
+        const loops = try scratch.alloc(Loop, faceCount);
+        const owner = try scratch.alloc(u32, faceCount); // union-find over faces
+        for (loops, owner, 0..) |*loop, *o, f| {
+            o.* = @intCast(f);
+            loop.len = 3;
+            for (0..3) |j| loop.v[j] = HE[f * 3 + j].origin;
+        }
+
+        // ----- interior edges between walkable faces, longest first -----
+        var candidates = std.ArrayList(EdgeCandidate).init(scratch);
+        for (0..faceCount * 3) |h| {
+            const twin = HE[h].twin;
+            if (twin < h) continue;
+            const twinFace = HE[twin].i_face orelse continue;
+            if (!walkable[h / 3] or !walkable[twinFace / 3]) continue;
+            const a = positions[HE[h].origin * 3 ..][0..3];
+            const b = positions[HE[HE[h].next].origin * 3 ..][0..3];
+            try candidates.append(.{ .edge = @intCast(h), .lengthSq = (a[0] - b[0]) * (a[0] - b[0]) + (a[2] - b[2]) * (a[2] - b[2]) });
+        }
+        std.mem.sort(EdgeCandidate, candidates.items, {}, EdgeCandidate.longerFirst);
+
+        for (candidates.items) |c| {
+            const p = find(owner, c.edge / 3);
+            const q = find(owner, HE[HE[c.edge].twin].i_face.? / 3);
+            if (p == q) continue;
+
+            const a = HE[c.edge].origin;
+            const b = HE[HE[c.edge].next].origin;
+            const merged = mergeLoops(loops[p], loops[q], a, b, positions) orelse continue;
+            loops[p] = merged;
+            owner[q] = p;
+        }
+
+        // ===== Compact polygons =====
+        const polyOf = try scratch.alloc(u32, faceCount);
+        var polygons = std.ArrayList(Polygon).init(allocator);
+        errdefer polygons.deinit();
+        var polyVertices = std.ArrayList(u32).init(allocator);
+        errdefer polyVertices.deinit();
+
+        for (0..faceCount) |f| {
+            polyOf[f] = noPolygon;
+            if (!walkable[f] or find(owner, @intCast(f)) != f) continue;
+            polyOf[f] = @intCast(polygons.items.len);
+
+            const loop = loops[f];
+            var polygon = Polygon{
+                .firstVertex = @intCast(polyVertices.items.len),
+                .vertexCount = loop.len,
+                .firstLink = 0,
+                .linkCount = 0,
+                .center = .{},
+                .minX = inf,
+                .minZ = inf,
+                .maxX = -inf,
+                .maxZ = -inf,
+            };
+            for (loop.v[0..loop.len]) |v| {
+                const p = positions[v * 3 ..][0..3];
+                polygon.center = polygon.center.add(.{ .x = p[0], .y = p[1], .z = p[2] });
+                polygon.minX = @min(polygon.minX, p[0]);
+                polygon.minZ = @min(polygon.minZ, p[2]);
+                polygon.maxX = @max(polygon.maxX, p[0]);
+                polygon.maxZ = @max(polygon.maxZ, p[2]);
+            }
+            polygon.center = polygon.center.scale(1 / @as(f32, @floatFromInt(loop.len)));
+            try polyVertices.appendSlice(loop.v[0..loop.len]);
+            try polygons.append(polygon);
+        }
+        if (polygons.items.len == 0) return NavMeshError.NoWalkableFaces;
+        for (0..faceCount) |f| {
+            if (walkable[f]) polyOf[f] = polyOf[find(owner, @intCast(f))];
+        }
+
+        // ===== Portals from twin links between different polygons =====
+        var links = std.ArrayList(Link).init(allocator);
+        errdefer links.deinit();
+        {
+            var perPolygon = std.ArrayList(std.ArrayListUnmanaged(Link)).init(scratch);
+            try perPolygon.appendNTimes(.{}, polygons.items.len);
+            for (0..faceCount * 3) |h| {
+                const from = polyOf[h / 3];
+                const twinFace = HE[HE[h].twin].i_face orelse continue;
+                const to = polyOf[twinFace / 3];
+                if (from == noPolygon or to == noPolygon or from == to) continue;
+                try perPolygon.items[from].append(scratch, .{ .neighbour = to, .a = HE[h].origin, .b = HE[HE[h].next].origin });
+            }
+            for (polygons.items, perPolygon.items) |*polygon, list| {
+                polygon.firstLink = @intCast(links.items.len);
+                polygon.linkCount = @intCast(list.items.len);
+                try links.appendSlice(list.items);
+            }
+        }
+
+        // ===== Own a copy of the vertex positions =====
+        const vertices = try allocator.alloc([3]f32, positions.len / 3);
+        errdefer allocator.free(vertices);
+        for (vertices, 0..) |*v, i| v.* = positions[i * 3 ..][0..3].*;
+        const ownedPolygons = try polygons.toOwnedSlice();
+        errdefer allocator.free(ownedPolygons);
+        const ownedPolyVertices = try polyVertices.toOwnedSlice();
+        errdefer allocator.free(ownedPolyVertices);
+        const ownedLinks = try links.toOwnedSlice();
+        errdefer allocator.free(ownedLinks);
+
+        var result = NavMesh{
+            .allocator = allocator,
+            .vertices = vertices,
+            .polygons = ownedPolygons,
+            .polyVertices = ownedPolyVertices,
+            .links = ownedLinks,
+            .gridMinX = 0,
+            .gridMinZ = 0,
+            .gridCellSize = 1,
+            .gridResolution = .{ 1, 1 },
+            .gridStart = &.{},
+            .gridPolygons = &.{},
+        };
+        // ----- everything else already has its errdefer -----
+        errdefer {
+            allocator.free(result.gridStart);
+            allocator.free(result.gridPolygons);
+        }
+        try result.buildLocationGrid();
+        return result;
+    }
+
+    pub fn deinit(self: *NavMesh) void {
+        self.allocator.free(self.vertices);
+        self.allocator.free(self.polygons);
+        self.allocator.free(self.polyVertices);
+        self.allocator.free(self.links);
+        self.allocator.free(self.gridStart);
+        self.allocator.free(self.gridPolygons);
+    }
+
+    pub fn polygonLinks(self: NavMesh, polygon: u32) []const Link {
+        const p = self.polygons[polygon];
+        return self.links[p.firstLink..][0..p.linkCount];
+    }
+
+    pub fn polygonLoop(self: NavMesh, polygon: u32) []const u32 {
+        const p = self.polygons[polygon];
+        return self.polyVertices[p.firstVertex..][0..p.vertexCount];
+    }
+
+    // ======================================
+    // Point location
+    // ======================================
+
+    /// Bucket polygons by their bounds in a uniform grid of about one polygon per cell
+    fn buildLocationGrid(self: *NavMesh) !void {
+        var minX = inf;
+        var minZ = inf;
+        var maxX = -inf;
+        var maxZ = -inf;
+        for (self.polygons) |p| {
+            minX = @min(minX, p.minX);
+            minZ = @min(minZ, p.minZ);
+            maxX = @max(maxX, p.maxX);
+            maxZ = @max(maxZ, p.maxZ);
+        }
+        const side = @max(@sqrt(@as(f32, @floatFromInt(self.polygons.len))), 1);
+        self.gridMinX = minX;
+        self.gridMinZ = minZ;
+        self.gridCellSize = @max(@max(maxX - minX, maxZ - minZ) / side, 1e-6);
+        self.gridResolution = .{
+            @as(usize, @intFromFloat((maxX - minX) / self.gridCellSize)) + 1,
+            @as(usize, @intFromFloat((maxZ - minZ) / self.gridCellSize)) + 1,
+        };
+
+        // ----- counting sort into cells -----
+        const cellCount = self.gridResolution[0] * self.gridResolution[1];
+        self.gridStart = try self.allocator.alloc(u32, cellCount + 1);
+        @memset(self.gridStart, 0);
+        for (self.polygons) |p| {
+            const r = self.cellRange(p);
+            for (r[1]..r[3] + 1) |z| {
+                for (r[0]..r[2] + 1) |x| self.gridStart[z * self.gridResolution[0] + x + 1] += 1;
+            }
+        }
+        for (1..self.gridStart.len) |i| self.gridStart[i] += self.gridStart[i - 1];
+
+        self.gridPolygons = try self.allocator.alloc(u32, self.gridStart[cellCount]);
+        const fill = try self.allocator.dupe(u32, self.gridStart[0..cellCount]);
+        defer self.allocator.free(fill);
+        for (self.polygons, 0..) |p, i| {
+            const r = self.cellRange(p);
+            for (r[1]..r[3] + 1) |z| {
+                for (r[0]..r[2] + 1) |x| {
+                    const cell = z * self.gridResolution[0] + x;
+                    self.gridPolygons[fill[cell]] = @intCast(i);
+                    fill[cell] += 1;
+                }
+            }
+        }
+    }
+
+    fn gridCoord(self: NavMesh, v: f32, min: f32, resolution: usize) usize {
+        const f = @floor((v - min) / self.gridCellSize);
+        if (!(f > 0)) return 0;
+        return @min(@as(usize, @intFromFloat(@min(f, 1e9))), resolution - 1);
+    }
+
+    /// Grid cells covered by the bounds of `p`: x0, z0, x1, z1
+    fn cellRange(self: NavMesh, p: Polygon) [4]usize {
+        return .{
+            self.gridCoord(p.minX, self.gridMinX, self.gridResolution[0]),
+            self.gridCoord(p.minZ, self.gridMinZ, self.gridResolution[1]),
+            self.gridCoord(p.maxX, self.gridMinX, self.gridResolution[0]),
+            self.gridCoord(p.maxZ, self.gridMinZ, self.gridResolution[1]),
+        };
+    }
+
+    /// Polygon containing (`x`, `z`) in the xz-plane, the one closest in height to `y` if several overlap
+    pub fn locate(self: NavMesh, x: f32, y: f32, z: f32) ?u32 {
+        const cx = self.gridCoord(x, self.gridMinX, self.gridResolution[0]);
+        const cz = self.gridCoord(z, self.gridMinZ, self.gridResolution[1]);
+        const cell = cz * self.gridResolution[0] + cx;
+
+        var best: ?u32 = null;
+        var bestDy = inf;
+        for (self.gridPolygons[self.gridStart[cell]..self.gridStart[cell + 1]]) |i| {
+            const p = self.polygons[i];
+            if (x < p.minX or x > p.maxX or z < p.minZ or z > p.maxZ) continue;
+            if (!self.contains(i, x, z)) continue;
+            const dy = @abs(p.center.y - y);
+            if (dy < bestDy) {
+                best = i;
+                bestDy = dy;
+            }
+        }
+        return best;
+    }
+
+    /// Point inside convex polygon: on the same side of every edge
+    fn contains(self: NavMesh, polygon: u32, x: f32, z: f32) bool {
+        const loop = self.polygonLoop(polygon);
+        var sign: f32 = 0;
+        for (loop, 0..) |v, i| {
+            const a = self.vertices[v];
+            const b = self.vertices[loop[(i + 1) % loop.len]];
+            const s = (b[0] - a[0]) * (z - a[2]) - (b[2] - a[2]) * (x - a[0]);
+            if (s == 0) continue;
+            if (sign == 0) sign = s else if ((s > 0) != (sign > 0)) return false;
+        }
+        return true;
+    }
+
+    // ======================================
+    // Paths
+    // ======================================
+
+    /// Straightened path from `start` to `goal` appended to `out`, both included. Returns false if either point is
+    /// off the navmesh or there is no connection. `search` holds the reusable per-query buffers.
+    pub fn findPath(self: NavMesh, search: *PathSearch, start: Vec3(f32), goal: Vec3(f32), out: *std.ArrayList(Vec3(f32))) !bool {
+        const startPoly = self.locate(start.x, start.y, start.z) orelse return false;
+        const goalPoly = self.locate(goal.x, goal.y, goal.z) orelse return false;
+
+        if (!try search.run(self, startPoly, goalPoly, goal)) return false;
+        try self.funnel(search, start, goal, out);
+        return true;
+    }
+
+    /// Simple stupid funnel over the portals of the polygon corridor found by `search`
+    fn funnel(self: NavMesh, search: *PathSearch, start: Vec3(f32), goal: Vec3(f32), out: *std.ArrayList(Vec3(f32))) !void {
+        // ----- portals as (left, right) seen in walking direction, start and goal as degenerate portals -----
+        // Walkable polygons wind with positive `triArea2` (their normal points up), so the interior lies on the
+        // positive side of a link a -> b of the polygon being left. Walking out through it, a is left and b is right
+        // (right has positive area with respect to the walking direction).
+        const portals = &search.portals;
+        portals.clearRetainingCapacity();
+        try portals.append(search.allocator, .{ start, start });
+        for (search.corridorLinks.items) |link| {
+            try portals.append(search.allocator, .{ toVec3(self.vertices[link.a]), toVec3(self.vertices[link.b]) });
+        }
+        try portals.append(search.allocator, .{ goal, goal });
+
+        try out.append(start);
+        var apex = start;
+        var left = start;
+        var right = start;
+        var apexIndex: usize = 0;
+        var leftIndex: usize = 0;
+        var rightIndex: usize = 0;
+
+        var i: usize = 1;
+        while (i < portals.items.len) : (i += 1) {
+            const pl = portals.items[i][0];
+            const pr = portals.items[i][1];
+
+            // ----- tighten right side -----
+            if (triArea2(apex, right, pr) <= 0) {
+                if (equal(apex, right) or triArea2(apex, left, pr) > 0) {
+                    right = pr;
+                    rightIndex = i;
+                } else {
+                    // right crossed left, left becomes a corner of the path
+                    try out.append(left);
+                    apex = left;
+                    apexIndex = leftIndex;
+                    right = apex;
+                    rightIndex = apexIndex;
+                    i = apexIndex;
+                    continue;
+                }
+            }
+
+            // ----- tighten left side -----
+            if (triArea2(apex, left, pl) >= 0) {
+                if (equal(apex, left) or triArea2(apex, right, pl) < 0) {
+                    left = pl;
+                    leftIndex = i;
+                } else {
+                    try out.append(right);
+                    apex = right;
+                    apexIndex = rightIndex;
+                    left = apex;
+                    leftIndex = apexIndex;
+                    i = apexIndex;
+                    continue;
+                }
+            }
+        }
+        if (!equal(out.items[out.items.len - 1], goal)) try out.append(goal);
+    }
+
+    /// Check of the last `findPath` with `search`: `samples` points along every segment of `path` lie inside a
+    /// polygon of the corridor, up to `tolerance` outside its edges
+    pub fn pathInCorridor(self: NavMesh, search: *const PathSearch, path: []const Vec3(f32), samples: usize, tolerance: f32) bool {
+        if (path.len == 0) return true;
+        for (path[0 .. path.len - 1], path[1..]) |from, to| {
+            for (0..samples + 1) |k| {
+                const t = @as(f32, @floatFromInt(k)) / @as(f32, @floatFromInt(samples));
+                const p = from.add(to.subtract(from).scale(t));
+                if (!self.inPolygon(search.startPolygon, p.x, p.z, tolerance)) {
+                    for (search.corridorLinks.items) |link| {
+                        if (self.inPolygon(link.neighbour, p.x, p.z, tolerance)) break;
+                    } else return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// Point within `tolerance` of convex `polygon`, relies on the positive winding of walkable polygons
+    fn inPolygon(self: NavMesh, polygon: u32, x: f32, z: f32, tolerance: f32) bool {
+        const loop = self.polygonLoop(polygon);
+        for (loop, 0..) |v, i| {
+            const a = self.vertices[v];
+            const b = self.vertices[loop[(i + 1) % loop.len]];
+            const ex = b[0] - a[0];
+            const ez = b[2] - a[2];
+            const outside = ex * (z - a[2]) - ez * (x - a[0]); // -triArea2(a, b, p)
+            if (outside > tolerance * @sqrt(ex * ex + ez * ez)) return false;
+        }
+        return true;
+    }
+};
+
+// ======================================
+// Polygon search
+// ======================================
+
+/// Reusable buffers of a navmesh path query, one per querying thread
+pub const PathSearch = struct {
+    allocator: Allocator,
+    gScore: []f32,
+    parent: []u32, // polygon reached from
+    parentLink: []u32, // link of the parent polygon used
+    open: std.PriorityQueue(QueueEntry, void, queueOrder),
+    startPolygon: u32 = noPolygon, // of the last `run`
+    corridorLinks: std.ArrayListUnmanaged(Link) = .{}, // crossed in order, each leads into `Link.neighbour`
+    portals: std.ArrayListUnmanaged([2]Vec3(f32)) = .{},
+
+    pub fn init(allocator: Allocator, navMesh: *const NavMesh) !PathSearch {
+        const n = navMesh.polygons.len;
+        const gScore = try allocator.alloc(f32, n);
+        errdefer allocator.free(gScore);
+        const parent = try allocator.alloc(u32, n);
+        errdefer allocator.free(parent);
+        return .{
+            .allocator = allocator,
+            .gScore = gScore,
+            .parent = parent,
+            .parentLink = try allocator.alloc(u32, n),
+            .open = std.PriorityQueue(QueueEntry, void, queueOrder).init(allocator, {}),
+        };
+    }
+
+    pub fn deinit(self: *PathSearch) void {
+        self.allocator.free(self.gScore);
+        self.allocator.free(self.parent);
+        self.allocator.free(self.parentLink);
+        self.open.deinit();
+        self.corridorLinks.deinit(self.allocator);
+        self.portals.deinit(self.allocator);
+    }
+
+    /// A* over polygons, moving between link midpoints. On success `corridorLinks` holds the crossed portals.
+    fn run(self: *PathSearch, navMesh: NavMesh, startPoly: u32, goalPoly: u32, goal: Vec3(f32)) !bool {
+        @memset(self.gScore, inf);
+        self.open.items.len = 0;
+        self.corridorLinks.clearRetainingCapacity();
+        self.startPolygon = startPoly;
+
+        self.gScore[startPoly] = 0;
+        self.parent[startPoly] = noPolygon;
+        try self.open.add(.{ .f = distance(navMesh.polygons[startPoly].center, goal), .polygon = startPoly });
+
+        while (self.open.removeOrNull()) |entry| {
+            const current = entry.polygon;
+            if (current == goalPoly) break;
+            const g = self.gScore[current];
+            const here = navMesh.polygons[current].center;
+
+            const first = navMesh.polygons[current].firstLink;
+            for (navMesh.polygonLinks(current), 0..) |link, l| {
+                const mid = toVec3(navMesh.vertices[link.a]).add(toVec3(navMesh.vertices[link.b])).scale(0.5);
+                const next = navMesh.polygons[link.neighbour].center;
+                const tentative = g + distance(here, mid) + distance(mid, next);
+                if (tentative >= self.gScore[link.neighbour]) continue;
+                self.gScore[link.neighbour] = tentative;
+                self.parent[link.neighbour] = current;
+                self.parentLink[link.neighbour] = first + @as(u32, @intCast(l));
+                try self.open.add(.{ .f = tentative + distance(next, goal), .polygon = link.neighbour });
+            }
+        } else return false;
+
+        // ----- corridor from start to goal -----
+        var polygon = goalPoly;
+        while (self.parent[polygon] != noPolygon) : (polygon = self.parent[polygon]) {
+            try self.corridorLinks.append(self.allocator, navMesh.links[self.parentLink[polygon]]);
+        }
+        std.mem.reverse(Link, self.corridorLinks.items);
+        return true;
+    }
+};
+
+const QueueEntry = struct {
+    f: f32,
+    polygon: u32,
+};
+
+fn queueOrder(_: void, a: QueueEntry, b: QueueEntry) std.math.Order {
+    return std.math.order(a.f, b.f);
+}
+
+// ======================================
+// Construction helpers
+// ======================================
+
+const Loop = struct {
+    v: [maxPolyVertices]u32,
+    len: u32,
+};
+
+const EdgeCandidate = struct {
+    edge: u32,
+    lengthSq: f32,
+
+    fn longerFirst(_: void, a: EdgeCandidate, b: EdgeCandidate) bool {
+        return a.lengthSq > b.lengthSq;
+    }
+};
+
+fn find(owner: []u32, face: u32) u32 {
+    var f = face;
+    while (owner[f] != f) {
+        owner[f] = owner[owner[f]]; // path halving
+        f = owner[f];
+    }
+    return f;
+}
+
+/// Merge `p` (containing edge a -> b) and `q` (containing b -> a) into one loop. Null if the edge is not found in both,
+/// the result is too large, not simple or not convex in the xz-plane.
+fn mergeLoops(p: Loop, q: Loop, a: u32, b: u32, positions: []const f32) ?Loop {
+    if (p.len + q.len - 2 > maxPolyVertices) return null;
+    const ip = edgeIndex(p, a, b) orelse return null;
+    const iq = edgeIndex(q, b, a) orelse return null;
+
+    // ----- p from b around to a, then q without a and b -----
+    var merged = Loop{ .v = undefined, .len = 0 };
+    for (0..p.len) |k| {
+        merged.v[merged.len] = p.v[(ip + 1 + k) % p.len];
+        merged.len += 1;
+    }
+    for (0..q.len - 2) |k| {
+        merged.v[merged.len] = q.v[(iq + 2 + k) % q.len];
+        merged.len += 1;
+    }
+
+    // ----- simple: polygons sharing more than one edge would repeat vertices -----
+    for (merged.v[0..merged.len], 0..) |v, i| {
+        if (std.mem.indexOfScalar(u32, merged.v[i + 1 .. merged.len], v) != null) return null;
+    }
+
+    // ----- convex: every corner turns the same way -----
+    var sign: f32 = 0;
+    for (0..merged.len) |i| {
+        const o = positions[merged.v[i] * 3 ..][0..3];
+        const m = positions[merged.v[(i + 1) % merged.len] * 3 ..][0..3];
+        const e = positions[merged.v[(i + 2) % merged.len] * 3 ..][0..3];
+        const turn = (m[0] - o[0]) * (e[2] - m[2]) - (m[2] - o[2]) * (e[0] - m[0]);
+        if (@abs(turn) < 1e-9) continue;
+        if (sign == 0) sign = turn else if ((turn > 0) != (sign > 0)) return null;
+    }
+    return merged;
+}
+
+/// Index i of the loop with v[i] == a and v[i + 1] == b
+fn edgeIndex(loop: Loop, a: u32, b: u32) ?usize {
+    for (0..loop.len) |i| {
+        if (loop.v[i] == a and loop.v[(i + 1) % loop.len] == b) return i;
+    }
+    return null;
+}
+
+// ======================================
+// Geometry
+// ======================================
+
+fn toVec3(v: [3]f32) Vec3(f32) {
+    return .{ .x = v[0], .y = v[1], .z = v[2] };
+}
+
+fn distance(a: Vec3(f32), b: Vec3(f32)) f32 {
+    const d = b.subtract(a);
+    return @sqrt(d.dot(d));
+}
+
+/// Twice the signed area of triangle (a, b, c) in the xz-plane
+fn triArea2(a: Vec3(f32), b: Vec3(f32), c: Vec3(f32)) f32 {
+    const ax = b.x - a.x;
+    const az = b.z - a.z;
+    const bx = c.x - a.x;
+    const bz = c.z - a.z;
+    return bx * az - ax * bz;
+}
+
+fn equal(a: Vec3(f32), b: Vec3(f32)) bool {
+    const d = b.subtract(a);
+    return d.x * d.x + d.z * d.z < 1e-12;
+}
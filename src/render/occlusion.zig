@@ -0,0 +1,373 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const SimMap = @import("../world/sim_map.zig").SimMap;
+const BoundingBox = @import("../mesh/processing.zig").BoundingBox;
+
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+
+const OcclusionError = error{InvalidResolution};
+
+const lanes = std.simd.suggestVectorLength(f32) orelse 4;
+const VecN = @Vector(lanes, f32);
+const LaneMask = std.meta.Int(.unsigned, lanes);
+const laneOffsets = std.simd.iota(f32, lanes);
+
+const maxLevels = 16;
+const nearW = 0.01; // geometry closer to the camera plane is never an occluder and never culled
+
+pub const Visibility = enum { visible, occluded, outside };
+
+/// Counters and timings of one occlusion pass, reset by `HiZBuffer.begin`
+pub const OcclusionStats = struct {
+    occluderTriangles: usize = 0,
+    tested: usize = 0,
+    occluded: usize = 0,
+    outside: usize = 0, // off screen
+    rasterNs: u64 = 0, // begin -> buildPyramid
+    pyramidNs: u64 = 0,
+    testNs: u64 = 0, // in testBoxes
+
+    pub fn culledPercent(self: OcclusionStats) f64 {
+        if (self.tested == 0) return 0;
+        return @as(f64, @floatFromInt(self.occluded + self.outside)) * 100 / @as(f64, @floatFromInt(self.tested));
+    }
+
+    pub fn passNs(self: OcclusionStats) u64 {
+        return self.rasterNs + self.pyramidNs + self.testNs;
+    }
+};
+
+/// Software depth buffer with a max-depth pyramid for conservative occlusion tests.
+///
+/// Occluder triangles are rasterized a vector of pixels at a time, each with the depth of its farthest vertex, so the
+/// buffer never claims to be closer than the real geometry. Depth is the clip w (view distance), +inf where nothing
+/// was drawn. Every pyramid texel holds the farthest depth of the pixels below it. A bounding box is occluded when its
+/// nearest corner is behind the farthest depth of the at most 4x4 texels covering its screen rectangle.
+pub const HiZBuffer = struct {
+    allocator: Allocator,
+    width: usize, // multiple of the vector width
+    height: usize,
+    viewProjection: [16]f32 = math.mat4Identity,
+
+    levels: [maxLevels][]f32 = undefined, // level 0 is the depth buffer
+    levelWidth: [maxLevels]usize = undefined,
+    levelHeight: [maxLevels]usize = undefined,
+    levelCount: usize = 0,
+
+    stats: OcclusionStats = .{},
+    timer: std.time.Timer = undefined,
+
+    pub fn init(allocator: Allocator, width: usize, height: usize) !HiZBuffer {
+        if (width == 0 or height == 0) return OcclusionError.InvalidResolution;
+        var result = HiZBuffer{
+            .allocator = allocator,
+            .width = std.mem.alignForward(usize, width, lanes),
+            .height = height,
+        };
+        errdefer result.deinit();
+
+        var w = result.width;
+        var h = height;
+        while (result.levelCount < maxLevels) {
+            result.levels[result.levelCount] = try allocator.alloc(f32, w * h);
+            result.levelWidth[result.levelCount] = w;
+            result.levelHeight[result.levelCount] = h;
+            result.levelCount += 1;
+            if (w == 1 and h == 1) break;
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+        return result;
+    }
+
+    pub fn deinit(self: *HiZBuffer) void {
+        for (self.levels[0..self.levelCount]) |level| self.allocator.free(level);
+        self.levelCount = 0;
+    }
+
+    /// Clear depth and statistics for a new frame seen through the column-major `viewProjection`
+    pub fn begin(self: *HiZBuffer, viewProjection: [16]f32) !void {
+        self.timer = try std.time.Timer.start();
+        self.viewProjection = viewProjection;
+        self.stats = .{};
+        @memset(self.levels[0], std.math.inf(f32));
+    }
+
+    // ======================================
+    // Occluders
+    // ======================================
+
+    /// Screen position (pixels, y down) and clip w of world point `p`
+    fn toScreen(self: HiZBuffer, p: [3]f32) [3]f32 {
+        const M = self.viewProjection;
+        const x = M[0] * p[0] + M[4] * p[1] + M[8] * p[2] + M[12];
+        const y = M[1] * p[0] + M[5] * p[1] + M[9] * p[2] + M[13];
+        const w = M[3] * p[0] + M[7] * p[1] + M[11] * p[2] + M[15];
+        const fw: f32 = @floatFromInt(self.width);
+        const fh: f32 = @floatFromInt(self.height);
+        return .{ (x / w * 0.5 + 0.5) * fw, (0.5 - y / w * 0.5) * fh, w };
+    }
+
+    /// Rasterize indexed triangles. Triangles reaching behind the near plane are skipped, which is always safe.
+    pub fn drawOccluder(self: *HiZBuffer, vertices: []const [3]f32, indices: []const u32) void {
+        var t: usize = 0;
+        while (t + 3 <= indices.len) : (t += 3) {
+            const a = self.toScreen(vertices[indices[t]]);
+            const b = self.toScreen(vertices[indices[t + 1]]);
+            const c = self.toScreen(vertices[indices[t + 2]]);
+            if (a[2] <= nearW or b[2] <= nearW or c[2] <= nearW) continue;
+            self.rasterTriangle(a, b, c);
+        }
+    }
+
+    fn rasterTriangle(self: *HiZBuffer, a: [3]f32, b_: [3]f32, c_: [3]f32) void {
+        // ----- counter-clockwise in pixel space, either winding draws -----
+        const area = (b_[0] - a[0]) * (c_[1] - a[1]) - (b_[1] - a[1]) * (c_[0] - a[0]);
+        if (area == 0 or std.math.isNan(area)) return;
+        const b = if (area > 0) b_ else c_;
+        const c = if (area > 0) c_ else b_;
+
+        const fw: f32 = @floatFromInt(self.width - 1);
+        const fh: f32 = @floatFromInt(self.height - 1);
+        const minX = @max(@floor(@min(a[0], b[0], c[0])), 0);
+        const maxX = @min(@ceil(@max(a[0], b[0], c[0])), fw);
+        const minY = @max(@floor(@min(a[1], b[1], c[1])), 0);
+        const maxY = @min(@ceil(@max(a[1], b[1], c[1])), fh);
+        if (minX > maxX or minY > maxY) return;
+        self.stats.occluderTriangles += 1;
+
+        // ----- edge functions e = A x + B y + C, inside where all are >= 0 -----
+        const edges = [3][2][3]f32{ .{ a, b }, .{ b, c }, .{ c, a } };
+        var A: [3]f32 = undefined;
+        var B: [3]f32 = undefined;
+        var C: [3]f32 = undefined;
+        for (edges, 0..) |e, k| {
+            A[k] = -(e[1][1] - e[0][1]);
+            B[k] = e[1][0] - e[0][0];
+            C[k] = -(A[k] * e[0][0] + B[k] * e[0][1]);
+        }
+        const depth: VecN = @splat(@max(a[2], b[2], c[2])); // farthest vertex, conservative
+        const zero: VecN = @splat(0);
+
+        const x0 = std.mem.alignBackward(usize, @intFromFloat(minX), lanes);
+        const x1: usize = @intFromFloat(maxX);
+        const buffer = self.levels[0];
+        for (@as(usize, @intFromFloat(minY))..@as(usize, @intFromFloat(maxY)) + 1) |y| {
+            const py: f32 = @as(f32, @floatFromInt(y)) + 0.5;
+            const row = buffer[y * self.width ..][0..self.width];
+
+            var x = x0;
+            while (x <= x1) : (x += lanes) {
+                const px = @as(VecN, @splat(@as(f32, @floatFromInt(x)) + 0.5)) + laneOffsets;
+                var inside: LaneMask = ~@as(LaneMask, 0);
+                inline for (0..3) |k| {
+                    const e = @as(VecN, @splat(A[k])) * px + @as(VecN, @splat(B[k] * py + C[k]));
+                    inside &= @as(LaneMask, @bitCast(e >= zero));
+                }
+                if (inside == 0) continue;
+
+                const old: VecN = row[x..][0..lanes].*;
+                const mask: @Vector(lanes, bool) = @bitCast(inside);
+                row[x..][0..lanes].* = @select(f32, mask, @min(old, depth), old);
+            }
+        }
+    }
+
+    /// Reduce the depth buffer into the max-depth pyramid, call after the last occluder
+    pub fn buildPyramid(self: *HiZBuffer) void {
+        self.stats.rasterNs = self.timer.lap();
+        defer self.stats.pyramidNs = self.timer.lap();
+
+        for (1..self.levelCount) |l| {
+            const src = self.levels[l - 1];
+            const sw = self.levelWidth[l - 1];
+            const sh = self.levelHeight[l - 1];
+            const dst = self.levels[l];
+            const dw = self.levelWidth[l];
+
+            for (0..self.levelHeight[l]) |y| {
+                const y0 = 2 * y;
+                const y1 = @min(2 * y + 1, sh - 1);
+                for (0..dw) |x| {
+                    const x0 = 2 * x;
+                    const x1 = @min(2 * x + 1, sw - 1);
+                    dst[y * dw + x] = @max(src[y0 * sw + x0], src[y0 * sw + x1], src[y1 * sw + x0], src[y1 * sw + x1]);
+                }
+            }
+        }
+    }
+
+    // ======================================
+    // Tests
+    // ======================================
+
+    /// Classify every box of `boxes` into `out`, timed into the pass statistics
+    pub fn testBoxes(self: *HiZBuffer, boxes: []const BoundingBox, out: []Visibility) void {
+        _ = self.timer.lap();
+        defer self.stats.testNs += self.timer.lap();
+        for (boxes, out) |box, *visibility| visibility.* = self.testBox(box.min, box.max);
+    }
+
+    /// Classify the axis aligned box `min`..`max` against the pyramid of the current frame
+    pub fn testBox(self: *HiZBuffer, min: Vec3(f32), max: Vec3(f32)) Visibility {
+        self.stats.tested += 1;
+
+        // ----- all 8 corners at once -----
+        const V8 = @Vector(8, f32);
+        const px = V8{ min.x, max.x, min.x, max.x, min.x, max.x, min.x, max.x };
+        const py = V8{ min.y, min.y, max.y, max.y, min.y, min.y, max.y, max.y };
+        const pz = V8{ min.z, min.z, min.z, min.z, max.z, max.z, max.z, max.z };
+        const M = self.viewProjection;
+        const cx = @as(V8, @splat(M[0])) * px + @as(V8, @splat(M[4])) * py + @as(V8, @splat(M[8])) * pz + @as(V8, @splat(M[12]));
+        const cy = @as(V8, @splat(M[1])) * px + @as(V8, @splat(M[5])) * py + @as(V8, @splat(M[9])) * pz + @as(V8, @splat(M[13]));
+        const cw = @as(V8, @splat(M[3])) * px + @as(V8, @splat(M[7])) * py + @as(V8, @splat(M[11])) * pz + @as(V8, @splat(M[15]));
+
+        const nearestW = @reduce(.Min, cw);
+        if (nearestW <= nearW) return .visible; // crosses the camera plane
+
+        const fw: f32 = @floatFromInt(self.width);
+        const fh: f32 = @floatFromInt(self.height);
+        const sx = (cx / cw * @as(V8, @splat(0.5)) + @as(V8, @splat(0.5))) * @as(V8, @splat(fw));
+        const sy = (@as(V8, @splat(0.5)) - cy / cw * @as(V8, @splat(0.5))) * @as(V8, @splat(fh));
+        const minX = @reduce(.Min, sx);
+        const maxX = @reduce(.Max, sx);
+        const minY = @reduce(.Min, sy);
+        const maxY = @reduce(.Max, sy);
+        if (maxX < 0 or maxY < 0 or minX >= fw or minY >= fh) {
+            self.stats.outside += 1;
+            return .outside;
+        }
+
+        // ----- smallest level where the rectangle covers at most 4x4 texels, thin rectangles stay tight -----
+        var x0: usize = @intFromFloat(@max(minX, 0));
+        var x1: usize = @intFromFloat(@min(maxX, fw - 1));
+        var y0: usize = @intFromFloat(@max(minY, 0));
+        var y1: usize = @intFromFloat(@min(maxY, fh - 1));
+        var level: usize = 0;
+        while (level + 1 < self.levelCount and (x1 - x0 > 3 or y1 - y0 > 3)) : (level += 1) {
+            x0 /= 2;
+            x1 /= 2;
+            y0 /= 2;
+            y1 /= 2;
+        }
+
+        const texels = self.levels[level];
+        const w = self.levelWidth[level];
+        var farthest: f32 = 0;
+        for (y0..y1 + 1) |y| {
+            for (x0..x1 + 1) |x| farthest = @max(farthest, texels[y * w + x]);
+        }
+        if (nearestW > farthest) {
+            self.stats.occluded += 1;
+            return .occluded;
+        }
+        return .visible;
+    }
+};
+
+// ======================================
+// Terrain occluders
+// ======================================
+
+/// Coarse occluder meshes of all map chunks: `quads`² quads per chunk whose vertices take the lowest height around
+/// them, so the occluder surface never rises above the terrain it stands for.
+pub const TerrainOccluders = struct {
+    allocator: Allocator,
+    chunkVertices: [][3]f32, // (quads + 1)² vertices per chunk, one chunk after another
+    indices: []u32, // shared by all chunks
+    verticesPerChunk: usize,
+    centers: [][3]f32, // chunk centers for distance sorting
+    order: []u32, // nearest chunks first, reused by `draw`
+
+    pub fn fromSimMap(allocator: Allocator, map: *const SimMap, quads: usize) !TerrainOccluders {
+        const cellsX = map.resolution.x / map.chunking.x;
+        const cellsZ = map.resolution.y / map.chunking.y;
+        if (quads == 0 or cellsX % quads != 0 or cellsZ % quads != 0) return OcclusionError.InvalidResolution;
+        const chunkCount = map.chunking.x * map.chunking.y;
+        const side = quads + 1;
+
+        const chunkVertices = try allocator.alloc([3]f32, chunkCount * side * side);
+        errdefer allocator.free(chunkVertices);
+        const indices = try allocator.alloc(u32, quads * quads * 6);
+        errdefer allocator.free(indices);
+        const centers = try allocator.alloc([3]f32, chunkCount);
+        errdefer allocator.free(centers);
+        const order = try allocator.alloc(u32, chunkCount);
+
+        // ----- shared grid topology -----
+        for (0..quads) |qz| {
+            for (0..quads) |qx| {
+                const v: u32 = @intCast(qz * side + qx);
+                const s: u32 = @intCast(side);
+                indices[(qz * quads + qx) * 6 ..][0..6].* = .{ v, v + s, v + 1, v + 1, v + s, v + s + 1 };
+            }
+        }
+
+        // ----- vertices: lowest cell height of the quads touching them -----
+        const cellsPerQuadX = cellsX / quads;
+        const cellsPerQuadZ = cellsZ / quads;
+        for (0..map.chunking.y) |chunkZ| {
+            for (0..map.chunking.x) |chunkX| {
+                const chunk = chunkZ * map.chunking.x + chunkX;
+                centers[chunk] = map.chunkBounds[chunk].center();
+                for (0..side) |vz| {
+                    for (0..side) |vx| {
+                        const gx = chunkX * cellsX + vx * cellsPerQuadX; // grid line of this vertex
+                        const gz = chunkZ * cellsZ + vz * cellsPerQuadZ;
+                        var lowest = std.math.inf(f32);
+                        for (gz -| cellsPerQuadZ..@min(gz + cellsPerQuadZ, map.resolution.y)) |z| {
+                            for (gx -| cellsPerQuadX..@min(gx + cellsPerQuadX, map.resolution.x)) |x| {
+                                lowest = @min(lowest, map.heights[z * map.resolution.x + x]);
+                            }
+                        }
+                        chunkVertices[(chunk * side + vz) * side + vx] = .{
+                            map.origin.x + @as(f32, @floatFromInt(gx)) * map.cellSize.x,
+                            lowest,
+                            map.origin.z + @as(f32, @floatFromInt(gz)) * map.cellSize.y,
+                        };
+                    }
+                }
+            }
+        }
+
+        return .{
+            .allocator = allocator,
+            .chunkVertices = chunkVertices,
+            .indices = indices,
+            .verticesPerChunk = side * side,
+            .centers = centers,
+            .order = order,
+        };
+    }
+
+    pub fn deinit(self: *TerrainOccluders) void {
+        self.allocator.free(self.chunkVertices);
+        self.allocator.free(self.indices);
+        self.allocator.free(self.centers);
+        self.allocator.free(self.order);
+    }
+
+    /// Draw the occluders of the `maxChunks` chunks nearest to `eye` into `buffer`
+    pub fn draw(self: *TerrainOccluders, buffer: *HiZBuffer, eye: Vec3(f32), maxChunks: usize) void {
+        for (self.order, 0..) |*o, i| o.* = @intCast(i);
+        const Context = struct {
+            centers: [][3]f32,
+            eye: Vec3(f32),
+            fn distance(ctx: @This(), i: u32) f32 {
+                const dx = ctx.centers[i][0] - ctx.eye.x;
+                const dz = ctx.centers[i][2] - ctx.eye.z;
+                return dx * dx + dz * dz;
+            }
+            fn nearer(ctx: @This(), a: u32, b: u32) bool {
+                return ctx.distance(a) < ctx.distance(b);
+            }
+        };
+        std.mem.sort(u32, self.order, Context{ .centers = self.centers, .eye = eye }, Context.nearer);
+
+        for (self.order[0..@min(maxChunks, self.order.len)]) |chunk| {
+            buffer.drawOccluder(self.chunkVertices[chunk * self.verticesPerChunk ..][0..self.verticesPerChunk], self.indices);
+        }
+    }
+};
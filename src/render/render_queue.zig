@@ -0,0 +1,307 @@
+const std = @import("std");
+const MN = @import("../globals.zig");
+
+const Allocator = std.mem.Allocator;
+
+const RenderQueueError = error{TooManyResources};
+
+/// Passes in submission order
+pub const Pass = enum(u4) { opaqueGeometry, terrain, transparent };
+
+// ----- sort key layouts, most significant first -----
+//   opaque passes:     pass | material | mesh | depth   state changes first, front to back within a batch key
+//   transparent pass:  pass | depth | material | mesh   back to front (depth is inverted on record)
+const depthBits = 24;
+const meshBits = 20;
+const materialBits = 16;
+const passBits = 4;
+const meshShift = depthBits;
+const materialShift = meshShift + meshBits;
+const passShift = materialShift + materialBits;
+const transparentDepthShift = materialBits + meshBits;
+const depthMask: u64 = (1 << depthBits) - 1;
+comptime {
+    std.debug.assert(passShift + passBits == 64);
+    std.debug.assert(transparentDepthShift + depthBits == passShift);
+}
+
+/// Key of a draw. Draws with equal `batchKey` which are adjacent after sorting can share one instanced call.
+pub fn sortKey(pass: Pass, material: u32, mesh: u32, depth: u32) u64 {
+    const passKey = @as(u64, @intFromEnum(pass)) << passShift;
+    if (pass == .transparent) return passKey | @as(u64, depth) << transparentDepthShift | @as(u64, material) << meshBits | mesh;
+    return passKey | @as(u64, material) << materialShift | @as(u64, mesh) << meshShift | depth;
+}
+
+pub fn keyPass(key: u64) Pass {
+    return @enumFromInt(key >> passShift);
+}
+
+/// `key` without its depth
+pub fn batchKey(key: u64) u64 {
+    return if (keyPass(key) == .transparent) key & ~(depthMask << transparentDepthShift) else key & ~depthMask;
+}
+
+fn keyMaterial(key: u64) u32 {
+    const shift: u6 = if (keyPass(key) == .transparent) meshBits else materialShift;
+    return @intCast(key >> shift & ((1 << materialBits) - 1));
+}
+
+fn keyMesh(key: u64) u32 {
+    const shift: u6 = if (keyPass(key) == .transparent) 0 else meshShift;
+    return @intCast(key >> shift & ((1 << meshBits) - 1));
+}
+
+/// One recorded draw. `instance` indexes the transforms recorded alongside.
+pub const Command = struct {
+    key: u64,
+    instance: u32,
+};
+
+/// What the queue asked of the backend. These are logical counts, whether a bind or an instanced call reaches the GPU
+/// as such depends on the backend (`ZuneBackend` draws instance by instance).
+pub const RenderStats = struct {
+    commands: usize = 0,
+    drawCalls: usize = 0, // instanced calls submitted
+    materialChanges: usize = 0,
+    meshChanges: usize = 0,
+    sortNs: u64 = 0,
+    submitNs: u64 = 0,
+
+    pub fn stateChanges(self: RenderStats) usize {
+        return self.materialChanges + self.meshChanges;
+    }
+};
+
+/// Deferred draw submission.
+///
+/// Visible draws are recorded into a flat command array with a 64-bit key (see `sortKey`), radix sorted, and
+/// consecutive draws of the same material and mesh are submitted as one instanced call. Materials and meshes are
+/// interned into small ids the first time they are recorded, so key order groups equal resources regardless of the
+/// order entities were created in.
+///
+/// Commands, transforms and sort buffers live one frame and come from the frame allocator passed to `begin`, sized
+/// from the previous frame. Intern tables are persistent and reserved up front for `MN.RENDER_RESOURCE_CAPACITY`.
+///
+/// `Backend` provides the types `Material` and `Mesh` (hashable handles) and
+///     `bindMaterial(*Backend, Material) !void`
+///     `bindMesh(*Backend, Mesh) !void`
+///     `drawInstanced(*Backend, Mesh, transforms: []const [16]f32) !void`
+/// Binds are only issued when the resource changes, which is what `RenderStats` counts as state changes.
+pub fn RenderQueue(comptime Backend: type) type {
+    return struct {
+        const Self = @This();
+        const Material = Backend.Material;
+        const Mesh = Backend.Mesh;
+
+        allocator: Allocator, // intern tables
+        frameAllocator: Allocator, // everything below up to the intern tables, set by `begin`
+        commands: std.ArrayListUnmanaged(Command) = .{},
+        sorted: std.ArrayListUnmanaged(Command) = .{}, // radix sort ping-pong buffer
+        transforms: std.ArrayListUnmanaged([16]f32) = .{},
+        batch: std.ArrayListUnmanaged([16]f32) = .{}, // transforms of the batch being submitted
+
+        materials: std.ArrayListUnmanaged(Material) = .{},
+        materialIds: std.AutoHashMapUnmanaged(Material, u32) = .{},
+        meshes: std.ArrayListUnmanaged(Mesh) = .{},
+        meshIds: std.AutoHashMapUnmanaged(Mesh, u32) = .{},
+
+        near: f32 = MN.CAMERA_NEAR,
+        far: f32 = MN.CAMERA_FAR,
+        stats: RenderStats = .{},
+
+        pub fn init(allocator: Allocator) !Self {
+            var self = Self{ .allocator = allocator, .frameAllocator = allocator };
+            errdefer self.deinit();
+            try self.materials.ensureTotalCapacity(allocator, MN.RENDER_RESOURCE_CAPACITY);
+            try self.materialIds.ensureTotalCapacity(allocator, MN.RENDER_RESOURCE_CAPACITY);
+            try self.meshes.ensureTotalCapacity(allocator, MN.RENDER_RESOURCE_CAPACITY);
+            try self.meshIds.ensureTotalCapacity(allocator, MN.RENDER_RESOURCE_CAPACITY);
+            return self;
+        }
+
+        /// Per-frame buffers belong to the frame allocator
+        pub fn deinit(self: *Self) void {
+            self.materials.deinit(self.allocator);
+            self.materialIds.deinit(self.allocator);
+            self.meshes.deinit(self.allocator);
+            self.meshIds.deinit(self.allocator);
+        }
+
+        /// Start a frame recording into `frameAllocator`, which must outlive `submit` and is not freed by the queue.
+        /// Last frame's commands are dropped, depths are quantized between `near` and `far`. Interned resources are kept.
+        pub fn begin(self: *Self, frameAllocator: Allocator, near: f32, far: f32) !void {
+            const expected = self.commands.items.len;
+            self.frameAllocator = frameAllocator;
+            self.commands = .{};
+            self.sorted = .{};
+            self.transforms = .{};
+            self.batch = .{};
+            try self.commands.ensureTotalCapacity(frameAllocator, expected);
+            try self.transforms.ensureTotalCapacity(frameAllocator, expected);
+            self.near = near;
+            self.far = far;
+        }
+
+        /// Record a draw of `mesh` with `material` at view distance `depth`. Opaque passes sort front to back within
+        /// a batch key, the transparent pass back to front.
+        pub fn record(self: *Self, pass: Pass, material: Material, mesh: Mesh, transform: [16]f32, depth: f32) !void {
+            const materialId = try intern(Material, self.allocator, &self.materials, &self.materialIds, material, materialBits);
+            const meshId = try intern(Mesh, self.allocator, &self.meshes, &self.meshIds, mesh, meshBits);
+
+            const maxDepth: f32 = @floatFromInt((1 << depthBits) - 1);
+            const t = std.math.clamp((depth - self.near) / (self.far - self.near), 0, 1);
+            var quantized: u32 = @intFromFloat(t * maxDepth);
+            if (pass == .transparent) quantized = (1 << depthBits) - 1 - quantized;
+
+            try self.commands.append(self.frameAllocator, .{
+                .key = sortKey(pass, materialId, meshId, quantized),
+                .instance = @intCast(self.transforms.items.len),
+            });
+            try self.transforms.append(self.frameAllocator, transform);
+        }
+
+        /// Sort the recorded commands and submit them to `backend` as instanced batches
+        pub fn submit(self: *Self, backend: *Backend) !void {
+            self.stats = .{ .commands = self.commands.items.len };
+            var timer = try std.time.Timer.start();
+
+            try self.sort();
+            self.stats.sortNs = timer.lap();
+
+            var boundMaterial: ?u32 = null;
+            var boundMesh: ?u32 = null;
+            const commands = self.commands.items;
+            try self.batch.ensureTotalCapacity(self.frameAllocator, @min(commands.len, MN.RENDER_MAX_INSTANCES));
+            var start: usize = 0;
+            while (start < commands.len) {
+                // ----- extend the batch while pass, material and mesh stay equal -----
+                const key = batchKey(commands[start].key);
+                var end = start + 1;
+                while (end < commands.len and batchKey(commands[end].key) == key and end - start < MN.RENDER_MAX_INSTANCES) end += 1;
+
+                const materialId = keyMaterial(key);
+                const meshId = keyMesh(key);
+                if (boundMaterial != materialId) {
+                    try backend.bindMaterial(self.materials.items[materialId]);
+                    boundMaterial = materialId;
+                    self.stats.materialChanges += 1;
+                }
+                if (boundMesh != meshId) {
+                    try backend.bindMesh(self.meshes.items[meshId]);
+                    boundMesh = meshId;
+                    self.stats.meshChanges += 1;
+                }
+
+                self.batch.clearRetainingCapacity();
+                for (commands[start..end]) |command| self.batch.appendAssumeCapacity(self.transforms.items[command.instance]);
+                try backend.drawInstanced(self.meshes.items[meshId], self.batch.items);
+                self.stats.drawCalls += 1;
+                start = end;
+            }
+            self.stats.submitNs = timer.read();
+        }
+
+        /// LSD radix sort on 8-bit digits, skipping digits every key shares. Stable, so equal keys keep record order.
+        fn sort(self: *Self) !void {
+            const n = self.commands.items.len;
+            try self.sorted.resize(self.frameAllocator, n);
+            var src = self.commands.items;
+            var dst = self.sorted.items;
+
+            var shift: u6 = 0;
+            while (true) : (shift += 8) {
+                var counts = [_]usize{0} ** 256;
+                for (src) |command| counts[@as(u8, @truncate(command.key >> shift))] += 1;
+
+                if (n > 0 and counts[@as(u8, @truncate(src[0].key >> shift))] != n) {
+                    var offset: usize = 0;
+                    for (&counts) |*count| {
+                        const c = count.*;
+                        count.* = offset;
+                        offset += c;
+                    }
+                    for (src) |command| {
+                        const digit: u8 = @truncate(command.key >> shift);
+                        dst[counts[digit]] = command;
+                        counts[digit] += 1;
+                    }
+                    std.mem.swap([]Command, &src, &dst);
+                }
+                if (shift == 56) break;
+            }
+            if (src.ptr != self.commands.items.ptr) @memcpy(self.commands.items, src);
+        }
+    };
+}
+
+/// Dense id of `value`, assigned on first sight
+fn intern(comptime T: type, allocator: Allocator, values: *std.ArrayListUnmanaged(T), ids: *std.AutoHashMapUnmanaged(T, u32), value: T, comptime bits: comptime_int) !u32 {
+    const entry = try ids.getOrPut(allocator, value);
+    if (!entry.found_existing) {
+        if (values.items.len >= 1 << bits) {
+            _ = ids.remove(value);
+            return RenderQueueError.TooManyResources;
+        }
+        entry.value_ptr.* = @intCast(values.items.len);
+        try values.append(allocator, value);
+    }
+    return entry.value_ptr.*;
+}
+
+// ======================================
+// Mock backend
+// ======================================
+
+/// Backend recording what reaches it instead of drawing, for checking the queue without a window
+pub const MockBackend = struct {
+    pub const Material = u32;
+    pub const Mesh = u32;
+
+    pub const Call = struct {
+        material: u32,
+        mesh: u32,
+        instances: usize,
+        firstTransform: [16]f32,
+    };
+
+    allocator: Allocator,
+    calls: std.ArrayListUnmanaged(Call) = .{},
+    material: ?u32 = null,
+    mesh: ?u32 = null,
+    binds: usize = 0,
+
+    pub fn init(allocator: Allocator) MockBackend {
+        return .{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *MockBackend) void {
+        self.calls.deinit(self.allocator);
+    }
+
+    pub fn reset(self: *MockBackend) void {
+        self.calls.clearRetainingCapacity();
+        self.material = null;
+        self.mesh = null;
+        self.binds = 0;
+    }
+
+    pub fn bindMaterial(self: *MockBackend, material: u32) !void {
+        self.material = material;
+        self.binds += 1;
+    }
+
+    pub fn bindMesh(self: *MockBackend, mesh: u32) !void {
+        self.mesh = mesh;
+        self.binds += 1;
+    }
+
+    pub fn drawInstanced(self: *MockBackend, mesh: u32, transforms: []const [16]f32) !void {
+        std.debug.assert(self.mesh == mesh);
+        try self.calls.append(self.allocator, .{
+            .material = self.material.?,
+            .mesh = mesh,
+            .instances = transforms.len,
+            .firstTransform = transforms[0],
+        });
+    }
+};
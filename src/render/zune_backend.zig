@@ -0,0 +1,30 @@
+const std = @import("std");
+const zune = @import("zune");
+
+const Model = zune.graphics.Model;
+const Camera = zune.graphics.Camera;
+const WorldMatrix = @FieldType(zune.ecs.components.TransformComponent, "world_matrix");
+
+/// `RenderQueue` backend drawing through a zune camera.
+///
+/// zune has no instancing path and no separate bind calls: `drawModel` binds a model's meshes and materials itself and
+/// issues one draw per mesh. A model is therefore both the material and the mesh of a command, `bindMaterial` and
+/// `bindMesh` do nothing and a batch is drawn model by model. The queue's draw call and state change counters are
+/// logical only with this backend; the GPU sees one draw per instance and whatever rebinding zune does internally.
+pub const ZuneBackend = struct {
+    pub const Material = *Model;
+    pub const Mesh = *Model;
+
+    camera: *Camera,
+
+    pub fn bindMaterial(_: *ZuneBackend, _: *Model) !void {}
+
+    pub fn bindMesh(_: *ZuneBackend, _: *Model) !void {}
+
+    pub fn drawInstanced(self: *ZuneBackend, model: *Model, transforms: []const [16]f32) !void {
+        for (transforms) |transform| {
+            const matrix = WorldMatrix{ .data = transform };
+            try self.camera.drawModel(model, &matrix);
+        }
+    }
+};
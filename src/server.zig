@@ -0,0 +1,247 @@
+const std = @import("std");
+const math = @import("math.zig");
+const tracking = @import("utils/tracking_allocator.zig");
+const scratch_arena = @import("utils/scratch.zig");
+
+const MN = @import("globals.zig");
+
+const SimMap = @import("world/sim_map.zig").SimMap;
+const map_pack = @import("world/map_pack.zig");
+const SpatialHash = @import("world/spatial_hash.zig").SpatialHash;
+const FogOfWar = @import("world/fog_of_war.zig").FogOfWar;
+const InfluenceMap = @import("ai/influence_map.zig").InfluenceMap;
+
+const Allocator = std.mem.Allocator;
+const Vec3 = math.vec3;
+
+// Headless dedicated server: no window, renderer or GL resources. Maps are loaded into simulation-only data
+// and every match is stepped at a fixed tick.
+//
+// usage: Zune_rts_server [--matches N] [--units N] [--ticks N] [--map ID]
+
+const ServerError = error{ InvalidArgument, MapError };
+
+const ServerConfig = struct {
+    matches: usize = 1,
+    unitsPerMatch: usize = 0,
+    ticks: ?u64 = null, // run forever if null
+    mapId: usize = 0,
+};
+
+pub fn main() !void {
+    // ===== Initialize allocator ===== //
+    var gpa = std.heap.GeneralPurposeAllocator(.{}){};
+    defer _ = gpa.deinit();
+
+    var tracker = try tracking.TrackingAllocator.init(gpa.allocator(), .{ .timeline = MN.TRACK_MEMORY_TIMELINE });
+    defer tracker.deinit();
+    defer if (MN.TRACK_MEMORY) tracker.printSummary();
+    const allocator = if (MN.TRACK_MEMORY) tracker.allocator() else gpa.allocator();
+    defer scratch_arena.deinitThreadScratch();
+
+    const config = try parseArgs(allocator);
+
+    // ===== Map pack once, shared read-only by all matches and all server processes ===== //
+    if (config.mapId >= MN.MAP_MESHES.len) return ServerError.MapError;
+    var timer = try std.time.Timer.start();
+    var simMap = try map_pack.openOrBuildPack(allocator, MN.MAP_PACKS[config.mapId], MN.MAP_MESHES[config.mapId], MN.MAP_CHUNKING[config.mapId], MN.NAV_CELLS_PER_CHUNK);
+    defer simMap.deinit();
+    std.debug.print("Mapped map '{s}' in {d:.1} ms ({} shared bytes)\n", .{ MN.MAP_NAMES[config.mapId], @as(f64, @floatFromInt(timer.lap())) / std.time.ns_per_ms, simMap.memoryBytes() });
+
+    // ===== Create matches ===== //
+    const matches = try allocator.alloc(Match, config.matches);
+    defer allocator.free(matches);
+    var created: usize = 0;
+    defer for (matches[0..created]) |*match| match.deinit();
+
+    var rng = std.Random.DefaultPrng.init(0x5EED);
+    for (matches) |*match| {
+        match.* = try Match.init(allocator, &simMap, config.unitsPerMatch, rng.random());
+        created += 1;
+    }
+    std.debug.print("Started {} match(es) in {d:.1} ms\n", .{ matches.len, @as(f64, @floatFromInt(timer.lap())) / std.time.ns_per_ms });
+
+    // ===== Fixed tick loop ===== //
+    const tickNs: u64 = std.time.ns_per_s / MN.SERVER_TICK_RATE;
+    const dt: f32 = 1.0 / @as(f32, @floatFromInt(MN.SERVER_TICK_RATE));
+    var tick: u64 = 0;
+    var busyNs: u64 = 0;
+    var queryNs: u64 = 0;
+    var maxQueryNs: u64 = 0;
+    var fogNs: u64 = 0;
+    var maxFogNs: u64 = 0;
+    var influenceNs: u64 = 0;
+    var maxInfluenceNs: u64 = 0;
+    var next: u64 = timer.read();
+
+    while (config.ticks == null or tick < config.ticks.?) : (tick += 1) {
+        const start = timer.read();
+        for (matches) |*match| {
+            try match.step(dt);
+            queryNs += match.lastQueryNs;
+            maxQueryNs = @max(maxQueryNs, match.lastQueryNs);
+            fogNs += match.fog.lastUpdateNs;
+            maxFogNs = @max(maxFogNs, match.fog.lastUpdateNs);
+            influenceNs += match.influence.lastStepNs;
+            maxInfluenceNs = @max(maxInfluenceNs, match.influence.lastStepNs);
+        }
+        busyNs += timer.read() - start;
+
+        // ----- wait for next tick, do not try to catch up more than one tick -----
+        next += tickNs;
+        const now = timer.read();
+        if (now < next) {
+            std.Thread.sleep(next - now);
+        } else if (now - next > tickNs) next = now;
+    }
+
+    if (tick > 0 and matches.len > 0) {
+        std.debug.print("{} ticks, avg step {d:.3} ms for {} match(es)\n", .{ tick, @as(f64, @floatFromInt(busyNs / tick)) / std.time.ns_per_ms, matches.len });
+        std.debug.print("proximity query batch per match: avg {d:.3} ms, max {d:.3} ms\n", .{
+            @as(f64, @floatFromInt(queryNs / (tick * matches.len))) / std.time.ns_per_ms,
+            @as(f64, @floatFromInt(maxQueryNs)) / std.time.ns_per_ms,
+        });
+        std.debug.print("fog of war update per match: avg {d:.3} ms, max {d:.3} ms\n", .{
+            @as(f64, @floatFromInt(fogNs / (tick * matches.len))) / std.time.ns_per_ms,
+            @as(f64, @floatFromInt(maxFogNs)) / std.time.ns_per_ms,
+        });
+        std.debug.print("influence map step per match: avg {d:.1} us, max {d:.1} us ({} rows per tick)\n", .{
+            @as(f64, @floatFromInt(influenceNs / (tick * matches.len))) / std.time.ns_per_us,
+            @as(f64, @floatFromInt(maxInfluenceNs)) / std.time.ns_per_us,
+            MN.INFLUENCE_ROWS_PER_TICK,
+        });
+    }
+}
+
+fn parseArgs(allocator: Allocator) !ServerConfig {
+    var config = ServerConfig{};
+    const args = try std.process.argsAlloc(allocator);
+    defer std.process.argsFree(allocator, args);
+
+    var i: usize = 1;
+    while (i < args.len) : (i += 2) {
+        if (i + 1 >= args.len) return ServerError.InvalidArgument;
+        const value = std.fmt.parseInt(usize, args[i + 1], 10) catch return ServerError.InvalidArgument;
+
+        if (std.mem.eql(u8, args[i], "--matches")) {
+            if (value == 0) return ServerError.InvalidArgument;
+            config.matches = value;
+        } else if (std.mem.eql(u8, args[i], "--units")) {
+            config.unitsPerMatch = value;
+        } else if (std.mem.eql(u8, args[i], "--ticks")) {
+            config.ticks = value;
+        } else if (std.mem.eql(u8, args[i], "--map")) {
+            config.mapId = value;
+        } else return ServerError.InvalidArgument;
+    }
+    return config;
+}
+
+// ======================================
+// Match
+// ======================================
+
+const Unit = struct {
+    position: Vec3(f32),
+    velocity: Vec3(f32),
+};
+
+/// Simulation state of a single match. Only refers to the shared `SimMap`, owns nothing but its units and their index.
+const Match = struct {
+    allocator: Allocator,
+    map: *const SimMap,
+    units: std.ArrayList(Unit),
+    proximity: SpatialHash, // unit index -> position
+    neighbours: std.ArrayList(u32), // query results, reused every tick
+    fog: FogOfWar, // unit index -> fog unit, teams alternate
+    influence: InfluenceMap, // one player per team
+    tick: u64 = 0,
+    lastQueryNs: u64 = 0, // separation queries of the last step
+
+    /// Spawn `unitCount` wandering units on random walkable cells
+    fn init(allocator: Allocator, map: *const SimMap, unitCount: usize, random: std.Random) !Match {
+        var units = try std.ArrayList(Unit).initCapacity(allocator, unitCount);
+        errdefer units.deinit();
+
+        var attempts: usize = 0;
+        while (units.items.len < unitCount and attempts < unitCount * 16) : (attempts += 1) {
+            const x = map.origin.x + random.float(f32) * map.extent.x;
+            const z = map.origin.z + random.float(f32) * map.extent.z;
+            if (!map.isWalkable(x, z)) continue;
+
+            const angle = random.float(f32) * std.math.tau;
+            units.appendAssumeCapacity(.{
+                .position = .{ .x = x, .y = map.heightAt(x, z), .z = z },
+                .velocity = .{ .x = @cos(angle) * MN.UNIT_SPEED, .z = @sin(angle) * MN.UNIT_SPEED },
+            });
+        }
+
+        var proximity = try SpatialHash.init(allocator, .{ .x = map.origin.x, .y = map.origin.z }, map.chunking, map.chunkSize, MN.SPATIAL_CELLS_PER_CHUNK);
+        errdefer proximity.deinit();
+        for (units.items, 0..) |unit, i| try proximity.insert(@intCast(i), unit.position.x, unit.position.z);
+
+        var fog = try FogOfWar.init(allocator, map, MN.TEAMS_PER_MATCH, MN.UNIT_EYE_HEIGHT);
+        errdefer fog.deinit();
+        for (units.items, 0..) |unit, i| {
+            _ = try fog.addUnit(@intCast(i % MN.TEAMS_PER_MATCH), MN.UNIT_SIGHT_CELLS, unit.position.x, unit.position.z);
+        }
+
+        var influence = try InfluenceMap.init(allocator, .{ .x = map.origin.x, .y = map.origin.z }, map.chunking, map.chunkSize, MN.INFLUENCE_CELLS_PER_CHUNK, MN.TEAMS_PER_MATCH, MN.INFLUENCE_RADIUS_CELLS);
+        errdefer influence.deinit();
+
+        return .{
+            .allocator = allocator,
+            .map = map,
+            .units = units,
+            .proximity = proximity,
+            .neighbours = std.ArrayList(u32).init(allocator),
+            .fog = fog,
+            .influence = influence,
+        };
+    }
+
+    fn deinit(self: *Match) void {
+        self.units.deinit();
+        self.proximity.deinit();
+        self.neighbours.deinit();
+        self.fog.deinit();
+        self.influence.deinit();
+    }
+
+    /// Advance match by `dt` seconds. Units turn around on unwalkable terrain, follow the heightfield and steer away
+    /// from units closer than `UNIT_SEPARATION`. Visibility is updated for the units which changed cell,
+    /// the influence map advances by a fixed number of rows.
+    fn step(self: *Match, dt: f32) !void {
+        const map = self.map;
+
+        // ----- separation, one proximity query per unit -----
+        var timer = try std.time.Timer.start();
+        for (self.units.items) |*unit| {
+            self.neighbours.clearRetainingCapacity();
+            try self.proximity.queryRadius(unit.position.x, unit.position.z, MN.UNIT_SEPARATION, &self.neighbours);
+            if (self.neighbours.items.len <= 1) continue; // only itself
+            unit.velocity = .{ .x = -unit.velocity.z, .y = unit.velocity.y, .z = unit.velocity.x }; // turn 90 degrees
+        }
+        self.lastQueryNs = timer.read();
+
+        for (self.units.items, 0..) |*unit, i| {
+            const next = unit.position.add(unit.velocity.scale(dt));
+            if (!map.isWalkable(next.x, next.z)) {
+                unit.velocity = unit.velocity.inv();
+                continue;
+            }
+            unit.position = .{ .x = next.x, .y = map.heightAt(next.x, next.z), .z = next.z };
+            try self.proximity.move(@intCast(i), next.x, next.z);
+            try self.fog.moveUnit(@intCast(i), next.x, next.z);
+        }
+        try self.fog.update();
+
+        // ----- influence, a new update is splatted once the previous one is published -----
+        if (self.influence.isIdle()) {
+            self.influence.begin();
+            for (self.units.items, 0..) |unit, i| try self.influence.splat(i % MN.TEAMS_PER_MATCH, unit.position.x, unit.position.z, 1);
+        }
+        _ = try self.influence.step(MN.INFLUENCE_ROWS_PER_TICK);
+        self.tick += 1;
+    }
+};
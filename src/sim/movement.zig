@@ -0,0 +1,131 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+
+pub const Velocity = struct {
+    x: f32 = 0,
+    y: f32 = 0,
+    z: f32 = 0,
+};
+
+const lanes = std.simd.suggestVectorLength(f32) orelse 4;
+const VecN = @Vector(lanes, f32);
+const LaneMask = std.meta.Int(.unsigned, lanes);
+
+/// Movement integration of all bodies, stored as structure of arrays so `integrate` runs `lanes` bodies per instruction.
+///
+/// Only positions are simulated. World matrices are owned by the render side's `TransformGraph`, which recomputes them
+/// for the bodies flagged in `moved`. All buffers are sized in `add`, so ticking never allocates.
+pub const Movement = struct {
+    allocator: Allocator,
+
+    px: std.ArrayList(f32),
+    py: std.ArrayList(f32),
+    pz: std.ArrayList(f32),
+    vx: std.ArrayList(f32),
+    vy: std.ArrayList(f32),
+    vz: std.ArrayList(f32),
+
+    moved: std.ArrayList(bool), // moved during the last `integrate`
+    movedCount: usize = 0, // bodies moved during the last `integrate`
+
+    pub fn init(allocator: Allocator) Movement {
+        return .{
+            .allocator = allocator,
+            .px = std.ArrayList(f32).init(allocator),
+            .py = std.ArrayList(f32).init(allocator),
+            .pz = std.ArrayList(f32).init(allocator),
+            .vx = std.ArrayList(f32).init(allocator),
+            .vy = std.ArrayList(f32).init(allocator),
+            .vz = std.ArrayList(f32).init(allocator),
+            .moved = std.ArrayList(bool).init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *Movement) void {
+        inline for (.{ &self.px, &self.py, &self.pz, &self.vx, &self.vy, &self.vz }) |list| list.deinit();
+        self.moved.deinit();
+    }
+
+    pub fn count(self: Movement) usize {
+        return self.px.items.len;
+    }
+
+    /// Add body, returns its index. It counts as moved until the first `integrate`.
+    pub fn add(self: *Movement, position: Vec3(f32), velocity: Velocity) !u32 {
+        const index: u32 = @intCast(self.count());
+        const n = index + 1;
+
+        // ----- reserve everything first, appends below cannot fail -----
+        inline for (.{ &self.px, &self.py, &self.pz, &self.vx, &self.vy, &self.vz }) |list| try list.ensureTotalCapacity(n);
+        try self.moved.ensureTotalCapacity(n);
+
+        self.px.appendAssumeCapacity(position.x);
+        self.py.appendAssumeCapacity(position.y);
+        self.pz.appendAssumeCapacity(position.z);
+        self.vx.appendAssumeCapacity(velocity.x);
+        self.vy.appendAssumeCapacity(velocity.y);
+        self.vz.appendAssumeCapacity(velocity.z);
+        self.moved.appendAssumeCapacity(true);
+        return index;
+    }
+
+    pub fn position(self: Movement, i: usize) Vec3(f32) {
+        return .{ .x = self.px.items[i], .y = self.py.items[i], .z = self.pz.items[i] };
+    }
+
+    pub fn setVelocity(self: *Movement, i: usize, velocity: Velocity) void {
+        self.vx.items[i] = velocity.x;
+        self.vy.items[i] = velocity.y;
+        self.vz.items[i] = velocity.z;
+    }
+
+    /// Copy positions into `out` (AoS), e.g. for a snapshot
+    pub fn copyPositions(self: Movement, out: []Vec3(f32)) void {
+        for (out, self.px.items, self.py.items, self.pz.items) |*p, x, y, z| p.* = .{ .x = x, .y = y, .z = z };
+    }
+
+    /// position += velocity * dt for all bodies. Bodies with non-zero velocity are marked moved.
+    pub fn integrate(self: *Movement, dt: f32) void {
+        const n = self.count();
+        const px = self.px.items;
+        const py = self.py.items;
+        const pz = self.pz.items;
+        const vx = self.vx.items;
+        const vy = self.vy.items;
+        const vz = self.vz.items;
+        const moved = self.moved.items;
+
+        const dtv: VecN = @splat(dt);
+        const zero: VecN = @splat(0);
+        var movedCount: usize = 0;
+
+        var i: usize = 0;
+        while (i + lanes <= n) : (i += lanes) {
+            const vxl: VecN = vx[i..][0..lanes].*;
+            const vyl: VecN = vy[i..][0..lanes].*;
+            const vzl: VecN = vz[i..][0..lanes].*;
+
+            px[i..][0..lanes].* = @as(VecN, px[i..][0..lanes].*) + vxl * dtv;
+            py[i..][0..lanes].* = @as(VecN, py[i..][0..lanes].*) + vyl * dtv;
+            pz[i..][0..lanes].* = @as(VecN, pz[i..][0..lanes].*) + vzl * dtv;
+
+            // ----- moved mask -----
+            const moving = vxl * vxl + vyl * vyl + vzl * vzl > zero;
+            moved[i..][0..lanes].* = moving;
+            movedCount += @popCount(@as(LaneMask, @bitCast(moving)));
+        }
+
+        // ----- remainder -----
+        while (i < n) : (i += 1) {
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+            pz[i] += vz[i] * dt;
+            moved[i] = vx[i] != 0 or vy[i] != 0 or vz[i] != 0;
+            movedCount += @intFromBool(moved[i]);
+        }
+        self.movedCount = movedCount;
+    }
+};
@@ -0,0 +1,227 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const sim_world = @import("sim_world.zig");
+const SimWorld = sim_world.SimWorld;
+const SimInput = sim_world.SimInput;
+const TripleBuffer = @import("triple_buffer.zig").TripleBuffer;
+
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+const Atomic = std.atomic.Value;
+
+/// Body positions of a single tick, exchanged through the triple buffer.
+/// Holds the positions before and after the tick so the render side can interpolate between them.
+pub const Snapshot = struct {
+    tick: u64 = 0,
+    publishedNs: u64 = 0, // end of tick, relative to epoch
+    inputSeq: u64 = 0, // newest input seen by this tick
+    inputSentNs: u64 = 0,
+    previous: []Vec3(f32) = &.{},
+    current: []Vec3(f32) = &.{},
+    moved: []bool = &.{}, // body moved during this tick
+};
+
+/// Written by the simulation thread, readable from any thread
+pub const SimPacing = struct {
+    ticks: Atomic(u64) = Atomic(u64).init(0),
+    lateTicks: Atomic(u64) = Atomic(u64).init(0), // ticks started more than a full tick behind schedule
+    maxLatenessNs: Atomic(u64) = Atomic(u64).init(0),
+    lastStepNs: Atomic(u64) = Atomic(u64).init(0),
+    maxStepNs: Atomic(u64) = Atomic(u64).init(0),
+    bodiesMoved: Atomic(u64) = Atomic(u64).init(0), // by the last tick
+};
+
+/// Owned by the render thread
+pub const FramePacing = struct {
+    frames: u64 = 0,
+    lastFrameNs: u64 = 0,
+    maxFrameNs: u64 = 0,
+    inputLatencyNs: u64 = 0, // sample -> first snapshot which includes it
+    maxInputLatencyNs: u64 = 0,
+    lastInputSeq: u64 = 0,
+};
+
+/// Steps a `SimWorld` at a fixed rate on its own thread. Positions are handed to the render thread through a
+/// lock-free triple buffer, input is handed to the simulation through a second one. Neither thread ever blocks the other.
+pub const SimThread = struct {
+    allocator: Allocator,
+    world: *SimWorld,
+    thread: ?std.Thread = null,
+    running: Atomic(bool) = Atomic(bool).init(false),
+
+    epoch: std.time.Instant,
+    tickNs: u64,
+    snapshots: TripleBuffer(Snapshot),
+    inputs: TripleBuffer(SimInput),
+
+    pacing: SimPacing = .{},
+    framePacing: FramePacing = .{},
+
+    /// Per-slot position buffers are sized to the bodies in `world`, spawn all bodies first
+    pub fn init(allocator: Allocator, world: *SimWorld, tickRate: u64) !SimThread {
+        var result = SimThread{
+            .allocator = allocator,
+            .world = world,
+            .epoch = try std.time.Instant.now(),
+            .tickNs = std.time.ns_per_s / tickRate,
+            .snapshots = TripleBuffer(Snapshot).init(.{}),
+            .inputs = TripleBuffer(SimInput).init(.{}),
+        };
+        errdefer result.freeSlots();
+
+        const bodyCount = world.bodyCount();
+        for (result.snapshots.allSlots()) |*slot| {
+            slot.previous = try allocator.alloc(Vec3(f32), bodyCount);
+            slot.current = try allocator.alloc(Vec3(f32), bodyCount);
+            slot.moved = try allocator.alloc(bool, bodyCount);
+            world.movement.copyPositions(slot.previous);
+            world.movement.copyPositions(slot.current);
+            @memset(slot.moved, true);
+        }
+        return result;
+    }
+
+    pub fn deinit(self: *SimThread) void {
+        self.stop();
+        self.freeSlots();
+    }
+
+    fn freeSlots(self: *SimThread) void {
+        for (self.snapshots.allSlots()) |*slot| {
+            self.allocator.free(slot.previous);
+            self.allocator.free(slot.current);
+            self.allocator.free(slot.moved);
+            slot.* = .{};
+        }
+    }
+
+    /// `self` must not move while the thread runs
+    pub fn start(self: *SimThread) !void {
+        self.running.store(true, .release);
+        self.thread = try std.Thread.spawn(.{}, run, .{self});
+    }
+
+    pub fn stop(self: *SimThread) void {
+        self.running.store(false, .release);
+        if (self.thread) |thread| thread.join();
+        self.thread = null;
+    }
+
+    /// Nanoseconds since the sim thread epoch, comparable between threads
+    pub fn now(self: SimThread) u64 {
+        const instant = std.time.Instant.now() catch return 0;
+        return instant.since(self.epoch);
+    }
+
+    // ======================================
+    // Render side
+    // ======================================
+
+    /// Hand this frame's input to the simulation
+    pub fn sendInput(self: *SimThread, input: SimInput) void {
+        const slot = self.inputs.writeSlot();
+        slot.* = input;
+        slot.sentNs = self.now();
+        self.inputs.publish();
+    }
+
+    /// Newest snapshot. Updates input latency and frame pacing, call once per frame with the frame time.
+    pub fn latest(self: *SimThread, frameNs: u64) *const Snapshot {
+        const fp = &self.framePacing;
+        fp.frames += 1;
+        fp.lastFrameNs = frameNs;
+        fp.maxFrameNs = @max(fp.maxFrameNs, frameNs);
+
+        const changed = self.snapshots.acquire();
+        const snapshot = self.snapshots.readSlot();
+        if (changed and snapshot.inputSeq != fp.lastInputSeq) {
+            fp.lastInputSeq = snapshot.inputSeq;
+            fp.inputLatencyNs = snapshot.publishedNs -| snapshot.inputSentNs;
+            fp.maxInputLatencyNs = @max(fp.maxInputLatencyNs, fp.inputLatencyNs);
+        }
+        return snapshot;
+    }
+
+    /// Position of body `index` interpolated between the last two ticks for time `nowNs`
+    pub fn interpolate(self: SimThread, snapshot: *const Snapshot, index: usize, nowNs: u64) Vec3(f32) {
+        const elapsed: f32 = @floatFromInt(nowNs -| snapshot.publishedNs);
+        const alpha = std.math.clamp(elapsed / @as(f32, @floatFromInt(self.tickNs)), 0, 1);
+        const prev = snapshot.previous[index];
+        return prev.add(snapshot.current[index].subtract(prev).scale(alpha));
+    }
+
+    pub fn printPacing(self: *SimThread) void {
+        const p = &self.pacing;
+        const fp = self.framePacing;
+        const ms = @as(f64, std.time.ns_per_ms);
+        std.debug.print("\n===== Pacing =====\n", .{});
+        std.debug.print("sim   : {} ticks, {} late, max lateness {d:.3} ms, step last/max {d:.3}/{d:.3} ms, bodies moved last tick {}\n", .{
+            p.ticks.load(.monotonic),
+            p.lateTicks.load(.monotonic),
+            @as(f64, @floatFromInt(p.maxLatenessNs.load(.monotonic))) / ms,
+            @as(f64, @floatFromInt(p.lastStepNs.load(.monotonic))) / ms,
+            @as(f64, @floatFromInt(p.maxStepNs.load(.monotonic))) / ms,
+            p.bodiesMoved.load(.monotonic),
+        });
+        std.debug.print("render: {} frames, frame last/max {d:.3}/{d:.3} ms, input latency last/max {d:.3}/{d:.3} ms\n", .{
+            fp.frames,
+            @as(f64, @floatFromInt(fp.lastFrameNs)) / ms,
+            @as(f64, @floatFromInt(fp.maxFrameNs)) / ms,
+            @as(f64, @floatFromInt(fp.inputLatencyNs)) / ms,
+            @as(f64, @floatFromInt(fp.maxInputLatencyNs)) / ms,
+        });
+    }
+
+    // ======================================
+    // Simulation side
+    // ======================================
+
+    fn run(self: *SimThread) void {
+        const world = self.world;
+        const dt: f32 = @as(f32, @floatFromInt(self.tickNs)) / std.time.ns_per_s;
+        var next = self.now();
+        var tick: u64 = 0;
+
+        while (self.running.load(.acquire)) {
+            // ----- keep schedule, drop ticks when more than one behind -----
+            const start = self.now();
+            if (start < next) {
+                std.Thread.sleep(next - start);
+                continue;
+            }
+            const lateness = start - next;
+            if (lateness > self.tickNs) {
+                _ = self.pacing.lateTicks.fetchAdd(1, .monotonic);
+                next = start;
+            }
+            _ = self.pacing.maxLatenessNs.fetchMax(lateness, .monotonic);
+            next += self.tickNs;
+
+            // ----- step -----
+            _ = self.inputs.acquire();
+            const input = self.inputs.readSlot().*;
+
+            const snapshot = self.snapshots.writeSlot();
+            world.movement.copyPositions(snapshot.previous);
+            world.step(dt, input);
+            world.movement.copyPositions(snapshot.current);
+            @memcpy(snapshot.moved, world.movement.moved.items);
+
+            tick += 1;
+            snapshot.tick = tick;
+            snapshot.inputSeq = input.seq;
+            snapshot.inputSentNs = input.sentNs;
+            const end = self.now();
+            snapshot.publishedNs = end;
+            self.snapshots.publish();
+
+            // ----- counters -----
+            const stepNs = end - start;
+            self.pacing.lastStepNs.store(stepNs, .monotonic);
+            _ = self.pacing.maxStepNs.fetchMax(stepNs, .monotonic);
+            self.pacing.bodiesMoved.store(world.movement.movedCount, .monotonic);
+            _ = self.pacing.ticks.fetchAdd(1, .monotonic);
+        }
+    }
+};
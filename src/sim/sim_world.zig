@@ -0,0 +1,64 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const movement = @import("movement.zig");
+const Movement = movement.Movement;
+pub const Velocity = movement.Velocity;
+
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+
+/// Render -> simulation input, sampled once per frame. Only the newest input reaches a tick, so it carries state
+/// (the velocity a body should have), not one-shot events.
+pub const SimInput = struct {
+    seq: u64 = 0, // increases every frame
+    sentNs: u64 = 0, // time the input was sampled, relative to the sim thread epoch
+    steer: ?Steer = null,
+
+    pub const Steer = struct {
+        body: u32,
+        velocity: Velocity,
+    };
+};
+
+/// ECS component linking an entity to a body in the `SimWorld`. Its transform is driven by the simulation.
+pub const SimBody = struct {
+    index: u32,
+    settled: bool = false, // render side: transform holds the final position of the last move
+};
+
+/// State owned by the simulation thread
+///
+/// Bodies must be spawned before the simulation thread is started.
+pub const SimWorld = struct {
+    allocator: Allocator,
+    movement: Movement,
+
+    pub fn init(allocator: Allocator) SimWorld {
+        return .{
+            .allocator = allocator,
+            .movement = Movement.init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *SimWorld) void {
+        self.movement.deinit();
+    }
+
+    /// Add body at `position`, returns the component linking an entity to it
+    pub fn spawn(self: *SimWorld, position: Vec3(f32), velocity: Velocity) !SimBody {
+        return .{ .index = try self.movement.add(position, velocity) };
+    }
+
+    pub fn bodyCount(self: SimWorld) usize {
+        return self.movement.count();
+    }
+
+    /// Apply `input`, then advance world by `dt` seconds
+    pub fn step(self: *SimWorld, dt: f32, input: SimInput) void {
+        if (input.steer) |steer| {
+            if (steer.body < self.bodyCount()) self.movement.setVelocity(steer.body, steer.velocity);
+        }
+        self.movement.integrate(dt);
+    }
+};
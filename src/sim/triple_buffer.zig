@@ -0,0 +1,57 @@
+const std = @import("std");
+
+/// Lock-free single-producer/single-consumer triple buffer.
+///
+/// The producer always has a slot to write in and the consumer always has a slot to read from. `publish` hands the
+/// written slot over by swapping it with the middle slot, `acquire` takes the middle slot if it holds newer data.
+/// Neither side ever waits for the other, intermediate values may be skipped by the consumer.
+pub fn TripleBuffer(comptime T: type) type {
+    return struct {
+        slots: [3]T,
+        writeIndex: u8 = 0,
+        readIndex: u8 = 1,
+        middle: std.atomic.Value(u8) = std.atomic.Value(u8).init(2), // index | freshBit
+
+        const Self = @This();
+        const freshBit: u8 = 0b100;
+        const indexMask: u8 = 0b011;
+
+        /// `initial` is copied into all slots
+        pub fn init(initial: T) Self {
+            return .{ .slots = .{ initial, initial, initial } };
+        }
+
+        // ----- producer -----
+
+        /// Slot the producer may write. Only valid until `publish`.
+        pub fn writeSlot(self: *Self) *T {
+            return &self.slots[self.writeIndex];
+        }
+
+        /// Make the written slot available to the consumer and take over the previous middle slot
+        pub fn publish(self: *Self) void {
+            const prev = self.middle.swap(self.writeIndex | freshBit, .acq_rel);
+            self.writeIndex = prev & indexMask;
+        }
+
+        // ----- consumer -----
+
+        /// Take the newest published slot if there is one. Returns `true` if the read slot changed.
+        pub fn acquire(self: *Self) bool {
+            if (self.middle.load(.acquire) & freshBit == 0) return false;
+            const prev = self.middle.swap(self.readIndex, .acq_rel);
+            self.readIndex = prev & indexMask;
+            return true;
+        }
+
+        /// Slot the consumer may read. Only valid until the next `acquire`.
+        pub fn readSlot(self: *Self) *const T {
+            return &self.slots[self.readIndex];
+        }
+
+        /// Access to all slots, e.g. to allocate and free per-slot storage before/after both threads run
+        pub fn allSlots(self: *Self) *[3]T {
+            return &self.slots;
+        }
+    };
+}
@@ -0,0 +1,184 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const Vec2 = math.vec2;
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+
+const SelectionError = error{InvalidLasso};
+
+const lanes = std.simd.suggestVectorLength(f32) orelse 4;
+const VecN = @Vector(lanes, f32);
+const LaneMask = std.meta.Int(.unsigned, lanes);
+
+/// Lasso corner limit, lassos are convex so more corners add little
+pub const maxLassoCorners = 32;
+
+/// Drag selection of units on screen.
+///
+/// `project` transforms all unit positions with one view-projection matrix, a full vector of units at a time, and
+/// keeps their normalized device coordinates. Points behind the camera get NaN coordinates, so every following
+/// comparison rejects them without a separate mask. Rectangle and lasso tests then only compare the projected
+/// coordinates and append the indices of the units inside.
+pub const Selection = struct {
+    allocator: Allocator,
+    ndcX: std.ArrayList(f32), // padded to whole vectors
+    ndcY: std.ArrayList(f32),
+    count: usize = 0, // projected units
+
+    lastProjectNs: u64 = 0,
+    lastSelectNs: u64 = 0,
+
+    pub fn init(allocator: Allocator) Selection {
+        return .{
+            .allocator = allocator,
+            .ndcX = std.ArrayList(f32).init(allocator),
+            .ndcY = std.ArrayList(f32).init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *Selection) void {
+        self.ndcX.deinit();
+        self.ndcY.deinit();
+    }
+
+    /// Size buffers for up to `unitCount` units, `project` then does not allocate, e.g. inside the frame loop
+    pub fn reserve(self: *Selection, unitCount: usize) !void {
+        const padded = std.mem.alignForward(usize, unitCount, lanes);
+        try self.ndcX.ensureTotalCapacity(padded);
+        try self.ndcY.ensureTotalCapacity(padded);
+    }
+
+    /// Normalized device coordinates of pixel (`px`, `py`) on a `width` x `height` screen, y pointing up
+    pub fn ndcFromPixels(px: f32, py: f32, width: f32, height: f32) Vec2(f32) {
+        return .{ .x = px / width * 2 - 1, .y = 1 - py / height * 2 };
+    }
+
+    /// Project `positions` with the column-major `viewProjection` matrix. Unit i keeps index i in the selections.
+    pub fn project(self: *Selection, viewProjection: [16]f32, positions: []const Vec3(f32)) !void {
+        var timer = try std.time.Timer.start();
+        defer self.lastProjectNs = timer.read();
+
+        const padded = std.mem.alignForward(usize, positions.len, lanes);
+        try self.ndcX.resize(padded);
+        try self.ndcY.resize(padded);
+        self.count = positions.len;
+
+        const M = viewProjection;
+        const nan: VecN = @splat(std.math.nan(f32));
+        const zero: VecN = @splat(0);
+
+        var i: usize = 0;
+        while (i < padded) : (i += lanes) {
+            // ----- transpose a batch of positions, padding lanes take NaN -----
+            var x: [lanes]f32 = undefined;
+            var y: [lanes]f32 = undefined;
+            var z: [lanes]f32 = undefined;
+            for (0..lanes) |l| {
+                if (i + l < positions.len) {
+                    const p = positions[i + l];
+                    x[l] = p.x;
+                    y[l] = p.y;
+                    z[l] = p.z;
+                } else {
+                    x[l] = std.math.nan(f32);
+                    y[l] = std.math.nan(f32);
+                    z[l] = std.math.nan(f32);
+                }
+            }
+            const vx: VecN = x;
+            const vy: VecN = y;
+            const vz: VecN = z;
+
+            const cx = @as(VecN, @splat(M[0])) * vx + @as(VecN, @splat(M[4])) * vy + @as(VecN, @splat(M[8])) * vz + @as(VecN, @splat(M[12]));
+            const cy = @as(VecN, @splat(M[1])) * vx + @as(VecN, @splat(M[5])) * vy + @as(VecN, @splat(M[9])) * vz + @as(VecN, @splat(M[13]));
+            const cw = @as(VecN, @splat(M[3])) * vx + @as(VecN, @splat(M[7])) * vy + @as(VecN, @splat(M[11])) * vz + @as(VecN, @splat(M[15]));
+
+            const inFront = cw > zero;
+            self.ndcX.items[i..][0..lanes].* = @select(f32, inFront, cx / cw, nan);
+            self.ndcY.items[i..][0..lanes].* = @select(f32, inFront, cy / cw, nan);
+        }
+    }
+
+    /// Append indices of projected units inside the rectangle spanned by corners `a` and `b` (NDC, any order)
+    pub fn selectRect(self: *Selection, a: Vec2(f32), b: Vec2(f32), out: *std.ArrayList(u32)) !void {
+        var timer = try std.time.Timer.start();
+        defer self.lastSelectNs = timer.read();
+
+        const minX: VecN = @splat(@min(a.x, b.x));
+        const maxX: VecN = @splat(@max(a.x, b.x));
+        const minY: VecN = @splat(@min(a.y, b.y));
+        const maxY: VecN = @splat(@max(a.y, b.y));
+
+        var i: usize = 0;
+        while (i < self.ndcX.items.len) : (i += lanes) {
+            const x: VecN = self.ndcX.items[i..][0..lanes].*;
+            const y: VecN = self.ndcY.items[i..][0..lanes].*;
+            const inside = toMask(x >= minX) & toMask(x <= maxX) & toMask(y >= minY) & toMask(y <= maxY);
+            try appendLanes(out, inside, i);
+        }
+    }
+
+    /// Append indices of projected units inside the convex polygon `lasso` (NDC, either winding).
+    /// Units are first tested against the lasso's bounding rectangle, then against every edge.
+    pub fn selectLasso(self: *Selection, lasso: []const Vec2(f32), out: *std.ArrayList(u32)) !void {
+        if (lasso.len < 3 or lasso.len > maxLassoCorners) return SelectionError.InvalidLasso;
+        var timer = try std.time.Timer.start();
+        defer self.lastSelectNs = timer.read();
+
+        // ----- winding, inside is left of every edge for counter-clockwise lassos -----
+        var area2: f32 = 0;
+        var minCorner = lasso[0];
+        var maxCorner = lasso[0];
+        for (lasso, 0..) |p, k| {
+            const q = lasso[(k + 1) % lasso.len];
+            area2 += p.x * q.y - q.x * p.y;
+            minCorner = .{ .x = @min(minCorner.x, p.x), .y = @min(minCorner.y, p.y) };
+            maxCorner = .{ .x = @max(maxCorner.x, p.x), .y = @max(maxCorner.y, p.y) };
+        }
+        if (area2 == 0) return;
+        const sign: f32 = if (area2 > 0) 1 else -1;
+
+        // ----- edge equations: inside where nx * x + ny * y + c >= 0 -----
+        var nx: [maxLassoCorners]f32 = undefined;
+        var ny: [maxLassoCorners]f32 = undefined;
+        var c: [maxLassoCorners]f32 = undefined;
+        for (lasso, 0..) |p, k| {
+            const q = lasso[(k + 1) % lasso.len];
+            nx[k] = -(q.y - p.y) * sign;
+            ny[k] = (q.x - p.x) * sign;
+            c[k] = -(nx[k] * p.x + ny[k] * p.y);
+        }
+
+        const minX: VecN = @splat(minCorner.x);
+        const maxX: VecN = @splat(maxCorner.x);
+        const minY: VecN = @splat(minCorner.y);
+        const maxY: VecN = @splat(maxCorner.y);
+        const zero: VecN = @splat(0);
+
+        var i: usize = 0;
+        while (i < self.ndcX.items.len) : (i += lanes) {
+            const x: VecN = self.ndcX.items[i..][0..lanes].*;
+            const y: VecN = self.ndcY.items[i..][0..lanes].*;
+            var inside = toMask(x >= minX) & toMask(x <= maxX) & toMask(y >= minY) & toMask(y <= maxY);
+            for (0..lasso.len) |k| {
+                if (inside == 0) break;
+                const d = @as(VecN, @splat(nx[k])) * x + @as(VecN, @splat(ny[k])) * y + @as(VecN, @splat(c[k]));
+                inside &= toMask(d >= zero);
+            }
+            try appendLanes(out, inside, i);
+        }
+    }
+};
+
+inline fn toMask(v: @Vector(lanes, bool)) LaneMask {
+    return @bitCast(v);
+}
+
+/// Append `base` + index of every set lane of `mask`
+inline fn appendLanes(out: *std.ArrayList(u32), mask: LaneMask, base: usize) !void {
+    var m = mask;
+    while (m != 0) : (m &= m - 1) {
+        try out.append(@intCast(base + @ctz(m)));
+    }
+}
@@ -0,0 +1,152 @@
+const std = @import("std");
+
+const Allocator = std.mem.Allocator;
+const Alignment = std.mem.Alignment;
+
+// ======================================
+// Frame arena
+// ======================================
+
+/// Linear allocator for everything that lives at most one frame. Reset once per frame at `swapBuffers`.
+///
+/// Capacity is retained between frames, so after the first few frames the steady state does not touch the backing allocator.
+pub const FrameArena = struct {
+    arena: std.heap.ArenaAllocator,
+    frameCount: u64 = 0,
+    peakCapacity: usize = 0, // largest capacity ever reached
+
+    pub fn init(backing: Allocator) FrameArena {
+        return .{ .arena = std.heap.ArenaAllocator.init(backing) };
+    }
+
+    pub fn deinit(self: *FrameArena) void {
+        self.arena.deinit();
+    }
+
+    pub fn allocator(self: *FrameArena) Allocator {
+        return self.arena.allocator();
+    }
+
+    /// Invalidate all allocations of the current frame. Call after `swapBuffers`.
+    pub fn reset(self: *FrameArena) void {
+        self.peakCapacity = @max(self.peakCapacity, self.arena.queryCapacity());
+        _ = self.arena.reset(.retain_capacity);
+        self.frameCount += 1;
+    }
+};
+
+// ======================================
+// Heap guard
+// ======================================
+
+/// Set by `HeapGuard.beginFrame` on the thread running the frame loop. Other threads (loading, simulation) are not guarded.
+threadlocal var inFrame: bool = false;
+threadlocal var exemptDepth: u32 = 0;
+
+pub const GuardOptions = struct {
+    trap: bool = false, // panic on the first offending allocation instead of reporting it
+};
+
+/// Wraps the general-purpose allocator and reports every allocation that is made inside the frame scope (`beginFrame`..`endFrame`).
+///
+/// Each offending call site (return address) is reported once, with a stack trace. Offenders are stored in a fixed table
+/// so the guard itself never allocates.
+pub const HeapGuard = struct {
+    parent: Allocator,
+    options: GuardOptions,
+    mutex: std.Thread.Mutex = .{},
+
+    offenders: [maxOffenders]usize = undefined,
+    offenderCount: usize = 0,
+    offenceCount: usize = 0, // total number of allocations inside frame scope
+
+    const maxOffenders = 64;
+
+    pub fn init(parent: Allocator, options: GuardOptions) HeapGuard {
+        return .{ .parent = parent, .options = options };
+    }
+
+    pub fn allocator(self: *HeapGuard) Allocator {
+        return .{
+            .ptr = self,
+            .vtable = &.{
+                .alloc = alloc,
+                .resize = resize,
+                .remap = remap,
+                .free = free,
+            },
+        };
+    }
+
+    pub fn beginFrame(_: *HeapGuard) void {
+        inFrame = true;
+    }
+
+    pub fn endFrame(_: *HeapGuard) void {
+        inFrame = false;
+    }
+
+    /// Allow heap allocations on this thread until `unexempt`, e.g. for editor actions triggered from within the frame.
+    ///
+    /// Usage: `guard.exempt(); defer guard.unexempt();`
+    pub fn exempt(_: *HeapGuard) void {
+        exemptDepth += 1;
+    }
+
+    pub fn unexempt(_: *HeapGuard) void {
+        exemptDepth -= 1;
+    }
+
+    pub fn printSummary(self: *HeapGuard) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        std.debug.print("frame-scope heap allocations: {} from {} call site(s)\n", .{ self.offenceCount, self.offenderCount });
+    }
+
+    fn check(self: *HeapGuard, len: usize, ret_addr: usize) void {
+        if (!inFrame or exemptDepth > 0) return;
+        if (self.options.trap) std.debug.panic("heap allocation of {} bytes inside frame scope", .{len});
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        self.offenceCount += 1;
+        for (self.offenders[0..self.offenderCount]) |known| {
+            if (known == ret_addr) return;
+        }
+        if (self.offenderCount < maxOffenders) {
+            self.offenders[self.offenderCount] = ret_addr;
+            self.offenderCount += 1;
+        }
+
+        std.debug.print("\n===== Heap allocation of {} bytes inside frame scope =====\n", .{len});
+        std.debug.dumpCurrentStackTrace(ret_addr);
+    }
+
+    // ======================================
+    // Allocator vtable
+    // ======================================
+
+    fn alloc(ctx: *anyopaque, len: usize, alignment: Alignment, ret_addr: usize) ?[*]u8 {
+        const self: *HeapGuard = @ptrCast(@alignCast(ctx));
+        self.check(len, ret_addr);
+        return self.parent.rawAlloc(len, alignment, ret_addr);
+    }
+
+    fn resize(ctx: *anyopaque, memory: []u8, alignment: Alignment, new_len: usize, ret_addr: usize) bool {
+        const self: *HeapGuard = @ptrCast(@alignCast(ctx));
+        if (new_len > memory.len) self.check(new_len - memory.len, ret_addr);
+        return self.parent.rawResize(memory, alignment, new_len, ret_addr);
+    }
+
+    fn remap(ctx: *anyopaque, memory: []u8, alignment: Alignment, new_len: usize, ret_addr: usize) ?[*]u8 {
+        const self: *HeapGuard = @ptrCast(@alignCast(ctx));
+        if (new_len > memory.len) self.check(new_len - memory.len, ret_addr);
+        return self.parent.rawRemap(memory, alignment, new_len, ret_addr);
+    }
+
+    fn free(ctx: *anyopaque, memory: []u8, alignment: Alignment, ret_addr: usize) void {
+        const self: *HeapGuard = @ptrCast(@alignCast(ctx));
+        self.parent.rawFree(memory, alignment, ret_addr);
+    }
+};
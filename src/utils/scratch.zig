@@ -0,0 +1,153 @@
+const std = @import("std");
+
+const Allocator = std.mem.Allocator;
+const Alignment = std.mem.Alignment;
+
+/// Linear allocator for temporaries of a single pipeline stage (import, a single split, half-edge construction, ...).
+///
+/// Individual frees are (mostly) no-ops. A stage takes a `mark` on entry and `restore`s it on exit, which releases
+/// what it allocated without touching memory of its callers. Full `reset`s are left to top-level owners (main, benches).
+/// Released chunks are retained, such that the next stage does not have to go to the backing allocator again.
+///
+/// Usage: `const mark = scratch.mark(); defer scratch.restore(mark);`
+pub const ScratchArena = struct {
+    backing: Allocator,
+    chunks: std.ArrayListUnmanaged([]u8) = .{},
+    chunk: usize = 0, // chunk allocations are served from
+    end: usize = 0, // first unused byte of `chunks[chunk]`
+
+    /// Position to return to with `restore`
+    pub const Mark = struct { chunk: usize, end: usize };
+
+    const minChunkSize = 64 * 1024;
+
+    pub fn init(backing: Allocator) ScratchArena {
+        return .{ .backing = backing };
+    }
+
+    pub fn deinit(self: *ScratchArena) void {
+        for (self.chunks.items) |buffer| self.backing.free(buffer);
+        self.chunks.deinit(self.backing);
+    }
+
+    pub fn allocator(self: *ScratchArena) Allocator {
+        return .{
+            .ptr = self,
+            .vtable = &.{
+                .alloc = alloc,
+                .resize = resize,
+                .remap = remap,
+                .free = free,
+            },
+        };
+    }
+
+    pub fn mark(self: ScratchArena) Mark {
+        return .{ .chunk = self.chunk, .end = self.end };
+    }
+
+    /// Invalidate all allocations made since `m` was taken, retaining capacity
+    pub fn restore(self: *ScratchArena, m: Mark) void {
+        std.debug.assert(m.chunk < self.chunk or (m.chunk == self.chunk and m.end <= self.end)); // marks restore in reverse order
+        self.chunk = m.chunk;
+        self.end = m.end;
+    }
+
+    /// Invalidate all allocations, retaining capacity. Only for the owner of the arena, stages `restore` their mark.
+    pub fn reset(self: *ScratchArena) void {
+        self.chunk = 0;
+        self.end = 0;
+    }
+
+    /// Bytes currently reserved from the backing allocator
+    pub fn capacity(self: ScratchArena) usize {
+        var total: usize = 0;
+        for (self.chunks.items) |buffer| total += buffer.len;
+        return total;
+    }
+
+    // ======================================
+    // Allocator vtable
+    // ======================================
+
+    fn alloc(ctx: *anyopaque, len: usize, alignment: Alignment, ret_addr: usize) ?[*]u8 {
+        _ = ret_addr;
+        const self: *ScratchArena = @ptrCast(@alignCast(ctx));
+
+        // ----- current chunk, then the retained chunks after it -----
+        while (self.chunk < self.chunks.items.len) : ({
+            self.chunk += 1;
+            self.end = 0;
+        }) {
+            const buffer = self.chunks.items[self.chunk];
+            const start = alignment.forward(@intFromPtr(buffer.ptr) + self.end) - @intFromPtr(buffer.ptr);
+            if (start + len <= buffer.len) {
+                self.end = start + len;
+                return buffer.ptr + start;
+            }
+        }
+
+        // ----- new chunk, at least half of what is reserved already -----
+        const last = if (self.chunks.items.len > 0) self.chunks.items[self.chunks.items.len - 1].len else 0;
+        const size = @max(minChunkSize, len + alignment.toByteUnits(), last + last / 2);
+        const buffer = self.backing.alloc(u8, size) catch return null;
+        self.chunks.append(self.backing, buffer) catch {
+            self.backing.free(buffer);
+            return null;
+        };
+        self.chunk = self.chunks.items.len - 1;
+        const start = alignment.forward(@intFromPtr(buffer.ptr)) - @intFromPtr(buffer.ptr);
+        self.end = start + len;
+        return buffer.ptr + start;
+    }
+
+    fn resize(ctx: *anyopaque, memory: []u8, alignment: Alignment, new_len: usize, ret_addr: usize) bool {
+        _ = alignment;
+        _ = ret_addr;
+        const self: *ScratchArena = @ptrCast(@alignCast(ctx));
+        const start = self.lastStart(memory) orelse return new_len <= memory.len;
+        if (start + new_len > self.chunks.items[self.chunk].len) return false;
+        self.end = start + new_len;
+        return true;
+    }
+
+    fn remap(ctx: *anyopaque, memory: []u8, alignment: Alignment, new_len: usize, ret_addr: usize) ?[*]u8 {
+        return if (resize(ctx, memory, alignment, new_len, ret_addr)) memory.ptr else null;
+    }
+
+    fn free(ctx: *anyopaque, memory: []u8, alignment: Alignment, ret_addr: usize) void {
+        _ = alignment;
+        _ = ret_addr;
+        const self: *ScratchArena = @ptrCast(@alignCast(ctx));
+        if (self.lastStart(memory)) |start| self.end = start;
+    }
+
+    /// Offset of `memory` in the current chunk if it is the most recent allocation, only that one can grow or shrink
+    fn lastStart(self: *ScratchArena, memory: []u8) ?usize {
+        if (self.chunk >= self.chunks.items.len) return null;
+        const base = @intFromPtr(self.chunks.items[self.chunk].ptr);
+        const address = @intFromPtr(memory.ptr);
+        if (address < base or address - base + memory.len != self.end) return null;
+        return address - base;
+    }
+};
+
+// ======================================
+// Thread-local instances
+// ======================================
+
+threadlocal var threadArena: ?ScratchArena = null;
+
+/// Returns scratch arena of the calling thread. Created on first use with `backing` as backing allocator.
+///
+/// Every thread working on a parallel stage gets its own instance -> no locking.
+pub fn threadScratch(backing: Allocator) *ScratchArena {
+    if (threadArena == null) threadArena = ScratchArena.init(backing);
+    return &threadArena.?;
+}
+
+/// Release the scratch arena of the calling thread. Call before the backing allocator is deinitialized / the thread exits.
+pub fn deinitThreadScratch() void {
+    if (threadArena) |*arena| arena.deinit();
+    threadArena = null;
+}
@@ -0,0 +1,264 @@
+const std = @import("std");
+
+const Allocator = std.mem.Allocator;
+const Alignment = std.mem.Alignment;
+
+// ======================================
+// Subsystem tagging
+// ======================================
+
+/// Subsystems allocations can be attributed to. `other` catches everything outside a tagged scope.
+pub const Subsystem = enum(u8) {
+    other,
+    import,
+    chunking,
+    simplification,
+    map,
+    wrapper, // output buffers of the eigen wrapper kernels
+};
+
+const subsystemCount = @typeInfo(Subsystem).@"enum".fields.len;
+
+/// Subsystem that new allocations on this thread are attributed to.
+threadlocal var currentSubsystem: Subsystem = .other;
+
+/// Attribute allocations on this thread to `subsystem` until `leave` is called. Returns the previous subsystem.
+///
+/// Usage: `const prev = tracking.enter(.import); defer tracking.leave(prev);`
+pub fn enter(subsystem: Subsystem) Subsystem {
+    const prev = currentSubsystem;
+    currentSubsystem = subsystem;
+    return prev;
+}
+
+/// Restore subsystem returned by `enter`
+pub fn leave(prev: Subsystem) void {
+    currentSubsystem = prev;
+}
+
+// ======================================
+// Structs
+// ======================================
+
+/// Allocation counters of a single subsystem
+pub const Stats = struct {
+    liveBytes: usize = 0,
+    peakBytes: usize = 0,
+    allocCount: usize = 0,
+    freeCount: usize = 0,
+    resizeCount: usize = 0, // successful in-place resizes and remaps
+    remapMoves: usize = 0, // remaps which moved memory to a new address
+    reallocBytes: usize = 0, // absolute byte-difference of all resizes -> realloc traffic
+    failedCount: usize = 0,
+};
+
+pub const EventKind = enum(u8) { alloc, resize, free };
+
+/// Single entry in the optional allocation timeline
+pub const TimelineEvent = struct {
+    timeNs: u64,
+    subsystem: Subsystem,
+    kind: EventKind,
+    bytes: isize, // change in live bytes
+    liveTotal: usize, // live bytes of all subsystems after the event
+};
+
+pub const TrackingOptions = struct {
+    timeline: bool = false, // record every allocation event for `dumpTimeline`
+};
+
+/// Wraps `parent` and attributes every allocation to the subsystem active on the calling thread (see `enter`).
+/// Frees and resizes are attributed to the subsystem which made the original allocation.
+///
+/// Bookkeeping is done with `parent` directly, so it never shows up in the statistics.
+pub const TrackingAllocator = struct {
+    parent: Allocator,
+    mutex: std.Thread.Mutex = .{},
+
+    stats: [subsystemCount]Stats = .{Stats{}} ** subsystemCount,
+    liveTotal: usize = 0,
+    peakTotal: usize = 0,
+
+    owners: std.AutoHashMapUnmanaged(usize, Subsystem) = .{}, // address -> allocating subsystem
+    timeline: ?std.ArrayListUnmanaged(TimelineEvent) = null,
+    timer: std.time.Timer,
+
+    pub fn init(parent: Allocator, options: TrackingOptions) !TrackingAllocator {
+        return .{
+            .parent = parent,
+            .timeline = if (options.timeline) .{} else null,
+            .timer = try std.time.Timer.start(),
+        };
+    }
+
+    pub fn deinit(self: *TrackingAllocator) void {
+        self.owners.deinit(self.parent);
+        if (self.timeline) |*timeline| timeline.deinit(self.parent);
+    }
+
+    pub fn allocator(self: *TrackingAllocator) Allocator {
+        return .{
+            .ptr = self,
+            .vtable = &.{
+                .alloc = alloc,
+                .resize = resize,
+                .remap = remap,
+                .free = free,
+            },
+        };
+    }
+
+    /// Returns counters of `subsystem`
+    pub fn subsystemStats(self: *TrackingAllocator, subsystem: Subsystem) Stats {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        return self.stats[@intFromEnum(subsystem)];
+    }
+
+    /// Returns counters of all subsystems, indexed by `@intFromEnum(Subsystem)`
+    pub fn summary(self: *TrackingAllocator) [subsystemCount]Stats {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        return self.stats;
+    }
+
+    /// Reset peak values to current live values, e.g. between pipeline stages
+    pub fn resetPeaks(self: *TrackingAllocator) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        for (&self.stats) |*s| s.peakBytes = s.liveBytes;
+        self.peakTotal = self.liveTotal;
+    }
+
+    pub fn printSummary(self: *TrackingAllocator) void {
+        // ----- one consistent snapshot, other threads may still allocate -----
+        self.mutex.lock();
+        const stats = self.stats;
+        const liveTotal = self.liveTotal;
+        const peakTotal = self.peakTotal;
+        self.mutex.unlock();
+
+        std.debug.print("\n===== Memory per subsystem =====\n", .{});
+        std.debug.print("{s:<15} | {s:>12} | {s:>12} | {s:>10} | {s:>10} | {s:>10} | {s:>14}\n", .{ "Subsystem", "Live", "Peak", "Allocs", "Frees", "Resizes", "Realloc bytes" });
+        for (stats, 0..) |s, i| {
+            const name = @tagName(@as(Subsystem, @enumFromInt(i)));
+            std.debug.print("{s:<15} | {d:>12} | {d:>12} | {d:>10} | {d:>10} | {d:>10} | {d:>14}\n", .{ name, s.liveBytes, s.peakBytes, s.allocCount, s.freeCount, s.resizeCount, s.reallocBytes });
+        }
+        std.debug.print("total live/peak: {}/{}\n", .{ liveTotal, peakTotal });
+    }
+
+    /// Write timeline as CSV (`time_ns,subsystem,kind,bytes,live_total`). Does nothing if timeline is disabled.
+    pub fn dumpTimeline(self: *TrackingAllocator, writer: anytype) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const timeline = self.timeline orelse return;
+        try writer.writeAll("time_ns,subsystem,kind,bytes,live_total\n");
+        for (timeline.items) |event| {
+            try writer.print("{},{s},{s},{},{}\n", .{ event.timeNs, @tagName(event.subsystem), @tagName(event.kind), event.bytes, event.liveTotal });
+        }
+    }
+
+    // ======================================
+    // Allocator vtable
+    // ======================================
+
+    fn alloc(ctx: *anyopaque, len: usize, alignment: Alignment, ret_addr: usize) ?[*]u8 {
+        const self: *TrackingAllocator = @ptrCast(@alignCast(ctx));
+        const subsystem = currentSubsystem;
+
+        const result = self.parent.rawAlloc(len, alignment, ret_addr);
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const s = &self.stats[@intFromEnum(subsystem)];
+        const ptr = result orelse {
+            s.failedCount += 1;
+            return null;
+        };
+        self.owners.put(self.parent, @intFromPtr(ptr), subsystem) catch {}; // untracked owner falls back to `other` on free
+        s.allocCount += 1;
+        self.record(subsystem, .alloc, @intCast(len));
+        return ptr;
+    }
+
+    fn resize(ctx: *anyopaque, memory: []u8, alignment: Alignment, new_len: usize, ret_addr: usize) bool {
+        const self: *TrackingAllocator = @ptrCast(@alignCast(ctx));
+        if (!self.parent.rawResize(memory, alignment, new_len, ret_addr)) return false;
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const subsystem = self.owners.get(@intFromPtr(memory.ptr)) orelse .other;
+        self.countResize(subsystem, memory.len, new_len);
+        return true;
+    }
+
+    fn remap(ctx: *anyopaque, memory: []u8, alignment: Alignment, new_len: usize, ret_addr: usize) ?[*]u8 {
+        const self: *TrackingAllocator = @ptrCast(@alignCast(ctx));
+
+        // ----- a move frees the old address: re-key it before another thread can be handed that address -----
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        const result = self.parent.rawRemap(memory, alignment, new_len, ret_addr) orelse return null;
+
+        const subsystem = self.owners.get(@intFromPtr(memory.ptr)) orelse .other;
+        if (result != memory.ptr) {
+            _ = self.owners.remove(@intFromPtr(memory.ptr));
+            self.owners.put(self.parent, @intFromPtr(result), subsystem) catch {};
+            self.stats[@intFromEnum(subsystem)].remapMoves += 1;
+        }
+        self.countResize(subsystem, memory.len, new_len);
+        return result;
+    }
+
+    fn free(ctx: *anyopaque, memory: []u8, alignment: Alignment, ret_addr: usize) void {
+        const self: *TrackingAllocator = @ptrCast(@alignCast(ctx));
+
+        // ----- owner entry goes first, once freed the address can be handed to another thread -----
+        {
+            self.mutex.lock();
+            defer self.mutex.unlock();
+
+            const subsystem = if (self.owners.fetchRemove(@intFromPtr(memory.ptr))) |kv| kv.value else .other;
+            self.stats[@intFromEnum(subsystem)].freeCount += 1;
+            self.record(subsystem, .free, -@as(isize, @intCast(memory.len)));
+        }
+        self.parent.rawFree(memory, alignment, ret_addr);
+    }
+
+    // ======================================
+    // Bookkeeping (mutex must be held)
+    // ======================================
+
+    fn countResize(self: *TrackingAllocator, subsystem: Subsystem, old_len: usize, new_len: usize) void {
+        const s = &self.stats[@intFromEnum(subsystem)];
+        s.resizeCount += 1;
+        s.reallocBytes += if (new_len > old_len) new_len - old_len else old_len - new_len;
+        self.record(subsystem, .resize, @as(isize, @intCast(new_len)) - @as(isize, @intCast(old_len)));
+    }
+
+    fn record(self: *TrackingAllocator, subsystem: Subsystem, kind: EventKind, bytes: isize) void {
+        const s = &self.stats[@intFromEnum(subsystem)];
+
+        // ----- live/peak per subsystem -----
+        s.liveBytes = @intCast(@max(@as(isize, @intCast(s.liveBytes)) + bytes, 0));
+        s.peakBytes = @max(s.peakBytes, s.liveBytes);
+
+        // ----- live/peak total -----
+        self.liveTotal = @intCast(@max(@as(isize, @intCast(self.liveTotal)) + bytes, 0));
+        self.peakTotal = @max(self.peakTotal, self.liveTotal);
+
+        // ----- timeline -----
+        if (self.timeline) |*timeline| {
+            timeline.append(self.parent, .{
+                .timeNs = self.timer.read(),
+                .subsystem = subsystem,
+                .kind = kind,
+                .bytes = bytes,
+                .liveTotal = self.liveTotal,
+            }) catch {};
+        }
+    }
+};
@@ -0,0 +1,374 @@
+const std = @import("std");
+
+const SimMap = @import("sim_map.zig").SimMap;
+const Allocator = std.mem.Allocator;
+
+const FogOfWarError = error{ InvalidTeam, SightTooLarge };
+
+/// Sight radius limit in cells, a unit's sight window (2r + 1 cells) fits in a single 64 bit row mask
+pub const maxSight = 31;
+const windowSize = 2 * maxSight + 1;
+
+/// Ticks since last seen are counted in `ageBits` bit planes, saturating at `maxAge` (also: never seen)
+pub const ageBits = 4;
+pub const maxAge = (1 << ageBits) - 1;
+
+const lanes = std.simd.suggestVectorLength(u64) orelse 4;
+const VecN = @Vector(lanes, u64);
+
+/// Rows of a unit's visible cells, bit `ox + sight` of row `oz + sight` is cell (x + ox, z + oz)
+const Stamp = [windowSize]u64;
+
+const FogUnit = struct {
+    team: u8,
+    sight: u8, // radius in cells
+    cellX: i32,
+    cellZ: i32,
+    active: bool = true,
+};
+
+/// Bit-packed visibility of one team over the map cells
+const TeamGrid = struct {
+    visible: []u64, // seen this update
+    explored: []u64, // seen at any time
+    age: [ageBits][]u64, // bit planes of ticks since last seen
+    changed: bool = true, // a unit of this team moved, appeared or disappeared
+};
+
+const RayStep = struct {
+    dx: i8,
+    dz: i8,
+    distance: f32, // in cells
+};
+
+/// Steps of the rays from a center cell to every cell on the border of its sight square, within the sight circle
+const RayTable = struct {
+    steps: []RayStep,
+    rayStarts: []u32, // [ray] -> first step, one extra entry at the end
+};
+
+/// Per-team fog of war on the `SimMap` cell grid.
+///
+/// Every unit keeps a stamp of the cells it sees: rays are cast from its eye over the heightfield to the border of its
+/// sight square, and a cell is visible while it is not below the steepest horizon seen so far along the ray. Stamps are
+/// recomputed only for units which changed cell; `update` ORs the stamps of a team into its grid and ages the
+/// last-seen counters of all cells with wide bit operations.
+pub const FogOfWar = struct {
+    allocator: Allocator,
+    map: *const SimMap,
+    eyeHeight: f32, // above terrain, also the height of units being seen
+
+    wordsPerRow: usize,
+    teams: []TeamGrid,
+
+    units: std.ArrayList(FogUnit),
+    stamps: std.ArrayList(Stamp),
+    dirty: std.ArrayList(u32), // units whose stamp is outdated
+    isDirty: std.ArrayList(bool),
+    rayTables: [maxSight + 1]?RayTable = .{null} ** (maxSight + 1),
+
+    stampsRecomputed: usize = 0, // by the last `update`
+    lastUpdateNs: u64 = 0,
+
+    pub fn init(allocator: Allocator, map: *const SimMap, teamCount: u8, eyeHeight: f32) !FogOfWar {
+        const wordsPerRow = (map.resolution.x + 63) / 64;
+        const wordCount = std.mem.alignForward(usize, wordsPerRow * map.resolution.y, lanes); // whole vectors
+
+        const teams = try allocator.alloc(TeamGrid, teamCount);
+        var created: usize = 0;
+        errdefer {
+            for (teams[0..created]) |team| freeTeam(allocator, team);
+            allocator.free(teams);
+        }
+        for (teams) |*team| {
+            team.* = .{ .visible = &.{}, .explored = &.{}, .age = [_][]u64{&.{}} ** ageBits };
+            errdefer freeTeam(allocator, team.*);
+            team.visible = try allocator.alloc(u64, wordCount);
+            team.explored = try allocator.alloc(u64, wordCount);
+            @memset(team.visible, 0);
+            @memset(team.explored, 0);
+            for (&team.age) |*plane| {
+                plane.* = try allocator.alloc(u64, wordCount);
+                @memset(plane.*, std.math.maxInt(u64)); // never seen
+            }
+            created += 1;
+        }
+
+        return .{
+            .allocator = allocator,
+            .map = map,
+            .eyeHeight = eyeHeight,
+            .wordsPerRow = wordsPerRow,
+            .teams = teams,
+            .units = std.ArrayList(FogUnit).init(allocator),
+            .stamps = std.ArrayList(Stamp).init(allocator),
+            .dirty = std.ArrayList(u32).init(allocator),
+            .isDirty = std.ArrayList(bool).init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *FogOfWar) void {
+        for (self.teams) |team| freeTeam(self.allocator, team);
+        self.allocator.free(self.teams);
+        self.units.deinit();
+        self.stamps.deinit();
+        self.dirty.deinit();
+        self.isDirty.deinit();
+        for (self.rayTables) |table| {
+            if (table) |t| {
+                self.allocator.free(t.steps);
+                self.allocator.free(t.rayStarts);
+            }
+        }
+    }
+
+    fn freeTeam(allocator: Allocator, team: TeamGrid) void {
+        allocator.free(team.visible);
+        allocator.free(team.explored);
+        for (team.age) |plane| allocator.free(plane);
+    }
+
+    // ======================================
+    // Units
+    // ======================================
+
+    /// Add a unit of `team` seeing `sight` cells far, returns its id
+    pub fn addUnit(self: *FogOfWar, team: u8, sight: u8, x: f32, z: f32) !u32 {
+        if (team >= self.teams.len) return FogOfWarError.InvalidTeam;
+        if (sight > maxSight) return FogOfWarError.SightTooLarge;
+        try self.ensureRayTable(sight);
+
+        const id: u32 = @intCast(self.units.items.len);
+        const cell = self.cellOf(x, z);
+        try self.units.append(.{ .team = team, .sight = sight, .cellX = cell[0], .cellZ = cell[1] });
+        try self.stamps.append(undefined);
+        try self.isDirty.append(false);
+        try self.markDirty(id);
+        return id;
+    }
+
+    /// Move unit `id` to (`x`, `z`). Its stamp is only recomputed if it changed cell.
+    pub fn moveUnit(self: *FogOfWar, id: u32, x: f32, z: f32) !void {
+        const unit = &self.units.items[id];
+        const cell = self.cellOf(x, z);
+        if (cell[0] == unit.cellX and cell[1] == unit.cellZ) return;
+        unit.cellX = cell[0];
+        unit.cellZ = cell[1];
+        try self.markDirty(id);
+    }
+
+    /// Unit stops contributing to the visibility of its team. The id is not reused.
+    pub fn removeUnit(self: *FogOfWar, id: u32) void {
+        const unit = &self.units.items[id];
+        if (!unit.active) return;
+        unit.active = false;
+        self.teams[unit.team].changed = true;
+    }
+
+    fn markDirty(self: *FogOfWar, id: u32) !void {
+        self.teams[self.units.items[id].team].changed = true;
+        if (self.isDirty.items[id]) return;
+        try self.dirty.append(id);
+        self.isDirty.items[id] = true;
+    }
+
+    /// Cell coordinates of (`x`, `z`), clamped to the map
+    fn cellOf(self: FogOfWar, x: f32, z: f32) [2]i32 {
+        const map = self.map;
+        const fx = @floor((x - map.origin.x) / map.cellSize.x);
+        const fz = @floor((z - map.origin.z) / map.cellSize.y);
+        const maxX: f32 = @floatFromInt(map.resolution.x - 1);
+        const maxZ: f32 = @floatFromInt(map.resolution.y - 1);
+        return .{
+            @intFromFloat(if (fx > 0) @min(fx, maxX) else 0), // also catches NaN
+            @intFromFloat(if (fz > 0) @min(fz, maxZ) else 0),
+        };
+    }
+
+    // ======================================
+    // Update
+    // ======================================
+
+    /// Recompute stamps of moved units, rebuild the grids of changed teams and age all grids by one tick
+    pub fn update(self: *FogOfWar) !void {
+        var timer = try std.time.Timer.start();
+
+        // ----- line of sight, only for units which changed cell -----
+        for (self.dirty.items) |id| {
+            self.isDirty.items[id] = false;
+            const unit = self.units.items[id];
+            if (unit.active) self.computeStamp(unit, &self.stamps.items[id]);
+        }
+        self.stampsRecomputed = self.dirty.items.len;
+        self.dirty.clearRetainingCapacity();
+
+        // ----- merge stamps of changed teams -----
+        for (self.teams) |*team| {
+            if (team.changed) @memset(team.visible, 0);
+        }
+        for (self.units.items, self.stamps.items) |unit, *stamp| {
+            const team = &self.teams[unit.team];
+            if (unit.active and team.changed) self.mergeStamp(team.visible, unit, stamp);
+        }
+
+        // ----- explored and last seen counters -----
+        for (self.teams) |*team| {
+            team.changed = false;
+            ageGrid(team);
+        }
+        self.lastUpdateNs = timer.read();
+    }
+
+    /// Cast rays from the unit's eye, marking cells which rise above the horizon of everything in front of them
+    fn computeStamp(self: FogOfWar, unit: FogUnit, stamp: *Stamp) void {
+        const map = self.map;
+        const row = map.resolution.x;
+        const resX: i32 = @intCast(map.resolution.x);
+        const resZ: i32 = @intCast(map.resolution.y);
+        const r: u6 = @intCast(unit.sight);
+
+        @memset(stamp[0 .. 2 * @as(usize, r) + 1], 0);
+        stamp[r] = @as(u64, 1) << r; // own cell
+        const eye = map.heights[@as(usize, @intCast(unit.cellZ)) * row + @as(usize, @intCast(unit.cellX))] + self.eyeHeight;
+
+        const table = self.rayTables[r].?;
+        for (0..table.rayStarts.len - 1) |ray| {
+            var horizon = -std.math.inf(f32); // steepest slope from the eye along this ray so far
+            for (table.steps[table.rayStarts[ray]..table.rayStarts[ray + 1]]) |s| {
+                const x = unit.cellX + s.dx;
+                const z = unit.cellZ + s.dz;
+                if (x < 0 or z < 0 or x >= resX or z >= resZ) break;
+
+                const h = map.heights[@as(usize, @intCast(z)) * row + @as(usize, @intCast(x))];
+                if ((h + self.eyeHeight - eye) / s.distance >= horizon) {
+                    stamp[@intCast(@as(i32, s.dz) + r)] |= @as(u64, 1) << @intCast(@as(i32, s.dx) + r);
+                }
+                horizon = @max(horizon, (h - eye) / s.distance);
+            }
+        }
+    }
+
+    /// OR the stamp of `unit` into the bit rows of `visible`
+    fn mergeStamp(self: FogOfWar, visible: []u64, unit: FogUnit, stamp: *const Stamp) void {
+        const r: i32 = unit.sight;
+        const resZ: i32 = @intCast(self.map.resolution.y);
+        const x0 = unit.cellX - r;
+
+        for (stamp[0..@intCast(2 * r + 1)], 0..) |rowMask, j| {
+            const z = unit.cellZ - r + @as(i32, @intCast(j));
+            if (z < 0 or z >= resZ or rowMask == 0) continue;
+
+            // ----- clip the window at the left map border -----
+            var mask = rowMask;
+            var base: usize = 0;
+            if (x0 < 0) mask >>= @intCast(-x0) else base = @intCast(x0);
+
+            const words = visible[@as(usize, @intCast(z)) * self.wordsPerRow ..][0..self.wordsPerRow];
+            const word = base / 64;
+            const shift: u6 = @intCast(base % 64);
+            words[word] |= mask << shift;
+            if (shift != 0 and word + 1 < words.len) words[word + 1] |= mask >> @intCast(64 - @as(u7, shift));
+        }
+    }
+
+    /// Add visible cells to explored and count ticks since last seen: reset where visible, saturating increment
+    /// elsewhere. The counter is bit-sliced over the age planes, so every lane ages 64 cells at once.
+    fn ageGrid(team: *TeamGrid) void {
+        var i: usize = 0;
+        while (i < team.visible.len) : (i += lanes) {
+            const visible: VecN = team.visible[i..][0..lanes].*;
+            const explored: VecN = team.explored[i..][0..lanes].*;
+            team.explored[i..][0..lanes].* = explored | visible;
+
+            var saturated: VecN = @splat(std.math.maxInt(u64));
+            inline for (team.age) |plane| saturated &= plane[i..][0..lanes].*;
+
+            var carry = ~saturated;
+            inline for (team.age) |plane| {
+                const bits: VecN = plane[i..][0..lanes].*;
+                plane[i..][0..lanes].* = (bits ^ carry) & ~visible;
+                carry &= bits;
+            }
+        }
+    }
+
+    /// Build the rays for sight radius `r`: one ray per border cell of the (2r + 1)² square, stepping one cell along the
+    /// major axis at a time and stopping at the sight circle
+    fn ensureRayTable(self: *FogOfWar, r: u8) !void {
+        if (self.rayTables[r] != null) return;
+
+        var steps = std.ArrayList(RayStep).init(self.allocator);
+        defer steps.deinit();
+        var rayStarts = std.ArrayList(u32).init(self.allocator);
+        defer rayStarts.deinit();
+
+        const ri: i32 = r;
+        const rf: f32 = @floatFromInt(r);
+        var k: i32 = -ri;
+        while (k <= ri) : (k += 1) {
+            // ----- border cells, corners once -----
+            const border = [_][2]i32{ .{ k, -ri }, .{ k, ri }, .{ -ri, k }, .{ ri, k } };
+            for (border, 0..) |target, side| {
+                if (side >= 2 and (k == -ri or k == ri)) continue;
+                try rayStarts.append(@intCast(steps.items.len));
+
+                const tx: f32 = @floatFromInt(target[0]);
+                const tz: f32 = @floatFromInt(target[1]);
+                for (1..@as(usize, r) + 1) |s| {
+                    const t = @as(f32, @floatFromInt(s)) / rf;
+                    const dx: i8 = @intFromFloat(@round(tx * t));
+                    const dz: i8 = @intFromFloat(@round(tz * t));
+                    const distance = @sqrt(@as(f32, @floatFromInt(@as(i32, dx) * dx + @as(i32, dz) * dz)));
+                    if (distance > rf + 0.5) break;
+                    try steps.append(.{ .dx = dx, .dz = dz, .distance = distance });
+                }
+            }
+        }
+        try rayStarts.append(@intCast(steps.items.len));
+
+        const ownedSteps = try steps.toOwnedSlice();
+        errdefer self.allocator.free(ownedSteps);
+        self.rayTables[r] = .{ .steps = ownedSteps, .rayStarts = try rayStarts.toOwnedSlice() };
+    }
+
+    // ======================================
+    // Queries
+    // ======================================
+
+    fn bitIndex(self: FogOfWar, x: f32, z: f32) ?usize {
+        const i = self.map.cellIndex(x, z) orelse return null;
+        const cx = i % self.map.resolution.x;
+        const cz = i / self.map.resolution.x;
+        return cz * self.wordsPerRow * 64 + cx;
+    }
+
+    fn testBit(words: []const u64, bit: usize) bool {
+        return (words[bit / 64] >> @intCast(bit % 64)) & 1 != 0;
+    }
+
+    /// World position (`x`, `z`) is seen by `team` since the last `update`
+    pub fn isVisible(self: FogOfWar, team: u8, x: f32, z: f32) bool {
+        const bit = self.bitIndex(x, z) orelse return false;
+        return testBit(self.teams[team].visible, bit);
+    }
+
+    pub fn isExplored(self: FogOfWar, team: u8, x: f32, z: f32) bool {
+        const bit = self.bitIndex(x, z) orelse return false;
+        return testBit(self.teams[team].explored, bit);
+    }
+
+    /// Updates since `team` last saw (`x`, `z`), `maxAge` if long ago or never
+    pub fn ticksSinceSeen(self: FogOfWar, team: u8, x: f32, z: f32) u8 {
+        const bit = self.bitIndex(x, z) orelse return maxAge;
+        var age: u8 = 0;
+        inline for (self.teams[team].age, 0..) |plane, b| {
+            if (testBit(plane, bit)) age |= 1 << b;
+        }
+        return age;
+    }
+
+    /// Visible bits of `team`, `wordsPerRow` words per map row, e.g. for uploading a fog texture
+    pub fn visibleRows(self: FogOfWar, team: u8) []const u64 {
+        return self.teams[team].visible[0 .. self.wordsPerRow * self.map.resolution.y];
+    }
+};
@@ -4,13 +4,17 @@ const math = @import("../math.zig");
 
 const fImport = @import("../mesh/import_files.zig");
 const mProc = @import("../mesh/processing.zig");
+const tracking = @import("../utils/tracking_allocator.zig");
+const scratch_arena = @import("../utils/scratch.zig");
 
-const inView = @import("../main.zig").inview;
+const bounding_volumes = @import("../mesh/bounding_volumes.zig");
 
 const Vec2 = math.vec2;
 const Vec3 = math.vec3;
 const Allocator = std.mem.Allocator;
 const BoundingBox = mProc.BoundingBox;
+const BoundingVolume = bounding_volumes.BoundingVolume;
+const Frustum = bounding_volumes.Frustum;
 
 pub const MapConfig = struct{
     xsize:f32 = null,
@@ -27,6 +31,7 @@ pub const Map = struct {
     model: *zune.graphics.Model,
     positions: []Vec3(f32),
     boundingBoxes: []BoundingBox,
+    volumes: []BoundingVolume, // tightest cheap volume per chunk, used for view culling
 
     inView: []bool,
     loaded: []bool,
@@ -38,9 +43,11 @@ pub const Map = struct {
     
     pub fn init(resource_manager: *zune.graphics.ResourceManager, objFileLoc: []const u8, camera: *zune.graphics.Camera, material: *zune.graphics.Material, size: Vec3(f32), chunking: Vec2(usize), mapName: []const u8) !Map {
         const allocator = resource_manager.allocator;
+        const prevSubsystem = tracking.enter(.map);
+        defer tracking.leave(prevSubsystem);
         
         // ===== load and chunk mesh =====
-        var phMapMesh = try fImport.importPHMeshObj(resource_manager, objFileLoc);
+        var phMapMesh = try fImport.importPHMesh(resource_manager, objFileLoc);
         mProc.moveMesh(phMapMesh, phMapMesh.getBoundingBox().min.inv());
         const chunks = try mProc.chunkMesh2Model(resource_manager, &phMapMesh, material, chunking.x, chunking.y, mapName, true);
         const chunkTot = chunks.phMeshes.len;
@@ -57,6 +64,10 @@ pub const Map = struct {
         const boundingBoxes = try allocator.alloc(BoundingBox, chunkTot);
         for (chunks.phMeshes, 0..) | phMesh, i | boundingBoxes[i] = phMesh.boundingBox;
 
+        // ===== Fit culling volumes to chunk vertices =====
+        const volumes = try allocator.alloc(BoundingVolume, chunkTot);
+        for (chunks.phMeshes, 0..) | phMesh, i | volumes[i] = BoundingVolume.fromPoints(phMesh.vertices[0..phMesh.vertexCount*3]);
+
         // ===== Create loaded/inView chunk lists =====
         const loaded = try allocator.alloc(bool, chunkTot);
         for (0..chunkTot) | i | loaded[i] = false; 
@@ -74,6 +85,7 @@ pub const Map = struct {
             .model = chunks.model,
             .positions = positions,
             .boundingBoxes = boundingBoxes,
+            .volumes = volumes,
 
             .inView = viewed,
             .loaded = loaded,
@@ -82,13 +94,17 @@ pub const Map = struct {
             .chunking = chunking,
             .chunkSize = .{.x = size.x/(@as(f32, @floatFromInt(chunking.x))), .y = size.z/(@as(f32, @floatFromInt(chunking.y)))}
         };
-        try result.initView();
+        const scratch = scratch_arena.threadScratch(allocator);
+        const mark = scratch.mark();
+        defer scratch.restore(mark);
+        try result.initView(scratch.allocator());
         return result;
     }
 
     pub fn deinit(self: *Map) void {
         self.allocator.free(self.positions);
         self.allocator.free(self.boundingBoxes);
+        self.allocator.free(self.volumes);
         self.allocator.free(self.inView);
         self.allocator.free(self.loaded);
         self.allocator.free(self.monitored);
@@ -100,10 +116,11 @@ pub const Map = struct {
         const monitored = self.monitored;
         
         // ===== Set inView chunks =====
+        const frustum = self.viewFrustum();
         var i:usize = 0;
         while(i<monitored.len):(i+=1){
             if(monitored[i]){
-                const viewed = inView(self.camera, self.positions[i]);
+                const viewed = frustum.intersects(self.volumes[i]);
 
                 if(viewed and !self.inView[i]){
                     self.updateViewed(i, true);
@@ -115,12 +132,25 @@ pub const Map = struct {
         }
     }
 
-    pub fn initView(self: *Map) !void {
-        const allocator = self.allocator;
+    fn viewFrustum(self: Map) Frustum {
+        return Frustum.fromViewProjection(self.camera.getViewProjectionMatrix().data);
+    }
+
+    /// Per-frame view update of the monitored chunks. Falls back to a full `initView` when no chunk is in view anymore
+    /// (camera jumped or turned away from everything monitored), temporaries of which come from `frameAllocator`.
+    pub fn refreshView(self: *Map, frameAllocator: Allocator) !void {
+        self.updateLoaded();
+        if (std.mem.indexOfScalar(bool, self.inView, true) == null) try self.initView(frameAllocator);
+    }
+
+    /// (Re)determine inView/loaded/monitored chunks. Temporaries are taken from `frameAllocator` (frame arena or scratch).
+    pub fn initView(self: *Map, frameAllocator: Allocator) !void {
+        const allocator = frameAllocator;
 
         // ===== Set inView =====
-        for (self.positions, 0..) | position, i | {
-            const viewed = inView(self.camera, position);
+        const frustum = self.viewFrustum();
+        for (self.volumes, 0..) | volume, i | {
+            const viewed = frustum.intersects(volume);
             self.inView[i] = viewed;
             // ===== Set loaded =====
             if(viewed){
@@ -137,8 +167,8 @@ pub const Map = struct {
         var i: usize = 0;
         while(!self.inView[i]):(i+=1){if (i+1 >= self.loaded.len) break;}
 
-        const outerIndices = try self.roamIndices(self.loaded, i);
-        const innerIndices = try self.roamIndices(self.inView, i);
+        const outerIndices = try self.roamIndices(allocator, self.loaded, i);
+        const innerIndices = try self.roamIndices(allocator, self.inView, i);
         defer allocator.free(outerIndices);
         defer allocator.free(innerIndices);
 
@@ -151,10 +181,11 @@ pub const Map = struct {
     }
 
     const roamError = error{DeadEndSearch};
-    fn roamIndices(self: Map, list: []bool, i_start: usize) ![]usize {
+    fn roamIndices(self: Map, allocator: Allocator, list: []bool, i_start: usize) ![]usize {
         // ===== Determine constants =====
         const row = self.chunking.x;
-        const i_hist = try self.allocator.alloc(usize, self.positions.len);
+        const i_hist = try allocator.alloc(usize, self.positions.len);
+        errdefer allocator.free(i_hist);
 
         // ===== Find edge =====
         var i: usize = i_start;
@@ -189,7 +220,7 @@ pub const Map = struct {
             if (i_hist[c] == i_hist[c-1]) return roamError.DeadEndSearch;
         }
 
-        return try self.allocator.realloc(i_hist, c); // skip last element-> same as first
+        return try allocator.realloc(i_hist, c); // skip last element-> same as first
     }
 
     fn neighbourIndices(self: Map, i:usize) [8]?usize {
@@ -0,0 +1,192 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const sim_map = @import("sim_map.zig");
+const SimMap = sim_map.SimMap;
+const ChunkBounds = sim_map.ChunkBounds;
+
+// Map pack: immutable simulation data of a map in a single file which is mapped read-only by every process that
+// hosts a match on the map -> the pages are shared through the page cache instead of being rebuilt per process.
+//
+// Layout (little endian, all offsets relative to the start of the file, no pointers):
+//   Header | heights [cellCount]f32 | walkable [cellCount]bool | chunkBounds [chunkCount]ChunkBounds
+// Every section starts at a multiple of `sectionAlignment`.
+//
+// The header records what the pack was built from: chunking, nav resolution and size/mtime of the source mesh. A pack
+// which does not match the requested map is stale and rebuilt by `openOrBuildPack`.
+
+const PackError = error{ InvalidPack, UnsupportedVersion, StalePack };
+
+const magic = "ZMAP".*;
+const version: u32 = 2;
+const sectionAlignment = 64;
+
+pub const SectionId = enum(u32) {
+    heights,
+    walkable,
+    chunkBounds,
+};
+const sectionCount = @typeInfo(SectionId).@"enum".fields.len;
+
+const Section = extern struct {
+    offset: u64, // bytes from start of file
+    len: u64, // bytes
+};
+
+const Header = extern struct {
+    magic: [4]u8 = magic,
+    version: u32 = version,
+    endianCheck: u32 = 0x01020304,
+    sectionCount: u32 = sectionCount,
+
+    origin: [3]f32,
+    extent: [3]f32,
+    chunking: [2]u32,
+    resolution: [2]u32,
+    sourceSize: u64,
+    sourceMtime: i64, // ns since epoch
+
+    sections: [sectionCount]Section,
+};
+
+/// Parameters a pack is built from. Packs built from anything else are stale.
+pub const BuildParams = struct {
+    chunking: math.vec2(usize),
+    cellsPerChunk: usize,
+    sourceSize: u64,
+    sourceMtime: i64,
+
+    /// Parameters of building from `objFileLoc` as it is on disk now
+    pub fn init(objFileLoc: []const u8, chunking: math.vec2(usize), cellsPerChunk: usize) !BuildParams {
+        const stat = try std.fs.cwd().statFile(objFileLoc);
+        return .{
+            .chunking = chunking,
+            .cellsPerChunk = cellsPerChunk,
+            .sourceSize = stat.size,
+            .sourceMtime = @intCast(stat.mtime),
+        };
+    }
+
+    fn matches(self: BuildParams, header: *const Header) bool {
+        return header.chunking[0] == self.chunking.x and header.chunking[1] == self.chunking.y and
+            header.resolution[0] == self.chunking.x * self.cellsPerChunk and header.resolution[1] == self.chunking.y * self.cellsPerChunk and
+            header.sourceSize == self.sourceSize and header.sourceMtime == self.sourceMtime;
+    }
+};
+
+/// Write immutable data of `map`, built with `params`, to `path`. The file is written next to its destination and
+/// renamed, so processes never map a partially written pack.
+pub fn writePack(map: SimMap, params: BuildParams, path: []const u8) !void {
+    if (std.fs.path.dirname(path)) |dir| try std.fs.cwd().makePath(dir);
+
+    // ===== Determine layout =====
+    var header = Header{
+        .origin = .{ map.origin.x, map.origin.y, map.origin.z },
+        .extent = .{ map.extent.x, map.extent.y, map.extent.z },
+        .chunking = .{ @intCast(map.chunking.x), @intCast(map.chunking.y) },
+        .resolution = .{ @intCast(map.resolution.x), @intCast(map.resolution.y) },
+        .sourceSize = params.sourceSize,
+        .sourceMtime = params.sourceMtime,
+        .sections = undefined,
+    };
+    const payloads = [sectionCount][]const u8{
+        std.mem.sliceAsBytes(map.heights),
+        std.mem.sliceAsBytes(map.walkable),
+        std.mem.sliceAsBytes(map.chunkBounds),
+    };
+    var offset: u64 = std.mem.alignForward(u64, @sizeOf(Header), sectionAlignment);
+    for (payloads, 0..) |payload, i| {
+        header.sections[i] = .{ .offset = offset, .len = payload.len };
+        offset = std.mem.alignForward(u64, offset + payload.len, sectionAlignment);
+    }
+
+    // ===== Write =====
+    var atomicFile = try std.fs.cwd().atomicFile(path, .{});
+    defer atomicFile.deinit();
+    var buffered = std.io.bufferedWriter(atomicFile.file.writer());
+    const writer = buffered.writer();
+
+    try writer.writeAll(std.mem.asBytes(&header));
+    var written: u64 = @sizeOf(Header);
+    for (payloads, header.sections) |payload, section| {
+        try writer.writeByteNTimes(0, section.offset - written);
+        try writer.writeAll(payload);
+        written = section.offset + section.len;
+    }
+    try buffered.flush();
+    try atomicFile.finish();
+}
+
+/// Map pack at `path` read-only and return a `SimMap` viewing it. `SimMap.deinit` unmaps the file.
+/// Returns `StalePack` if the pack was not built with `expected`.
+pub fn openPack(path: []const u8, expected: BuildParams) !SimMap {
+    const file = try std.fs.cwd().openFile(path, .{});
+    defer file.close(); // mapping stays valid after closing
+
+    const size = (try file.stat()).size;
+    if (size < @sizeOf(Header)) return PackError.InvalidPack;
+
+    const mapping = try std.posix.mmap(null, size, std.posix.PROT.READ, .{ .TYPE = .SHARED }, file.handle, 0);
+    errdefer std.posix.munmap(mapping);
+
+    // ===== Validate header =====
+    const header: *const Header = @ptrCast(@alignCast(mapping.ptr));
+    if (!std.mem.eql(u8, &header.magic, &magic)) return PackError.InvalidPack;
+    if (header.version != version or header.sectionCount != sectionCount) return PackError.UnsupportedVersion;
+    if (header.endianCheck != 0x01020304) return PackError.InvalidPack;
+    if (header.chunking[0] == 0 or header.chunking[1] == 0 or header.resolution[0] == 0 or header.resolution[1] == 0) return PackError.InvalidPack;
+    if (!expected.matches(header)) return PackError.StalePack;
+
+    const cellCount = @as(usize, header.resolution[0]) * header.resolution[1];
+    const chunkCount = @as(usize, header.chunking[0]) * header.chunking[1];
+
+    // ===== Resolve sections =====
+    const heights = try sectionSlice(f32, mapping, header.sections[@intFromEnum(SectionId.heights)], cellCount);
+    const walkableBytes = try sectionSlice(u8, mapping, header.sections[@intFromEnum(SectionId.walkable)], cellCount);
+    for (walkableBytes) |b| {
+        if (b > 1) return PackError.InvalidPack; // only 0/1 are valid bools
+    }
+    const chunkBounds = try sectionSlice(ChunkBounds, mapping, header.sections[@intFromEnum(SectionId.chunkBounds)], chunkCount);
+
+    const origin = header.origin;
+    const extent = header.extent;
+    const chunking = header.chunking;
+    const resolution = header.resolution;
+    return .{
+        .backing = .{ .mapped = mapping },
+        .origin = .{ .x = origin[0], .y = origin[1], .z = origin[2] },
+        .extent = .{ .x = extent[0], .y = extent[1], .z = extent[2] },
+        .chunking = .{ .x = chunking[0], .y = chunking[1] },
+        .chunkSize = .{ .x = extent[0] / @as(f32, @floatFromInt(chunking[0])), .y = extent[2] / @as(f32, @floatFromInt(chunking[1])) },
+        .resolution = .{ .x = resolution[0], .y = resolution[1] },
+        .cellSize = .{ .x = extent[0] / @as(f32, @floatFromInt(resolution[0])), .y = extent[2] / @as(f32, @floatFromInt(resolution[1])) },
+        .heights = heights,
+        .walkable = @ptrCast(walkableBytes),
+        .chunkBounds = chunkBounds,
+    };
+}
+
+/// Open pack at `path`, (re)building it from `objFileLoc` first if it does not exist yet, was written by another pack
+/// version, or was built from another source file, chunking or resolution
+pub fn openOrBuildPack(allocator: std.mem.Allocator, path: []const u8, objFileLoc: []const u8, chunking: math.vec2(usize), cellsPerChunk: usize) !SimMap {
+    const params = try BuildParams.init(objFileLoc, chunking, cellsPerChunk);
+    return openPack(path, params) catch |err| switch (err) {
+        error.FileNotFound, PackError.StalePack, PackError.UnsupportedVersion => {
+            std.debug.print("Building map pack '{s}' ({s})\n", .{ path, @errorName(err) });
+            var built = try SimMap.init(allocator, objFileLoc, chunking, cellsPerChunk);
+            defer built.deinit();
+            try writePack(built, params, path);
+            return try openPack(path, params);
+        },
+        else => return err,
+    };
+}
+
+fn sectionSlice(T: type, mapping: []const u8, section: Section, count: usize) ![]const T {
+    if (section.len != count * @sizeOf(T)) return PackError.InvalidPack;
+    if (section.offset > mapping.len or mapping.len - section.offset < section.len) return PackError.InvalidPack;
+    if (section.offset % @alignOf(T) != 0) return PackError.InvalidPack;
+
+    const ptr: [*]const T = @ptrCast(@alignCast(mapping.ptr + section.offset));
+    return ptr[0..count];
+}
@@ -0,0 +1,291 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const fImport = @import("../mesh/import_files.zig");
+const mProc = @import("../mesh/processing.zig");
+const tracking = @import("../utils/tracking_allocator.zig");
+const MN = @import("../globals.zig");
+
+const Vec2 = math.vec2;
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+const BoundingBox = mProc.BoundingBox;
+
+const SimMapError = error{ InvalidResolution, EmptyMap };
+
+/// Axis aligned chunk bounds with a fixed layout, such that it can be stored in and mapped from a map pack
+pub const ChunkBounds = extern struct {
+    min: [3]f32,
+    max: [3]f32,
+
+    pub fn toBoundingBox(self: ChunkBounds) BoundingBox {
+        return .{
+            .min = .{ .x = self.min[0], .y = self.min[1], .z = self.min[2] },
+            .max = .{ .x = self.max[0], .y = self.max[1], .z = self.max[2] },
+        };
+    }
+
+    pub fn center(self: ChunkBounds) [3]f32 {
+        return .{ (self.min[0] + self.max[0]) * 0.5, (self.min[1] + self.max[1]) * 0.5, (self.min[2] + self.max[2]) * 0.5 };
+    }
+};
+
+/// Owner of the grid memory: allocated by `init`, or a read-only mapping of a map pack (see `map_pack.zig`)
+pub const Backing = union(enum) {
+    owned: Allocator,
+    mapped: []align(std.heap.page_size_min) const u8,
+};
+
+/// Simulation-only representation of a map: heightfield, walkable grid and chunk bounds.
+///
+/// Holds no render data, so it can be loaded without a window or GPU (headless server). Loaded once and shared read-only
+/// between all matches on the same map, or mapped from a map pack and shared between processes.
+pub const SimMap = struct {
+    backing: Backing,
+
+    origin: Vec3(f32), // minimum corner of the map
+    extent: Vec3(f32), // size of the map
+    chunking: Vec2(usize),
+    chunkSize: Vec2(f32),
+
+    resolution: Vec2(usize), // nav cell count in x and z
+    cellSize: Vec2(f32),
+    heights: []const f32, // [z * resolution.x + x], height at cell center
+    walkable: []const bool,
+    chunkBounds: []const ChunkBounds,
+
+    /// Import `objFileLoc`, rasterize it to a heightfield with `cellsPerChunk` cells along each chunk side and discard the mesh.
+    pub fn init(allocator: Allocator, objFileLoc: []const u8, chunking: Vec2(usize), cellsPerChunk: usize) !SimMap {
+        const prevSubsystem = tracking.enter(.map);
+        defer tracking.leave(prevSubsystem);
+
+        if (chunking.x == 0 or chunking.y == 0 or cellsPerChunk == 0) return SimMapError.InvalidResolution;
+
+        // ===== load mesh and move it to the origin =====
+        var phMapMesh = try fImport.importPHMeshAlloc(allocator, objFileLoc);
+        defer phMapMesh.deinit();
+        if (phMapMesh.triangleCount == 0) return SimMapError.EmptyMap;
+        mProc.moveMesh(phMapMesh, phMapMesh.getBoundingBox().min.inv());
+        const bb = phMapMesh.getBoundingBox();
+        const extent = bb.max.subtract(bb.min);
+
+        // ===== Create grid =====
+        const resolution = Vec2(usize){ .x = chunking.x * cellsPerChunk, .y = chunking.y * cellsPerChunk };
+        const cellCount = resolution.x * resolution.y;
+
+        const heights = try allocator.alloc(f32, cellCount);
+        errdefer allocator.free(heights);
+        const walkable = try allocator.alloc(bool, cellCount);
+        errdefer allocator.free(walkable);
+        const chunkBounds = try allocator.alloc(ChunkBounds, chunking.x * chunking.y);
+        errdefer allocator.free(chunkBounds);
+
+        const result = SimMap{
+            .backing = .{ .owned = allocator },
+            .origin = bb.min,
+            .extent = extent,
+            .chunking = chunking,
+            .chunkSize = .{ .x = extent.x / @as(f32, @floatFromInt(chunking.x)), .y = extent.z / @as(f32, @floatFromInt(chunking.y)) },
+            .resolution = resolution,
+            .cellSize = .{ .x = extent.x / @as(f32, @floatFromInt(resolution.x)), .y = extent.z / @as(f32, @floatFromInt(resolution.y)) },
+            .heights = heights,
+            .walkable = walkable,
+            .chunkBounds = chunkBounds,
+        };
+
+        result.rasterize(heights, phMapMesh);
+        result.updateWalkable(heights, walkable, MN.MAX_WALKABLE_SLOPE);
+        result.updateChunkBounds(heights, chunkBounds);
+        return result;
+    }
+
+    pub fn deinit(self: *SimMap) void {
+        switch (self.backing) {
+            .owned => |allocator| {
+                allocator.free(self.heights);
+                allocator.free(self.walkable);
+                allocator.free(self.chunkBounds);
+            },
+            .mapped => |mapping| std.posix.munmap(mapping),
+        }
+    }
+
+    /// Bytes of grid data. For mapped maps these pages are shared between processes.
+    pub fn memoryBytes(self: SimMap) usize {
+        return self.heights.len * @sizeOf(f32) + self.walkable.len * @sizeOf(bool) + self.chunkBounds.len * @sizeOf(ChunkBounds);
+    }
+
+    // ======================================
+    // Queries
+    // ======================================
+
+    /// Cell containing world position (`x`, `z`), null if outside the map
+    pub fn cellIndex(self: SimMap, x: f32, z: f32) ?usize {
+        const fx = (x - self.origin.x) / self.cellSize.x;
+        const fz = (z - self.origin.z) / self.cellSize.y;
+        if (fx < 0 or fz < 0) return null;
+        const cx: usize = @intFromFloat(fx);
+        const cz: usize = @intFromFloat(fz);
+        if (cx >= self.resolution.x or cz >= self.resolution.y) return null;
+        return cz * self.resolution.x + cx;
+    }
+
+    /// Bilinearly interpolated terrain height at world position (`x`, `z`), clamped to the map
+    pub fn heightAt(self: SimMap, x: f32, z: f32) f32 {
+        const maxX: f32 = @floatFromInt(self.resolution.x - 1);
+        const maxZ: f32 = @floatFromInt(self.resolution.y - 1);
+        const fx = std.math.clamp((x - self.origin.x) / self.cellSize.x - 0.5, 0, maxX); // cell centers are at +0.5
+        const fz = std.math.clamp((z - self.origin.z) / self.cellSize.y - 0.5, 0, maxZ);
+
+        const x0: usize = @intFromFloat(@floor(fx));
+        const z0: usize = @intFromFloat(@floor(fz));
+        const x1 = @min(x0 + 1, self.resolution.x - 1);
+        const z1 = @min(z0 + 1, self.resolution.y - 1);
+        const tx = fx - @floor(fx);
+        const tz = fz - @floor(fz);
+
+        const row = self.resolution.x;
+        const h0 = std.math.lerp(self.heights[z0 * row + x0], self.heights[z0 * row + x1], tx);
+        const h1 = std.math.lerp(self.heights[z1 * row + x0], self.heights[z1 * row + x1], tx);
+        return std.math.lerp(h0, h1, tz);
+    }
+
+    pub fn isWalkable(self: SimMap, x: f32, z: f32) bool {
+        const i = self.cellIndex(x, z) orelse return false;
+        return self.walkable[i];
+    }
+
+    /// Chunk index containing world position (`x`, `z`), null if outside the map
+    pub fn chunkIndex(self: SimMap, x: f32, z: f32) ?usize {
+        const fx = (x - self.origin.x) / self.chunkSize.x;
+        const fz = (z - self.origin.z) / self.chunkSize.y;
+        if (fx < 0 or fz < 0) return null;
+        const cx: usize = @intFromFloat(fx);
+        const cz: usize = @intFromFloat(fz);
+        if (cx >= self.chunking.x or cz >= self.chunking.y) return null;
+        return cz * self.chunking.x + cx;
+    }
+
+    // ======================================
+    // Construction
+    // ======================================
+
+    /// Store highest surface of `mesh` at every cell center. Cells not covered by any triangle get NaN.
+    fn rasterize(self: SimMap, heights: []f32, mesh: mProc.PlaceHolderMesh) void {
+        @memset(heights, std.math.nan(f32));
+        const row = self.resolution.x;
+        const v = mesh.vertices;
+
+        var f: usize = 0;
+        while (f < mesh.triangleCount) : (f += 1) {
+            const tri = mesh.indices[f * 3 ..][0..3];
+            const a = v[tri[0] * 3 ..][0..3];
+            const b = v[tri[1] * 3 ..][0..3];
+            const c = v[tri[2] * 3 ..][0..3];
+
+            // ----- barycentric denominator in xz -----
+            const det = (b[2] - c[2]) * (a[0] - c[0]) + (c[0] - b[0]) * (a[2] - c[2]);
+            if (@abs(det) < 1e-12) continue; // vertical or degenerate face
+
+            // ----- covered cell range -----
+            const minX = @min(a[0], b[0], c[0]) - self.origin.x;
+            const maxX = @max(a[0], b[0], c[0]) - self.origin.x;
+            const minZ = @min(a[2], b[2], c[2]) - self.origin.z;
+            const maxZ = @max(a[2], b[2], c[2]) - self.origin.z;
+            const cx0 = self.cellFloor(minX, self.cellSize.x, self.resolution.x);
+            const cx1 = self.cellFloor(maxX, self.cellSize.x, self.resolution.x);
+            const cz0 = self.cellFloor(minZ, self.cellSize.y, self.resolution.y);
+            const cz1 = self.cellFloor(maxZ, self.cellSize.y, self.resolution.y);
+
+            var cz = cz0;
+            while (cz <= cz1) : (cz += 1) {
+                const pz = (@as(f32, @floatFromInt(cz)) + 0.5) * self.cellSize.y + self.origin.z;
+                var cx = cx0;
+                while (cx <= cx1) : (cx += 1) {
+                    const px = (@as(f32, @floatFromInt(cx)) + 0.5) * self.cellSize.x + self.origin.x;
+
+                    const w0 = ((b[2] - c[2]) * (px - c[0]) + (c[0] - b[0]) * (pz - c[2])) / det;
+                    const w1 = ((c[2] - a[2]) * (px - c[0]) + (a[0] - c[0]) * (pz - c[2])) / det;
+                    const w2 = 1 - w0 - w1;
+                    if (w0 < 0 or w1 < 0 or w2 < 0) continue; // cell center outside triangle
+
+                    const h = w0 * a[1] + w1 * b[1] + w2 * c[1];
+                    const cell = &heights[cz * row + cx];
+                    if (std.math.isNan(cell.*) or h > cell.*) cell.* = h;
+                }
+            }
+        }
+    }
+
+    fn cellFloor(_: SimMap, local: f32, cellSize: f32, count: usize) usize {
+        const c = @floor(local / cellSize);
+        if (c <= 0) return 0;
+        return @min(@as(usize, @intFromFloat(c)), count - 1);
+    }
+
+    /// Cell is walkable when covered and its central-difference slope does not exceed `maxSlope` (rise over run)
+    fn updateWalkable(self: SimMap, heights: []f32, walkable: []bool, maxSlope: f32) void {
+        const row = self.resolution.x;
+        const col = self.resolution.y;
+
+        for (0..col) |z| {
+            for (0..row) |x| {
+                const i = z * row + x;
+                const h = heights[i];
+                if (std.math.isNan(h)) {
+                    walkable[i] = false;
+                    continue;
+                }
+
+                const xl = coveredOr(heights, z * row + (if (x > 0) x - 1 else x), h);
+                const xr = coveredOr(heights, z * row + @min(x + 1, row - 1), h);
+                const zl = coveredOr(heights, (if (z > 0) z - 1 else z) * row + x, h);
+                const zr = coveredOr(heights, @min(z + 1, col - 1) * row + x, h);
+
+                const dx = (xr - xl) / (2 * self.cellSize.x);
+                const dz = (zr - zl) / (2 * self.cellSize.y);
+                walkable[i] = dx * dx + dz * dz <= maxSlope * maxSlope;
+            }
+        }
+
+        // ----- uncovered cells take the lowest height so queries stay finite -----
+        var lowest: f32 = std.math.inf(f32);
+        for (heights) |h| {
+            if (!std.math.isNan(h)) lowest = @min(lowest, h);
+        }
+        for (heights) |*h| {
+            if (std.math.isNan(h.*)) h.* = lowest;
+        }
+    }
+
+    fn coveredOr(heights: []const f32, i: usize, fallback: f32) f32 {
+        const h = heights[i];
+        return if (std.math.isNan(h)) fallback else h;
+    }
+
+    fn updateChunkBounds(self: SimMap, heights: []const f32, chunkBounds: []ChunkBounds) void {
+        const row = self.resolution.x;
+        const cellsX = @divExact(self.resolution.x, self.chunking.x);
+        const cellsZ = @divExact(self.resolution.y, self.chunking.y);
+
+        for (0..self.chunking.y) |cz| {
+            for (0..self.chunking.x) |cx| {
+                var minY: f32 = std.math.inf(f32);
+                var maxY: f32 = -std.math.inf(f32);
+                for (cz * cellsZ..(cz + 1) * cellsZ) |z| {
+                    for (heights[z * row + cx * cellsX ..][0..cellsX]) |h| {
+                        minY = @min(minY, h);
+                        maxY = @max(maxY, h);
+                    }
+                }
+
+                const fx: f32 = @floatFromInt(cx);
+                const fz: f32 = @floatFromInt(cz);
+                chunkBounds[cz * self.chunking.x + cx] = .{
+                    .min = .{ self.origin.x + fx * self.chunkSize.x, minY, self.origin.z + fz * self.chunkSize.y },
+                    .max = .{ self.origin.x + (fx + 1) * self.chunkSize.x, maxY, self.origin.z + (fz + 1) * self.chunkSize.y },
+                };
+            }
+        }
+    }
+};
@@ -0,0 +1,229 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const Vec2 = math.vec2;
+const Allocator = std.mem.Allocator;
+
+const SpatialHashError = error{InvalidGrid};
+
+const lanes = std.simd.suggestVectorLength(f32) orelse 4;
+const VecN = @Vector(lanes, f32);
+const LaneMask = std.meta.Int(.unsigned, lanes);
+
+const noCell = std.math.maxInt(u32);
+
+/// Grid coordinate of `v` along one axis, clamped to [0, resolution)
+fn cellCoord(v: f32, origin: f32, rSize: f32, resolution: usize) usize {
+    const f = @floor((v - origin) * rSize);
+    if (!(f > 0)) return 0; // also catches NaN
+    return @min(@as(usize, @intFromFloat(@min(f, 1e9))), resolution - 1);
+}
+
+/// Uniform grid of entity positions on the map's xz-plane. Every map chunk is split into `subdivision`² cells, so
+/// cell boundaries line up with chunk boundaries. Positions outside the map are clamped into the border cells.
+///
+/// Entities are addressed by dense ids (e.g. body or unit index). Cells keep their capacity, so once the hash has
+/// warmed up, moves and queries do not allocate.
+pub const SpatialHash = struct {
+    allocator: Allocator,
+
+    origin: Vec2(f32), // minimum corner of the map, (x, z)
+    cellSize: Vec2(f32),
+    resolution: Vec2(usize), // cell count in x and z
+    rCellSize: Vec2(f32),
+
+    cells: []std.ArrayListUnmanaged(u32), // entity ids per cell
+    cellOf: std.ArrayList(u32), // [id] -> cell, `noCell` if not inserted
+    slotOf: std.ArrayList(u32), // [id] -> index in its cell list
+    xs: std.ArrayList(f32), // [id] -> position
+    zs: std.ArrayList(f32),
+
+    // ----- gather buffers for the SIMD distance filter -----
+    gatherIds: std.ArrayList(u32),
+    gatherX: std.ArrayList(f32),
+    gatherZ: std.ArrayList(f32),
+
+    pub fn init(allocator: Allocator, origin: Vec2(f32), chunking: Vec2(usize), chunkSize: Vec2(f32), subdivision: usize) !SpatialHash {
+        if (chunking.x == 0 or chunking.y == 0 or subdivision == 0 or chunkSize.x <= 0 or chunkSize.y <= 0) return SpatialHashError.InvalidGrid;
+
+        const resolution = Vec2(usize){ .x = chunking.x * subdivision, .y = chunking.y * subdivision };
+        const sub: f32 = @floatFromInt(subdivision);
+        const cellSize = Vec2(f32){ .x = chunkSize.x / sub, .y = chunkSize.y / sub };
+
+        const cells = try allocator.alloc(std.ArrayListUnmanaged(u32), resolution.x * resolution.y);
+        @memset(cells, .{});
+
+        return .{
+            .allocator = allocator,
+            .origin = origin,
+            .cellSize = cellSize,
+            .resolution = resolution,
+            .rCellSize = .{ .x = 1 / cellSize.x, .y = 1 / cellSize.y },
+            .cells = cells,
+            .cellOf = std.ArrayList(u32).init(allocator),
+            .slotOf = std.ArrayList(u32).init(allocator),
+            .xs = std.ArrayList(f32).init(allocator),
+            .zs = std.ArrayList(f32).init(allocator),
+            .gatherIds = std.ArrayList(u32).init(allocator),
+            .gatherX = std.ArrayList(f32).init(allocator),
+            .gatherZ = std.ArrayList(f32).init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *SpatialHash) void {
+        for (self.cells) |*cell| cell.deinit(self.allocator);
+        self.allocator.free(self.cells);
+        self.cellOf.deinit();
+        self.slotOf.deinit();
+        self.xs.deinit();
+        self.zs.deinit();
+        self.gatherIds.deinit();
+        self.gatherX.deinit();
+        self.gatherZ.deinit();
+    }
+
+    // ======================================
+    // Updates
+    // ======================================
+
+    /// Insert entity `id` at (`x`, `z`). Ids do not have to be inserted in order.
+    pub fn insert(self: *SpatialHash, id: u32, x: f32, z: f32) !void {
+        if (id >= self.cellOf.items.len) {
+            const n = id + 1;
+            try self.slotOf.resize(n);
+            try self.xs.resize(n);
+            try self.zs.resize(n);
+            const old = self.cellOf.items.len;
+            try self.cellOf.resize(n);
+            @memset(self.cellOf.items[old..], noCell);
+        }
+        std.debug.assert(self.cellOf.items[id] == noCell);
+
+        self.xs.items[id] = x;
+        self.zs.items[id] = z;
+        try self.link(id, self.cellAt(x, z));
+    }
+
+    /// Move entity `id` to (`x`, `z`). Only touches cell lists if it crossed a cell border.
+    /// Ids which were never inserted, or were removed, are inserted.
+    pub fn move(self: *SpatialHash, id: u32, x: f32, z: f32) !void {
+        if (id >= self.cellOf.items.len or self.cellOf.items[id] == noCell) return self.insert(id, x, z);
+        self.xs.items[id] = x;
+        self.zs.items[id] = z;
+
+        const cell = self.cellAt(x, z);
+        if (cell == self.cellOf.items[id]) return;
+        try self.cells[cell].ensureUnusedCapacity(self.allocator, 1); // link below cannot fail after unlinking
+        self.unlink(id);
+        self.link(id, cell) catch unreachable;
+    }
+
+    pub fn remove(self: *SpatialHash, id: u32) void {
+        if (id >= self.cellOf.items.len or self.cellOf.items[id] == noCell) return;
+        self.unlink(id);
+    }
+
+    fn link(self: *SpatialHash, id: u32, cell: u32) !void {
+        const list = &self.cells[cell];
+        try list.append(self.allocator, id);
+        self.cellOf.items[id] = cell;
+        self.slotOf.items[id] = @intCast(list.items.len - 1);
+    }
+
+    /// Swap-remove `id` from its cell list
+    fn unlink(self: *SpatialHash, id: u32) void {
+        const list = &self.cells[self.cellOf.items[id]];
+        const slot = self.slotOf.items[id];
+        _ = list.swapRemove(slot);
+        if (slot < list.items.len) self.slotOf.items[list.items[slot]] = slot;
+        self.cellOf.items[id] = noCell;
+    }
+
+    // ======================================
+    // Queries
+    // ======================================
+
+    /// Cell containing (`x`, `z`), clamped to the grid
+    pub fn cellAt(self: SpatialHash, x: f32, z: f32) u32 {
+        const cx = cellCoord(x, self.origin.x, self.rCellSize.x, self.resolution.x);
+        const cz = cellCoord(z, self.origin.y, self.rCellSize.y, self.resolution.y);
+        return @intCast(cz * self.resolution.x + cx);
+    }
+
+    /// Append ids of all entities within `radius` of (`x`, `z`) to `out`
+    pub fn queryRadius(self: *SpatialHash, x: f32, z: f32, radius: f32, out: *std.ArrayList(u32)) !void {
+        try self.gather(x - radius, z - radius, x + radius, z + radius);
+
+        const ids = self.gatherIds.items;
+        const gx = self.gatherX.items;
+        const gz = self.gatherZ.items;
+        const cx: VecN = @splat(x);
+        const cz: VecN = @splat(z);
+        const r2: VecN = @splat(radius * radius);
+
+        try out.ensureUnusedCapacity(ids.len);
+        var i: usize = 0;
+        while (i + lanes <= ids.len) : (i += lanes) {
+            const dx = @as(VecN, gx[i..][0..lanes].*) - cx;
+            const dz = @as(VecN, gz[i..][0..lanes].*) - cz;
+            var mask: LaneMask = @bitCast(dx * dx + dz * dz <= r2);
+            while (mask != 0) : (mask &= mask - 1) out.appendAssumeCapacity(ids[i + @ctz(mask)]);
+        }
+        while (i < ids.len) : (i += 1) {
+            const dx = gx[i] - x;
+            const dz = gz[i] - z;
+            if (dx * dx + dz * dz <= radius * radius) out.appendAssumeCapacity(ids[i]);
+        }
+    }
+
+    /// Append ids of all entities inside the axis aligned box [`min`, `max`] (x, z) to `out`
+    pub fn queryBox(self: *SpatialHash, min: Vec2(f32), max: Vec2(f32), out: *std.ArrayList(u32)) !void {
+        try self.gather(min.x, min.y, max.x, max.y);
+
+        const ids = self.gatherIds.items;
+        const gx = self.gatherX.items;
+        const gz = self.gatherZ.items;
+        const minX: VecN = @splat(min.x);
+        const minZ: VecN = @splat(min.y);
+        const maxX: VecN = @splat(max.x);
+        const maxZ: VecN = @splat(max.y);
+
+        try out.ensureUnusedCapacity(ids.len);
+        var i: usize = 0;
+        while (i + lanes <= ids.len) : (i += lanes) {
+            const vx: VecN = gx[i..][0..lanes].*;
+            const vz: VecN = gz[i..][0..lanes].*;
+            var mask: LaneMask = @as(LaneMask, @bitCast(vx >= minX)) & @as(LaneMask, @bitCast(vx <= maxX)) &
+                @as(LaneMask, @bitCast(vz >= minZ)) & @as(LaneMask, @bitCast(vz <= maxZ));
+            while (mask != 0) : (mask &= mask - 1) out.appendAssumeCapacity(ids[i + @ctz(mask)]);
+        }
+        while (i < ids.len) : (i += 1) {
+            if (gx[i] >= min.x and gx[i] <= max.x and gz[i] >= min.y and gz[i] <= max.y) out.appendAssumeCapacity(ids[i]);
+        }
+    }
+
+    /// Copy ids and positions of all entities in cells overlapping the box into the contiguous gather buffers
+    fn gather(self: *SpatialHash, minX: f32, minZ: f32, maxX: f32, maxZ: f32) !void {
+        self.gatherIds.clearRetainingCapacity();
+        self.gatherX.clearRetainingCapacity();
+        self.gatherZ.clearRetainingCapacity();
+
+        const x0 = cellCoord(minX, self.origin.x, self.rCellSize.x, self.resolution.x);
+        const x1 = cellCoord(maxX, self.origin.x, self.rCellSize.x, self.resolution.x);
+        const z0 = cellCoord(minZ, self.origin.y, self.rCellSize.y, self.resolution.y);
+        const z1 = cellCoord(maxZ, self.origin.y, self.rCellSize.y, self.resolution.y);
+
+        for (z0..z1 + 1) |cz| {
+            for (x0..x1 + 1) |cx| {
+                const ids = self.cells[cz * self.resolution.x + cx].items;
+                try self.gatherIds.appendSlice(ids);
+                try self.gatherX.ensureUnusedCapacity(ids.len);
+                try self.gatherZ.ensureUnusedCapacity(ids.len);
+                for (ids) |id| {
+                    self.gatherX.appendAssumeCapacity(self.xs.items[id]);
+                    self.gatherZ.appendAssumeCapacity(self.zs.items[id]);
+                }
+            }
+        }
+    }
+};
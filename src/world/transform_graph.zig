@@ -0,0 +1,147 @@
+const std = @import("std");
+const math = @import("../math.zig");
+
+const Vec3 = math.vec3;
+const Allocator = std.mem.Allocator;
+
+const TransformGraphError = error{InvalidParent};
+
+/// ECS component linking an entity to a node in the `TransformGraph`
+pub const TransformNode = struct {
+    index: u32,
+    seenVersion: u32 = 0, // world version last copied into the entity's transform
+};
+
+pub const noParent = std.math.maxInt(u32);
+
+/// Parent-child transform hierarchy with versioned, dirty-flagged world matrices.
+///
+/// A node may only be parented to a node added before it, so index order is a valid update order and a single
+/// forward pass updates parents before their children. Only nodes whose local matrix changed, and their descendants,
+/// are recomputed; `update` returns immediately when nothing changed.
+pub const TransformGraph = struct {
+    allocator: Allocator,
+
+    locals: std.ArrayList([16]f32), // column-major, relative to the parent
+    worlds: std.ArrayList([16]f32), // column-major, valid for all nodes after `update`
+    parents: std.ArrayList(u32), // `noParent` for roots
+    worldVersions: std.ArrayList(u32), // increases every time the world matrix is recomputed
+
+    isDirty: std.ArrayList(bool), // local matrix changed, or parent world matrix recomputed, since last `update`
+    firstDirty: u32 = noParent, // nodes before this are clean
+
+    // ----- counters -----
+    matricesRecomputed: usize = 0, // by the last `update`
+    totalRecomputed: usize = 0,
+    updates: usize = 0, // `update` calls which recomputed at least one matrix
+    frames: usize = 0,
+
+    pub fn init(allocator: Allocator) TransformGraph {
+        return .{
+            .allocator = allocator,
+            .locals = std.ArrayList([16]f32).init(allocator),
+            .worlds = std.ArrayList([16]f32).init(allocator),
+            .parents = std.ArrayList(u32).init(allocator),
+            .worldVersions = std.ArrayList(u32).init(allocator),
+            .isDirty = std.ArrayList(bool).init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *TransformGraph) void {
+        self.locals.deinit();
+        self.worlds.deinit();
+        self.parents.deinit();
+        self.worldVersions.deinit();
+        self.isDirty.deinit();
+    }
+
+    pub fn count(self: TransformGraph) usize {
+        return self.locals.items.len;
+    }
+
+    /// Add node below `parent` (or `noParent`), returns its index. Its world matrix is computed on the next `update`.
+    pub fn add(self: *TransformGraph, parent: u32, local: [16]f32) !u32 {
+        const index: u32 = @intCast(self.count());
+        if (parent != noParent and parent >= index) return TransformGraphError.InvalidParent;
+
+        // ----- reserve everything first, appends below cannot fail -----
+        const n = index + 1;
+        try self.locals.ensureTotalCapacity(n);
+        try self.worlds.ensureTotalCapacity(n);
+        try self.parents.ensureTotalCapacity(n);
+        try self.worldVersions.ensureTotalCapacity(n);
+        try self.isDirty.ensureTotalCapacity(n);
+
+        self.locals.appendAssumeCapacity(local);
+        self.worlds.appendAssumeCapacity(math.mat4Identity);
+        self.parents.appendAssumeCapacity(parent);
+        self.worldVersions.appendAssumeCapacity(0);
+        self.isDirty.appendAssumeCapacity(false);
+        self.markDirty(index);
+        return index;
+    }
+
+    pub fn setLocal(self: *TransformGraph, i: u32, local: [16]f32) void {
+        self.locals.items[i] = local;
+        self.markDirty(i);
+    }
+
+    /// Replace the translation of the local matrix, no-op if it did not change
+    pub fn setTranslation(self: *TransformGraph, i: u32, t: Vec3(f32)) void {
+        const m = &self.locals.items[i];
+        if (m[12] == t.x and m[13] == t.y and m[14] == t.z) return;
+        m[12] = t.x;
+        m[13] = t.y;
+        m[14] = t.z;
+        self.markDirty(i);
+    }
+
+    pub fn world(self: TransformGraph, i: u32) *const [16]f32 {
+        return &self.worlds.items[i];
+    }
+
+    pub fn worldVersion(self: TransformGraph, i: u32) u32 {
+        return self.worldVersions.items[i];
+    }
+
+    fn markDirty(self: *TransformGraph, i: u32) void {
+        self.isDirty.items[i] = true;
+        self.firstDirty = @min(self.firstDirty, i);
+    }
+
+    /// Recompute world matrices of dirty nodes and their descendants. Call once per frame before rendering.
+    pub fn update(self: *TransformGraph) void {
+        self.frames += 1;
+        self.matricesRecomputed = 0;
+        if (self.firstDirty == noParent) return; // static scene
+
+        const locals = self.locals.items;
+        const worlds = self.worlds.items;
+        const parents = self.parents.items;
+        const isDirty = self.isDirty.items;
+
+        var i: usize = self.firstDirty;
+        while (i < locals.len) : (i += 1) {
+            const parent = parents[i];
+            // ----- recomputed parent dirties its children, parents always come first -----
+            if (parent != noParent and isDirty[parent]) isDirty[i] = true;
+            if (!isDirty[i]) continue;
+
+            worlds[i] = if (parent == noParent) locals[i] else math.mat4Multiply(worlds[parent], locals[i]);
+            self.worldVersions.items[i] +%= 1;
+            self.matricesRecomputed += 1;
+        }
+
+        // ----- clear flags after the pass, children read their parent's flag above -----
+        @memset(isDirty[self.firstDirty..], false);
+        self.firstDirty = noParent;
+
+        self.totalRecomputed += self.matricesRecomputed;
+        self.updates += 1;
+    }
+
+    pub fn printSummary(self: TransformGraph) void {
+        std.debug.print("\n===== Transforms =====\n", .{});
+        std.debug.print("{} nodes, {} matrices recomputed over {} frames, {} frames with matrix work\n", .{ self.count(), self.totalRecomputed, self.frames, self.updates });
+    }
+};